@@ -20,6 +20,7 @@ using namespace yarp::sig;
 
 // iKin
 #include <iCub/iKin/iKinFwd.h>
+#include <iCub/iKin/iKinFwdFixed.h>
 #include <iCub/iKin/iKinHlp.h>
 #include <iCub/iKin/iKinInv.h>
 #include <iCub/iKin/iKinIpOpt.h>
@@ -69,7 +70,28 @@ using namespace yarp::sig;
 %include <std_vector.i>
 
 // iKin
+%apply unsigned long &OUTPUT { unsigned long &hits, unsigned long &misses };
 %include <iCub/iKin/iKinFwd.h>
+
+// the raw kernels are not exposed, only the fixed-size chains
+%ignore iCub::iKin::fixed::eye;
+%ignore iCub::iKin::fixed::copy;
+%ignore iCub::iKin::fixed::dhUpdate;
+%ignore iCub::iKin::fixed::dhInit;
+%ignore iCub::iKin::fixed::dh;
+%ignore iCub::iKin::fixed::dhDerivative;
+%ignore iCub::iKin::fixed::mulH;
+%ignore iCub::iKin::fixed::mul;
+%ignore iCub::iKin::fixed::mulHInPlace;
+%ignore iCub::iKin::fixed::dcm2axis;
+%ignore iCub::iKin::fixed::rotAng;
+%ignore iCub::iKin::fixed::geoJacobianCol;
+%include <iCub/iKin/iKinFwdFixed.h>
+%template(iCubTorsoFixed) iCub::iKin::iKinFixedChain<3>;
+%template(iCubLegFixed) iCub::iKin::iKinFixedChain<6>;
+%template(iCubEyeFixed) iCub::iKin::iKinFixedChain<8>;
+%template(iCubArmFixed) iCub::iKin::iKinFixedChain<10>;
+
 %include <iCub/iKin/iKinHlp.h>
 %include <iCub/iKin/iKinInv.h>
 %include <iCub/iKin/iKinIpOpt.h>
@@ -89,6 +111,9 @@ using namespace yarp::sig;
 %include <iCub/ctrl/pids.h>
 %include <iCub/ctrl/tuning.h>
 
+%template(FixedKalman_1_1_1) iCub::ctrl::FixedKalman<1,1,1>;
+%template(FixedKalman_3_1_1) iCub::ctrl::FixedKalman<3,1,1>;
+
 // skinDynLib
 %include <iCub/skinDynLib/common.h>
 %include <iCub/skinDynLib/Taxel.h>
@@ -0,0 +1,129 @@
+#!/usr/bin/python
+
+# Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+# All rights reserved.
+#
+# This software may be modified and distributed under the terms of the
+# BSD-3-Clause license. See the accompanying LICENSE file for details.
+
+
+# Check FixedKalman against one Kalman per channel on a constant-acceleration model driven by
+# the jerk and measured in position: with the steady-state mode disabled the estimates must
+# coincide, whereas with the default tolerance the gain freezes and the estimates stay close.
+
+from __future__ import (absolute_import, division,
+                        print_function)
+from future import standard_library
+
+standard_library.install_aliases()
+
+import math
+import random
+import sys
+
+import yarp
+
+import icub
+
+log = yarp.Log()
+
+random.seed(0)
+
+Ts = 0.01
+A = yarp.Matrix(3, 3)
+A.zero()
+A[0, 0] = A[1, 1] = A[2, 2] = 1.
+A[0, 1] = A[1, 2] = Ts
+A[0, 2] = Ts * Ts / 2.
+B = yarp.Matrix(3, 1)
+B[0, 0] = Ts * Ts * Ts / 6.
+B[1, 0] = Ts * Ts / 2.
+B[2, 0] = Ts
+H = yarp.Matrix(1, 3)
+H.zero()
+H[0, 0] = 1.
+Q = yarp.Matrix(3, 3)
+Q.zero()
+Q[1, 1] = 1e-4
+Q[2, 2] = 1e-2
+R = yarp.Matrix(1, 1)
+R[0, 0] = 1e-2
+P0 = yarp.Matrix(3, 3)
+P0.eye()
+
+channels = 2
+
+
+def run(tol):
+    kal = [icub.Kalman(A, B, H, Q, R) for _ in range(channels)]
+    fkal = icub.FixedKalman_3_1_1(A, B, H, Q, R, channels)
+    fkal.set_SteadyStateTolerance(tol)
+
+    xx0 = yarp.Vector(3 * channels, 0.)
+    for c in range(channels):
+        x0 = yarp.Vector(3, 0.)
+        x0[0] = 0.5 * c
+        kal[c].init(x0, P0)
+        for i in range(3):
+            xx0[3 * c + i] = x0[i]
+    fkal.init(xx0, P0)
+
+    err_x = err_P = err_gate = 0.
+    for t in range(2000):
+        u = [math.sin(t * Ts), math.cos(2. * t * Ts)]
+        z = [math.sin(t * Ts) + random.gauss(0., 0.1), 0.5 * math.cos(t * Ts) + random.gauss(0., 0.1)]
+        U = yarp.Vector(channels)
+        Z = yarp.Vector(channels)
+        ref = []
+        for c in range(channels):
+            U[c] = u[c]
+            Z[c] = z[c]
+            x = kal[c].filt(yarp.Vector(1, u[c]), yarp.Vector(1, z[c]))
+            ref.append([x[i] for i in range(3)])
+        x = fkal.filt(U, Z)
+        P = fkal.get_P()
+        P_ref = kal[0].get_P()
+        for c in range(channels):
+            err_x = max(err_x, max(abs(x[3 * c + i] - ref[c][i]) for i in range(3)))
+            gate = kal[c].get_ValidationGate()
+            err_gate = max(err_gate, abs(fkal.get_ValidationGate(c) - gate) / (1. + gate))
+        err_P = max(err_P, max(abs(P[r, c] - P_ref[r, c]) for r in range(3) for c in range(3)))
+
+    return err_x, err_P, err_gate, fkal.is_SteadyState()
+
+
+ok = True
+
+err_x, err_P, err_gate, steady = run(0.)
+log.info('FixedKalman<3,1,1> without steady state: max error {:g} on x, {:g} on P, {:g} on the gates'.format(err_x, err_P, err_gate))
+if (err_x > 1e-9) or (err_P > 1e-9) or (err_gate > 1e-9) or steady:
+    log.error('FixedKalman does not match Kalman')
+    ok = False
+
+err_x, err_P, err_gate, steady = run(1e-9)
+log.info('FixedKalman<3,1,1> with steady state: max error {:g} on x, {:g} on P, {:g} on the gates'.format(err_x, err_P, err_gate))
+if (err_x > 1e-5) or (err_P > 1e-5) or (err_gate > 1e-5) or not steady:
+    log.error('FixedKalman in steady state departs from Kalman')
+    ok = False
+
+# scalar random constant of test_ctrlLib.py
+A1 = yarp.Matrix(1, 1)
+A1[0, 0] = 1.
+Q1 = yarp.Matrix(1, 1)
+Q1[0, 0] = 0.
+R1 = yarp.Matrix(1, 1)
+R1[0, 0] = 0.1
+kal = icub.Kalman(A1, A1, Q1, R1)
+fkal = icub.FixedKalman_1_1_1(A1, A1, Q1, R1)
+kal.init(yarp.Vector(1, 0.), A1)
+fkal.init(yarp.Vector(1, 0.), A1)
+err = 0.
+for z in [0.39, 0.50, 0.48, 0.29, 0.25, 0.32, 0.34, 0.48, 0.41, 0.45]:
+    err = max(err, abs(fkal.filt(yarp.Vector(1, z))[0] - kal.filt(yarp.Vector(1, z))[0]))
+log.info('FixedKalman<1,1,1>: max error {:g}'.format(err))
+if err > 1e-9:
+    log.error('FixedKalman<1,1,1> does not match Kalman')
+    ok = False
+
+if not ok:
+    sys.exit(1)
@@ -0,0 +1,94 @@
+#!/usr/bin/python
+
+# Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+# All rights reserved.
+#
+# This software may be modified and distributed under the terms of the
+# BSD-3-Clause license. See the accompanying LICENSE file for details.
+
+
+# Check SOSFilter against a cascade of Filter objects, one per section, including sections
+# with a pole in z=1 and with zero DC gain, and state resets in the middle of the run.
+
+from __future__ import (absolute_import, division,
+                        print_function)
+from future import standard_library
+
+standard_library.install_aliases()
+
+import random
+import sys
+
+import yarp
+
+import icub
+
+log = yarp.Log()
+
+random.seed(0)
+
+
+def to_vector(values):
+    v = yarp.Vector(len(values))
+    for i in range(len(values)):
+        v[i] = values[i]
+    return v
+
+
+# rows [b0 b1 b2 a0 a1 a2], with a0 different from 1 to exercise the normalization
+sections = [[1.0, 0.5, 0.2, 2.0, -1.0, 0.6],      # regular section
+            [1.0, 0.0, 0.0, 2.0, -2.0, 0.0],      # integrator: pole in z=1
+            [1.0, -2.0, 1.0, 2.0, -0.8, 0.2],     # double zero in z=1: zero DC gain
+            [0.3, 0.1, -0.4, 2.0, 0.4, -2.4]]     # zero DC gain and pole in z=1
+gain = 0.7
+dim = 3
+
+sos = yarp.Matrix(len(sections), 6)
+for s in range(len(sections)):
+    for k in range(6):
+        sos[s, k] = sections[s][k]
+
+# the overall gain goes in the numerator of the first section of the cascade
+num = [[(gain if s == 0 else 1.0) * b for b in sections[s][0:3]] for s in range(len(sections))]
+den = [sections[s][3:6] for s in range(len(sections))]
+cascade = [icub.Filter(to_vector(num[s]), to_vector(den[s]), yarp.Vector(dim, 0.0)) for s in range(len(sections))]
+last = [[0.0] * dim for _ in range(len(sections))]
+
+
+def init_cascade(y0):
+    # going backward, each filter yields the output the next one has been initialized with
+    v = list(y0)
+    for s in reversed(range(len(sections))):
+        cascade[s].init(to_vector(v))
+        sum_b = sum(num[s])
+        sum_a = sum(den[s])
+        if abs(sum_b) > sys.float_info.epsilon:
+            v = [sum_a / sum_b * x for x in v]
+        else:
+            v = list(last[s])
+
+
+y0 = [random.uniform(-1.0, 1.0) for _ in range(dim)]
+sosFilter = icub.SOSFilter(sos, gain, to_vector(y0))
+init_cascade(y0)
+
+err = 0.0
+for k in range(400):
+    if k in (150, 300):
+        y0 = [random.uniform(-1.0, 1.0) for _ in range(dim)]
+        sosFilter.init(to_vector(y0))
+        init_cascade(y0)
+
+    u = to_vector([random.uniform(-1.0, 1.0) for _ in range(dim)])
+    y = sosFilter.filt(u)
+    r = u
+    for s in range(len(sections)):
+        last[s] = [r[i] for i in range(dim)]
+        r = cascade[s].filt(r)
+    err = max(err, max(abs(y[i] - r[i]) / (1.0 + abs(r[i])) for i in range(dim)))
+
+log.info('SOSFilter: max relative error {:g} with respect to the cascade of filters'.format(err))
+
+if err > 1e-9:
+    log.error('SOSFilter does not match the cascade of filters')
+    sys.exit(1)
@@ -0,0 +1,77 @@
+#!/usr/bin/python
+
+# Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+# All rights reserved.
+#
+# This software may be modified and distributed under the terms of the
+# BSD-3-Clause license. See the accompanying LICENSE file for details.
+
+
+# Check that the estimators working on running sums (AWLinFastEstimator, AWQuadFastEstimator)
+# give the same output of the reference ones (AWLinEstimator, AWQuadEstimator) on noisy signals
+# sampled with jitter. The running sums and the reference SVD differ by rounding, which may flip
+# the window length of a sample whose fitting error lies right at the threshold: a few mismatches
+# are then allowed and the outputs are compared where the windows agree.
+
+from __future__ import (absolute_import, division,
+                        print_function)
+from future import standard_library
+
+standard_library.install_aliases()
+
+import math
+import random
+import sys
+
+import yarp
+
+import icub
+
+log = yarp.Log()
+
+random.seed(0)
+
+dim = 16
+steps = 2000
+Ts = 0.01
+
+# at most one window length out of a thousand may differ
+max_mismatches = (dim * steps) // 1000
+
+
+def signal(t, i):
+    return 30.0 * math.sin(2.0 * math.pi * (0.3 + 0.1 * i) * t) + random.gauss(0.0, 0.05)
+
+
+def compare(name, ref, fast):
+    err = 0.0
+    mismatches = 0
+    t = 1000.0
+    for k in range(steps):
+        t += Ts + random.uniform(-0.002, 0.002)
+        x = yarp.Vector(dim)
+        for i in range(dim):
+            x[i] = signal(t, i)
+
+        el = icub.AWPolyElement(x, t)
+        y_ref = ref.estimate(el)
+        y_fast = fast.estimate(el)
+
+        w_ref = ref.getWinLen()
+        w_fast = fast.getWinLen()
+        for i in range(dim):
+            if w_ref[i] == w_fast[i]:
+                err = max(err, abs(y_ref[i] - y_fast[i]) / (1.0 + abs(y_ref[i])))
+            else:
+                mismatches += 1
+
+    log.info('{:s}: max relative difference = {:g}, window length mismatches = {:d}'.format(name, err, mismatches))
+    return (err < 1e-6) and (mismatches <= max_mismatches)
+
+
+ok = compare('linear', icub.AWLinEstimator(16, 1.0), icub.AWLinFastEstimator(16, 1.0))
+ok &= compare('quadratic', icub.AWQuadEstimator(25, 1.0), icub.AWQuadFastEstimator(25, 1.0))
+
+if not ok:
+    log.error('The estimators on running sums do not match the reference ones')
+    sys.exit(1)
@@ -12,6 +12,9 @@ from future import standard_library
 
 standard_library.install_aliases()
 
+import random
+import sys
+
 import yarp
 
 import icub
@@ -33,6 +36,96 @@ def deg_to_rad(V):
     return V_rad
 
 
+def max_error(v, ref):
+    return max(abs(v[i] - ref[i]) for i in range(ref.size()))
+
+
+def check_kinematics():
+    # compare the fixed-size chain, the cache of the links transformations
+    # and the batched forward kinematics against EndEffPose()
+    random.seed(0)
+    arm = icub.iCubArm('left')
+    chain = arm.asChain()
+    dof = arm.getDOF()
+    N = arm.getN()
+
+    def random_q():
+        q = yarp.Vector(dof)
+        for i in range(dof):
+            q[i] = random.uniform(-0.5, 0.5)
+        return q
+
+    ok = True
+
+    # fixed-size forward kinematics
+    arm_fixed = icub.iCubArmFixed()
+    arm_fixed.fromChain(chain)
+    pose = yarp.Vector(7)
+    err = 0.0
+    for _ in range(100):
+        q = random_q()
+        ref = yarp.Vector(arm.EndEffPose(q))
+        arm_fixed.setAng(q.data())
+        arm_fixed.EndEffPose(pose.data())
+        err = max(err, max_error(pose, ref))
+    log.info('iKin: max error {:g} of the fixed-size chain'.format(err))
+    if err > 1e-12:
+        log.error('The fixed-size chain does not match EndEffPose()')
+        ok = False
+
+    # batched forward kinematics
+    M = 50
+    Q = yarp.Matrix(dof, M)
+    for r in range(dof):
+        for c in range(M):
+            Q[r, c] = random.uniform(-0.5, 0.5)
+    poses = yarp.Matrix()
+    err = 0.0
+    if arm.EndEffPoseBatch(Q, poses, None, True, 1):
+        for c in range(M):
+            ref = yarp.Vector(arm.EndEffPose(Q.getCol(c)))
+            err = max(err, max(abs(poses[i, c] - ref[i]) for i in range(ref.size())))
+        log.info('iKin: max error {:g} of the batched poses'.format(err))
+    else:
+        err = float('inf')
+    if err > 1e-12:
+        log.error('EndEffPoseBatch() does not match EndEffPose()')
+        ok = False
+
+    # cache of the links transformations: a query on the same configuration
+    # reuses all the links, a change of the last joint recomputes only it
+    q = random_q()
+    q[dof - 1] = 0.0
+    arm.setAng(q)
+    chain.EndEffPose()
+    chain.resetCacheStats()
+    chain.EndEffPose()
+    hits, misses = chain.getCacheStats()
+    log.info('iKin: cache hits {:d} misses {:d} on the same configuration'.format(hits, misses))
+    ok_cache = (hits == N) and (misses == 0)
+
+    q[dof - 1] = 0.1
+    chain.resetCacheStats()
+    arm.setAng(q)
+    pose = yarp.Vector(chain.EndEffPose())
+    hits, misses = chain.getCacheStats()
+    log.info('iKin: cache hits {:d} misses {:d} after moving the last joint'.format(hits, misses))
+    ok_cache = ok_cache and (hits == N - 1) and (misses == 1)
+
+    err = max_error(pose, icub.iCubArm('left').EndEffPose(q))
+    if (not ok_cache) or (err > 1e-12):
+        log.error('The cache of the links transformations is not consistent')
+        ok = False
+
+    return ok
+
+
+# To use yarp log function
+log = yarp.Log()
+
+if not check_kinematics():
+    sys.exit(1)
+
 yarp.Network.init()
 icub.init()
 
@@ -40,9 +133,6 @@ name = 'test'
 robot = 'icubSim'
 arm_name = 'left_arm'
 
-# To use yarp log function
-log = yarp.Log()
-
 props = yarp.Property()
 props.put("device", "remote_controlboard")
 props.put("local", "/" + name + "/" + arm_name)
@@ -0,0 +1,80 @@
+#!/usr/bin/python
+
+# Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+# All rights reserved.
+#
+# This software may be modified and distributed under the terms of the
+# BSD-3-Clause license. See the accompanying LICENSE file for details.
+
+
+# Check the streaming MedianFilter against a reference median computed by sorting the last n+1 inputs,
+# on odd and even windows, with repeated values, across order changes and resets.
+
+from __future__ import (absolute_import, division,
+                        print_function)
+from future import standard_library
+
+standard_library.install_aliases()
+
+import random
+import sys
+
+import yarp
+
+import icub
+
+log = yarp.Log()
+
+random.seed(0)
+
+
+class ReferenceMedianFilter(object):
+    def __init__(self, n, y0):
+        self.n = n
+        self.init(y0)
+
+    def init(self, y0):
+        self.y = list(y0)
+        self.history = [[] for _ in self.y]
+
+    def filt(self, u):
+        for i in range(len(self.y)):
+            self.history[i].append(u[i])
+            if len(self.history[i]) > self.n:
+                s = sorted(self.history[i])
+                L = len(s) // 2
+                self.y[i] = s[L] if (len(s) % 2) else 0.5 * (s[L] + s[L - 1])
+                self.history[i].pop(0)
+        return self.y
+
+
+dim = 3
+mismatches = 0
+for n in range(16):
+    y0 = yarp.Vector(dim, 0.5)
+    filt = icub.MedianFilter(n, y0)
+    ref = ReferenceMedianFilter(n, [0.5] * dim)
+
+    for k in range(600):
+        # integers produce plenty of ties
+        u = [float(random.randint(0, 3)), random.uniform(-1.0, 1.0), round(random.uniform(-1.0, 1.0), 1)]
+        u_vec = yarp.Vector(dim)
+        for i in range(dim):
+            u_vec[i] = u[i]
+        y = filt.filt(u_vec)
+        y_ref = ref.filt(u)
+        mismatches += sum(int(y[i] != y_ref[i]) for i in range(dim))
+
+        if k == 200:
+            filt.setOrder(n + 1)
+            ref.n = n + 1
+            ref.init(ref.y)
+        elif k == 400:
+            filt.init(yarp.Vector(dim, 0.1))
+            ref.init([0.1] * dim)
+
+log.info('MedianFilter: {:d} mismatches with the reference median'.format(mismatches))
+
+if mismatches > 0:
+    log.error('MedianFilter does not match the reference median')
+    sys.exit(1)
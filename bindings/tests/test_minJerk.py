@@ -0,0 +1,172 @@
+#!/usr/bin/python
+
+# Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+# All rights reserved.
+#
+# This software may be modified and distributed under the terms of the
+# BSD-3-Clause license. See the accompanying LICENSE file for details.
+
+
+# Check the minimum-jerk generator and the controller for non ideal plants, which advance all the joints
+# together, against one Filter per quantity and per joint fed with the same coefficients,
+# across changes of the execution time (also back to cached values) and of the plant parameters.
+
+from __future__ import (absolute_import, division,
+                        print_function)
+from future import standard_library
+
+standard_library.install_aliases()
+
+import random
+import sys
+
+import yarp
+
+import icub
+
+log = yarp.Log()
+
+random.seed(0)
+
+
+def to_vector(values):
+    v = yarp.Vector(len(values))
+    for i in range(len(values)):
+        v[i] = values[i]
+    return v
+
+
+def max_error(v, ref):
+    return max(abs(v[i] - ref[i]) for i in range(len(ref)))
+
+
+def abc(T):
+    return -150.765868956161 / (T * T * T), -84.9812819469538 / (T * T), -15.9669610709384 / T
+
+
+class ReferenceTrajGen(object):
+    def __init__(self, y0, Ts, T):
+        self.Ts = Ts
+        self.pos = list(y0)
+        self.filters = None
+        self.setT(T)
+
+    def setT(self, T):
+        Ts = self.Ts
+        a, b, c = abc(T)
+        m = 4.0 * c * Ts
+        n = 2.0 * b * Ts * Ts
+        p = a * Ts * Ts * Ts
+        den = to_vector([m + n + p - 8.0, -m + n + 3.0 * p + 24.0, -m - n + 3.0 * p - 24.0, m - n + p + 8.0])
+        p1 = 2.0 * a * Ts * Ts
+        p2 = 4.0 * a * Ts
+        nums = [to_vector([p, 3.0 * p, 3.0 * p, p]), to_vector([p1, p1, -p1, -p1]), to_vector([p2, -p2, -p2, p2])]
+        zeros = yarp.Vector(len(self.pos), 0.0)
+        pos = to_vector(self.pos)
+        if self.filters is None:
+            self.filters = [icub.Filter(nums[0], den, pos), icub.Filter(nums[1], den, zeros),
+                            icub.Filter(nums[2], den, zeros)]
+        else:
+            for f, num in zip(self.filters, nums):
+                f.adjustCoeffs(num, den)
+        for f in self.filters[1:]:
+            f.init(zeros, pos)
+
+    def computeNextValues(self, yd):
+        out = [f.filt(yd) for f in self.filters]
+        self.pos = [out[0][i] for i in range(len(self.pos))]
+        return out
+
+
+class ReferenceNonIdealCtrl(object):
+    def __init__(self, Ts, params):
+        self.Ts = Ts
+        self.params = params
+        self.filters = None
+        self.T = 1.0
+        self.computeCoeffs()
+
+    def computeCoeffs(self):
+        Ts = self.Ts
+        a, b, c = abc(self.T)
+        Ts2 = Ts * Ts
+        Ts3 = Ts2 * Ts
+        _num_0 = 3.0 * Ts3
+        _den_0 = 4.0 * Ts
+        _den_1 = 2.0 * Ts2
+        _den_2 = _den_1 * c
+        _den_3 = Ts3 * b
+        _den_4 = 3.0 * _den_3
+        coeffs = []
+        for Kp, Tz, Tw, Zeta in self.params:
+            _num_1 = 4.0 * Zeta * Ts2 * Tw
+            _num_2 = 4.0 * Ts * Tw * Tw
+            num = [a * (Ts3 + _num_1 + _num_2), a * (_num_0 + _num_1 - _num_2),
+                   a * (_num_0 - _num_1 - _num_2), a * (Ts3 - _num_1 + _num_2)]
+            _den_5 = _den_1 * Tz * b
+            _den_6 = _den_0 * Tz * c
+            _den_7 = 8.0 * Tz
+            _den_8 = 3.0 * _den_7
+            den = [Kp * (_den_3 - _den_7 - _den_0 + _den_2 + _den_5 + _den_6),
+                   Kp * (_den_0 + _den_8 + _den_4 + _den_2 + _den_5 - _den_6),
+                   Kp * (_den_0 - _den_8 + _den_4 - _den_2 - _den_5 - _den_6),
+                   Kp * (_den_7 - _den_0 + _den_3 - _den_2 - _den_5 + _den_6)]
+            coeffs.append((to_vector(num), to_vector(den)))
+        if self.filters is None:
+            self.filters = [icub.Filter(num, den, yarp.Vector(1, 0.0)) for num, den in coeffs]
+        else:
+            for f, (num, den) in zip(self.filters, coeffs):
+                f.adjustCoeffs(num, den)
+
+    def computeCmd(self, T, e):
+        if T != self.T:
+            self.T = T
+            self.computeCoeffs()
+        return [f.filt(yarp.Vector(1, e[i]))[0] for i, f in enumerate(self.filters)]
+
+
+dim = 7
+Ts = 0.01
+T_seq = [1.0, 0.5, 2.0, 0.5, 1.0]
+
+# trajectory generator
+y0 = [random.uniform(-1.0, 1.0) for _ in range(dim)]
+gen = icub.minJerkTrajGen(to_vector(y0), Ts, 1.0)
+ref = ReferenceTrajGen(y0, Ts, 1.0)
+
+err_gen = 0.0
+for k in range(1500):
+    if k % 300 == 0:
+        yd = to_vector([random.uniform(-1.0, 1.0) for _ in range(dim)])
+    if k % 300 == 150:
+        T = T_seq[(k // 300) % len(T_seq)]
+        gen.setT(T)
+        ref.setT(T)
+    gen.computeNextValues(yd)
+    out = ref.computeNextValues(yd)
+    err_gen = max(err_gen, max_error(gen.getPos(), out[0]), max_error(gen.getVel(), out[1]),
+                  max_error(gen.getAcc(), out[2]))
+
+# controller for non ideal plants, with different parameters per joint
+params = [(random.uniform(0.5, 1.5), random.uniform(0.0, 0.05), random.uniform(0.0, 0.03),
+           random.uniform(0.5, 0.9)) for _ in range(dim)]
+conf = ' '.join('(joint_{:d} ((Kp {!r}) (Tz {!r}) (Tw {!r}) (Zeta {!r})))'.format(i, *p)
+                for i, p in enumerate(params))
+parameters = yarp.Property()
+parameters.fromString(conf)
+
+ctrl = icub.minJerkVelCtrlForNonIdealPlant(Ts, dim)
+ctrl.setPlantParameters(parameters, 'joint')
+ref_ctrl = ReferenceNonIdealCtrl(Ts, params)
+
+err_ctrl = 0.0
+for k in range(1500):
+    T = T_seq[(k // 300) % len(T_seq)]
+    e = to_vector([random.uniform(-1.0, 1.0) for _ in range(dim)])
+    err_ctrl = max(err_ctrl, max_error(ctrl.computeCmd(T, e), ref_ctrl.computeCmd(T, e)))
+
+log.info('minJerk: max error {:g} for the trajectory generator, {:g} for the controller'.format(err_gen, err_ctrl))
+
+if (err_gen > 1e-9) or (err_ctrl > 1e-9):
+    log.error('The minimum-jerk engine does not match the reference filters')
+    sys.exit(1)
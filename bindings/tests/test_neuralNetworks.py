@@ -0,0 +1,99 @@
+#!/usr/bin/python
+
+# Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+# All rights reserved.
+#
+# This software may be modified and distributed under the terms of the
+# BSD-3-Clause license. See the accompanying LICENSE file for details.
+
+
+# Check the batched prediction of a tansig-purelin network against the prediction of the single inputs
+# and against a reference implementation of the network, on inputs spanning the saturation of the hidden nodes.
+
+from __future__ import (absolute_import, division,
+                        print_function)
+from future import standard_library
+
+standard_library.install_aliases()
+
+import math
+import random
+import sys
+
+import yarp
+
+import icub
+
+log = yarp.Log()
+
+random.seed(0)
+
+numIn = 3
+numHidden = 7
+numOut = 2
+
+IW = [[random.uniform(-3.0, 3.0) for _ in range(numIn)] for _ in range(numHidden)]
+LW = [[random.uniform(-1.0, 1.0) for _ in range(numHidden)] for _ in range(numOut)]
+b1 = [random.uniform(-1.0, 1.0) for _ in range(numHidden)]
+b2 = [random.uniform(-1.0, 1.0) for _ in range(numOut)]
+inMinMax = [(-2.0, 3.0), (0.0, 1.0), (-10.0, 10.0)]
+outMinMax = [(-5.0, 5.0), (1.0, 4.0)]
+
+
+def to_list(values):
+    return '(' + ' '.join(repr(v) for v in values) + ')'
+
+
+conf = '(numInputNodes {:d}) (numHiddenNodes {:d}) (numOutputNodes {:d})'.format(numIn, numHidden, numOut)
+conf += ' (b1 {:s}) (b2 {:s})'.format(to_list(b1), to_list(b2))
+for j in range(numHidden):
+    conf += ' (IW_{:d} {:s})'.format(j, to_list(IW[j]))
+for j in range(numOut):
+    conf += ' (LW_{:d} {:s})'.format(j, to_list(LW[j]))
+    conf += ' (outMinMaxX_{:d} {:s}) (outMinMaxY_{:d} (-1.0 1.0))'.format(j, to_list(outMinMax[j]), j)
+for j in range(numIn):
+    conf += ' (inMinMaxX_{:d} {:s}) (inMinMaxY_{:d} (-1.0 1.0))'.format(j, to_list(inMinMax[j]), j)
+
+options = yarp.Property()
+options.fromString(conf)
+net = icub.ff2LayNN_tansig_purelin(options)
+if not net.isValid():
+    log.error('Unable to configure the network')
+    sys.exit(1)
+
+
+def reference(x):
+    x1 = [2.0 * (x[j] - inMinMax[j][0]) / (inMinMax[j][1] - inMinMax[j][0]) - 1.0 for j in range(numIn)]
+    a1 = [math.tanh(sum(IW[i][j] * x1[j] for j in range(numIn)) + b1[i]) for i in range(numHidden)]
+    a2 = [sum(LW[i][j] * a1[j] for j in range(numHidden)) + b2[i] for i in range(numOut)]
+    return [0.5 * (a2[i] + 1.0) * (outMinMax[i][1] - outMinMax[i][0]) + outMinMax[i][0] for i in range(numOut)]
+
+
+# more rows than a block, with a ragged tail
+N = 203
+X = yarp.Matrix(N, numIn)
+for r in range(N):
+    for j in range(numIn):
+        X[r, j] = random.uniform(10.0 * inMinMax[j][0], 10.0 * inMinMax[j][1])
+
+Y = net.predict(X)
+if (Y.rows() != N) or (Y.cols() != numOut):
+    log.error('Wrong size of the batched prediction')
+    sys.exit(1)
+
+err_single = 0.0
+err_reference = 0.0
+for r in range(N):
+    x = X.getRow(r)
+    y = net.predict(x)
+    y_ref = reference([x[j] for j in range(numIn)])
+    for i in range(numOut):
+        err_single = max(err_single, abs(Y[r, i] - y[i]))
+        err_reference = max(err_reference, abs(Y[r, i] - y_ref[i]))
+
+log.info('ff2LayNN: max error of the batched prediction {:g} wrt single inputs, {:g} wrt reference'.format(
+    err_single, err_reference))
+
+if (err_single > 1e-12) or (err_reference > 1e-12):
+    log.error('The batched prediction does not match')
+    sys.exit(1)
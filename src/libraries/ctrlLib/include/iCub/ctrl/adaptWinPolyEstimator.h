@@ -26,6 +26,7 @@
 #define __ADAPTWINPOLYESTIMATOR_H__
 
 #include <deque>
+#include <vector>
 
 #include <yarp/sig/Vector.h>
 #include <iCub/ctrl/math.h>
@@ -213,6 +214,178 @@ public:
     AWQuadEstimator(unsigned int _N, const double _D) : AWPolyEstimator(2,_N,_D) { }
 };
 
+
+/**
+* \ingroup adaptWinPolyEstimator
+*
+* Adaptive window polynomial fitting carried out on running sums. 
+* Abstract class. 
+*  
+* It implements the same algorithm of AWPolyEstimator, but the 
+* samples are stored in a preallocated ring buffer along with the 
+* cumulative sums of the powers of time and of their products with 
+* the data. In this way the least-squares fit on any candidate 
+* window is a closed-form solve of a (order+1)x(order+1) system 
+* instead of a pseudo-inverse of the window's regressor, and no 
+* memory is allocated once the buffer is full. 
+*  
+* @note The fit is equivalent to the one of AWPolyEstimator for 
+*       the linear and quadratic cases; the regressor's
+*       coefficients are referred to the oldest sample of the
+*       window of length N, as in AWPolyEstimator, so that
+*       getEsteeme() keeps the same meaning.
+*/
+class AWPolyFastEstimator
+{
+protected:
+    unsigned int order;
+    unsigned int N;
+    double D;
+
+    unsigned int R;
+    size_t dim;
+    unsigned long cnt;
+    unsigned long base;
+    double t0;
+
+    std::vector<double> ringTime;
+    std::vector<double> ringData;
+    std::vector<double> sumT;
+    std::vector<double> sumY;
+    std::vector<double> A;
+    std::vector<double> a;
+    std::vector<double> pw;
+
+    yarp::sig::Vector coeff;
+    yarp::sig::Vector winLen;
+    yarp::sig::Vector mse;
+
+    bool firstRun;
+
+    /**
+    * Accumulate the contribution of the sample at position k on top
+    * of the sums at position k, storing the result at position k+1.
+    * @param k the sample position.
+    */
+    void accumulate(const unsigned long k);
+
+    /**
+    * Refer the sums to the oldest sample of the window of length N, 
+    * recomputing them from scratch; this keeps the powers of time 
+    * bounded. 
+    */
+    void rebase();
+
+    /**
+    * Find the regressor which best fits in least square sense the 
+    * last n samples of the i-th channel; the coefficients are 
+    * stored in a and referred to the origin of the sums. 
+    * @param i the channel.
+    * @param n the number of samples.
+    * @return true iff the normal equations could be solved.
+    */
+    bool fit(const size_t i, const unsigned int n);
+
+    /** 
+    * Return the current estimation. 
+    * @note needs to be defined. 
+    * @return esteeme.
+    */ 
+    virtual double getEsteeme() = 0;
+
+public:
+    /**
+    * Create a polynomial estimator object of order _order on an 
+    * adaptive window of a maximum length _N an threshold _D.
+    * @param _order is the order of polynomial fitting.
+    * @param _N is the maximum windows length.
+    * @param _D is the threshold.
+    */ 
+    AWPolyFastEstimator(unsigned int _order, unsigned int _N, const double _D);
+
+    /**
+    * Feed data into the algorithm.
+    * @param el is the new data of type AWPolyElement.
+    * @note an element whose data size differs from the previous 
+    *       ones restarts the estimation.
+    */
+    void feedData(const AWPolyElement &el);
+
+    /**
+    * Return the current windows lengths.
+    * @return the current windows lengths. 
+    */
+    yarp::sig::Vector getWinLen() { return winLen; }
+
+    /**
+    * Return the mean squared error (MSE) computed over the current 
+    * windows lengths between the predictions and the real data.
+    * @return the MSE. 
+    */
+    yarp::sig::Vector getMSE() { return mse; }
+
+    /**
+    * Execute the algorithm upon the stored samples, with the max 
+    * deviation threshold given by D. 
+    * @return the current estimation. 
+    */
+    yarp::sig::Vector estimate();
+
+    /**
+    * Execute the algorithm upon the stored samples, with the max 
+    * deviation threshold given by D. 
+    * @param el is the new data of type AWPolyElement. 
+    * @return the current estimation. 
+    */
+    yarp::sig::Vector estimate(const AWPolyElement &el);
+
+    /**
+    * Reinitialize the internal state. 
+    * @note Windows lengths are brought to the maximum value N and 
+    *       output remains zero as long as fed data size reaches N.
+    */
+    void reset();
+
+    /**
+     * Destructor.
+     */
+    virtual ~AWPolyFastEstimator() { }
+};
+
+
+/**
+* \ingroup adaptWinPolyEstimator
+*
+* Adaptive window linear fitting to estimate the first
+* derivative, carried out on running sums. It yields the same 
+* output of AWLinEstimator. 
+*/
+class AWLinFastEstimator : public AWPolyFastEstimator
+{
+protected:
+    virtual double getEsteeme() { return coeff[1]; }
+
+public:
+    AWLinFastEstimator(unsigned int _N, const double _D) : AWPolyFastEstimator(1,_N,_D) { }
+};
+
+
+/**
+* \ingroup adaptWinPolyEstimator
+*
+* Adaptive window quadratic fitting to estimate the second
+* derivative, carried out on running sums. It yields the same 
+* output of AWQuadEstimator. 
+*/
+class AWQuadFastEstimator : public AWPolyFastEstimator
+{
+protected:
+    virtual double getEsteeme() { return 2.0*coeff[2]; }
+
+public:
+    AWQuadFastEstimator(unsigned int _N, const double _D) : AWPolyFastEstimator(2,_N,_D) { }
+};
+
 }
 
 }
@@ -64,7 +64,13 @@ public:
 *
 * Data clustering based on DBSCAN algorithm. 
 * 
-* @note This implementation is based on the code available at
+* The neighbours are searched through a uniform grid of cells of 
+* side epsilon built upon the first three coordinates of the 
+* points, the region queries run in parallel and the clusters are 
+* merged with a union-find structure. 
+*  
+* @note The clusters and their numbering are the same of the 
+*       sequential implementation based on the code available at
 *       https://github.com/gyaikhom/dbscan.
 */
 class DBSCAN : public Clustering
@@ -76,7 +82,9 @@ public:
     * @param options contains clustering options. The available 
     *                options are: "epsilon" representing the
     *                proximity sensitivity; "minpts" representing
-    *                the minimum number of neighbours.
+    *                the minimum number of neighbours; "threads"
+    *                representing the number of threads running the
+    *                region queries (1 by default).
     * @return clusters as a mapping between classes and the sets of
     *         elements indexes wrt the original data.
     */
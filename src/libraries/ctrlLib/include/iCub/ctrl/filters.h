@@ -23,8 +23,10 @@
 #define __FILTERS_H__
 
 #include <deque>
+#include <vector>
 
 #include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
 #include <iCub/ctrl/math.h>
 
 
@@ -72,6 +74,11 @@ public:
 * \ingroup Filters
 *
 * IIR and FIR.
+*  
+* The past inputs and outputs are kept in two preallocated 
+* circular buffers, where the samples of all the channels at a 
+* given time are stored contiguously; hence filtering does not 
+* allocate memory and the inner loops run over the channels. 
 */
 class Filter : public IFilter
 {
@@ -80,11 +87,16 @@ protected:
    yarp::sig::Vector a;
    yarp::sig::Vector y;
 
-   std::deque<yarp::sig::Vector> uold;
-   std::deque<yarp::sig::Vector> yold;
+   std::vector<double> uold;    // (m-1) rows of past inputs
+   std::vector<double> yold;    // (n-1) rows of past outputs
+   size_t uhead;                // row of the most recent input
+   size_t yhead;                // row of the most recent output
+   size_t dim;
    size_t n;
    size_t m;
 
+   void allocate(const size_t dim);
+
 public:
    /**
    * Creates a filter with specified numerator and denominator 
@@ -172,6 +184,87 @@ public:
 };
 
 
+/**
+* \ingroup Filters
+*
+* IIR filter implemented as a cascade of second-order sections 
+* (biquads), each in direct form II transposed. 
+*  
+* For high orders the cascade is far less sensitive to the 
+* quantization of the coefficients than the single transfer 
+* function of Filter. As in Filter, the states of all the 
+* channels are stored contiguously and filtering does not 
+* allocate memory. 
+*/
+class SOSFilter : public IFilter
+{
+protected:
+   yarp::sig::Matrix sos;
+   double gain;
+   yarp::sig::Vector y;
+
+   std::vector<double> z;       // two rows of states per section
+   std::vector<double> uold;    // last input of each section
+   size_t dim;
+   size_t L;
+
+public:
+   /**
+   * Creates a filter with the specified sections.
+   * @param sos Lx6 matrix where each row [b0 b1 b2 a0 a1 a2] 
+   *            holds the numerator and denominator coefficients
+   *            of one section, given as increasing power of
+   *            z^-1 (the same format of the Matlab sos matrix).
+   * @param g the overall gain.
+   * @param y0 initial output.
+   * @note a0 shall not be 0. 
+   */ 
+   SOSFilter(const yarp::sig::Matrix &sos, const double g=1.0,
+             const yarp::sig::Vector &y0=yarp::sig::Vector(1,0.0));
+
+   /**
+   * Internal state reset. 
+   * @param y0 new internal state.
+   * @note going backward from the last section, each section is 
+   *       initialized as Filter::init() would do given the output
+   *       it shall yield: a section with zero DC gain takes its
+   *       last input as guess for the next input, whereas a pole
+   *       in z=1 yields a zero input for the preceding sections.
+   */ 
+   virtual void init(const yarp::sig::Vector &y0);
+
+   /**
+   * Returns the current sections.
+   * @param sos Lx6 matrix of the sections.
+   * @param g the overall gain.
+   */ 
+   void getCoeffs(yarp::sig::Matrix &sos, double &g);
+
+   /**
+   * Sets new sections.
+   * @param sos Lx6 matrix of the sections.
+   * @param g the overall gain.
+   * @note a0 shall not be 0. 
+   * @note the internal state is reinitialized to the current 
+   *       output.
+   */ 
+   void setCoeffs(const yarp::sig::Matrix &sos, const double g=1.0);
+
+   /**
+   * Performs filtering on the actual input.
+   * @param u reference to the actual input. 
+   * @return the corresponding output. 
+   */ 
+   virtual const yarp::sig::Vector& filt(const yarp::sig::Vector &u);
+
+   /**
+   * Return current filter output.
+   * @return the filter output. 
+   */ 
+   virtual const yarp::sig::Vector& output() const { return y; }
+};
+
+
 /**
 * \ingroup Filters
 *
@@ -314,16 +407,32 @@ public:
 * \ingroup Filters
 *
 * Median Filter
+*  
+* The median is computed over the last n+1 inputs. For each 
+* channel the samples are kept in a preallocated circular buffer 
+* and indexed by two heaps, a max-heap holding the lower half of 
+* the window and a min-heap holding the upper half, so that each 
+* new sample replaces the oldest one in O(log n) without 
+* allocating memory. 
 */
 class MedianFilter : public IFilter
 {
 protected:
-   std::deque<std::deque<double> > uold;
+   std::vector<double> uold;    // m rows of W samples
+   std::vector<size_t> heap;    // m rows: W/2+W%2 slots of the max-heap, then W/2 of the min-heap
+   std::vector<size_t> pos;     // m rows: position of each slot within heap
    yarp::sig::Vector y;
    size_t n;
    size_t m;
-
-   double median(std::deque<double>& v);
+   size_t W;
+   size_t nLow;
+   size_t cnt;
+   size_t head;
+
+   void sift(const size_t i, size_t p);
+   void build(const size_t i);
+   void replace(const size_t i, const size_t slot, const double u);
+   double median(const size_t i) const;
 
 public:
    /**
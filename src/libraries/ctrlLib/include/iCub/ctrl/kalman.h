@@ -22,6 +22,11 @@
 #ifndef __KALMAN_H__
 #define __KALMAN_H__
 
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include <yarp/os/LogStream.h>
 #include <yarp/sig/Vector.h>
 #include <yarp/sig/Matrix.h>
 #include <iCub/ctrl/math.h>
@@ -265,11 +270,740 @@ public:
     bool set_R(const yarp::sig::Matrix &_R);
 };
 
+
+/**
+* \ingroup Kalman
+*
+* Kalman estimator whose dimensions are fixed at compile time,
+* meant for small time-invariant models run at high rates.
+*
+* All the quantities are stored in fixed-size arrays and the gain
+* is computed through the Cholesky factorization of the innovation
+* covariance, hence no memory is allocated after construction.
+* Since the evolution of the covariance does not depend on the
+* data, the estimator tracks how fast the corrected covariance
+* converges and, as soon as it is within a given tolerance from
+* the steady state, freezes the gain: from then on each step costs
+* only the update of the state. The steady-state mode is left
+* automatically whenever a prediction is not followed by a
+* correction (e.g. a missing measurement) and whenever the model
+* is changed.
+*
+* The estimator can also process a number of independent channels
+* sharing the same model (e.g. the joints of a limb) in one call:
+* the channels share the covariance and the gain, while states,
+* inputs and measurements are stacked channel after channel.
+*
+* @note The measurement noise covariance R needs to be positive
+*       definite.
+*
+* Template parameters:
+* - N: the state size.
+* - M: the measurement size.
+* - L: the input size.
+*/
+template <unsigned int N, unsigned int M, unsigned int L=N>
+class FixedKalman
+{
+protected:
+    double A[N*N];
+    double B[N*L];
+    double H[M*N];
+    double Q[N*N];
+    double R[M*M];
+
+    double P[N*N];
+    double Pp[N*N];
+    double Pc[N*N];
+    double K[N*M];
+    double S[M*M];
+    double Lc[M*M];
+
+    yarp::sig::Vector x;
+    yarp::sig::Vector gates;
+    unsigned int channels;
+    double tol;
+    double diffOld;
+
+    bool factorized;
+    bool corrected;
+    bool hasPrevious;
+    bool steady;
+
+    static void load(double *dst, const yarp::sig::Matrix &src, const unsigned int rows, const unsigned int cols);
+    static yarp::sig::Matrix store(const double *src, const unsigned int rows, const unsigned int cols);
+    void propagate(const double *u);
+    bool factorize();
+    void reset();
+
+    // Default constructor: not implemented.
+    FixedKalman();
+
+public:
+    /**
+     * Init a Kalman state estimator.
+     *
+     * @param _A State transition matrix.
+     * @param _H Measurement matrix.
+     * @param _Q Process noise covariance.
+     * @param _R Measurement noise covariance.
+     * @param _channels Number of independent channels.
+     */
+    FixedKalman(const yarp::sig::Matrix &_A, const yarp::sig::Matrix &_H,
+                const yarp::sig::Matrix &_Q, const yarp::sig::Matrix &_R,
+                const unsigned int _channels=1);
+
+    /**
+     * Init a Kalman state estimator.
+     *
+     * @param _A State transition matrix.
+     * @param _B Input matrix.
+     * @param _H Measurement matrix.
+     * @param _Q Process noise covariance.
+     * @param _R Measurement noise covariance.
+     * @param _channels Number of independent channels.
+     */
+    FixedKalman(const yarp::sig::Matrix &_A, const yarp::sig::Matrix &_B,
+                const yarp::sig::Matrix &_H, const yarp::sig::Matrix &_Q,
+                const yarp::sig::Matrix &_R, const unsigned int _channels=1);
+
+    /**
+     * Set initial state and error covariance.
+     *
+     * @param _x0 Initial condition for estimated state, either of
+     *            size N (applied to all the channels) or of size
+     *            N times the number of channels.
+     * @param _P0 Initial condition for estimated error covariance.
+     * @return true/false on success/failure.
+     */
+    bool init(const yarp::sig::Vector &_x0, const yarp::sig::Matrix &_P0);
+
+    /**
+     * Predicts the next state vector given the current input.
+     *
+     * @param u Current input of size L times the number of
+     *          channels.
+     *
+     * @return Estimated state vector.
+     */
+    const yarp::sig::Vector& predict(const yarp::sig::Vector &u);
+
+    /**
+     * Predicts the next state vector.
+     *
+     * @return Estimated state vector.
+     */
+    const yarp::sig::Vector& predict();
+
+    /**
+     * Corrects the current estimation of the state vector given the
+     * current measurement.
+     *
+     * @param z Current measurement of size M times the number of
+     *          channels.
+     *
+     * @return Estimated state vector.
+     */
+    const yarp::sig::Vector& correct(const yarp::sig::Vector &z);
+
+    /**
+     * Returns the estimated state vector given the current
+     * input and the current measurement by performing a prediction
+     * and then correcting the result.
+     *
+     * @param u Current input.
+     * @param z Current measurement.
+     *
+     * @return Estimated state vector.
+     */
+    const yarp::sig::Vector& filt(const yarp::sig::Vector &u, const yarp::sig::Vector &z);
+
+    /**
+     * Returns the estimated state vector given the current
+     * measurement by performing a prediction and then correcting
+     * the result.
+     *
+     * @param z Current measurement.
+     *
+     * @return Estimated state vector.
+     */
+    const yarp::sig::Vector& filt(const yarp::sig::Vector &z);
+
+    /**
+     * Returns the estimated state of all the channels.
+     *
+     * @return Estimated state.
+     */
+    const yarp::sig::Vector& get_x() const { return x; }
+
+    /**
+     * Returns the estimated output of all the channels.
+     *
+     * @return Estimated output.
+     */
+    yarp::sig::Vector get_y() const;
+
+    /**
+     * Returns the estimated state covariance, shared by all the
+     * channels.
+     *
+     * @return Estimated state covariance.
+     */
+    yarp::sig::Matrix get_P() const { return store(steady&&!corrected?Pp:P,N,N); }
+
+    /**
+     * Returns the estimated measurement covariance.
+     *
+     * @return Estimated measurement covariance.
+     */
+    yarp::sig::Matrix get_S() const { return store(S,M,M); }
+
+    /**
+     * Returns the Kalman gain matrix.
+     *
+     * @return Kalman gain matrix.
+     */
+    yarp::sig::Matrix get_K() const { return store(K,N,M); }
+
+    /**
+     * Returns the validation gate of a channel.
+     * @note The validation gate is meaningful only after
+     *       correction.
+     * @see correct
+     * @param channel the channel.
+     * @return validation gate.
+     */
+    double get_ValidationGate(const unsigned int channel=0) const { return gates[channel]; }
+
+    /**
+     * Returns the number of channels.
+     *
+     * @return Number of channels.
+     */
+    unsigned int get_Channels() const { return channels; }
+
+    /**
+     * Tells whether the gain has been frozen to its steady-state
+     * value.
+     *
+     * @return true iff the steady state has been reached.
+     */
+    bool is_SteadyState() const { return steady; }
+
+    /**
+     * Sets the tolerance used to detect the convergence of the
+     * covariance, i.e. the largest distance of its elements from
+     * their steady-state values, relative to its largest element.
+     * The distance is extrapolated from the changes observed
+     * between consecutive corrections.
+     *
+     * @param _tol the tolerance; a non-positive value disables the
+     *             steady-state mode (default 1e-9).
+     */
+    void set_SteadyStateTolerance(const double _tol);
+
+    /**
+     * Sets the state transition matrix.
+     *
+     * @param _A State transition matrix.
+     * @return true/false on success/failure.
+     */
+    bool set_A(const yarp::sig::Matrix &_A);
+
+    /**
+     * Sets the input matrix.
+     *
+     * @param _B Input matrix.
+     * @return true/false on success/failure.
+     */
+    bool set_B(const yarp::sig::Matrix &_B);
+
+    /**
+     * Sets the measurement matrix.
+     *
+     * @param _H Measurement matrix.
+     * @return true/false on success/failure.
+     */
+    bool set_H(const yarp::sig::Matrix &_H);
+
+    /**
+     * Sets the process noise covariance matrix.
+     *
+     * @param _Q Process noise covariance matrix.
+     * @return true/false on success/failure.
+     */
+    bool set_Q(const yarp::sig::Matrix &_Q);
+
+    /**
+     * Sets the measurement noise covariance matrix.
+     *
+     * @param _R Measurement noise covariance matrix.
+     * @return true/false on success/failure.
+     */
+    bool set_R(const yarp::sig::Matrix &_R);
+};
+
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+void FixedKalman<N,M,L>::load(double *dst, const yarp::sig::Matrix &src,
+                              const unsigned int rows, const unsigned int cols)
+{
+    for (unsigned int r=0; r<rows; r++)
+        for (unsigned int c=0; c<cols; c++)
+            dst[r*cols+c]=src(r,c);
 }
 
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+yarp::sig::Matrix FixedKalman<N,M,L>::store(const double *src, const unsigned int rows,
+                                            const unsigned int cols)
+{
+    yarp::sig::Matrix dst(rows,cols);
+    for (unsigned int r=0; r<rows; r++)
+        for (unsigned int c=0; c<cols; c++)
+            dst(r,c)=src[r*cols+c];
+    return dst;
+}
+
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+void FixedKalman<N,M,L>::reset()
+{
+    // P holds the corrected covariance throughout the steady state
+    if (steady && !corrected)
+        std::memcpy(P,Pp,sizeof(P));
+
+    factorized=false;
+    hasPrevious=false;
+    steady=false;
+}
+
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+FixedKalman<N,M,L>::FixedKalman(const yarp::sig::Matrix &_A, const yarp::sig::Matrix &_H,
+                                const yarp::sig::Matrix &_Q, const yarp::sig::Matrix &_R,
+                                const unsigned int _channels) :
+                                FixedKalman(_A,yarp::math::zeros(N,L),_H,_Q,_R,_channels)
+{
+}
+
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+FixedKalman<N,M,L>::FixedKalman(const yarp::sig::Matrix &_A, const yarp::sig::Matrix &_B,
+                                const yarp::sig::Matrix &_H, const yarp::sig::Matrix &_Q,
+                                const yarp::sig::Matrix &_R, const unsigned int _channels) :
+                                x(_channels*N,0.0), gates(_channels,0.0),
+                                channels(_channels), tol(1e-9), diffOld(0.0), factorized(false),
+                                corrected(true), hasPrevious(false), steady(false)
+{
+    yAssert(channels>0);
+    yAssert((_A.rows()==N) && (_A.cols()==N));
+    yAssert((_B.rows()==N) && (_B.cols()==L));
+    yAssert((_H.rows()==M) && (_H.cols()==N));
+    yAssert((_Q.rows()==N) && (_Q.cols()==N));
+    yAssert((_R.rows()==M) && (_R.cols()==M));
+
+    load(A,_A,N,N);
+    load(B,_B,N,L);
+    load(H,_H,M,N);
+    load(Q,_Q,N,N);
+    load(R,_R,M,M);
+
+    std::memset(P,0,sizeof(P));
+    std::memset(Pp,0,sizeof(Pp));
+    std::memset(Pc,0,sizeof(Pc));
+    std::memset(K,0,sizeof(K));
+    std::memset(S,0,sizeof(S));
+    std::memset(Lc,0,sizeof(Lc));
+}
+
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+bool FixedKalman<N,M,L>::init(const yarp::sig::Vector &_x0, const yarp::sig::Matrix &_P0)
+{
+    if (((_x0.length()!=N) && (_x0.length()!=x.length())) ||
+        (_P0.rows()!=N) || (_P0.cols()!=N))
+        return false;
+
+    for (size_t i=0; i<x.length(); i++)
+        x[i]=_x0[i%_x0.length()];
+    reset();
+    load(P,_P0,N,N);
+    corrected=true;
+    return true;
+}
+
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+void FixedKalman<N,M,L>::propagate(const double *u)
+{
+    // a prediction with no correction in between breaks the steady state
+    if (steady && !corrected)
+        reset();
+
+    double *px=x.data();
+    for (unsigned int c=0; c<channels; c++, px+=N)
+    {
+        double xn[N];
+        for (unsigned int i=0; i<N; i++)
+        {
+            double s=0.0;
+            for (unsigned int j=0; j<N; j++)
+                s+=A[i*N+j]*px[j];
+            if (u!=NULL)
+                for (unsigned int j=0; j<L; j++)
+                    s+=B[i*L+j]*u[c*L+j];
+            xn[i]=s;
+        }
+        std::memcpy(px,xn,sizeof(xn));
+    }
+
+    if (!steady)
+    {
+        // P=A*P*A'+Q
+        double AP[N*N];
+        for (unsigned int i=0; i<N; i++)
+            for (unsigned int j=0; j<N; j++)
+            {
+                double s=0.0;
+                for (unsigned int k=0; k<N; k++)
+                    s+=A[i*N+k]*P[k*N+j];
+                AP[i*N+j]=s;
+            }
+        for (unsigned int i=0; i<N; i++)
+            for (unsigned int j=0; j<N; j++)
+            {
+                double s=Q[i*N+j];
+                for (unsigned int k=0; k<N; k++)
+                    s+=AP[i*N+k]*A[j*N+k];
+                P[i*N+j]=s;
+            }
+
+        // S=H*P*H'+R
+        double HP[M*N];
+        for (unsigned int i=0; i<M; i++)
+            for (unsigned int j=0; j<N; j++)
+            {
+                double s=0.0;
+                for (unsigned int k=0; k<N; k++)
+                    s+=H[i*N+k]*P[k*N+j];
+                HP[i*N+j]=s;
+            }
+        for (unsigned int i=0; i<M; i++)
+            for (unsigned int j=0; j<M; j++)
+            {
+                double s=R[i*M+j];
+                for (unsigned int k=0; k<N; k++)
+                    s+=HP[i*N+k]*H[j*N+k];
+                S[i*M+j]=s;
+            }
+
+        factorized=false;
+    }
+
+    for (unsigned int c=0; c<channels; c++)
+        gates[c]=0.0;
+    corrected=false;
 }
 
-#endif
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+bool FixedKalman<N,M,L>::factorize()
+{
+    // S=Lc*Lc'
+    for (unsigned int j=0; j<M; j++)
+    {
+        double d=S[j*M+j];
+        for (unsigned int k=0; k<j; k++)
+            d-=Lc[j*M+k]*Lc[j*M+k];
+        if (!(d>0.0))
+            return false;
+
+        d=std::sqrt(d);
+        Lc[j*M+j]=d;
+        for (unsigned int i=j+1; i<M; i++)
+        {
+            double s=S[i*M+j];
+            for (unsigned int k=0; k<j; k++)
+                s-=Lc[i*M+k]*Lc[j*M+k];
+            Lc[i*M+j]=s/d;
+            Lc[j*M+i]=0.0;
+        }
+    }
+
+    factorized=true;
+    return true;
+}
+
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+const yarp::sig::Vector& FixedKalman<N,M,L>::predict(const yarp::sig::Vector &u)
+{
+    yAssert(u.length()==channels*L);
+    propagate(u.data());
+    return x;
+}
+
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+const yarp::sig::Vector& FixedKalman<N,M,L>::predict()
+{
+    propagate(NULL);
+    return x;
+}
+
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+const yarp::sig::Vector& FixedKalman<N,M,L>::correct(const yarp::sig::Vector &z)
+{
+    yAssert(z.length()==channels*M);
+
+    // a correction with no prediction in between breaks the steady state
+    if (steady && corrected)
+        reset();
+
+    if (!steady)
+    {
+        // a singular S yields a null gain
+        if (!factorized && !factorize())
+            return x;
+
+        // K=P*H'*inv(S), solved row by row through the factorization
+        for (unsigned int i=0; i<N; i++)
+        {
+            double *k=K+i*M;
+            for (unsigned int j=0; j<M; j++)
+            {
+                double s=0.0;
+                for (unsigned int l=0; l<N; l++)
+                    s+=P[i*N+l]*H[j*N+l];
+                for (unsigned int l=0; l<j; l++)
+                    s-=Lc[j*M+l]*k[l];
+                k[j]=s/Lc[j*M+j];
+            }
+            for (int j=(int)M-1; j>=0; j--)
+            {
+                double s=k[j];
+                for (unsigned int l=j+1; l<M; l++)
+                    s-=Lc[l*M+j]*k[l];
+                k[j]=s/Lc[j*M+j];
+            }
+        }
+    }
+
+    const double *pz=z.data();
+    double *px=x.data();
+    for (unsigned int c=0; c<channels; c++, px+=N, pz+=M)
+    {
+        double e[M];
+        for (unsigned int i=0; i<M; i++)
+        {
+            double s=pz[i];
+            for (unsigned int j=0; j<N; j++)
+                s-=H[i*N+j]*px[j];
+            e[i]=s;
+        }
+
+        for (unsigned int i=0; i<N; i++)
+        {
+            double s=0.0;
+            for (unsigned int j=0; j<M; j++)
+                s+=K[i*M+j]*e[j];
+            px[i]+=s;
+        }
+
+        // e'*inv(S)*e=|inv(Lc)*e|^2
+        double gate=0.0;
+        for (unsigned int i=0; i<M; i++)
+        {
+            double s=e[i];
+            for (unsigned int j=0; j<i; j++)
+                s-=Lc[i*M+j]*e[j];
+            e[i]=s/Lc[i*M+i];
+            gate+=e[i]*e[i];
+        }
+        gates[c]=gate;
+    }
+
+    if (!steady)
+    {
+        // P=(I-K*H)*P
+        double KH[N*N];
+        std::memcpy(Pp,P,sizeof(P));
+        for (unsigned int i=0; i<N; i++)
+            for (unsigned int j=0; j<N; j++)
+            {
+                double s=0.0;
+                for (unsigned int k=0; k<M; k++)
+                    s+=K[i*M+k]*H[k*N+j];
+                KH[i*N+j]=s;
+            }
+        for (unsigned int i=0; i<N; i++)
+            for (unsigned int j=0; j<N; j++)
+            {
+                double s=Pp[i*N+j];
+                for (unsigned int k=0; k<N; k++)
+                    s-=KH[i*N+k]*Pp[k*N+j];
+                P[i*N+j]=s;
+            }
+
+        // freeze the gain as soon as the covariance has settled: the
+        // contraction rate rho of the last two changes bounds the
+        // distance still to be covered, i.e. diff*rho/(1-rho)
+        double diff=0.0,mag=0.0;
+        for (unsigned int i=0; i<N*N; i++)
+        {
+            diff=std::max(diff,std::fabs(P[i]-Pc[i]));
+            mag=std::max(mag,std::fabs(P[i]));
+        }
+        if ((tol>0.0) && hasPrevious && (diffOld>0.0))
+        {
+            double rho=diff/diffOld;
+            steady=(rho<1.0) && (diff*rho<=tol*mag*(1.0-rho));
+        }
+        diffOld=hasPrevious?diff:0.0;
+        std::memcpy(Pc,P,sizeof(P));
+        hasPrevious=true;
+    }
+
+    corrected=true;
+    return x;
+}
+
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+const yarp::sig::Vector& FixedKalman<N,M,L>::filt(const yarp::sig::Vector &u,
+                                                  const yarp::sig::Vector &z)
+{
+    predict(u);
+    return correct(z);
+}
+
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+const yarp::sig::Vector& FixedKalman<N,M,L>::filt(const yarp::sig::Vector &z)
+{
+    predict();
+    return correct(z);
+}
+
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+yarp::sig::Vector FixedKalman<N,M,L>::get_y() const
+{
+    yarp::sig::Vector y(channels*M);
+    for (unsigned int c=0; c<channels; c++)
+        for (unsigned int i=0; i<M; i++)
+        {
+            double s=0.0;
+            for (unsigned int j=0; j<N; j++)
+                s+=H[i*N+j]*x[c*N+j];
+            y[c*M+i]=s;
+        }
+    return y;
+}
 
 
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+void FixedKalman<N,M,L>::set_SteadyStateTolerance(const double _tol)
+{
+    tol=_tol;
+    if (tol<=0.0)
+        reset();
+}
+
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+bool FixedKalman<N,M,L>::set_A(const yarp::sig::Matrix &_A)
+{
+    if ((_A.rows()==N) && (_A.cols()==N))
+    {
+        load(A,_A,N,N);
+        reset();
+        return true;
+    }
+    else
+        return false;
+}
+
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+bool FixedKalman<N,M,L>::set_B(const yarp::sig::Matrix &_B)
+{
+    if ((_B.rows()==N) && (_B.cols()==L))
+    {
+        load(B,_B,N,L);
+        reset();
+        return true;
+    }
+    else
+        return false;
+}
+
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+bool FixedKalman<N,M,L>::set_H(const yarp::sig::Matrix &_H)
+{
+    if ((_H.rows()==M) && (_H.cols()==N))
+    {
+        load(H,_H,M,N);
+        reset();
+        return true;
+    }
+    else
+        return false;
+}
 
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+bool FixedKalman<N,M,L>::set_Q(const yarp::sig::Matrix &_Q)
+{
+    if ((_Q.rows()==N) && (_Q.cols()==N))
+    {
+        load(Q,_Q,N,N);
+        reset();
+        return true;
+    }
+    else
+        return false;
+}
+
+
+/**********************************************************************/
+template <unsigned int N, unsigned int M, unsigned int L>
+bool FixedKalman<N,M,L>::set_R(const yarp::sig::Matrix &_R)
+{
+    if ((_R.rows()==M) && (_R.cols()==M))
+    {
+        load(R,_R,M,M);
+        reset();
+        return true;
+    }
+    else
+        return false;
+}
+
+}
+
+}
+
+#endif
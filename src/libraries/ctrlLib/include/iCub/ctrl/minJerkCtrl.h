@@ -24,6 +24,7 @@
 
 #include <string>
 #include <deque>
+#include <vector>
 
 #include <yarp/os/Property.h>
 #include <yarp/sig/Vector.h>
@@ -37,6 +38,144 @@ namespace iCub
 namespace ctrl
 {
 
+/**
+* \ingroup minJerkCtrl
+*
+* Bank of IIR filters of the same order, one per channel, which 
+* serves as the engine of the minimum-jerk controllers and 
+* generators. 
+*  
+* Coefficients and past samples are stored as structures of 
+* arrays, tap by tap, so that all the channels (e.g. all the 
+* joints of a limb, or their positions, velocities and 
+* accelerations) are advanced together by loops running over 
+* contiguous memory, with no allocation. Each channel has its own 
+* coefficients and the operations are carried out in the same 
+* order as Filter, hence the outputs are the same as those of a 
+* Filter per channel. 
+*  
+* Since the coefficients depend on the sample time Ts and on the 
+* execution time T, the bank can also keep the last coefficient 
+* sets in a cache indexed by (Ts,T). 
+*/
+class minJerkFilterBank
+{
+protected:
+    struct CoeffsSet
+    {
+        double Ts;
+        double T;
+        std::vector<double> b;
+        std::vector<double> a;
+    };
+
+    size_t order;                   // order of the filters
+    size_t dim;                     // number of channels
+    size_t head;                    // row of the most recent samples
+
+    std::vector<double> b;          // numerators, tap by tap
+    std::vector<double> a;          // denominators, tap by tap
+    std::vector<double> uold;       // past inputs, circular over the taps
+    std::vector<double> yold;       // past outputs, circular over the taps
+    std::deque<CoeffsSet> cache;    // last coefficient sets
+
+    yarp::sig::Vector y;
+
+public:
+    /**
+    * Create an empty bank.
+    */
+    minJerkFilterBank();
+
+    /**
+    * Create a bank with null states and unitary filters.
+    * @param _order the order of the filters (greater than 0).
+    * @param _dim the number of channels.
+    */
+    minJerkFilterBank(const size_t _order, const size_t _dim);
+
+    /**
+    * Reshape the bank, clearing states, coefficients and cache.
+    * @param _order the order of the filters (greater than 0).
+    * @param _dim the number of channels.
+    */
+    void resize(const size_t _order, const size_t _dim);
+
+    /**
+    * Return the number of channels.
+    * @return the number of channels.
+    */
+    size_t getDim() const { return dim; }
+
+    /**
+    * Set the coefficients of a range of channels, keeping the 
+    * states. 
+    * @param num the numerator of order+1 elements.
+    * @param den the denominator of order+1 elements.
+    * @param first the first channel.
+    * @param count the number of channels; 0 for all the channels 
+    *              starting from first.
+    */
+    void setCoeffs(const double *num, const double *den,
+                   const size_t first=0, const size_t count=0);
+
+    /**
+    * Store the current coefficients in the cache. 
+    * @param Ts the sample time.
+    * @param T the execution time.
+    */
+    void storeCoeffs(const double Ts, const double T);
+
+    /**
+    * Retrieve from the cache the coefficients for a given pair 
+    * (Ts,T), keeping the states. 
+    * @param Ts the sample time.
+    * @param T the execution time.
+    * @return true iff the pair was found in the cache.
+    */
+    bool loadCoeffs(const double Ts, const double T);
+
+    /**
+    * Clear the cache of the coefficients.
+    */
+    void clearCoeffs() { cache.clear(); }
+
+    /**
+    * Initialize a range of channels so that they are at steady 
+    * state with output y0, as Filter::init(y0,u0) does. 
+    * @param y0 the output values, one per channel in the range.
+    * @param u0 the input values used when the DC gain is null, one
+    *           per channel in the range.
+    * @param first the first channel.
+    * @param count the number of channels.
+    */
+    void init(const double *y0, const double *u0, const size_t first, const size_t count);
+
+    /**
+    * Initialize a range of channels so that they are at steady 
+    * state with output y0, taking the last input as guess for the
+    * next one, as Filter::init(y0) does. 
+    * @param y0 the output values, one per channel in the range.
+    * @param first the first channel.
+    * @param count the number of channels.
+    */
+    void init(const double *y0, const size_t first, const size_t count);
+
+    /**
+    * Advance all the channels. 
+    * @param u points to the inputs, one per channel.
+    * @return the outputs.
+    */
+    const yarp::sig::Vector& filt(const double *u);
+
+    /**
+    * Return the current outputs.
+    * @return the outputs.
+    */
+    const yarp::sig::Vector& output() const { return y; }
+};
+
+
 /**
 * \ingroup minJerkCtrl
 *
@@ -85,7 +224,7 @@ private:
     minJerkVelCtrlForIdealPlant();
 
 protected:
-    ctrl::Filter *F;
+    minJerkFilterBank F;
 
     double Ts;
     double T;
@@ -143,7 +282,7 @@ protected:
     yarp::sig::Vector Tz;
     yarp::sig::Vector Tw;
     yarp::sig::Vector Zeta;
-    std::deque<ctrl::Filter*> F;
+    minJerkFilterBank F;
 
     double Ts;
     double T;
@@ -227,9 +366,8 @@ public:
 class minJerkBaseGen
 {
 protected:
-    Filter* posFilter;              // filter used to compute the position
-    Filter* velFilter;              // filter used to compute the velocity
-    Filter* accFilter;              // filter used to compute the acceleration
+    minJerkFilterBank filters;      // position, velocity and acceleration filters, stacked
+    yarp::sig::Vector in;           // inputs of the filters, stacked
 
     yarp::sig::Vector pos;          // current position
     yarp::sig::Vector vel;          // current velocity
@@ -242,6 +380,17 @@ protected:
 
     virtual void computeCoeffs()=0; // compute the filter coefficients
 
+    // set and cache the coefficients of the pos, vel and acc filters
+    void setCoeffs(const double *posNum, const double *posDen,
+                   const double *velNum, const double *velDen,
+                   const double *accNum, const double *accDen);
+
+    // bring the filters at rest in pos (the pos filter only if requested)
+    void initFilters(const bool withPos);
+
+    // run the filters on the inputs and update pos, vel and acc
+    void advance();
+
 public:
     /**
     * Constructor.
@@ -28,6 +28,7 @@
 
 #include <yarp/os/Property.h>
 #include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
 #include <iCub/ctrl/math.h>
 
 
@@ -43,6 +44,12 @@ namespace ctrl
 * Feed-Forward 2 layers Neural Network. 
 * Useful to implement the networks trained via MATLAB (e.g. 
 * through nftool). 
+*  
+* Besides the evaluation of a single input, the network can 
+* process a whole dataset at once: the inputs are taken in 
+* blocks of rows and each layer is computed as a product between 
+* the block and a contiguous copy of the weights, through loops 
+* that the compiler can vectorize. 
 */
 class ff2LayNN
 {
@@ -83,6 +90,24 @@ protected:
     void setItem(yarp::os::Property &options, const std::string &tag, const yarp::sig::Vector &item) const;
     bool getItem(const yarp::os::Property &options, const std::string &tag, yarp::sig::Vector &item) const;
 
+    /**
+    * Hidden Layer Function applied in place to a contiguous block 
+    * of values, as required by the batched prediction. 
+    * The default implementation relies on hiddenLayerFcn(). 
+    * @param x points to the values.
+    * @param n is the number of values.
+    */ 
+    virtual void hiddenLayerFcnBlock(double *x, const size_t n) const;
+
+    /**
+    * Output Layer Function applied in place to a contiguous block 
+    * of values, as required by the batched prediction. 
+    * The default implementation relies on outputLayerFcn(). 
+    * @param x points to the values.
+    * @param n is the number of values.
+    */ 
+    virtual void outputLayerFcnBlock(double *x, const size_t n) const;
+
 public:
     /**
     * Create an empty network.
@@ -155,6 +180,14 @@ public:
     */ 
     virtual yarp::sig::Vector predict(const yarp::sig::Vector &x) const;
 
+    /**
+    * Predict the outputs given a batch of inputs to the network.
+    * @param x contains one input per row.
+    * @return the predicted outputs, one per row; an empty matrix 
+    *         is returned if the network is not configured.
+    */ 
+    virtual yarp::sig::Matrix predict(const yarp::sig::Matrix &x) const;
+
     /**
     * Retrieve the network structure as a Property object.
     * @param options is the output stream. 
@@ -260,6 +293,10 @@ public:
 */
 class ff2LayNN_tansig_purelin : virtual public ff2LayNN
 {
+protected:
+    virtual void hiddenLayerFcnBlock(double *x, const size_t n) const;
+    virtual void outputLayerFcnBlock(double *x, const size_t n) const;
+
 public:
     /**
     * Create an empty network.
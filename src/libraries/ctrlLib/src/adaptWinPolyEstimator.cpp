@@ -241,3 +241,275 @@ Vector AWLinEstimator::fit(const Vector &x, const Vector &y, const unsigned int
 
 
 
+
+
+/***************************************************************************/
+AWPolyFastEstimator::AWPolyFastEstimator(unsigned int _order, unsigned int _N,
+                                         const double _D) :
+                                         order(_order), N(_N), D(_D)
+{
+    order=std::max(order,1U);
+    coeff.resize(order+1);
+    N=N<=order ? N+1 : N;
+
+    // the sums span at most 2N samples before being rebased
+    R=2*N+1;
+    dim=0;
+    cnt=base=0;
+    t0=0.0;
+
+    A.resize((order+1)*(order+1));
+    a.resize(order+1);
+    pw.resize(2*order+1);
+    sumT.resize(R*(2*order+1));
+
+    firstRun=true;
+}
+
+
+/***************************************************************************/
+void AWPolyFastEstimator::accumulate(const unsigned long k)
+{
+    unsigned int lenT=2*order+1;
+    unsigned int lenY=order+1;
+
+    const double *data=&ringData[(k%R)*dim];
+    const double *sT0=&sumT[(k%R)*lenT];
+    const double *sY0=&sumY[(k%R)*dim*lenY];
+    double *sT1=&sumT[((k+1)%R)*lenT];
+    double *sY1=&sumY[((k+1)%R)*dim*lenY];
+
+    double tau=ringTime[k%R]-t0;
+    pw[0]=1.0;
+    for (unsigned int j=1; j<lenT; j++)
+        pw[j]=pw[j-1]*tau;
+
+    for (unsigned int j=0; j<lenT; j++)
+        sT1[j]=sT0[j]+pw[j];
+
+    for (size_t i=0; i<dim; i++)
+        for (unsigned int j=0; j<lenY; j++)
+            sY1[i*lenY+j]=sY0[i*lenY+j]+pw[j]*data[i];
+}
+
+
+/***************************************************************************/
+void AWPolyFastEstimator::rebase()
+{
+    unsigned int lenT=2*order+1;
+    unsigned int lenY=order+1;
+
+    base=cnt-N;
+    t0=ringTime[base%R];
+
+    std::fill(sumT.begin()+(base%R)*lenT,sumT.begin()+(base%R+1)*lenT,0.0);
+    std::fill(sumY.begin()+(base%R)*dim*lenY,sumY.begin()+(base%R+1)*dim*lenY,0.0);
+    for (unsigned long k=base; k<cnt; k++)
+        accumulate(k);
+}
+
+
+/***************************************************************************/
+bool AWPolyFastEstimator::fit(const size_t i, const unsigned int n)
+{
+    unsigned int lenT=2*order+1;
+    unsigned int lenY=order+1;
+
+    // moments over the last n samples, as difference of cumulative sums
+    const double *sT1=&sumT[(cnt%R)*lenT];
+    const double *sT0=&sumT[((cnt-n)%R)*lenT];
+    const double *sY1=&sumY[(cnt%R)*dim*lenY+i*lenY];
+    const double *sY0=&sumY[((cnt-n)%R)*dim*lenY+i*lenY];
+
+    // normal equations: A is a Hankel matrix of the time moments
+    for (unsigned int r=0; r<lenY; r++)
+    {
+        for (unsigned int c=0; c<lenY; c++)
+            A[r*lenY+c]=sT1[r+c]-sT0[r+c];
+        a[r]=sY1[r]-sY0[r];
+    }
+
+    // in-place Cholesky factorization A=L*L'
+    for (unsigned int c=0; c<lenY; c++)
+    {
+        double d=A[c*lenY+c];
+        for (unsigned int k=0; k<c; k++)
+            d-=A[c*lenY+k]*A[c*lenY+k];
+
+        if (d<=0.0)
+        {
+            std::fill(a.begin(),a.end(),0.0);
+            return false;
+        }
+
+        d=sqrt(d);
+        A[c*lenY+c]=d;
+        for (unsigned int r=c+1; r<lenY; r++)
+        {
+            double v=A[r*lenY+c];
+            for (unsigned int k=0; k<c; k++)
+                v-=A[r*lenY+k]*A[c*lenY+k];
+            A[r*lenY+c]=v/d;
+        }
+    }
+
+    // forward and backward substitutions
+    for (unsigned int r=0; r<lenY; r++)
+    {
+        for (unsigned int k=0; k<r; k++)
+            a[r]-=A[r*lenY+k]*a[k];
+        a[r]/=A[r*lenY+r];
+    }
+
+    for (int r=lenY-1; r>=0; r--)
+    {
+        for (unsigned int k=r+1; k<lenY; k++)
+            a[r]-=A[k*lenY+r]*a[k];
+        a[r]/=A[r*lenY+r];
+    }
+
+    return true;
+}
+
+
+/***************************************************************************/
+void AWPolyFastEstimator::feedData(const AWPolyElement &el)
+{
+    // a change of the data size restarts the estimation
+    if ((cnt>0) && (el.data.length()!=dim))
+    {
+        cnt=0;
+        firstRun=true;
+    }
+
+    if (cnt==0)
+    {
+        dim=el.data.length();
+        ringTime.assign(R,0.0);
+        ringData.assign(R*dim,0.0);
+        sumY.assign(R*dim*(order+1),0.0);
+        std::fill(sumT.begin(),sumT.end(),0.0);
+        base=0;
+        t0=el.time;
+    }
+
+    ringTime[cnt%R]=el.time;
+    std::copy(el.data.begin(),el.data.end(),ringData.begin()+(cnt%R)*dim);
+
+    cnt++;
+
+    // the sums at position cnt would overwrite those at position base
+    if (cnt-base>=R)
+        rebase();
+    else
+        accumulate(cnt-1);
+}
+
+
+/***************************************************************************/
+Vector AWPolyFastEstimator::estimate()
+{
+    yAssert(cnt>0);
+
+    Vector esteem(dim,0.0);
+
+    if (firstRun)
+    {
+        winLen.resize(dim,N);
+        mse.resize(dim,0.0);
+        firstRun=false;
+    }
+
+    if (cnt<N)
+        return esteem;
+
+    // enforce condition on time vector
+    unsigned long first=cnt-N;
+    double tf=ringTime[first%R];
+    for (unsigned long k=first+1; k<cnt; k++)
+    {
+        if (ringTime[k%R]-tf<=0.0)
+        {
+            yWarning()<<"Provided non-increasing time vector";
+            return esteem;
+        }
+    }
+
+    // cycle upon all elements
+    for (size_t i=0; i<dim; i++)
+    {
+        // change the window length of two units, back and forth
+        unsigned int n1=(unsigned int)((winLen[i]>(order+1))?(winLen[i]-1):(order+1));
+        unsigned int n2=(unsigned int)((winLen[i]<N)?(winLen[i]+1):N);
+
+        // cycle upon all possibile window's length
+        for (unsigned int n=n1; n<=n2; n++)
+        {
+            // find the regressor's coefficients
+            fit(i,n);
+            bool _stop=false;
+
+            // test the regressor upon all the elements
+            // belonging to the actual window
+            mse[i]=0.0;
+            unsigned int slot=(unsigned int)((cnt-n)%R);
+            for (unsigned int k=0; k<n; k++)
+            {
+                double tau=ringTime[slot]-t0;
+                double y=a[order];
+                for (int j=order-1; j>=0; j--)
+                    y=y*tau+a[j];
+
+                double e=ringData[slot*dim+i]-y;
+                _stop|=(fabs(e)>D);
+                mse[i]+=e*e;
+
+                if (++slot==R)
+                    slot=0;
+            }
+            mse[i]/=n;
+
+            // set the new window's length in case of
+            // crossing of max deviation threshold
+            if (_stop)
+            {
+                winLen[i]=n;
+                break;
+            }
+        }
+
+        // refer the coefficients to the oldest sample
+        // of the window through a Taylor shift
+        double s=tf-t0;
+        for (unsigned int j=0; j<=order; j++)
+            coeff[j]=a[j];
+        for (unsigned int j=0; j<order; j++)
+            for (int k=order-1; k>=(int)j; k--)
+                coeff[k]+=s*coeff[k+1];
+
+        esteem[i]=getEsteeme();
+    }
+
+    return esteem;
+}
+
+
+/***************************************************************************/
+Vector AWPolyFastEstimator::estimate(const AWPolyElement &el)
+{
+    feedData(el);
+    return estimate();
+}
+
+
+/***************************************************************************/
+void AWPolyFastEstimator::reset()
+{
+    if (cnt>0)
+    {
+        winLen.resize(dim,N);
+        cnt=base=0;
+    }
+}
+
+
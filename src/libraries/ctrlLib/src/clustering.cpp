@@ -8,8 +8,14 @@
  * details.
 */
 
-#include <memory>
+#include <cstdint>
 #include <vector>
+#include <array>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <limits>
+#include <algorithm>
 #include <cmath>
 #include <yarp/math/Math.h>
 #include <iCub/ctrl/clustering.h>
@@ -23,125 +29,223 @@ using namespace iCub::ctrl;
 namespace iCub {
     namespace ctrl {
         namespace dbscan {
-            enum class PointType {
-                unclassified=-1,
-                noise=-2
-            };
+            /**********************************************************************/
+            bool are_neighbours(const Vector &p1, const Vector &p2, const double epsilon)
+            {
+                double d=0.0;
+                for (size_t j=0; j<p1.length(); j++)
+                {
+                    d+=pow(p1[j]-p2[j],2.0);
+                }
+                return (sqrt(d)<=epsilon);
+            }
 
-            struct Data_t {
+            /**********************************************************************/
+            // Uniform grid of cubic cells of side epsilon built upon the
+            // first (at most) three coordinates: the epsilon-neighbours of
+            // a point can only lie in the cells adjacent to its own cell.
+            // With more than three coordinates the grid still returns a
+            // superset of the neighbours, since the distance computed on
+            // a subset of the coordinates cannot exceed the full one.
+            // A non finite epsilon gives one single cell for all the points.
+            class Grid_t {
                 const vector<Vector> &points;
                 const double epsilon;
-                const size_t minpts;
-                vector<int> ids;
-                Data_t(const vector<Vector> &points_,
-                       const double epsilon_,
-                       const size_t minpts_) :
-                       points(points_), epsilon(epsilon_), minpts(minpts_) {
-                    ids.assign(points.size(),(int)PointType::unclassified);
+                size_t dims;
+                double side;
+                bool single;
+                double origin[3];
+                vector<size_t> order;       // points sorted by cell
+                vector<size_t> cell_begin;  // first point of each cell within order
+                vector<size_t> adj_begin;   // first adjacent cell of each cell within adj
+                vector<size_t> adj;         // adjacent cells, the cell itself included
+                vector<size_t> cell_of;     // cell of each point
+
+                bool get_key(const Vector &p, array<int64_t,3> &key) const {
+                    key.fill(0);
+                    for (size_t k=0; k<dims; k++)
+                    {
+                        // points with non finite coordinates have no neighbours
+                        if (!std::isfinite(p[k]))
+                            return false;
+                        if (!single)
+                            key[k]=(int64_t)floor((p[k]-origin[k])/side);
+                    }
+                    return true;
                 }
-            };
 
-            struct Node_t {
-                size_t index;
-                shared_ptr<Node_t> next;
-            };
+            public:
+                Grid_t(const vector<Vector> &points_, const double epsilon_) :
+                       points(points_), epsilon(epsilon_) {
+                    dims=points.empty()?0:std::min(points[0].length(),(size_t)3);
 
-            struct Epsilon_neighbours_t {
-                size_t num_members;
-                shared_ptr<Node_t> head;
-                weak_ptr<Node_t> tail;
-            };
+                    double lo[3]={0.0,0.0,0.0};
+                    double hi[3]={0.0,0.0,0.0};
+                    bool first=true;
+                    for (auto &p:points)
+                    {
+                        bool finite=true;
+                        for (size_t k=0; k<dims; k++)
+                            finite&=std::isfinite(p[k]);
+                        if (!finite)
+                            continue;
 
-            /**********************************************************************/
-            shared_ptr<Node_t> create_node(const size_t index)
-            {
-                shared_ptr<Node_t> node(new Node_t());
-                node->index=index;
-                node->next=nullptr;
-                return node;
-            }
+                        for (size_t k=0; k<dims; k++)
+                        {
+                            lo[k]=first?p[k]:std::min(lo[k],p[k]);
+                            hi[k]=first?p[k]:std::max(hi[k],p[k]);
+                        }
+                        first=false;
+                    }
 
-            /**********************************************************************/
-            void append(const size_t index, shared_ptr<Epsilon_neighbours_t> en)
-            {
-                shared_ptr<Node_t> node=create_node(index);
-                if (en->head==nullptr)
-                {
-                    en->head=node;
-                    en->tail=node;
-                }
-                else
-                {
-                    en->tail.lock()->next=node;
-                    en->tail=node;
-                }
-                en->num_members++;
-            }
+                    // cells larger than epsilon are still correct: bound
+                    // their number to keep the keys within range
+                    double extent=0.0;
+                    for (size_t k=0; k<dims; k++)
+                    {
+                        origin[k]=lo[k];
+                        extent=std::max(extent,hi[k]-lo[k]);
+                    }
+                    side=std::max(epsilon,extent/(double)(1<<30));
+                    single=!std::isfinite(side);
+                    if (single || !(side>0.0))
+                        side=1.0;
 
-            /**********************************************************************/
-            shared_ptr<Epsilon_neighbours_t> get_epsilon_neighbours(const size_t index,
-                                                                    shared_ptr<Data_t> augData)
-            {
-                shared_ptr<Epsilon_neighbours_t> en(new Epsilon_neighbours_t());
-                for (size_t i=0; i<augData->points.size(); i++)
-                {
-                    double d=0.0;
-                    for (size_t j=0; j<augData->points[index].length(); j++)
+                    // sort the points by cell, then by index
+                    vector<pair<array<int64_t,3>,size_t>> keys;
+                    keys.reserve(points.size());
+                    for (size_t i=0; i<points.size(); i++)
                     {
-                        d+=pow(augData->points[index][j]-augData->points[i][j],2.0);
+                        array<int64_t,3> key;
+                        if (get_key(points[i],key))
+                            keys.push_back(make_pair(key,i));
                     }
-                    if ((i!=index) && (sqrt(d)<=augData->epsilon))
+                    sort(keys.begin(),keys.end());
+
+                    const size_t none=numeric_limits<size_t>::max();
+                    cell_of.assign(points.size(),none);
+                    vector<array<int64_t,3>> cell_key;
+                    order.resize(keys.size());
+                    for (size_t i=0; i<keys.size(); i++)
                     {
-                        append(i,en);
+                        if ((i==0) || (keys[i].first!=keys[i-1].first))
+                        {
+                            cell_key.push_back(keys[i].first);
+                            cell_begin.push_back(i);
+                        }
+                        order[i]=keys[i].second;
+                        cell_of[order[i]]=cell_key.size()-1;
                     }
+                    cell_begin.push_back(keys.size());
+
+                    // look up the adjacent cells once for all
+                    int64_t span[3]={0,0,0};
+                    for (size_t k=0; k<dims; k++)
+                        span[k]=single?0:1;
+
+                    for (auto &key:cell_key)
+                    {
+                        adj_begin.push_back(adj.size());
+
+                        array<int64_t,3> query;
+                        for (query[0]=key[0]-span[0]; query[0]<=key[0]+span[0]; query[0]++)
+                        for (query[1]=key[1]-span[1]; query[1]<=key[1]+span[1]; query[1]++)
+                        for (query[2]=key[2]-span[2]; query[2]<=key[2]+span[2]; query[2]++)
+                        {
+                            auto it=lower_bound(cell_key.begin(),cell_key.end(),query);
+                            if ((it!=cell_key.end()) && (*it==query))
+                                adj.push_back(it-cell_key.begin());
+                        }
+                    }
+                    adj_begin.push_back(adj.size());
                 }
-                return en;
-            }
 
-            /**********************************************************************/
-            void spread(const size_t index, shared_ptr<Epsilon_neighbours_t> seeds,
-                        const size_t id, shared_ptr<Data_t> augData)
-            {
-                shared_ptr<Epsilon_neighbours_t> spread=get_epsilon_neighbours(index,augData);
-                if (spread->num_members>=augData->minpts)
-                {
-                    for (shared_ptr<Node_t> node=spread->head; node!=nullptr; node=node->next)
+                // calls f(j) for each epsilon-neighbour j of the point index,
+                // as long as f returns true
+                template<typename F>
+                void for_each_neighbour(const size_t index, F f) const {
+                    size_t c=cell_of[index];
+                    if (c==numeric_limits<size_t>::max())
+                        return;
+
+                    for (size_t a=adj_begin[c]; a<adj_begin[c+1]; a++)
                     {
-                        if ((augData->ids[node->index]==(int)PointType::noise) ||
-                            (augData->ids[node->index]==(int)PointType::unclassified))
+                        for (size_t k=cell_begin[adj[a]]; k<cell_begin[adj[a]+1]; k++)
                         {
-                            if (augData->ids[node->index]==(int)PointType::unclassified)
-                            {
-                                append(node->index,seeds);
-                            }
-                            augData->ids[node->index]=(int)id;
+                            size_t i=order[k];
+                            if ((i!=index) && are_neighbours(points[index],points[i],epsilon))
+                                if (!f(i))
+                                    return;
                         }
                     }
                 }
-            }
+            };
 
             /**********************************************************************/
-            bool expand(const size_t index, const size_t id, shared_ptr<Data_t> augData)
-            {
-                shared_ptr<Epsilon_neighbours_t> seeds=get_epsilon_neighbours(index,augData);
-                if (seeds->num_members<augData->minpts)
-                {
-                    augData->ids[index]=(int)PointType::noise;
-                    return false;
+            // Lock-free union-find where the root of each set is always
+            // its smallest element.
+            class UnionFind_t {
+                vector<atomic<size_t>> parent;
+
+            public:
+                UnionFind_t(const size_t n) : parent(n) {
+                    for (size_t i=0; i<n; i++)
+                        parent[i].store(i);
                 }
-                else
-                {
-                    augData->ids[index]=(int)id;
-                    for (shared_ptr<Node_t> h=seeds->head; h!=nullptr; h=h->next)
+
+                size_t find(size_t i) {
+                    while (true)
                     {
-                        augData->ids[h->index]=(int)id;
+                        size_t p=parent[i].load();
+                        if (p==i)
+                            return i;
+
+                        // path halving
+                        size_t gp=parent[p].load();
+                        if (gp!=p)
+                            parent[i].compare_exchange_weak(p,gp);
+                        i=gp;
                     }
-                    for (shared_ptr<Node_t> h=seeds->head; h!=nullptr; h=h->next)
+                }
+
+                void unite(size_t i, size_t j) {
+                    while (true)
                     {
-                        spread(h->index,seeds,id,augData);
+                        i=find(i);
+                        j=find(j);
+                        if (i==j)
+                            return;
+                        if (i<j)
+                            swap(i,j);
+
+                        // hook the larger root, provided it still is a root
+                        size_t expected=i;
+                        if (parent[i].compare_exchange_strong(expected,j))
+                            return;
                     }
-                    return true;
                 }
+            };
+
+            /**********************************************************************/
+            // Runs f(i) for i in [0,n) over nThreads threads, the calling
+            // one included, handing out the indexes in blocks.
+            template<typename F>
+            void parallel_for(const size_t n, const size_t nThreads, F f)
+            {
+                const size_t block=256;
+                atomic<size_t> next(0);
+                auto work=[&]() {
+                    for (size_t b=next.fetch_add(block); b<n; b=next.fetch_add(block))
+                        for (size_t i=b; i<std::min(b+block,n); i++)
+                            f(i);
+                };
+
+                deque<thread> threads;
+                for (size_t k=1; k<std::min(nThreads,(n+block-1)/block); k++)
+                    threads.push_back(thread(work));
+                work();
+                for (auto &t:threads)
+                    t.join();
             }
         }
     }
@@ -154,28 +258,78 @@ map<size_t,set<size_t>> DBSCAN::cluster(const vector<Vector> &data,
 {
     double epsilon=options.check("epsilon",Value(1.0)).asDouble();
     size_t minpts=(size_t)options.check("minpts",Value(2)).asInt();
-    shared_ptr<dbscan::Data_t> augData(new dbscan::Data_t(data,epsilon,minpts));
+    int threads=options.check("threads",Value(1)).asInt();
+    size_t nThreads=(size_t)std::max(threads,1);
 
-    size_t id=0;
-    for (size_t i=0; i<augData->points.size(); i++)
-    {
-        if (augData->ids[i]==(int)dbscan::PointType::unclassified)
+    size_t N=data.size();
+    dbscan::Grid_t grid(data,epsilon);
+
+    // core points have at least minpts neighbours
+    vector<char> core(N,0);
+    dbscan::parallel_for(N,nThreads,[&](const size_t i) {
+        size_t num=0;
+        if (minpts>0)
+            grid.for_each_neighbour(i,[&](const size_t j) { return (++num<minpts); });
+        core[i]=(num>=minpts);
+    });
+
+    // neighbouring core points belong to the same cluster
+    dbscan::UnionFind_t uf(N);
+    dbscan::parallel_for(N,nThreads,[&](const size_t i) {
+        if (core[i])
         {
-            if (dbscan::expand(i,id,augData))
-            {
-                id++;
-            }
+            grid.for_each_neighbour(i,[&](const size_t j) {
+                if (core[j] && (j<i))
+                    uf.unite(i,j);
+                return true;
+            });
         }
-    }
+    });
+
+    // a cluster is labelled by its smallest core point, which is
+    // the one the sequential algorithm starts the expansion from
+    const size_t noise=numeric_limits<size_t>::max();
+    vector<size_t> label(N,noise);
+    for (size_t i=0; i<N; i++)
+        if (core[i])
+            label[i]=uf.find(i);
+
+    // a border point is claimed by the first cluster reaching it,
+    // unless it is a direct neighbour of the starting point of a
+    // later cluster, which takes it over: the last such cluster wins
+    dbscan::parallel_for(N,nThreads,[&](const size_t i) {
+        if (!core[i])
+        {
+            size_t first=noise;
+            size_t last_start=noise;
+            grid.for_each_neighbour(i,[&](const size_t j) {
+                if (core[j])
+                {
+                    first=std::min(first,label[j]);
+                    if ((label[j]==j) && ((last_start==noise) || (j>last_start)))
+                        last_start=j;
+                }
+                return true;
+            });
+            label[i]=(last_start!=noise)?last_start:first;
+        }
+    });
+
+    // clusters are numbered in the order they are discovered
+    vector<size_t> id(N,noise);
+    size_t num_clusters=0;
+    for (size_t i=0; i<N; i++)
+        if (core[i] && (label[i]==i))
+            id[i]=num_clusters++;
 
     map<size_t,set<size_t>> clusters;
-    for (size_t i=0; i<augData->points.size(); i++)
+    for (size_t i=0; i<N; i++)
     {
-        if (augData->ids[i]!=(int)dbscan::PointType::noise)
+        if (label[i]!=noise)
         {
-            clusters[augData->ids[i]].insert(i);
+            set<size_t> &c=clusters[id[label[i]]];
+            c.insert(c.end(),i);
         }
     }
     return clusters;
 }
-
@@ -31,20 +31,32 @@ Filter::Filter(const Vector &num, const Vector &den, const Vector &y0)
     m=b.length(); n=a.length();
     yAssert((m>0)&&(n>0));
 
-    uold.insert(uold.begin(),m-1,zeros((int)y0.length()));
-    yold.insert(yold.begin(),n-1,zeros((int)y0.length()));
-
+    allocate(y0.length());
     init(y0);    
 }
 
 
+/***************************************************************************/
+void Filter::allocate(const size_t dim)
+{
+    this->dim=dim;
+    uold.assign((m-1)*dim,0.0);
+    yold.assign((n-1)*dim,0.0);
+    uhead=yhead=0;
+}
+
+
 /***************************************************************************/
 void Filter::init(const Vector &y0)
 {
     // take the last input
     // as guess for the next input
-    if (uold.size()>0)
-        init(y0,uold[0]);
+    if (m>1)
+    {
+        Vector u0(dim);
+        std::copy(uold.begin()+uhead*dim,uold.begin()+(uhead+1)*dim,u0.begin());
+        init(y0,u0);
+    }
     else    // otherwise use zero
         init(y0,zeros((int)y0.length()));    
 }
@@ -78,12 +90,15 @@ void Filter::init(const Vector &y0, const Vector &u0)
             y_init=a[0]/(a[0]-sum_a)*y;
         // if sum_a==a[0] then the filter can only be initialized to zero
     }
+
+    if (y0.length()!=dim)
+        allocate(y0.length());
     
-    for (size_t i=0; i<yold.size(); i++)
-        yold[i]=y_init;
+    for (size_t i=0; i<n-1; i++)
+        std::copy(y_init.begin(),y_init.end(),yold.begin()+i*dim);
     
-    for (size_t i=0; i<uold.size(); i++)
-        uold[i]=u_init;
+    for (size_t i=0; i<m-1; i++)
+        std::copy(u_init.begin(),u_init.end(),uold.begin()+i*dim);
 }
 
 
@@ -101,15 +116,10 @@ void Filter::setCoeffs(const Vector &num, const Vector &den)
     b=num;
     a=den;
 
-    uold.clear();
-    yold.clear();
-
     m=b.length(); n=a.length();
     yAssert((m>0)&&(n>0));
 
-    uold.insert(uold.begin(),m-1,zeros((int)y.length()));
-    yold.insert(yold.begin(),n-1,zeros((int)y.length()));
-
+    allocate(y.length());
     init(y);
 }
 
@@ -131,8 +141,20 @@ bool Filter::adjustCoeffs(const Vector &num, const Vector &den)
 /***************************************************************************/
 void Filter::getStates(deque<Vector> &u, deque<Vector> &y)
 {
-    u=uold;
-    y=yold;
+    // unroll the circular buffers, most recent samples first
+    u.assign(m-1,Vector(dim));
+    for (size_t i=0; i<m-1; i++)
+    {
+        size_t row=(uhead+i)%(m-1);
+        std::copy(uold.begin()+row*dim,uold.begin()+(row+1)*dim,u[i].begin());
+    }
+
+    y.assign(n-1,Vector(dim));
+    for (size_t i=0; i<n-1; i++)
+    {
+        size_t row=(yhead+i)%(n-1);
+        std::copy(yold.begin()+row*dim,yold.begin()+(row+1)*dim,y[i].begin());
+    }
 }
 
 
@@ -140,30 +162,170 @@ void Filter::getStates(deque<Vector> &u, deque<Vector> &y)
 const Vector& Filter::filt(const Vector &u)
 {
     yAssert(y.length()==u.length());
-    for (size_t j=0; j<y.length(); j++)
-        y[j]=b[0]*u[j];
-    
-    for (size_t i=1; i<m; i++)
-        for (size_t j=0; j<y.length(); j++)
-            y[j]+=b[i]*uold[i-1][j];
-    
-    for (size_t i=1; i<n; i++)
-        for (size_t j=0; j<y.length(); j++)
-            y[j]-=a[i]*yold[i-1][j];
+    const double *pu=u.data();
+    double *py=y.data();
+
+    for (size_t j=0; j<dim; j++)
+        py[j]=b[0]*pu[j];
     
-    for (size_t j=0; j<y.length(); j++)
-        y[j]/=a[0];
+    for (size_t i=1, row=uhead; i<m; i++)
+    {
+        const double bi=b[i];
+        const double *pold=&uold[row*dim];
+        for (size_t j=0; j<dim; j++)
+            py[j]+=bi*pold[j];
+
+        if (++row==m-1)
+            row=0;
+    }
     
-    uold.push_front(u);
-    uold.pop_back();
+    for (size_t i=1, row=yhead; i<n; i++)
+    {
+        const double ai=a[i];
+        const double *pold=&yold[row*dim];
+        for (size_t j=0; j<dim; j++)
+            py[j]-=ai*pold[j];
+
+        if (++row==n-1)
+            row=0;
+    }
     
-    yold.push_front(y);
-    yold.pop_back();
+    const double a0=a[0];
+    for (size_t j=0; j<dim; j++)
+        py[j]/=a0;
+
+    // the new samples overwrite the oldest ones,
+    // becoming the head of the circular buffers
+    if (m>1)
+    {
+        uhead=(uhead>0)?uhead-1:m-2;
+        std::copy(pu,pu+dim,uold.begin()+uhead*dim);
+    }
+
+    if (n>1)
+    {
+        yhead=(yhead>0)?yhead-1:n-2;
+        std::copy(py,py+dim,yold.begin()+yhead*dim);
+    }
     
     return y;
 }
 
 
+/***************************************************************************/
+SOSFilter::SOSFilter(const Matrix &sos, const double g, const Vector &y0)
+{
+    y=y0;
+    dim=0;
+    setCoeffs(sos,g);
+}
+
+
+/***************************************************************************/
+void SOSFilter::init(const Vector &y0)
+{
+    y=y0;
+    if (dim!=y.length())
+    {
+        dim=y.length();
+        z.assign(2*L*dim,0.0);
+        uold.assign(L*dim,0.0);
+    }
+
+    // go backward from the last section: each one is initialized
+    // as Filter::init() would do given the output it shall yield,
+    // and the input it takes is the output of the previous section
+    for (size_t j=0; j<dim; j++)
+    {
+        double v=y0[j];
+        for (int s=(int)L-1; s>=0; s--)
+        {
+            double sum_b=sos(s,0)+sos(s,1)+sos(s,2);
+            double sum_a=1.0+sos(s,4)+sos(s,5);
+            double &u=uold[s*dim+j];
+            double v_init=v;
+
+            // if the section DC gain is not zero
+            if (fabs(sum_b)>std::numeric_limits<double>::epsilon())
+                u=(sum_a/sum_b)*v;
+            // otherwise keep the last input as guess for the next input
+            else if (fabs(sum_a-1.0)>std::numeric_limits<double>::epsilon())
+                v_init=v/(1.0-sum_a);
+
+            double z2=sos(s,2)*u-sos(s,5)*v_init;
+            double z1=sos(s,1)*u-sos(s,4)*v_init+z2;
+            z[(2*s)*dim+j]=z1;
+            z[(2*s+1)*dim+j]=z2;
+            v=u;
+        }
+    }
+}
+
+
+/***************************************************************************/
+void SOSFilter::getCoeffs(Matrix &sos, double &g)
+{
+    sos=this->sos;
+    g=gain;
+}
+
+
+/***************************************************************************/
+void SOSFilter::setCoeffs(const Matrix &sos, const double g)
+{
+    yAssert((sos.rows()>0)&&(sos.cols()==6));
+    L=sos.rows();
+    gain=g;
+
+    // normalize the sections so that a0=1
+    this->sos=sos;
+    for (size_t s=0; s<L; s++)
+    {
+        double a0=sos(s,3);
+        yAssert(a0!=0.0);
+        for (size_t k=0; k<6; k++)
+            this->sos(s,k)/=a0;
+    }
+
+    dim=y.length();
+    z.assign(2*L*dim,0.0);
+    uold.assign(L*dim,0.0);
+    init(y);
+}
+
+
+/***************************************************************************/
+const Vector& SOSFilter::filt(const Vector &u)
+{
+    yAssert(y.length()==u.length());
+    const double *pu=u.data();
+    double *py=y.data();
+
+    for (size_t j=0; j<dim; j++)
+        py[j]=gain*pu[j];
+
+    // each section filters in place the output of the previous one
+    for (size_t s=0; s<L; s++)
+    {
+        const double b0=sos(s,0), b1=sos(s,1), b2=sos(s,2);
+        const double a1=sos(s,4), a2=sos(s,5);
+        double *z1=&z[(2*s)*dim];
+        double *z2=&z[(2*s+1)*dim];
+        double *us=&uold[s*dim];
+        for (size_t j=0; j<dim; j++)
+        {
+            double x=us[j]=py[j];
+            double v=b0*x+z1[j];
+            z1[j]=b1*x-a1*v+z2[j];
+            z2[j]=b2*x-a2*v;
+            py[j]=v;
+        }
+    }
+
+    return y;
+}
+
+
 /**********************************************************************/
 RateLimiter::RateLimiter(const Vector &rL, const Vector &rU) :
                          rateLowerLim(rL), rateUpperLim(rU)
@@ -306,7 +468,13 @@ void MedianFilter::init(const Vector &y0)
     yAssert(y0.length()>0);
     y=y0;
     m=y.length();
-    uold.assign(m,deque<double>());
+
+    W=n+1;
+    nLow=W-(W>>1);
+    uold.assign(m*W,0.0);
+    heap.assign(m*W,0);
+    pos.assign(m*W,0);
+    cnt=head=0;
 }
 
 
@@ -320,37 +488,144 @@ void MedianFilter::setOrder(const size_t n)
 
 
 /***************************************************************************/
-double MedianFilter::median(deque<double>& v)
+void MedianFilter::sift(const size_t i, size_t p)
 {
-    size_t L=v.size()>>1;
-    nth_element(v.begin(),v.begin()+L,v.end());
-    if (v.size()&0x01)
-        return v[L];
-    else
+    const double *v=&uold[i*W];
+    size_t *h=&heap[i*W];
+    size_t *ps=&pos[i*W];
+
+    // the max-heap lies in [0,nLow) and the min-heap in [nLow,W):
+    // the latter is handled as a max-heap of the opposite values
+    size_t off=(p<nLow)?0:nLow;
+    size_t len=(p<nLow)?nLow:W-nLow;
+    double sgn=(p<nLow)?1.0:-1.0;
+    p-=off;
+
+    // move up
+    while (p>0)
     {
-        nth_element(v.begin(),v.begin()+L-1,v.end());
-        return 0.5*(v[L]+v[L-1]);
+        size_t parent=(p-1)>>1;
+        if (sgn*v[h[off+p]]>sgn*v[h[off+parent]])
+        {
+            std::swap(h[off+p],h[off+parent]);
+            ps[h[off+p]]=off+p;
+            ps[h[off+parent]]=off+parent;
+            p=parent;
+        }
+        else
+            break;
+    }
+
+    // move down
+    while (true)
+    {
+        size_t c=(p<<1)+1;
+        if (c>=len)
+            break;
+        if ((c+1<len) && (sgn*v[h[off+c+1]]>sgn*v[h[off+c]]))
+            c++;
+
+        if (sgn*v[h[off+c]]>sgn*v[h[off+p]])
+        {
+            std::swap(h[off+p],h[off+c]);
+            ps[h[off+p]]=off+p;
+            ps[h[off+c]]=off+c;
+            p=c;
+        }
+        else
+            break;
     }
 }
 
 
+/***************************************************************************/
+void MedianFilter::build(const size_t i)
+{
+    const double *v=&uold[i*W];
+    size_t *h=&heap[i*W];
+    size_t *ps=&pos[i*W];
+
+    // a descending array is a max-heap and
+    // an ascending array is a min-heap
+    for (size_t k=0; k<W; k++)
+        h[k]=k;
+    std::sort(h,h+W,[v](const size_t a, const size_t b) { return v[a]<v[b]; });
+    std::reverse(h,h+nLow);
+
+    for (size_t k=0; k<W; k++)
+        ps[h[k]]=k;
+}
+
+
+/***************************************************************************/
+void MedianFilter::replace(const size_t i, const size_t slot, const double u)
+{
+    double *v=&uold[i*W];
+    size_t *h=&heap[i*W];
+    size_t *ps=&pos[i*W];
+
+    v[slot]=u;
+    sift(i,ps[slot]);
+
+    // the new sample may belong to the other half:
+    // exchanging the tops of the heaps fixes the order
+    if ((nLow<W) && (v[h[0]]>v[h[nLow]]))
+    {
+        std::swap(h[0],h[nLow]);
+        ps[h[0]]=0;
+        ps[h[nLow]]=nLow;
+        sift(i,0);
+        sift(i,nLow);
+    }
+}
+
+
+/***************************************************************************/
+double MedianFilter::median(const size_t i) const
+{
+    const double *v=&uold[i*W];
+    const size_t *h=&heap[i*W];
+
+    if (W&0x01)
+        return v[h[0]];
+    else
+        return 0.5*(v[h[nLow]]+v[h[0]]);
+}
+
+
 /***************************************************************************/
 const Vector& MedianFilter::filt(const Vector &u)
 {
     yAssert(y.length()==u.length());
-    for (size_t i=0; i<m; i++)
-        uold[i].push_front(u[i]);
 
-    if (uold[0].size()>n)
+    // fill up the window first
+    if (cnt<W)
     {
         for (size_t i=0; i<m; i++)
+            uold[i*W+cnt]=u[i];
+
+        if (++cnt==W)
         {
-            deque<double> tmp=uold[i];
-            y[i]=median(tmp);
-            uold[i].pop_back();
+            for (size_t i=0; i<m; i++)
+            {
+                build(i);
+                y[i]=median(i);
+            }
         }
+
+        return y;
     }
 
+    // then replace the oldest sample
+    for (size_t i=0; i<m; i++)
+    {
+        replace(i,head,u[i]);
+        y[i]=median(i);
+    }
+
+    if (++head==W)
+        head=0;
+
     return y;
 }
 
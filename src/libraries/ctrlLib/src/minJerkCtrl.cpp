@@ -10,8 +10,11 @@
 
 #include <sstream>
 #include <cmath>
+#include <limits>
+#include <algorithm>
 
 #include <yarp/os/Time.h>
+#include <yarp/os/LogStream.h>
 #include <yarp/math/Math.h>
 #include <iCub/ctrl/minJerkCtrl.h>
 
@@ -21,10 +24,199 @@ using namespace yarp::sig;
 using namespace yarp::math;
 using namespace iCub::ctrl;
 
+// number of (Ts,T) pairs whose coefficients are retained
+#define MINJERK_COEFFS_CACHE    8
+
+
+/*******************************************************************************************/
+minJerkFilterBank::minJerkFilterBank() : order(0), dim(0), head(0)
+{
+}
+
+
+/*******************************************************************************************/
+minJerkFilterBank::minJerkFilterBank(const size_t _order, const size_t _dim)
+{
+    resize(_order,_dim);
+}
+
+
+/*******************************************************************************************/
+void minJerkFilterBank::resize(const size_t _order, const size_t _dim)
+{
+    yAssert(_order>0);
+    order=_order;
+    dim=_dim;
+    head=0;
+
+    // unitary filters
+    b.assign((order+1)*dim,0.0);
+    a.assign((order+1)*dim,0.0);
+    std::fill(b.begin(),b.begin()+dim,1.0);
+    std::fill(a.begin(),a.begin()+dim,1.0);
+
+    uold.assign(order*dim,0.0);
+    yold.assign(order*dim,0.0);
+    cache.clear();
+
+    y.resize(dim,0.0);
+    y=0.0;
+}
+
+
+/*******************************************************************************************/
+void minJerkFilterBank::setCoeffs(const double *num, const double *den,
+                                  const size_t first, const size_t count)
+{
+    size_t last=(count==0)?dim:first+count;
+    yAssert(last<=dim);
+    for (size_t i=0; i<=order; i++)
+    {
+        std::fill(b.begin()+i*dim+first,b.begin()+i*dim+last,num[i]);
+        std::fill(a.begin()+i*dim+first,a.begin()+i*dim+last,den[i]);
+    }
+}
+
+
+/*******************************************************************************************/
+void minJerkFilterBank::storeCoeffs(const double Ts, const double T)
+{
+    for (deque<CoeffsSet>::iterator it=cache.begin(); it!=cache.end(); it++)
+    {
+        if ((it->Ts==Ts) && (it->T==T))
+        {
+            cache.erase(it);
+            break;
+        }
+    }
+
+    if (cache.size()>=MINJERK_COEFFS_CACHE)
+        cache.pop_back();
+
+    CoeffsSet set;
+    set.Ts=Ts;
+    set.T=T;
+    set.b=b;
+    set.a=a;
+    cache.push_front(set);
+}
+
+
+/*******************************************************************************************/
+bool minJerkFilterBank::loadCoeffs(const double Ts, const double T)
+{
+    for (deque<CoeffsSet>::iterator it=cache.begin(); it!=cache.end(); it++)
+    {
+        if ((it->Ts==Ts) && (it->T==T))
+        {
+            // copies keep the storage, hence no allocation
+            b=it->b;
+            a=it->a;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/*******************************************************************************************/
+void minJerkFilterBank::init(const double *y0, const double *u0, const size_t first,
+                             const size_t count)
+{
+    yAssert(first+count<=dim);
+    for (size_t j=first; j<first+count; j++)
+    {
+        // same steps of Filter::init(), channel by channel
+        double sum_b=0.0;
+        for (size_t i=0; i<=order; i++)
+            sum_b+=b[i*dim+j];
+
+        double sum_a=0.0;
+        for (size_t i=0; i<=order; i++)
+            sum_a+=a[i*dim+j];
+
+        double _y0=y0[j-first];
+        double u_init, y_init=_y0;
+        if (fabs(sum_b)>std::numeric_limits<double>::epsilon())
+            u_init=(sum_a/sum_b)*_y0;
+        else
+        {
+            u_init=u0[j-first];
+            if (fabs(sum_a-a[j])>std::numeric_limits<double>::epsilon())
+                y_init=a[j]/(a[j]-sum_a)*_y0;
+        }
+
+        y[j]=_y0;
+        for (size_t i=0; i<order; i++)
+        {
+            uold[i*dim+j]=u_init;
+            yold[i*dim+j]=y_init;
+        }
+    }
+}
+
+
+/*******************************************************************************************/
+void minJerkFilterBank::init(const double *y0, const size_t first, const size_t count)
+{
+    // take the last input
+    // as guess for the next input
+    init(y0,&uold[head*dim+first],first,count);
+}
+
+
+/*******************************************************************************************/
+const Vector& minJerkFilterBank::filt(const double *u)
+{
+    double *py=y.data();
+
+    // the channels run in the innermost loops over contiguous
+    // memory, in the same order of operations of Filter::filt()
+    const double *b0=&b[0];
+    for (size_t j=0; j<dim; j++)
+        py[j]=b0[j]*u[j];
+
+    for (size_t i=1, row=head; i<=order; i++)
+    {
+        const double *bi=&b[i*dim];
+        const double *pold=&uold[row*dim];
+        for (size_t j=0; j<dim; j++)
+            py[j]+=bi[j]*pold[j];
+
+        if (++row==order)
+            row=0;
+    }
+
+    for (size_t i=1, row=head; i<=order; i++)
+    {
+        const double *ai=&a[i*dim];
+        const double *pold=&yold[row*dim];
+        for (size_t j=0; j<dim; j++)
+            py[j]-=ai[j]*pold[j];
+
+        if (++row==order)
+            row=0;
+    }
+
+    const double *a0=&a[0];
+    for (size_t j=0; j<dim; j++)
+        py[j]/=a0[j];
+
+    // the new samples overwrite the oldest ones,
+    // becoming the head of the circular buffers
+    head=(head>0)?head-1:order-1;
+    std::copy(u,u+dim,uold.begin()+head*dim);
+    std::copy(py,py+dim,yold.begin()+head*dim);
+
+    return y;
+}
+
+
 
 /*******************************************************************************************/
 minJerkVelCtrlForIdealPlant::minJerkVelCtrlForIdealPlant(const double _Ts, const int _dim) :
-                                                         Ts(_Ts), dim(_dim), T(1.0), F(NULL)
+                                                         F(2,_dim), Ts(_Ts), T(1.0), dim(_dim)
 {
     computeCoeffs();
 }
@@ -33,6 +225,9 @@ minJerkVelCtrlForIdealPlant::minJerkVelCtrlForIdealPlant(const double _Ts, const
 /*******************************************************************************************/
 void minJerkVelCtrlForIdealPlant::computeCoeffs()
 {
+    if (F.loadCoeffs(Ts,T))
+        return;
+
     double T2=T*T;
     double T3=T2*T;
     double twoOnTs=2.0/Ts;
@@ -44,8 +239,8 @@ void minJerkVelCtrlForIdealPlant::computeCoeffs()
     double c=-15.9669610709384/T;
 
     // implementing F(s)=-a/(s^2-c*s-b)
-    Vector num(3);
-    Vector den(3);
+    double num[3];
+    double den[3];
 
     double c1=twoOnTs*(twoOnTs-c)-b;
     double c2=-a/c1;
@@ -58,13 +253,8 @@ void minJerkVelCtrlForIdealPlant::computeCoeffs()
     den[1]=-2.0*(twoOnTs*twoOnTs+b)/c1;
     den[2]=(twoOnTs*(twoOnTs+c)-b)/c1;
 
-    if (F==NULL)
-    {
-        Vector e0(dim); e0=0.0;
-        F=new Filter(num,den,e0);
-    }
-    else
-        F->adjustCoeffs(num,den);
+    F.setCoeffs(num,den);
+    F.storeCoeffs(Ts,T);
 }
 
 
@@ -77,36 +267,34 @@ Vector minJerkVelCtrlForIdealPlant::computeCmd(const double _T, const Vector &e)
         computeCoeffs();
     }
 
-    return F->filt(e);
+    yAssert((int)e.length()==dim);
+    return F.filt(e.data());
 }
 
 
 /*******************************************************************************************/
 void minJerkVelCtrlForIdealPlant::reset(const Vector &u0)
 {
-    F->init(u0);
+    yAssert((int)u0.length()==dim);
+    F.init(u0.data(),0,dim);
 }
 
 
 /*******************************************************************************************/
 minJerkVelCtrlForIdealPlant::~minJerkVelCtrlForIdealPlant()
 {
-    delete F;
 }
 
 
 /*******************************************************************************************/
 minJerkVelCtrlForNonIdealPlant::minJerkVelCtrlForNonIdealPlant(const double _Ts, const int _dim) :
-                                                               Ts(_Ts), dim(_dim), T(1.0)
+                                                               F(3,_dim), Ts(_Ts), T(1.0), dim(_dim)
 {
     Kp.resize(dim,1.0);
     Tz.resize(dim,0.0);
     Tw.resize(dim,0.0);
     Zeta.resize(dim,0.0);
 
-    for (int i=0; i<dim; i++)
-        F.push_back(NULL);
-
     computeCoeffs();
 }
 
@@ -114,8 +302,11 @@ minJerkVelCtrlForNonIdealPlant::minJerkVelCtrlForNonIdealPlant(const double _Ts,
 /*******************************************************************************************/
 void minJerkVelCtrlForNonIdealPlant::computeCoeffs()
 {
-    Vector num(4);
-    Vector den(4);
+    if (F.loadCoeffs(Ts,T))
+        return;
+
+    double num[4];
+    double den[4];
 
     double T2=T*T;
     double T3=T2*T;
@@ -154,14 +345,10 @@ void minJerkVelCtrlForNonIdealPlant::computeCoeffs()
         den[2]=Kp[i] * (_den_0 - _den_8 + _den_4 - _den_2 - _den_5 - _den_6);
         den[3]=Kp[i] * (_den_7 - _den_0 + _den_3 - _den_2 - _den_5 + _den_6);
 
-        if (F[i]==NULL)
-        {
-            Vector e0(1); e0=0.0;
-            F[i]=new Filter(num,den,e0);
-        }
-        else
-            F[i]->adjustCoeffs(num,den);
+        F.setCoeffs(num,den,i,1);
     }
+
+    F.storeCoeffs(Ts,T);
 }
 
 
@@ -174,27 +361,17 @@ Vector minJerkVelCtrlForNonIdealPlant::computeCmd(const double _T, const Vector
         computeCoeffs();
     }
 
-    Vector y(dim), _e(1);
-    for (int i=0; i<dim; i++)
-    {
-        _e[0]=e[i];
-        Vector _y=F[i]->filt(_e);
-        y[i]=_y[0];
-    }
-
-    return y;
+    // all the joints are advanced together
+    yAssert((int)e.length()==dim);
+    return F.filt(e.data());
 }
 
 
 /*******************************************************************************************/
 void minJerkVelCtrlForNonIdealPlant::reset(const Vector &u0)
 {
-    Vector _u0(1);
-    for (int i=0; i<dim; i++)
-    {
-        _u0[0]=u0[i];
-        F[i]->init(_u0);
-    }
+    yAssert((int)u0.length()==dim);
+    F.init(u0.data(),0,dim);
 }
 
 
@@ -233,6 +410,8 @@ void minJerkVelCtrlForNonIdealPlant::setPlantParameters(const Property &paramete
         }
     }
     
+    // the cached coefficients refer to the old parameters
+    F.clearCoeffs();
     computeCoeffs();
 }
 
@@ -262,10 +441,6 @@ void minJerkVelCtrlForNonIdealPlant::getPlantParameters(Property &parameters,
 /*******************************************************************************************/
 minJerkVelCtrlForNonIdealPlant::~minJerkVelCtrlForNonIdealPlant()
 {
-    for (size_t i=0; i<F.size(); i++)
-        delete F[i];
-
-    F.clear();
 }
 
 
@@ -273,8 +448,8 @@ minJerkVelCtrlForNonIdealPlant::~minJerkVelCtrlForNonIdealPlant()
 minJerkBaseGen::minJerkBaseGen(const unsigned int _dim, const double _Ts, const double _T)
     :dim(_dim), Ts(_Ts), T(_T)
 {
-    posFilter = velFilter = accFilter = NULL;
     pos = vel = acc = lastRef = zeros(dim);
+    in = zeros(3*dim);
 }
 
 
@@ -282,16 +457,15 @@ minJerkBaseGen::minJerkBaseGen(const unsigned int _dim, const double _Ts, const
 minJerkBaseGen::minJerkBaseGen(const Vector &y0, const double _Ts, const double _T)
     :dim((unsigned int)y0.size()), Ts(_Ts), T(_T)
 {
-    posFilter = velFilter = accFilter = NULL;
     lastRef = pos = y0;
     vel = acc = zeros(dim);
+    in = zeros(3*dim);
 }
 
 
 /*******************************************************************************************/
 minJerkBaseGen::minJerkBaseGen(const minJerkBaseGen &z)
 {
-    posFilter = velFilter = accFilter = NULL;
     pos = z.pos;
     vel = z.vel;
     acc = z.acc;
@@ -299,25 +473,20 @@ minJerkBaseGen::minJerkBaseGen(const minJerkBaseGen &z)
     T = z.T;
     Ts = z.Ts;
     dim = z.dim;
+    in = zeros(3*dim);
 }
 
 
 /*******************************************************************************************/
 minJerkBaseGen::~minJerkBaseGen()
 {
-    delete posFilter;
-    delete velFilter;
-    delete accFilter;
 }
 
 
 /*******************************************************************************************/
 minJerkBaseGen& minJerkBaseGen::operator=(const minJerkBaseGen &z)
 {
-    delete posFilter;
-    delete velFilter;
-    delete accFilter;
-    posFilter = velFilter = accFilter = NULL;
+    filters = minJerkFilterBank();
 
     pos = z.pos;
     vel = z.vel;
@@ -326,6 +495,7 @@ minJerkBaseGen& minJerkBaseGen::operator=(const minJerkBaseGen &z)
     T = z.T;
     Ts = z.Ts;
     dim = z.dim;
+    in = zeros(3*dim);
 
     return *this;
 }
@@ -337,14 +507,48 @@ void minJerkBaseGen::init(const Vector &y0)
     // save initial state y0, so that if setT() or setTs() are called afterwards
     // the vel and acc filters are initialized with the right value (i.e. y0) 
     lastRef = pos = y0; 
-    if (posFilter!=NULL)
-        posFilter->init(y0);
+    if (filters.getDim()>0)
+        initFilters(true);
+}
 
-    if (velFilter!=NULL)
-        velFilter->init(zeros(dim), y0);
 
-    if (accFilter!=NULL)
-        accFilter->init(zeros(dim), y0);
+/*******************************************************************************************/
+void minJerkBaseGen::initFilters(const bool withPos)
+{
+    yAssert(pos.length()==dim);
+    if (withPos)
+        filters.init(pos.data(),0,dim);
+
+    // init vel and acc filters to avoid spikes at the start;
+    // the inputs are overwritten at each step, hence they
+    // can provide the zero outputs
+    double *zero=in.data();
+    std::fill(zero,zero+dim,0.0);
+    filters.init(zero,pos.data(),dim,dim);
+    filters.init(zero,pos.data(),2*dim,dim);
+}
+
+
+/*******************************************************************************************/
+void minJerkBaseGen::setCoeffs(const double *posNum, const double *posDen,
+                               const double *velNum, const double *velDen,
+                               const double *accNum, const double *accDen)
+{
+    filters.setCoeffs(posNum,posDen,0,dim);
+    filters.setCoeffs(velNum,velDen,dim,dim);
+    filters.setCoeffs(accNum,accDen,2*dim,dim);
+    filters.storeCoeffs(Ts,T);
+}
+
+
+/*******************************************************************************************/
+void minJerkBaseGen::advance()
+{
+    // pos, vel and acc are computed in one go
+    const double *out=filters.filt(in.data()).data();
+    std::copy(out,out+dim,pos.data());
+    std::copy(out+dim,out+2*dim,vel.data());
+    std::copy(out+2*dim,out+3*dim,acc.data());
 }
 
 
@@ -406,56 +610,52 @@ minJerkTrajGen& minJerkTrajGen::operator=(const minJerkTrajGen &z)
 /*******************************************************************************************/
 void minJerkTrajGen::computeCoeffs()
 {
-    // 90% of steady-state value in t=T
-    // transient extinguished for t>=1.5*T
-    double a = -150.765868956161/(T*T*T);
-    double b = -84.9812819469538/(T*T);
-    double c = -15.9669610709384/T;
-
-    // implementing F(s)=-a/(s^3-c*s^2-b*s-a)
-    double m = 4.0*c*Ts;
-    double n = 2.0*b*Ts*Ts;
-    double p = a*Ts*Ts*Ts;
-    Vector num = cat(p, 3.0*p, 3.0*p, p);
-    Vector den = cat(m+n+p-8.0, -m+n+3.0*p+24.0, -m-n+3.0*p-24.0, m-n+p+8.0);
-    if (posFilter==NULL)
-        posFilter=new Filter(num,den,pos);
-    else
-        posFilter->adjustCoeffs(num,den);
-
-    // implementing F(s)=-a*s/(s^3-c*s^2-b*s-a)
-    p = 2.0*a*Ts*Ts;
-    num = cat(p, p, -p, -p);
-    if (velFilter==NULL)
-        velFilter=new Filter(num,den,vel);
-    else
-        velFilter->adjustCoeffs(num,den);
-    velFilter->init(zeros(dim), pos);  //init filter to avoid spikes at the start
-
-    // implementing F(s)=-a*s^2/(s^3-c*s^2-b*s-a)
-    p = 4.0*a*Ts;
-    num = cat(p, -p, -p, p);
-    if (accFilter==NULL)
-        accFilter=new Filter(num,den,acc);
-    else
-        accFilter->adjustCoeffs(num,den);
-    accFilter->init(zeros(dim), pos);  //init filter to avoid spikes at the start
+    bool created = (filters.getDim()==0);
+    if (created)
+        filters.resize(3,3*dim);
+
+    if (!filters.loadCoeffs(Ts,T))
+    {
+        // 90% of steady-state value in t=T
+        // transient extinguished for t>=1.5*T
+        double a = -150.765868956161/(T*T*T);
+        double b = -84.9812819469538/(T*T);
+        double c = -15.9669610709384/T;
+
+        // implementing F(s)=-a/(s^3-c*s^2-b*s-a)
+        double m = 4.0*c*Ts;
+        double n = 2.0*b*Ts*Ts;
+        double p = a*Ts*Ts*Ts;
+        double posNum[4] = {p, 3.0*p, 3.0*p, p};
+        double den[4] = {m+n+p-8.0, -m+n+3.0*p+24.0, -m-n+3.0*p-24.0, m-n+p+8.0};
+
+        // implementing F(s)=-a*s/(s^3-c*s^2-b*s-a)
+        p = 2.0*a*Ts*Ts;
+        double velNum[4] = {p, p, -p, -p};
+
+        // implementing F(s)=-a*s^2/(s^3-c*s^2-b*s-a)
+        p = 4.0*a*Ts;
+        double accNum[4] = {p, -p, -p, p};
+
+        setCoeffs(posNum,den,velNum,den,accNum,den);
+    }
+
+    initFilters(created);
 }
 
 
 /*******************************************************************************************/
 void minJerkTrajGen::computeNextValues(const Vector &yd)
 {
+    yAssert(yd.length()==dim);
     lastRef = yd;
 
-    if (posFilter!=NULL)
-        pos = posFilter->filt(yd);
-
-    if (velFilter!=NULL)
-        vel = velFilter->filt(yd);
-
-    if (accFilter!=NULL)
-        acc = accFilter->filt(yd);
+    const double *pyd = yd.data();
+    double *pin = in.data();
+    std::copy(pyd,pyd+dim,pin);
+    std::copy(pyd,pyd+dim,pin+dim);
+    std::copy(pyd,pyd+dim,pin+2*dim);
+    advance();
 }
 
 
@@ -495,65 +695,68 @@ minJerkRefGen& minJerkRefGen::operator=(const minJerkRefGen &z)
 /*******************************************************************************************/
 void minJerkRefGen::computeCoeffs()
 {
-    // 90% of steady-state value in t=T
-    // transient extinguished for t>=1.5*T
-    double a = -150.765868956161/(T*T*T);
-    double b = -84.9812819469538/(T*T);
-    double c = -15.9669610709384/T;
-
-    // implementing F(s)=-a/(s^3-c*s^2-b*s-a)
-    double m = 4.0*c*Ts;
-    double n = 2.0*b*Ts*Ts;
-    double p = a*Ts*Ts*Ts;
-    Vector num = cat(p, 3.0*p, 3.0*p, p);
-    Vector den = cat(m+n+p-8.0, -m+n+3.0*p+24.0, -m-n+3.0*p-24.0, m-n+p+8.0);
-    if (posFilter==NULL)
-        posFilter=new Filter(num,den,pos);
-    else
-        posFilter->adjustCoeffs(num,den);
+    bool created = (filters.getDim()==0);
+    if (created)
+        filters.resize(3,3*dim);
 
-    // implementing F(s)=-a/(s^2-c*s-b)
-    double twoOnTs=2.0/Ts;
-    double c1=twoOnTs*(twoOnTs-c)-b;
-    double c2=-a/c1;
-    num = cat(c2, 2.0*c2, c2);
-    den = cat(1.0, -2.0*(twoOnTs*twoOnTs+b)/c1, (twoOnTs*(twoOnTs+c)-b)/c1);
-    if (velFilter==NULL)
-        velFilter = new Filter(num,den,zeros(dim));
-    else
-        velFilter->adjustCoeffs(num,den);
-    velFilter->init(zeros(dim), pos);       //init filter to avoid spikes at the start
+    if (!filters.loadCoeffs(Ts,T))
+    {
+        // 90% of steady-state value in t=T
+        // transient extinguished for t>=1.5*T
+        double a = -150.765868956161/(T*T*T);
+        double b = -84.9812819469538/(T*T);
+        double c = -15.9669610709384/T;
+
+        // implementing F(s)=-a/(s^3-c*s^2-b*s-a)
+        double m = 4.0*c*Ts;
+        double n = 2.0*b*Ts*Ts;
+        double p = a*Ts*Ts*Ts;
+        double posNum[4] = {p, 3.0*p, 3.0*p, p};
+        double posDen[4] = {m+n+p-8.0, -m+n+3.0*p+24.0, -m-n+3.0*p-24.0, m-n+p+8.0};
+
+        // vel and acc filters are of 2nd order: the last taps
+        // are null so that all the filters share the same order
+
+        // implementing F(s)=-a/(s^2-c*s-b)
+        double twoOnTs=2.0/Ts;
+        double c1=twoOnTs*(twoOnTs-c)-b;
+        double c2=-a/c1;
+        double velNum[4] = {c2, 2.0*c2, c2, 0.0};
+        double velDen[4] = {1.0, -2.0*(twoOnTs*twoOnTs+b)/c1, (twoOnTs*(twoOnTs+c)-b)/c1, 0.0};
+
+        // implementing F(s)=-a*s/(s^2-c*s-b)
+        m = 2.0*c*Ts;
+        n = b*Ts*Ts;
+        p = 2.0*a*Ts;
+        double accNum[4] = {-p, 0.0, p, 0.0};
+        double accDen[4] = {4.0-m-n, -8.0+m-2.0*n, 4.0-n, 0.0};
+
+        setCoeffs(posNum,posDen,velNum,velDen,accNum,accDen);
+    }
 
-    // implementing F(s)=-a*s/(s^2-c*s-b)
-    m = 2.0*c*Ts;
-    n = b*Ts*Ts;
-    p = 2.0*a*Ts;
-    num = cat(-p, 0.0, p);
-    den = cat(4.0-m-n, -8.0+m-2.0*n, 4.0-n);
-    if (accFilter==NULL)
-        accFilter=new Filter(num,den,acc);
-    else
-        accFilter->adjustCoeffs(num,den);
-    accFilter->init(zeros(dim), pos);       //init filter to avoid spikes at the start
+    initFilters(created);
 }
 
 
 /*******************************************************************************************/
 void minJerkRefGen::computeNextValues(const yarp::sig::Vector &y)
 {
-    if (posFilter!=NULL)
-        pos = posFilter->filt(lastRef);
+    yAssert(y.length()==dim);
+
+    // pos is driven by lastRef, vel and acc by the distance lastRef-y
+    const double *pref = lastRef.data();
+    const double *py = y.data();
+    double *pin = in.data();
+    std::copy(pref,pref+dim,pin);
+    for (unsigned int i=0; i<dim; i++)
+        pin[dim+i] = pin[2*dim+i] = pref[i]-py[i];
+
+    advance();
     
     // rotate pos around lastRef so that it lies along the distance y-lastRef
     /*double n = yarp::math::norm(y-lastRef);
     if(n!=0.0)
         pos = lastRef + yarp::math::norm(pos-lastRef)*(y-lastRef)/n;*/
-
-    if (velFilter!=NULL)
-        vel = velFilter->filt(lastRef-y);
-
-    if (accFilter!=NULL)
-        acc = accFilter->filt(lastRef-y);
 }
 
 
@@ -10,11 +10,18 @@
 
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <cstdint>
 #include <cmath>
 
+#include <yarp/os/LogStream.h>
 #include <yarp/math/Math.h>
 #include <iCub/ctrl/neuralNetworks.h>
 
+#define FF2LAYNN_BLOCK      64
+
 using namespace std;
 using namespace yarp::os;
 using namespace yarp::sig;
@@ -256,6 +263,115 @@ Vector ff2LayNN::predict(const Vector &x) const
 }
 
 
+/***************************************************************************/
+Matrix ff2LayNN::predict(const Matrix &x) const
+{
+    if (!configured)
+        return Matrix();
+
+    const size_t numIn=inMinX.length();
+    const size_t numHidden=IW.size();
+    const size_t numOut=LW.size();
+    yAssert(x.cols()==numIn);
+
+    // transposed contiguous copies of the weights: the inner loops
+    // then run over independent nodes and can be vectorized
+    vector<double> IWt(numIn*numHidden),LWt(numHidden*numOut);
+    for (size_t i=0; i<numHidden; i++)
+        for (size_t j=0; j<numIn; j++)
+            IWt[j*numHidden+i]=IW[i][j];
+    for (size_t i=0; i<numOut; i++)
+        for (size_t j=0; j<numHidden; j++)
+            LWt[j*numOut+i]=LW[i][j];
+
+    vector<double> x1(FF2LAYNN_BLOCK*numIn);
+    vector<double> n1(FF2LAYNN_BLOCK*numHidden);
+    vector<double> n2(FF2LAYNN_BLOCK*numOut);
+
+    Matrix y(x.rows(),numOut);
+    for (size_t r0=0; r0<x.rows(); r0+=FF2LAYNN_BLOCK)
+    {
+        size_t rows=std::min((size_t)FF2LAYNN_BLOCK,x.rows()-r0);
+
+        // input preprocessing
+        for (size_t r=0; r<rows; r++)
+        {
+            const double *xr=x[r0+r];
+            double *x1r=&x1[r*numIn];
+            for (size_t j=0; j<numIn; j++)
+                x1r[j]=inRatio[j]*(xr[j]-inMinX[j])+inMinY[j];
+        }
+
+        // compute the output a1 of hidden layer
+        for (size_t r=0; r<rows; r++)
+        {
+            const double *x1r=&x1[r*numIn];
+            double *n1r=&n1[r*numHidden];
+            std::fill(n1r,n1r+numHidden,0.0);
+            for (size_t j=0; j<numIn; j++)
+            {
+                const double xj=x1r[j];
+                const double *w=&IWt[j*numHidden];
+                for (size_t i=0; i<numHidden; i++)
+                    n1r[i]+=w[i]*xj;
+            }
+            const double *b=b1.data();
+            for (size_t i=0; i<numHidden; i++)
+                n1r[i]+=b[i];
+        }
+        hiddenLayerFcnBlock(n1.data(),rows*numHidden);
+
+        // compute the output a2 of the network
+        for (size_t r=0; r<rows; r++)
+        {
+            const double *a1r=&n1[r*numHidden];
+            double *n2r=&n2[r*numOut];
+            std::fill(n2r,n2r+numOut,0.0);
+            for (size_t j=0; j<numHidden; j++)
+            {
+                const double aj=a1r[j];
+                const double *w=&LWt[j*numOut];
+                for (size_t i=0; i<numOut; i++)
+                    n2r[i]+=w[i]*aj;
+            }
+            const double *b=b2.data();
+            for (size_t i=0; i<numOut; i++)
+                n2r[i]+=b[i];
+        }
+        outputLayerFcnBlock(n2.data(),rows*numOut);
+
+        // output postprocessing
+        for (size_t r=0; r<rows; r++)
+        {
+            const double *a2r=&n2[r*numOut];
+            double *yr=y[r0+r];
+            for (size_t i=0; i<numOut; i++)
+                yr[i]=outRatio[i]*(a2r[i]-outMinY[i])+outMinX[i];
+        }
+    }
+
+    return y;
+}
+
+
+/***************************************************************************/
+void ff2LayNN::hiddenLayerFcnBlock(double *x, const size_t n) const
+{
+    Vector v(n,x);
+    v=hiddenLayerFcn(v);
+    std::copy(v.data(),v.data()+n,x);
+}
+
+
+/***************************************************************************/
+void ff2LayNN::outputLayerFcnBlock(double *x, const size_t n) const
+{
+    Vector v(n,x);
+    v=outputLayerFcn(v);
+    std::copy(v.data(),v.data()+n,x);
+}
+
+
 /***************************************************************************/
 bool ff2LayNN::getStructure(Property &options) const
 {
@@ -381,6 +497,62 @@ Vector ff2LayNN_tansig_purelin::hiddenLayerFcn(const Vector &x) const
 }
 
 
+/***************************************************************************/
+void ff2LayNN_tansig_purelin::hiddenLayerFcnBlock(double *x, const size_t n) const
+{
+    // t=-2*x is clamped where tansig is already saturated to +/-1;
+    // this is kept apart since comparisons prevent the vectorization
+    for (size_t i=0; i<n; i++)
+        x[i]=std::min(std::max(-2.0*x[i],-700.0),700.0);
+
+    // the exponential is computed without branches, so that the loop
+    // can be vectorized: exp(t)=2^k*exp(r), with t=k*ln(2)+r, |r|<=ln(2)/2,
+    // and exp(r) expanded up to the 13th order (error below 1e-17)
+    const double round=6755399441055744.0;  // 1.5*2^52
+    const double log2e=1.4426950408889634;
+    const double ln2_hi=6.93145751953125e-1;
+    const double ln2_lo=1.42860682030941723212e-6;
+    for (size_t i=0; i<n; i++)
+    {
+        double t=x[i];
+        double kr=t*log2e+round;
+        double k=kr-round;
+        double r=(t-k*ln2_hi)-k*ln2_lo;
+
+        double p=1.0/6227020800.0;
+        p=p*r+1.0/479001600.0;
+        p=p*r+1.0/39916800.0;
+        p=p*r+1.0/3628800.0;
+        p=p*r+1.0/362880.0;
+        p=p*r+1.0/40320.0;
+        p=p*r+1.0/5040.0;
+        p=p*r+1.0/720.0;
+        p=p*r+1.0/120.0;
+        p=p*r+1.0/24.0;
+        p=p*r+1.0/6.0;
+        p=p*r+0.5;
+        p=p*r+1.0;
+        p=p*r+1.0;
+
+        // 2^k is built directly from the integer sitting in the
+        // lowest bits of kr
+        uint64_t bits;
+        std::memcpy(&bits,&kr,sizeof(bits));
+        bits=(bits+1023)<<52;
+        double scale;
+        std::memcpy(&scale,&bits,sizeof(scale));
+
+        x[i]=2.0/(1.0+p*scale)-1.0;
+    }
+}
+
+
+/***************************************************************************/
+void ff2LayNN_tansig_purelin::outputLayerFcnBlock(double *x, const size_t n) const
+{
+}
+
+
 /***************************************************************************/
 Vector ff2LayNN_tansig_purelin::outputLayerFcn(const Vector &x) const
 {
@@ -1104,6 +1104,24 @@ public:
     */
     yarp::sig::Matrix computeMassMatrix(const yarp::sig::Vector& q);
 
+    /**
+    * Compute the joint space mass matrix considering only the active joints
+    * by means of the Composite Rigid Body Algorithm. 
+    * The complexity is O(DOF^2) and, unlike computeMassMatrix(), the joint 
+    * velocities and accelerations of the chain are left untouched.
+    * @return a DOF-by-DOF symmetric positive-definite matrix
+    * @note As in computeMassMatrix(), the inertia of the motors is neglected.
+    */
+    yarp::sig::Matrix computeMassMatrixCRBA();
+
+    /**
+    * Compute the joint space mass matrix considering only the active joints
+    * by means of the Composite Rigid Body Algorithm. 
+    * @param q vector of the active joint positions
+    * @return a DOF-by-DOF symmetric positive-definite matrix
+    */
+    yarp::sig::Matrix computeMassMatrixCRBA(const yarp::sig::Vector& q);
+
     /**
     * Compute the torques due to centrifugal and coriolis effects considering only the active joints.
     * @return a DOF-dim vector
@@ -1154,6 +1172,109 @@ public:
     yarp::sig::Vector computeCcGravityTorques(const yarp::sig::Vector& ddp0, const yarp::sig::Vector& q, const yarp::sig::Vector& dq);
 
 
+    //---------------------------
+    // Forward Dynamics
+    //---------------------------
+
+    /**
+    * Compute the joint accelerations produced by the given joint torques by means of the
+    * Articulated Body Algorithm, considering only the active joints; the blocked links are
+    * treated as rigidly attached to their parents. The complexity is O(N) and the current
+    * joint positions and velocities are used.
+    * @param tau vector of the active joint torques
+    * @param w0 the angular velocity of the base
+    * @param dw0 the angular acceleration of the base
+    * @param ddp0 the linear acceleration of the base, including the term equal and opposite to gravity
+    * @param Fend the force exerted by the end-effector on the environment
+    * @param Muend the moment exerted by the end-effector on the environment
+    * @return a DOF-dim vector (all zeros if the sizes of the inputs are wrong)
+    * @note The base and end-effector quantities are expressed as in computeNewtonEuler() with the
+    *       kinematics propagated forward from the base, so that feeding back the returned accelerations
+    *       to the Newton-Euler yields tau. The inertia of the motors is neglected and the joint 
+    *       accelerations of the chain are left untouched.
+    */
+    yarp::sig::Vector computeForwardDynamics(const yarp::sig::Vector &tau, const yarp::sig::Vector &w0, const yarp::sig::Vector &dw0,
+                                             const yarp::sig::Vector &ddp0, const yarp::sig::Vector &Fend, const yarp::sig::Vector &Muend);
+
+    /**
+    * Compute the joint accelerations produced by the given joint torques by means of the
+    * Articulated Body Algorithm, considering only the active joints.
+    * @param q vector of the active joint positions
+    * @param dq vector of the active joint velocities
+    * @param tau vector of the active joint torques
+    * @param w0 the angular velocity of the base
+    * @param dw0 the angular acceleration of the base
+    * @param ddp0 the linear acceleration of the base, including the term equal and opposite to gravity
+    * @param Fend the force exerted by the end-effector on the environment
+    * @param Muend the moment exerted by the end-effector on the environment
+    * @return a DOF-dim vector
+    */
+    yarp::sig::Vector computeForwardDynamics(const yarp::sig::Vector &q, const yarp::sig::Vector &dq, const yarp::sig::Vector &tau,
+                                             const yarp::sig::Vector &w0, const yarp::sig::Vector &dw0, const yarp::sig::Vector &ddp0,
+                                             const yarp::sig::Vector &Fend, const yarp::sig::Vector &Muend);
+
+    /**
+    * Compute the joint accelerations produced by the given joint torques by means of the
+    * Articulated Body Algorithm, considering only the active joints, a fixed base and no 
+    * wrench at the end-effector.
+    * @param q vector of the active joint positions
+    * @param dq vector of the active joint velocities
+    * @param tau vector of the active joint torques
+    * @param ddp0 a vector that is equal and opposite to gravity expressed in the base reference frame (not the 0th frame)
+    * @return a DOF-dim vector
+    */
+    yarp::sig::Vector computeForwardDynamics(const yarp::sig::Vector &q, const yarp::sig::Vector &dq, const yarp::sig::Vector &tau,
+                                             const yarp::sig::Vector &ddp0);
+
+
+    //---------------------------
+    // Dynamic Regressor
+    //---------------------------
+
+    /**
+    * Retrieve the dynamic parameters of all the links of the chain, which the joint torques
+    * depend linearly on. For each link the 10 parameters are, in the order:
+    * the mass m, the first moment of mass m*rC (3), the inertia about the link origin 
+    * Ixx, Ixy, Ixz, Iyy, Iyz, Izz, all expressed in the link frame.
+    * @return a 10N-dim vector
+    */
+    yarp::sig::Vector getDynamicParameters() const;
+
+    /**
+    * Set the dynamic parameters of all the links of the chain, as returned by getDynamicParameters().
+    * The COM is set without rotation and the inertia is moved back about the COM.
+    * @param pi the 10N-dim vector of the parameters
+    * @return true if succeeded, false otherwise (e.g. wrong size, a link with negative mass or
+    *         a link with zero mass and non-zero first moment)
+    */
+    bool setDynamicParameters(const yarp::sig::Vector &pi);
+
+    /**
+    * Compute the dynamic regressor Y of the active joints, such that the joint torques provided 
+    * by the Newton-Euler with no wrench at the end-effector are tau = Y*pi, being pi the vector
+    * returned by getDynamicParameters(). The current joint positions, velocities and accelerations 
+    * are used. The complexity is O(N^2).
+    * @param w0 the angular velocity of the base
+    * @param dw0 the angular acceleration of the base
+    * @param ddp0 the linear acceleration of the base, including the term equal and opposite to gravity
+    * @return a DOF-by-10N matrix (empty if the sizes of the inputs are wrong)
+    * @note The base quantities are expressed as in computeNewtonEuler() with the kinematics 
+    *       propagated forward from the base. The inertia of the motors is neglected.
+    */
+    yarp::sig::Matrix computeRegressor(const yarp::sig::Vector &w0, const yarp::sig::Vector &dw0, const yarp::sig::Vector &ddp0);
+
+    /**
+    * Compute the dynamic regressor Y of the active joints, for a fixed base.
+    * @param q vector of the active joint positions
+    * @param dq vector of the active joint velocities
+    * @param ddq vector of the active joint accelerations
+    * @param ddp0 a vector that is equal and opposite to gravity expressed in the base reference frame (not the 0th frame)
+    * @return a DOF-by-10N matrix
+    */
+    yarp::sig::Matrix computeRegressor(const yarp::sig::Vector &q, const yarp::sig::Vector &dq, const yarp::sig::Vector &ddq,
+                                       const yarp::sig::Vector &ddp0);
+
+
 
 };
 
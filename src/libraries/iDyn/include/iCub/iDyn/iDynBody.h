@@ -54,6 +54,11 @@
 #include <iCub/iDyn/iDynContact.h>
 #include <deque>
 #include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 
 
 namespace iCub
@@ -121,6 +126,58 @@ struct version_tag
 
 //enum partEnum{ LEFT_ARM=0, RIGHT_ARM, LEFT_LEG, RIGHT_LEG, TORSO, HEAD, ALL }; 
 
+/**
+* \ingroup iDynBody
+*
+* A persistent pool of threads for processing independent limbs concurrently. 
+* The thread calling run() takes part in the processing as well, hence a pool 
+* with N threads spawns N-1 workers, which stay asleep between two batches.
+*/
+class iDynWorkerPool
+{
+protected:
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::mutex mtx_run;
+    std::condition_variable cv_work;
+    std::condition_variable cv_done;
+    std::vector<std::function<void()> > *tasks;
+    size_t next;
+    size_t pending;
+    bool closing;
+
+    void loop();
+
+    // not copyable
+    iDynWorkerPool(const iDynWorkerPool&);
+    iDynWorkerPool &operator=(const iDynWorkerPool&);
+
+public:
+    /**
+    * Constructor
+    * @param nThreads the number of threads processing a batch, including the 
+    *                 calling one (0 selects the number of hardware threads)
+    */
+    iDynWorkerPool(const unsigned int nThreads=0);
+
+    /**
+    * Destructor: wakes up and joins the workers
+    */
+    ~iDynWorkerPool();
+
+    /**
+    * @return the number of threads processing a batch, including the calling one
+    */
+    unsigned int getNumThreads() const { return (unsigned int)workers.size()+1; }
+
+    /**
+    * Execute a batch of independent tasks and wait for their completion. 
+    * Batches coming from different threads are serialized.
+    * @param _tasks the list of tasks
+    */
+    void run(std::vector<std::function<void()> > &_tasks);
+};
+
 /**
 * \ingroup iDynBody
 *
@@ -558,12 +615,21 @@ protected:
     yarp::sig::Vector COM;  
     /// total mass of the node
     double mass;
+    /// the pool processing the limbs concurrently (NULL for serial processing)
+    iDynWorkerPool *pool;
 
     /**
     * Reset all data to zero. The list of limbs is not modified or deleted.
     */
     void zero();
 
+    /**
+    * Execute tasks dealing with distinct limbs, either concurrently through the
+    * worker pool or serially in the given order.
+    * @param tasks the list of tasks
+    */
+    void runLimbTasks(std::vector<std::function<void()> > &tasks);
+
     /**
     * Compute Pn and H_A_Node matrices given two chains. This function is private, and
     * is used by computeJacobian() and computePose() to merely avoid code duplication.
@@ -629,6 +695,21 @@ public:
     */
     virtual void addLimb(iDyn::iDynLimb *limb, const yarp::sig::Matrix &H, const FlowType kinFlow=RBT_NODE_OUT, const FlowType wreFlow=RBT_NODE_IN, bool hasSensor=false);
 
+    /**
+    * Select the pool of workers used to solve the kinematics and the wrenches of
+    * the limbs that do not depend on each other. Results do not depend on the 
+    * number of threads, since the contributions of the limbs to the node are
+    * summed up always in the same order.
+    * @param _pool the pool, which is not owned by the node (NULL restores the
+    *              serial processing)
+    */
+    void setWorkerPool(iDynWorkerPool *_pool) { pool=_pool; }
+
+    /**
+    * @return the pool of workers in use (NULL for serial processing)
+    */
+    iDynWorkerPool *getWorkerPool() const { return pool; }
+
     /**
     * Return the RBT matrix of a certain limb attached to the node.
     * @param iLimb the index of the limb - the index is the number of insertion of the limb in the node
@@ -1475,6 +1556,8 @@ protected:
     /// defining the connection between Upper and Lower Torso
     RigidBodyTransformation * rbt;
     version_tag tag;
+    /// the pool shared by the nodes in parallel mode
+    iDynWorkerPool * pool;
 
 public:
 
@@ -1492,6 +1575,9 @@ public:
     yarp::sig::Vector lower_COM;
     yarp::sig::Matrix COM_Jacob;
     double sw_getcom;
+    /// results of the last computeCOMjacobian(): COM jacobian (3x32) and centroidal momentum matrix (6x32)
+    yarp::sig::Matrix COM_jacobian;
+    yarp::sig::Matrix centroidal_momentum_matrix;
     /**
     * Constructor: build the nodes and creates the whole body
     * @param mode the computation mode: DYNAMIC/STATIC/DYNAMIC_W_ROTOR/DYNAMIC_CORIOLIS_GRAVITY
@@ -1504,6 +1590,21 @@ public:
     */
     ~iCubWholeBody();
 
+    /**
+    * Enable or disable the parallel mode, where the limbs of each node are solved 
+    * concurrently by a persistent pool of workers, once the wrench and kinematics 
+    * information they depend on are available. Results are identical to the serial mode.
+    * @param enable true to enable the parallel mode
+    * @param nThreads the number of threads, including the calling one (0 selects
+    *                 as many threads as the limbs of a node, within the hardware limits)
+    */
+    void setParallelMode(const bool enable, const unsigned int nThreads=0);
+
+    /**
+    * @return true if the parallel mode is enabled
+    */
+    bool getParallelMode() const { return (pool!=NULL); }
+
     /**
     * Connect upper and lower torso: this procedure handles the exchange of kinematic and
     * wrench variables between the two parts.
@@ -1560,6 +1661,31 @@ public:
     * @return true if succeeds, false otherwise
     */
     bool EXPERIMENTAL_getCOMvelocity(iCub::skinDynLib::BodyPart which_part, yarp::sig::Vector &vel, yarp::sig::Vector &dq);
+
+    /**
+    * Performs the computation of the jacobian of the whole-body center of mass and of the
+    * centroidal momentum matrix, in a single sweep over the kinematic tree. Both matrices are
+    * expressed in the root reference frame, i.e. the lower torso node, and refer to the joints
+    * ordered as in getAllPositions(). The link transformations are those cached by the chains,
+    * which are already up to date after solveKinematics().
+    * @return true if succeeds, false otherwise
+    */
+    bool computeCOMjacobian();
+
+    /**
+    * Retrieves the jacobian of the whole-body COM from the last computeCOMjacobian()
+    * @param jac the 3x32 matrix mapping the joints velocities onto the COM velocity
+    * @return true if succeeds, false otherwise
+    */
+    bool getCOMjacobian(yarp::sig::Matrix &jac) const;
+
+    /**
+    * Retrieves the centroidal momentum matrix from the last computeCOMjacobian()
+    * @param cmm the 6x32 matrix mapping the joints velocities onto the linear momentum (first 
+    *            three rows) and the angular momentum about the COM (last three rows) of the robot
+    * @return true if succeeds, false otherwise
+    */
+    bool getCentroidalMomentumMatrix(yarp::sig::Matrix &cmm) const;
 };
 
 
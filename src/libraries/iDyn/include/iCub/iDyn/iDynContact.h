@@ -59,10 +59,26 @@ protected:
     // body part related to this solver
     iCub::skinDynLib::BodyPart      bodyPart;
 
+    /// factorization of the contact matrix A, reused as long as A does not change
+    enum FactorizationType { FACT_NONE, FACT_QR, FACT_PINV };
+    FactorizationType factType;
+    /// contact matrix the factorization refers to
+    yarp::sig::Matrix factA;
+    /// pseudo-inverse of A, from the QR factorization (FACT_QR) or the SVD (FACT_PINV)
+    yarp::sig::Matrix factPinv;
+
     void findContactSubChain(unsigned int &firstLink, unsigned int &lastLink);
     
     yarp::sig::Matrix buildA(unsigned int firstContactLink, unsigned int lastContactLink);
     yarp::sig::Vector buildB(unsigned int firstContactLink, unsigned int lastContactLink);
+
+    /**
+     * Solve the system AX=B in the least-squares (minimum-norm) sense, refactorizing A only if it 
+     * differs from the one of the previous call. A full rank A is factorized by QR with column 
+     * pivoting of either A or A', otherwise (smallest singular value possibly below TOLLERANCE) 
+     * its pseudo-inverse is computed through the SVD.
+     */
+    yarp::sig::Vector solveContactSystem(const yarp::sig::Matrix &A, const yarp::sig::Vector &B);
     
     //***************************************************************************************
     // UTILITY METHODS
@@ -136,6 +152,12 @@ public:
      */
     void clearContactList();
 
+    /**
+     * Discard the factorization of the contact matrix, which is otherwise kept until 
+     * the contacts geometry changes.
+     */
+    void resetFactorization();
+
     /**
      * Compute an estimate of the external contact wrenches.
      * @param FMsens the wrench measured by the F/T sensor
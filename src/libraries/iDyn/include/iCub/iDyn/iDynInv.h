@@ -48,6 +48,7 @@
 #include <iCub/ctrl/math.h>
 #include <iCub/iKin/iKinFwd.h>
 #include <iCub/iDyn/iDyn.h>
+#include <iCub/iDyn/iDynSpatial.h>
 #include <iCub/skinDynLib/common.h>
 #include <deque>
 #include <string>
@@ -108,6 +109,15 @@ protected:
     yarp::sig::Vector zm;   
     ///the corresponding iDynLink 
     iDyn::iDynLink *link;   
+    ///buffer to pass fixed-size results to the set methods without allocating memory
+    yarp::sig::Vector buf3;
+
+    /**
+    * Copy a fixed-size vector into the internal buffer.
+    * @param v the vector
+    * @return a reference to the buffer, valid until the next call
+    */
+    const yarp::sig::Vector &toYarp(const spatial::Vec3 &v);
 
     //~~~~~~~~~~~~~~~~~~~~~~
     //   set methods  
@@ -248,6 +258,20 @@ protected:
      */
      void computeMomentForward( OneLinkNewtonEuler *prev);
 
+    /**
+     * [Backward Newton-Euler] compute force and moment from the following link, without setting them
+      * @param next the OneLinkNewtonEuler class of the following link
+      * @return the wrench expressed in the frame of the link
+     */
+     spatial::ForceVector computeWrenchBackward( OneLinkNewtonEuler *next);
+
+    /**
+     * [Inverse Newton-Euler] compute force and moment from the previous link, without setting them
+      * @param prev the OneLinkNewtonEuler class of the previous link
+      * @return the wrench expressed in the frame of the link
+     */
+     spatial::ForceVector computeWrenchForward( OneLinkNewtonEuler *prev);
+
 
 public:
 
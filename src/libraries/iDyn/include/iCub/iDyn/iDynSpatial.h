@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-3-Clause license. See the accompanying LICENSE file for details.
+*/
+
+/**
+ * \defgroup iDynSpatial iDynSpatial
+ *
+ * @ingroup iDyn
+ *
+ * Fixed-size 3D and 6D (spatial) algebra used internally by the
+ * Newton-Euler recursion.
+ *
+ * All the types live on the stack and all the operations are
+ * inline, so that the recursion does not allocate memory; the
+ * conversion from and to yarp::sig::Vector and yarp::sig::Matrix
+ * takes place only at the boundary with the public API.
+ */
+
+#ifndef __IDYNSPATIAL_H__
+#define __IDYNSPATIAL_H__
+
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+namespace iCub
+{
+
+namespace iDyn
+{
+
+namespace spatial
+{
+
+/**
+* \ingroup iDynSpatial
+*
+* A 3D vector.
+*/
+struct Vec3
+{
+    double v[3];
+
+    Vec3() { v[0]=v[1]=v[2]=0.0; }
+    Vec3(const double x, const double y, const double z) { v[0]=x; v[1]=y; v[2]=z; }
+
+    /**
+    * Load from the first 3 components of a yarp vector.
+    */
+    explicit Vec3(const yarp::sig::Vector &y) { const double *d=y.data(); v[0]=d[0]; v[1]=d[1]; v[2]=d[2]; }
+
+    /**
+    * Store into a yarp vector, which is resized only if needed.
+    */
+    void store(yarp::sig::Vector &y) const
+    {
+        if (y.length()!=3)
+            y.resize(3);
+        double *d=y.data();
+        d[0]=v[0]; d[1]=v[1]; d[2]=v[2];
+    }
+
+    double &operator[](const int i)       { return v[i]; }
+    double  operator[](const int i) const { return v[i]; }
+
+    Vec3 &operator+=(const Vec3 &b) { v[0]+=b.v[0]; v[1]+=b.v[1]; v[2]+=b.v[2]; return *this; }
+    Vec3 &operator-=(const Vec3 &b) { v[0]-=b.v[0]; v[1]-=b.v[1]; v[2]-=b.v[2]; return *this; }
+    Vec3 &operator*=(const double s) { v[0]*=s; v[1]*=s; v[2]*=s; return *this; }
+};
+
+inline Vec3 operator+(const Vec3 &a, const Vec3 &b) { return Vec3(a.v[0]+b.v[0],a.v[1]+b.v[1],a.v[2]+b.v[2]); }
+inline Vec3 operator-(const Vec3 &a, const Vec3 &b) { return Vec3(a.v[0]-b.v[0],a.v[1]-b.v[1],a.v[2]-b.v[2]); }
+inline Vec3 operator*(const double s, const Vec3 &a) { return Vec3(s*a.v[0],s*a.v[1],s*a.v[2]); }
+
+inline double dot(const Vec3 &a, const Vec3 &b)
+{
+    return a.v[0]*b.v[0]+a.v[1]*b.v[1]+a.v[2]*b.v[2];
+}
+
+inline Vec3 cross(const Vec3 &a, const Vec3 &b)
+{
+    return Vec3(a.v[1]*b.v[2]-a.v[2]*b.v[1],
+                a.v[2]*b.v[0]-a.v[0]*b.v[2],
+                a.v[0]*b.v[1]-a.v[1]*b.v[0]);
+}
+
+/**
+* \ingroup iDynSpatial
+*
+* A 3x3 matrix stored by rows, used for rotations and inertias.
+*/
+struct Mat3
+{
+    double m[9];
+
+    Mat3() { for (int i=0; i<9; i++) m[i]=0.0; }
+
+    /**
+    * Load from the upper-left 3x3 block of a yarp matrix (e.g. a
+    * rotation or a roto-translation).
+    */
+    explicit Mat3(const yarp::sig::Matrix &y)
+    {
+        for (int r=0; r<3; r++)
+        {
+            const double *row=y[r];
+            m[3*r]=row[0]; m[3*r+1]=row[1]; m[3*r+2]=row[2];
+        }
+    }
+
+    double operator()(const int r, const int c) const { return m[3*r+c]; }
+
+    /**
+    * Returns M*a.
+    */
+    Vec3 operator*(const Vec3 &a) const
+    {
+        return Vec3(m[0]*a.v[0]+m[1]*a.v[1]+m[2]*a.v[2],
+                    m[3]*a.v[0]+m[4]*a.v[1]+m[5]*a.v[2],
+                    m[6]*a.v[0]+m[7]*a.v[1]+m[8]*a.v[2]);
+    }
+
+    /**
+    * Returns M'*a, i.e. a*M.
+    */
+    Vec3 transposedTimes(const Vec3 &a) const
+    {
+        return Vec3(m[0]*a.v[0]+m[3]*a.v[1]+m[6]*a.v[2],
+                    m[1]*a.v[0]+m[4]*a.v[1]+m[7]*a.v[2],
+                    m[2]*a.v[0]+m[5]*a.v[1]+m[8]*a.v[2]);
+    }
+};
+
+/**
+* \ingroup iDynSpatial
+*
+* A 6D motion vector: angular and linear components, both
+* expressed in the same frame.
+*/
+struct MotionVector
+{
+    Vec3 ang;
+    Vec3 lin;
+
+    MotionVector() { }
+    MotionVector(const Vec3 &_ang, const Vec3 &_lin) : ang(_ang), lin(_lin) { }
+
+    /**
+    * Rotate both components by R'.
+    */
+    MotionVector rotateTransposed(const Mat3 &R) const { return MotionVector(R.transposedTimes(ang),R.transposedTimes(lin)); }
+
+    /**
+    * Given the angular and linear accelerations of a rigid body at
+    * a point, returns the linear acceleration of the point displaced
+    * by r.
+    * @param w the angular velocity of the body.
+    * @param r the displacement.
+    */
+    Vec3 shiftAcc(const Vec3 &w, const Vec3 &r) const { return lin+cross(ang,r)+cross(w,cross(w,r)); }
+};
+
+/**
+* \ingroup iDynSpatial
+*
+* A 6D force vector: force and moment, both expressed in the same
+* frame.
+*/
+struct ForceVector
+{
+    Vec3 f;
+    Vec3 mu;
+
+    ForceVector() { }
+    ForceVector(const Vec3 &_f, const Vec3 &_mu) : f(_f), mu(_mu) { }
+
+    /**
+    * Rotate both components by R, i.e. express the wrench in the
+    * frame whose rotation to the current one is R.
+    */
+    ForceVector rotate(const Mat3 &R) const { return ForceVector(R*f,R*mu); }
+
+    /**
+    * Rotate both components by R'.
+    */
+    ForceVector rotateTransposed(const Mat3 &R) const { return ForceVector(R.transposedTimes(f),R.transposedTimes(mu)); }
+};
+
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-3-Clause license. See the accompanying LICENSE file for details.
+*/
+
+/**
+ * \defgroup iDynWholeBodyState iDynWholeBodyState
+ *
+ * @ingroup iDyn
+ *
+ * Consolidated snapshot of the whole-body dynamics quantities
+ * (joint torques, external wrenches, COMs, ...), streamed in one
+ * binary packet per cycle.
+ *
+ * \section intro_sec Description
+ *
+ * The packet is made of a schema header, listing for each field
+ * its identifier, its size and its position in the payload, and of
+ * a payload of doubles sent as a single raw block. All the fields
+ * share the same yarp::os::Stamp, hence a consumer always gets a
+ * coherent snapshot of the whole body without synchronizing several
+ * ports by timestamp. The schema lets the consumer tell which
+ * fields are present (e.g. the COM jacobian is streamed only when
+ * the COM velocity computation is enabled).
+ *
+ * Decoding on the client side:
+ * \code
+ * BufferedPort<wholeBodyState> port;
+ * port.open("/client/state:i");
+ * Network::connect("/wholeBodyDynamics/state:o","/client/state:i");
+ *
+ * wholeBodyState *state=port.read();
+ * Vector tau;
+ * if (state->get(WBS_TORQUES_LEFT_ARM,tau))
+ *     printf("%.3f: %s\n",state->getStamp().getTime(),tau.toString().c_str());
+ * \endcode
+ */
+
+#ifndef __IDYNWHOLEBODYSTATE_H__
+#define __IDYNWHOLEBODYSTATE_H__
+
+#include <string>
+#include <vector>
+#include <yarp/os/Portable.h>
+#include <yarp/os/Stamp.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+
+namespace iCub
+{
+
+namespace iDyn
+{
+
+/**
+* \ingroup iDynWholeBodyState
+*
+* Identifiers of the fields of a wholeBodyState; each field holds
+* the same values streamed by the corresponding port of
+* wholeBodyDynamics.
+*/
+enum WholeBodyStateField
+{
+    WBS_TORQUES_HEAD=0,
+    WBS_TORQUES_TORSO,
+    WBS_TORQUES_LEFT_ARM,
+    WBS_TORQUES_RIGHT_ARM,
+    WBS_TORQUES_LEFT_LEG,
+    WBS_TORQUES_RIGHT_LEG,
+    WBS_WRENCH_TORSO,
+    WBS_WRENCH_LEFT_ARM,
+    WBS_WRENCH_RIGHT_ARM,
+    WBS_WRENCH_LEFT_LEG,
+    WBS_WRENCH_RIGHT_LEG,
+    WBS_WRENCH_LEFT_FOOT,
+    WBS_WRENCH_RIGHT_FOOT,
+    WBS_CARTESIAN_WRENCH_LEFT_ARM,
+    WBS_CARTESIAN_WRENCH_RIGHT_ARM,
+    WBS_CARTESIAN_WRENCH_LEFT_LEG,
+    WBS_CARTESIAN_WRENCH_RIGHT_LEG,
+    WBS_CARTESIAN_WRENCH_LEFT_FOOT,
+    WBS_CARTESIAN_WRENCH_RIGHT_FOOT,
+    WBS_SENSOR_WRENCH_LEFT_ARM,
+    WBS_SENSOR_WRENCH_RIGHT_ARM,
+    WBS_SENSOR_WRENCH_LEFT_LEG,
+    WBS_SENSOR_WRENCH_RIGHT_LEG,
+    WBS_COM_ALL,
+    WBS_COM_LOWER_BODY,
+    WBS_COM_UPPER_BODY,
+    WBS_COM_LEFT_ARM,
+    WBS_COM_RIGHT_ARM,
+    WBS_COM_LEFT_LEG,
+    WBS_COM_RIGHT_LEG,
+    WBS_COM_HEAD,
+    WBS_COM_TORSO,
+    WBS_COM_ALL_FOOT,
+    WBS_COM_VELOCITY,
+    WBS_ALL_POSITIONS,
+    WBS_ALL_VELOCITIES,
+    WBS_COM_JACOBIAN,
+    WBS_COM_ANALYTIC_JACOBIAN,
+    WBS_CENTROIDAL_MOMENTUM_MATRIX,
+    WBS_ROOT_POSITION_MAT,
+    WBS_ROOT_POSITION_VEC,
+    WBS_FIELD_NUM
+};
+
+/**
+* \ingroup iDynWholeBodyState
+*
+* A whole-body snapshot that can be sent over a port.
+*
+* The producer calls clear(), then add() for each field and writes
+* the object; once the layout has settled (i.e. the same fields
+* with the same sizes are added every cycle) no memory is
+* allocated. The consumer reads the object and accesses the fields
+* with get().
+*/
+class wholeBodyState : public yarp::os::Portable
+{
+protected:
+    struct FieldInfo
+    {
+        int id;
+        int rows;
+        int cols;
+        int offset;
+    };
+
+    yarp::os::Stamp        stamp;
+    std::vector<FieldInfo> fields;
+    size_t                 nFields;
+    std::vector<double>    values;
+    size_t                 nValues;
+    int                    lookup[WBS_FIELD_NUM];
+
+    bool append(const int field, const int rows, const int cols, const double *data);
+
+public:
+    /// version of the packet layout, increased whenever the wire format or the meaning of the fields changes
+    static const int VERSION;
+
+    /**
+    * Default Constructor.
+    */
+    wholeBodyState();
+
+    /**
+    * Removes all the fields, keeping the allocated memory.
+    */
+    void clear();
+
+    /**
+    * Sets the stamp shared by all the fields.
+    * @param _stamp the stamp.
+    */
+    void setStamp(const yarp::os::Stamp &_stamp) { stamp=_stamp; }
+
+    /**
+    * Returns the stamp shared by all the fields.
+    * @return the stamp.
+    */
+    const yarp::os::Stamp &getStamp() const { return stamp; }
+
+    /**
+    * Appends a vector field.
+    * @param field the field identifier.
+    * @param v the values.
+    * @return true if the field was not present yet.
+    */
+    bool add(const int field, const yarp::sig::Vector &v);
+
+    /**
+    * Appends a matrix field, stored by rows.
+    * @param field the field identifier.
+    * @param m the values.
+    * @return true if the field was not present yet.
+    */
+    bool add(const int field, const yarp::sig::Matrix &m);
+
+    /**
+    * Checks whether a field is present.
+    * @param field the field identifier.
+    * @return true if the field is present.
+    */
+    bool has(const int field) const;
+
+    /**
+    * Gives access to the values of a field without copying them.
+    * @param field the field identifier.
+    * @param rows the number of rows (1 for vectors).
+    * @param cols the number of columns.
+    * @return a pointer to the values stored by rows, NULL if the
+    *         field is not present.
+    */
+    const double *getData(const int field, int &rows, int &cols) const;
+
+    /**
+    * Retrieves a field as a vector; matrices are returned by rows.
+    * @param field the field identifier.
+    * @param v the vector to fill.
+    * @return true if the field is present.
+    */
+    bool get(const int field, yarp::sig::Vector &v) const;
+
+    /**
+    * Retrieves a field as a matrix; vectors are returned as a single
+    * row.
+    * @param field the field identifier.
+    * @param m the matrix to fill.
+    * @return true if the field is present.
+    */
+    bool get(const int field, yarp::sig::Matrix &m) const;
+
+    /**
+    * Returns the number of fields in the schema.
+    * @return the number of fields.
+    */
+    int getNumFields() const { return (int)nFields; }
+
+    /**
+    * Returns the identifier of the i-th field of the schema.
+    * @param i the position of the field in the schema.
+    * @return the field identifier, -1 if i is out of range.
+    */
+    int getFieldId(const int i) const;
+
+    /**
+    * Returns the name of a field (e.g. "torques_left_arm").
+    * @param field the field identifier.
+    * @return the name, empty if the identifier is unknown.
+    */
+    static std::string getFieldName(const int field);
+
+    /**
+    * Reads a wholeBodyState from a connection.
+    * @return true iff a wholeBodyState was read correctly.
+    */
+    bool read(yarp::os::ConnectionReader& connection) override;
+
+    /**
+    * Writes the wholeBodyState to a connection.
+    * @return true iff the wholeBodyState was written correctly.
+    */
+    bool write(yarp::os::ConnectionWriter& connection) const override;
+};
+
+}
+
+}
+
+#endif
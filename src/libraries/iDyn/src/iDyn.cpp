@@ -20,6 +20,7 @@
 #include <cstdio>
 #include <iostream>
 #include <iomanip>
+#include <vector>
 
 #include <yarp/os/Log.h>
 #include <iCub/iDyn/iDyn.h>
@@ -1646,6 +1647,115 @@ Matrix iDynChain::computeMassMatrix(const Vector& q)
     return computeMassMatrix();
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Matrix iDynChain::computeMassMatrixCRBA()
+{
+    Matrix M(DOF,DOF);
+    if(DOF==0)
+        return M;
+
+    // intH[16*i] is the roto-translation from the root to the frame
+    // where the axis of the i-th joint lies, intH[16*(i+1)] is the 
+    // roto-translation from the root to the frame of the i-th link
+    computeIntH(N);
+
+    // inertial parameters of the composite body made of the links 
+    // from i to N-1, all expressed w.r.t. the root: mass, first
+    // moment of mass and rotational inertia about the origin
+    double mc=0.0;
+    double hc[3]={0.0, 0.0, 0.0};
+    double Jc[9]={0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+    // for each active joint: axis, position of the axis and spatial 
+    // momentum (linear, angular about the origin) of the composite 
+    // body moved by the joint at unit velocity
+    vector<double> z(3*DOF), o(3*DOF), p(3*DOF), L(3*DOF);
+
+    int d=DOF-1;
+    for(int i=N-1; i>=0; i--)
+    {
+        iDynLink *l = refLink(i);
+        const double *H = &intH[16*(i+1)];
+        const Matrix &I = l->getInertia();
+        const Vector &rc = l->getrC();
+        double m = l->getMass();
+
+        // COM and inertia tensor of the link in the root frame
+        double c[3], RI[9];
+        for(int r=0; r<3; r++)
+        {
+            c[r] = H[4*r]*rc[0] + H[4*r+1]*rc[1] + H[4*r+2]*rc[2] + H[4*r+3];
+            for(int k=0; k<3; k++)
+                RI[3*r+k] = H[4*r]*I(0,k) + H[4*r+1]*I(1,k) + H[4*r+2]*I(2,k);
+        }
+
+        // accumulate into the composite body (parallel axis theorem)
+        double c2 = c[0]*c[0] + c[1]*c[1] + c[2]*c[2];
+        mc += m;
+        for(int r=0; r<3; r++)
+        {
+            hc[r] += m*c[r];
+            for(int k=0; k<3; k++)
+                Jc[3*r+k] += RI[3*r]*H[4*k] + RI[3*r+1]*H[4*k+1] + RI[3*r+2]*H[4*k+2]
+                           + m*((r==k ? c2 : 0.0) - c[r]*c[k]);
+        }
+
+        if(l->isBlocked())
+            continue;
+
+        const double *Hj = &intH[16*i];
+        double *zd = &z[3*d];
+        double *od = &o[3*d];
+        for(int r=0; r<3; r++)
+        {
+            zd[r] = Hj[4*r+2];
+            od[r] = Hj[4*r+3];
+        }
+
+        // velocity of the point coincident with the origin: v0 = o x z
+        double v0[3] = { od[1]*zd[2]-od[2]*zd[1],
+                         od[2]*zd[0]-od[0]*zd[2],
+                         od[0]*zd[1]-od[1]*zd[0] };
+
+        // p = mc*v0 + z x hc ; L = Jc*z + hc x v0
+        double *pd = &p[3*d];
+        double *Ld = &L[3*d];
+        pd[0] = mc*v0[0] + zd[1]*hc[2]-zd[2]*hc[1];
+        pd[1] = mc*v0[1] + zd[2]*hc[0]-zd[0]*hc[2];
+        pd[2] = mc*v0[2] + zd[0]*hc[1]-zd[1]*hc[0];
+        Ld[0] = Jc[0]*zd[0] + Jc[1]*zd[1] + Jc[2]*zd[2] + hc[1]*v0[2]-hc[2]*v0[1];
+        Ld[1] = Jc[3]*zd[0] + Jc[4]*zd[1] + Jc[5]*zd[2] + hc[2]*v0[0]-hc[0]*v0[2];
+        Ld[2] = Jc[6]*zd[0] + Jc[7]*zd[1] + Jc[8]*zd[2] + hc[0]*v0[1]-hc[1]*v0[0];
+
+        d--;
+    }
+
+    // M(j,i) is the projection on the j-th joint axis of the angular 
+    // momentum about o_j of the composite body moved by the i-th joint,
+    // i.e. L_i - o_j x p_i, for j<=i
+    for(unsigned int i=0; i<DOF; i++)
+    {
+        const double *pi = &p[3*i];
+        const double *Li = &L[3*i];
+        for(unsigned int j=0; j<=i; j++)
+        {
+            const double *zj = &z[3*j];
+            const double *oj = &o[3*j];
+            double n[3] = { Li[0] - (oj[1]*pi[2]-oj[2]*pi[1]),
+                            Li[1] - (oj[2]*pi[0]-oj[0]*pi[2]),
+                            Li[2] - (oj[0]*pi[1]-oj[1]*pi[0]) };
+            M(j,i) = M(i,j) = zj[0]*n[0] + zj[1]*n[1] + zj[2]*n[2];
+        }
+    }
+
+    return M;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Matrix iDynChain::computeMassMatrixCRBA(const Vector& q)
+{
+    setAng(q);
+    return computeMassMatrixCRBA();
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // This is a simpler version of the method, just to understand what the method does.
 // The new version is about 2 times faster than this, because it exploits the fact that
 // the mass matrix is symmetric (but it is a little harder to understand the code).
@@ -1730,6 +1840,548 @@ Vector iDynChain::computeCcGravityTorques(const Vector& ddp0, const Vector& q, c
     setDAng(dq);
     return computeCcGravityTorques(ddp0);
 }
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// spatial vectors are stored as [angular; linear] and the motion transform
+// from the parent frame to the child frame is X = [E 0; -E*skew(p) E], where
+// E rotates from parent to child coordinates and p is the position of the 
+// child origin expressed in the parent frame
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+static void spatialTransformMotion(const double *E, const double *p, const double *v, double *out)
+{
+    double l[3] = { v[3] - (p[1]*v[2]-p[2]*v[1]),
+                    v[4] - (p[2]*v[0]-p[0]*v[2]),
+                    v[5] - (p[0]*v[1]-p[1]*v[0]) };
+    for(int r=0; r<3; r++)
+    {
+        out[r]   = E[3*r]*v[0] + E[3*r+1]*v[1] + E[3*r+2]*v[2];
+        out[3+r] = E[3*r]*l[0] + E[3*r+1]*l[1] + E[3*r+2]*l[2];
+    }
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+static void spatialTransformForceBack(const double *E, const double *p, const double *f, double *out)
+{
+    double n[3], l[3];
+    for(int r=0; r<3; r++)
+    {
+        n[r] = E[r]*f[0] + E[3+r]*f[1] + E[6+r]*f[2];
+        l[r] = E[r]*f[3] + E[3+r]*f[4] + E[6+r]*f[5];
+    }
+    out[0] = n[0] + p[1]*l[2]-p[2]*l[1];
+    out[1] = n[1] + p[2]*l[0]-p[0]*l[2];
+    out[2] = n[2] + p[0]*l[1]-p[1]*l[0];
+    out[3] = l[0];
+    out[4] = l[1];
+    out[5] = l[2];
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+static void spatialCrossMotion(const double *v, const double *m, double *out)
+{
+    out[0] = v[1]*m[2]-v[2]*m[1];
+    out[1] = v[2]*m[0]-v[0]*m[2];
+    out[2] = v[0]*m[1]-v[1]*m[0];
+    out[3] = v[1]*m[5]-v[2]*m[4] + v[4]*m[2]-v[5]*m[1];
+    out[4] = v[2]*m[3]-v[0]*m[5] + v[5]*m[0]-v[3]*m[2];
+    out[5] = v[0]*m[4]-v[1]*m[3] + v[3]*m[1]-v[4]*m[0];
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+static void spatialCrossForce(const double *v, const double *f, double *out)
+{
+    out[0] = v[1]*f[2]-v[2]*f[1] + v[4]*f[5]-v[5]*f[4];
+    out[1] = v[2]*f[0]-v[0]*f[2] + v[5]*f[3]-v[3]*f[5];
+    out[2] = v[0]*f[1]-v[1]*f[0] + v[3]*f[4]-v[4]*f[3];
+    out[3] = v[1]*f[5]-v[2]*f[4];
+    out[4] = v[2]*f[3]-v[0]*f[5];
+    out[5] = v[0]*f[4]-v[1]*f[3];
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Vector iDynChain::computeForwardDynamics(const Vector &tau, const Vector &w0, const Vector &dw0,
+                                         const Vector &ddp0, const Vector &Fend, const Vector &Muend)
+{
+    Vector ddq(DOF,0.0);
+
+    if((tau.length()!=DOF)||(w0.length()!=3)||(dw0.length()!=3)||(ddp0.length()!=3)||(Fend.length()!=3)||(Muend.length()!=3))
+    {
+        if(verbose)
+        {
+            yError("iDynChain error: could not compute the forward dynamics due to wrong sized vectors: \n");
+            yError(" tau,w0,dw0,ddp0,Fend,Muend have size %d,%d,%d,%d,%d,%d instead of %d,3,3,3,3,3 \n",(int)tau.length(),(int)w0.length(),
+                   (int)dw0.length(),(int)ddp0.length(),(int)Fend.length(),(int)Muend.length(),DOF);
+        }
+        return ddq;
+    }
+
+    if(N==0)
+        return ddq;
+
+    // per-link quantities: transform from the parent, joint axis, velocity,
+    // velocity-product acceleration, articulated inertia and bias force
+    vector<double> E(9*N), p(3*N), S(6*N), v(6*N), c(6*N), IA(36*N), pA(6*N), a(6*N);
+    vector<double> U(6*DOF), D(DOF), u(DOF);
+    double v0[6], a0[6], tmp[6];
+
+    // the base quantities are given in the root frame, as for the Newton-Euler
+    for(int r=0; r<3; r++)
+    {
+        v0[r]   = H0(0,r)*w0[0]   + H0(1,r)*w0[1]   + H0(2,r)*w0[2];
+        v0[3+r] = 0.0;
+        a0[r]   = H0(0,r)*dw0[0]  + H0(1,r)*dw0[1]  + H0(2,r)*dw0[2];
+        a0[3+r] = H0(0,r)*ddp0[0] + H0(1,r)*ddp0[1] + H0(2,r)*ddp0[2];
+    }
+
+    // pass 1: velocities and rigid body quantities from the base to the end-effector
+    for(unsigned int i=0; i<N; i++)
+    {
+        iDynLink *l = refLink(i);
+        const Matrix &H = l->getH();
+        double *Ei = &E[9*i];
+        double *pi = &p[3*i];
+        double *Si = &S[6*i];
+        double *vi = &v[6*i];
+        double *ci = &c[6*i];
+
+        for(int r=0; r<3; r++)
+        {
+            for(int k=0; k<3; k++)
+                Ei[3*r+k] = H(k,r);
+            pi[r] = H(r,3);
+        }
+
+        // the joint rotates about the z-axis of the parent frame
+        double dq = 0.0;
+        for(int k=0; k<6; k++)
+            Si[k] = 0.0;
+        if(!l->isBlocked())
+        {
+            for(int r=0; r<3; r++)
+            {
+                Si[r]   = Ei[3*r+2];
+                Si[3+r] = -Ei[3*r]*pi[1] + Ei[3*r+1]*pi[0];
+            }
+            dq = l->getDAng();
+        }
+
+        spatialTransformMotion(Ei,pi,(i==0 ? v0 : &v[6*(i-1)]),vi);
+        for(int k=0; k<6; k++)
+        {
+            tmp[k] = Si[k]*dq;
+            vi[k] += tmp[k];
+        }
+        spatialCrossMotion(vi,tmp,ci);
+
+        // rigid body inertia about the link origin
+        const Matrix &I = l->getInertia();
+        const Vector &rc = l->getrC();
+        double m = l->getMass();
+        double *IAi = &IA[36*i];
+        double cx[9] = { 0.0, -rc[2], rc[1], rc[2], 0.0, -rc[0], -rc[1], rc[0], 0.0 };
+        double c2 = rc[0]*rc[0] + rc[1]*rc[1] + rc[2]*rc[2];
+        for(int r=0; r<3; r++)
+        {
+            for(int k=0; k<3; k++)
+            {
+                IAi[6*r+k]       = I(r,k) + m*((r==k ? c2 : 0.0) - rc[r]*rc[k]);
+                IAi[6*r+3+k]     = m*cx[3*r+k];
+                IAi[6*(3+r)+k]   = -m*cx[3*r+k];
+                IAi[6*(3+r)+3+k] = (r==k ? m : 0.0);
+            }
+        }
+
+        // bias force due to the velocity and to the end-effector wrench
+        double h[6];
+        for(int r=0; r<6; r++)
+        {
+            h[r] = 0.0;
+            for(int k=0; k<6; k++)
+                h[r] += IAi[6*r+k]*vi[k];
+        }
+        spatialCrossForce(vi,h,&pA[6*i]);
+    }
+
+    for(int r=0; r<3; r++)
+    {
+        pA[6*(N-1)+r]   += Muend[r];
+        pA[6*(N-1)+3+r] += Fend[r];
+    }
+
+    // pass 2: articulated inertias from the end-effector to the base
+    int d = DOF-1;
+    for(int i=N-1; i>=0; i--)
+    {
+        const double *Si = &S[6*i];
+        const double *ci = &c[6*i];
+        double *IAi = &IA[36*i];
+        double *pAi = &pA[6*i];
+        double pa[6];
+
+        if(!refLink(i)->isBlocked())
+        {
+            double *Ud = &U[6*d];
+            D[d] = 0.0;
+            u[d] = tau[d];
+            for(int r=0; r<6; r++)
+            {
+                Ud[r] = 0.0;
+                for(int k=0; k<6; k++)
+                    Ud[r] += IAi[6*r+k]*Si[k];
+                D[d] += Si[r]*Ud[r];
+                u[d] -= Si[r]*pAi[r];
+            }
+
+            for(int r=0; r<6; r++)
+                for(int k=0; k<6; k++)
+                    IAi[6*r+k] -= Ud[r]*Ud[k]/D[d];
+
+            for(int r=0; r<6; r++)
+            {
+                pa[r] = pAi[r] + Ud[r]*u[d]/D[d];
+                for(int k=0; k<6; k++)
+                    pa[r] += IAi[6*r+k]*ci[k];
+            }
+
+            d--;
+        }
+        else
+        {
+            // blocked links have no velocity-product term
+            for(int r=0; r<6; r++)
+                pa[r] = pAi[r];
+        }
+
+        if(i==0)
+            break;
+
+        // propagate to the parent: IA += X'*Ia*X, pA += X'*pa
+        const double *Ei = &E[9*i];
+        const double *pi = &p[3*i];
+        double *IAp = &IA[36*(i-1)];
+        double col[6], XIa[36];
+        for(int k=0; k<6; k++)
+        {
+            // k-th column of X'*Ia
+            for(int r=0; r<6; r++)
+                col[r] = IAi[6*r+k];
+            spatialTransformForceBack(Ei,pi,col,tmp);
+            for(int r=0; r<6; r++)
+                XIa[6*r+k] = tmp[r];
+        }
+        for(int r=0; r<6; r++)
+        {
+            // being Ia symmetric, X' applied to the r-th row of X'*Ia
+            // yields the r-th row of X'*Ia*X
+            for(int k=0; k<6; k++)
+                col[k] = XIa[6*r+k];
+            spatialTransformForceBack(Ei,pi,col,tmp);
+            for(int k=0; k<6; k++)
+                IAp[6*r+k] += tmp[k];
+        }
+        spatialTransformForceBack(Ei,pi,pa,tmp);
+        for(int r=0; r<6; r++)
+            pA[6*(i-1)+r] += tmp[r];
+    }
+
+    // pass 3: accelerations from the base to the end-effector
+    d = 0;
+    for(unsigned int i=0; i<N; i++)
+    {
+        double *ai = &a[6*i];
+        spatialTransformMotion(&E[9*i],&p[3*i],(i==0 ? a0 : &a[6*(i-1)]),ai);
+        for(int k=0; k<6; k++)
+            ai[k] += c[6*i+k];
+
+        if(!refLink(i)->isBlocked())
+        {
+            const double *Ud = &U[6*d];
+            const double *Si = &S[6*i];
+            double Ua = 0.0;
+            for(int k=0; k<6; k++)
+                Ua += Ud[k]*ai[k];
+            ddq[d] = (u[d]-Ua)/D[d];
+            for(int k=0; k<6; k++)
+                ai[k] += Si[k]*ddq[d];
+            d++;
+        }
+    }
+
+    return ddq;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Vector iDynChain::computeForwardDynamics(const Vector &q, const Vector &dq, const Vector &tau,
+                                         const Vector &w0, const Vector &dw0, const Vector &ddp0,
+                                         const Vector &Fend, const Vector &Muend)
+{
+    setAng(q);
+    setDAng(dq);
+    return computeForwardDynamics(tau,w0,dw0,ddp0,Fend,Muend);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Vector iDynChain::computeForwardDynamics(const Vector &q, const Vector &dq, const Vector &tau,
+                                         const Vector &ddp0)
+{
+    Vector zero3(3,0.0);
+    setAng(q);
+    setDAng(dq);
+    return computeForwardDynamics(tau,zero3,zero3,ddp0,zero3,zero3);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Vector iDynChain::getDynamicParameters() const
+{
+    Vector pi(10*N,0.0);
+    for(unsigned int i=0; i<N; i++)
+    {
+        const Matrix &I  = allList[i]->getInertia();
+        const Matrix &HC = allList[i]->getCOM();
+        double m = allList[i]->getMass();
+        double rc[3] = { HC(0,3), HC(1,3), HC(2,3) };
+        double c2 = rc[0]*rc[0] + rc[1]*rc[1] + rc[2]*rc[2];
+        double *pii = pi.data()+10*i;
+
+        // inertia moved from the COM to the link origin
+        pii[0] = m;
+        pii[1] = m*rc[0];
+        pii[2] = m*rc[1];
+        pii[3] = m*rc[2];
+        pii[4] = I(0,0) + m*(c2-rc[0]*rc[0]);
+        pii[5] = I(0,1) - m*rc[0]*rc[1];
+        pii[6] = I(0,2) - m*rc[0]*rc[2];
+        pii[7] = I(1,1) + m*(c2-rc[1]*rc[1]);
+        pii[8] = I(1,2) - m*rc[1]*rc[2];
+        pii[9] = I(2,2) + m*(c2-rc[2]*rc[2]);
+    }
+    return pi;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool iDynChain::setDynamicParameters(const Vector &pi)
+{
+    if(pi.length()!=10*N)
+    {
+        if(verbose)
+            yError("iDynChain: setDynamicParameters() failed due to wrong sized vector: %d instead of %d \n",(int)pi.length(),10*N);
+        return false;
+    }
+
+    bool ret = true;
+    for(unsigned int i=0; i<N; i++)
+    {
+        const double *pii = pi.data()+10*i;
+        double m = pii[0];
+        if(m<0.0)
+        {
+            if(verbose)
+                yError("iDynChain: setDynamicParameters() failed for link %d: negative mass %f \n",i,m);
+            ret = false;
+            continue;
+        }
+
+        Vector rc(3,0.0);
+        if(m>0.0)
+        {
+            rc[0] = pii[1]/m;
+            rc[1] = pii[2]/m;
+            rc[2] = pii[3]/m;
+        }
+        else if((pii[1]!=0.0)||(pii[2]!=0.0)||(pii[3]!=0.0))
+        {
+            if(verbose)
+                yError("iDynChain: setDynamicParameters() failed for link %d: non-zero first moment with zero mass \n",i);
+            ret = false;
+            continue;
+        }
+
+        double c2 = rc[0]*rc[0] + rc[1]*rc[1] + rc[2]*rc[2];
+        iDynLink *l = refLink(i);
+        l->setMass(m);
+        l->setCOM(rc);
+        l->setInertia(pii[4] - m*(c2-rc[0]*rc[0]), pii[5] + m*rc[0]*rc[1], pii[6] + m*rc[0]*rc[2],
+                      pii[7] - m*(c2-rc[1]*rc[1]), pii[8] + m*rc[1]*rc[2],
+                      pii[9] - m*(c2-rc[2]*rc[2]));
+    }
+    return ret;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Matrix iDynChain::computeRegressor(const Vector &w0, const Vector &dw0, const Vector &ddp0)
+{
+    if((w0.length()!=3)||(dw0.length()!=3)||(ddp0.length()!=3))
+    {
+        if(verbose)
+        {
+            yError("iDynChain error: could not compute the regressor due to wrong sized vectors: \n");
+            yError(" w0,dw0,ddp0 have size %d,%d,%d instead of 3,3,3 \n",(int)w0.length(),(int)dw0.length(),(int)ddp0.length());
+        }
+        return Matrix(0,0);
+    }
+
+    Matrix Y(DOF,10*N); Y.zero();
+    if(N==0)
+        return Y;
+
+    // per-link rotation and position with respect to the parent frame,
+    // angular velocity, angular acceleration and acceleration of the origin,
+    // all expressed in the link frame
+    vector<double> R(9*N), p(3*N), w(3*N), dw(3*N), a(3*N);
+    double wp[3], dwp[3], ap[3];
+
+    // the base quantities are given in the root frame, as for the Newton-Euler
+    for(int r=0; r<3; r++)
+    {
+        wp[r]  = H0(0,r)*w0[0]   + H0(1,r)*w0[1]   + H0(2,r)*w0[2];
+        dwp[r] = H0(0,r)*dw0[0]  + H0(1,r)*dw0[1]  + H0(2,r)*dw0[2];
+        ap[r]  = H0(0,r)*ddp0[0] + H0(1,r)*ddp0[1] + H0(2,r)*ddp0[2];
+    }
+
+    // forward pass: kinematics from the base to the end-effector
+    for(unsigned int i=0; i<N; i++)
+    {
+        iDynLink *l = refLink(i);
+        const Matrix &H = l->getH();
+        double *Ri = &R[9*i];
+        double *pi = &p[3*i];
+        double *wi = &w[3*i];
+        double *dwi = &dw[3*i];
+        double *ai = &a[3*i];
+        for(int r=0; r<3; r++)
+        {
+            for(int k=0; k<3; k++)
+                Ri[3*r+k] = H(r,k);
+            pi[r] = H(r,3);
+        }
+
+        // the joint rotates about the z-axis of the parent frame
+        double dq = 0.0, ddq = 0.0;
+        if(!l->isBlocked())
+        {
+            dq  = l->getDAng();
+            ddq = l->getD2Ang();
+        }
+        double wz[3]  = { wp[0], wp[1], wp[2]+dq };
+        double dwz[3] = { dwp[0] + dq*wp[1], dwp[1] - dq*wp[0], dwp[2]+ddq };
+
+        double r_[3];
+        for(int r=0; r<3; r++)
+        {
+            wi[r]  = Ri[r]*wz[0]  + Ri[3+r]*wz[1]  + Ri[6+r]*wz[2];
+            dwi[r] = Ri[r]*dwz[0] + Ri[3+r]*dwz[1] + Ri[6+r]*dwz[2];
+            ai[r]  = Ri[r]*ap[0]  + Ri[3+r]*ap[1]  + Ri[6+r]*ap[2];
+            r_[r]  = Ri[r]*pi[0]  + Ri[3+r]*pi[1]  + Ri[6+r]*pi[2];
+        }
+
+        // a = R'*a_prev + dw x r + w x (w x r)
+        double wr[3] = { wi[1]*r_[2]-wi[2]*r_[1], wi[2]*r_[0]-wi[0]*r_[2], wi[0]*r_[1]-wi[1]*r_[0] };
+        ai[0] += dwi[1]*r_[2]-dwi[2]*r_[1] + wi[1]*wr[2]-wi[2]*wr[1];
+        ai[1] += dwi[2]*r_[0]-dwi[0]*r_[2] + wi[2]*wr[0]-wi[0]*wr[2];
+        ai[2] += dwi[0]*r_[1]-dwi[1]*r_[0] + wi[0]*wr[1]-wi[1]*wr[0];
+
+        for(int r=0; r<3; r++)
+        {
+            wp[r]  = wi[r];
+            dwp[r] = dwi[r];
+            ap[r]  = ai[r];
+        }
+    }
+
+    // backward pass: the wrench exerted on the subchain i..N-1 at the origin of
+    // the frame i, which is linear in the parameters, is accumulated in W
+    int cols = 10*N;
+    vector<double> W(6*cols,0.0);
+    int d = DOF-1;
+    for(int i=N-1; i>=0; i--)
+    {
+        int c0 = 10*i;
+
+        // move the wrench of the subchain i+1..N-1 to the frame i
+        if(i<(int)N-1)
+        {
+            const double *Rn = &R[9*(i+1)];
+            const double *pn = &p[3*(i+1)];
+            for(int c=10*(i+1); c<cols; c++)
+            {
+                double f[3], n[3];
+                for(int r=0; r<3; r++)
+                {
+                    f[r] = Rn[3*r]*W[c] + Rn[3*r+1]*W[cols+c] + Rn[3*r+2]*W[2*cols+c];
+                    n[r] = Rn[3*r]*W[3*cols+c] + Rn[3*r+1]*W[4*cols+c] + Rn[3*r+2]*W[5*cols+c];
+                }
+                W[c]        = f[0];
+                W[cols+c]   = f[1];
+                W[2*cols+c] = f[2];
+                W[3*cols+c] = n[0] + pn[1]*f[2]-pn[2]*f[1];
+                W[4*cols+c] = n[1] + pn[2]*f[0]-pn[0]*f[2];
+                W[5*cols+c] = n[2] + pn[0]*f[1]-pn[1]*f[0];
+            }
+        }
+
+        // wrench of the link i:
+        // f = m*a + dw x h + w x (w x h)
+        // n = I*dw + w x (I*w) + h x a
+        // with h the first moment of mass and I the inertia about the origin
+        const double *wi = &w[3*i];
+        const double *dwi = &dw[3*i];
+        const double *ai = &a[3*i];
+        double K[9], Lw[18], Ldw[18];
+        for(int r=0; r<3; r++)
+        {
+            for(int k=0; k<3; k++)
+                K[3*r+k] = wi[r]*wi[k] - (r==k ? wi[0]*wi[0]+wi[1]*wi[1]+wi[2]*wi[2] : 0.0);
+        }
+        K[1] -= dwi[2]; K[3] += dwi[2];
+        K[2] += dwi[1]; K[6] -= dwi[1];
+        K[5] -= dwi[0]; K[7] += dwi[0];
+
+        // I*v = L(v)*[Ixx Ixy Ixz Iyy Iyz Izz]'
+        const double *v[2] = { wi, dwi };
+        double *L[2] = { Lw, Ldw };
+        for(int j=0; j<2; j++)
+        {
+            double *Lj = L[j];
+            const double *vj = v[j];
+            Lj[0]  = vj[0]; Lj[1]  = vj[1]; Lj[2]  = vj[2]; Lj[3]  = 0.0;   Lj[4]  = 0.0;   Lj[5]  = 0.0;
+            Lj[6]  = 0.0;   Lj[7]  = vj[0]; Lj[8]  = 0.0;   Lj[9]  = vj[1]; Lj[10] = vj[2]; Lj[11] = 0.0;
+            Lj[12] = 0.0;   Lj[13] = 0.0;   Lj[14] = vj[0]; Lj[15] = 0.0;   Lj[16] = vj[1]; Lj[17] = vj[2];
+        }
+
+        for(int r=0; r<3; r++)
+        {
+            W[r*cols+c0] += ai[r];
+            for(int k=0; k<3; k++)
+                W[r*cols+c0+1+k] += K[3*r+k];
+
+            int r1 = (r+1)%3, r2 = (r+2)%3;
+            for(int k=0; k<6; k++)
+                W[(3+r)*cols+c0+4+k] += Ldw[6*r+k] + wi[r1]*Lw[6*r2+k] - wi[r2]*Lw[6*r1+k];
+
+            // h x a
+            W[(3+r)*cols+c0+1+r1] += ai[r2];
+            W[(3+r)*cols+c0+1+r2] -= ai[r1];
+        }
+
+        // the torque is the component of the moment at the parent origin
+        // along the z-axis of the parent frame
+        if(!refLink(i)->isBlocked())
+        {
+            const double *Ri = &R[9*i];
+            const double *pi = &p[3*i];
+            for(int c=c0; c<cols; c++)
+            {
+                double fx = Ri[0]*W[c] + Ri[1]*W[cols+c] + Ri[2]*W[2*cols+c];
+                double fy = Ri[3]*W[c] + Ri[4]*W[cols+c] + Ri[5]*W[2*cols+c];
+                double nz = Ri[6]*W[3*cols+c] + Ri[7]*W[4*cols+c] + Ri[8]*W[5*cols+c];
+                Y(d,c) = nz + pi[0]*fy - pi[1]*fx;
+            }
+            d--;
+        }
+    }
+
+    return Y;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Matrix iDynChain::computeRegressor(const Vector &q, const Vector &dq, const Vector &ddq, const Vector &ddp0)
+{
+    Vector zero3(3,0.0);
+    setAng(q);
+    setDAng(dq);
+    setD2Ang(ddq);
+    return computeRegressor(zero3,zero3,ddp0);
+}
 
 
 //================================
@@ -20,6 +20,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <algorithm>
 
 #include <iCub/iDyn/iDyn.h>
 #include <iCub/iDyn/iDynBody.h>
@@ -406,6 +407,93 @@ Matrix RigidBodyTransformation::getHCOM(unsigned int iLink)
 
 
 
+//====================================
+//
+//      i DYN WORKER POOL
+//
+//====================================
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+iDynWorkerPool::iDynWorkerPool(const unsigned int nThreads)
+{
+    tasks = NULL;
+    next = pending = 0;
+    closing = false;
+
+    unsigned int n = nThreads;
+    if(n==0)
+        n = std::max(std::thread::hardware_concurrency(),1U);
+
+    // the calling thread is one of the n threads
+    for(unsigned int i=1; i<n; i++)
+        workers.push_back(std::thread(&iDynWorkerPool::loop,this));
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+iDynWorkerPool::~iDynWorkerPool()
+{
+    {
+        lock_guard<mutex> lck(mtx);
+        closing = true;
+    }
+    cv_work.notify_all();
+
+    for(size_t i=0; i<workers.size(); i++)
+        workers[i].join();
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void iDynWorkerPool::loop()
+{
+    unique_lock<mutex> lck(mtx);
+    while(true)
+    {
+        cv_work.wait(lck,[this](){ return closing || ((tasks!=NULL) && (next<tasks->size())); });
+        if(closing)
+            return;
+
+        // pick the next task and execute it outside the critical section
+        size_t i = next++;
+        lck.unlock();
+        (*tasks)[i]();
+        lck.lock();
+
+        if(--pending==0)
+            cv_done.notify_all();
+    }
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void iDynWorkerPool::run(vector<function<void()> > &_tasks)
+{
+    // nothing to be shared
+    if(workers.empty() || (_tasks.size()<2))
+    {
+        for(size_t i=0; i<_tasks.size(); i++)
+            _tasks[i]();
+        return;
+    }
+
+    lock_guard<mutex> lck_run(mtx_run);
+    unique_lock<mutex> lck(mtx);
+    tasks = &_tasks;
+    next = 0;
+    pending = _tasks.size();
+    cv_work.notify_all();
+
+    // the calling thread contributes too
+    while(next<tasks->size())
+    {
+        size_t i = next++;
+        lck.unlock();
+        _tasks[i]();
+        lck.lock();
+        pending--;
+    }
+
+    cv_done.wait(lck,[this](){ return (pending==0); });
+    tasks = NULL;
+}
+
+
+
 //====================================
 //
 //      i DYN NODE
@@ -418,6 +506,7 @@ iDynNode::iDynNode(const NewEulMode _mode)
     rbtList.clear();
     mode = _mode;
     verbose = iCub::skinDynLib::VERBOSE;
+    pool = NULL;
     zero();
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -427,6 +516,7 @@ iDynNode::iDynNode(const string &_info, const NewEulMode _mode, unsigned int ver
     rbtList.clear();
     mode = _mode;
     verbose = verb;
+    pool = NULL;
     zero();
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -439,6 +529,17 @@ void iDynNode::zero()
     Mu.resize(3); Mu.zero();
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void iDynNode::runLimbTasks(vector<function<void()> > &tasks)
+{
+    if(pool!=NULL)
+        pool->run(tasks);
+    else
+    {
+        for(size_t i=0; i<tasks.size(); i++)
+            tasks[i]();
+    }
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void iDynNode::addLimb(iDynLimb *limb, const Matrix &H, const FlowType kinFlow, const FlowType wreFlow, bool hasSensor)
 {
     string infoRbt = limb->getType() + " to node";
@@ -483,16 +584,22 @@ bool iDynNode::solveKinematics()
     if(inputNode==1)
     {
         //now forward the kinematic input from limbs whose kinematic flow is input type
+        //these limbs do not depend on each other, so they can be solved concurrently
+        vector<function<void()> > tasks;
         for(unsigned int i=0; i<rbtList.size(); i++)
         {
             if(rbtList[i].getKinematicFlow()==RBT_NODE_OUT)
             {
-                //init the kinematics with the node information
-                rbtList[i].setKinematic(w,dw,ddp);
-                //solve kinematics in that limb/chain
-                rbtList[i].computeLimbKinematic();
+                tasks.push_back([this,i]()
+                {
+                    //init the kinematics with the node information
+                    rbtList[i].setKinematic(w,dw,ddp);
+                    //solve kinematics in that limb/chain
+                    rbtList[i].computeLimbKinematic();
+                });
             }
         }
+        runLimbTasks(tasks);
         return true;
     
     }
@@ -532,16 +639,22 @@ bool iDynNode::solveKinematics(const Vector &w0, const Vector &dw0, const Vector
     if(inputNode==1)
     {
         //now forward the kinematic input from limbs whose kinematic flow is input type
+        //these limbs do not depend on each other, so they can be solved concurrently
+        vector<function<void()> > tasks;
         for(unsigned int i=0; i<rbtList.size(); i++)
         {
             if(rbtList[i].getKinematicFlow()==RBT_NODE_OUT)
             {
-                //init the kinematics with the node information
-                rbtList[i].setKinematic(w,dw,ddp);
-                //solve kinematics in that limb/chain
-                rbtList[i].computeLimbKinematic();
+                tasks.push_back([this,i]()
+                {
+                    //init the kinematics with the node information
+                    rbtList[i].setKinematic(w,dw,ddp);
+                    //solve kinematics in that limb/chain
+                    rbtList[i].computeLimbKinematic();
+                });
             }
         }
+        runLimbTasks(tasks);
         return true;
     
     }
@@ -595,15 +708,25 @@ bool iDynNode::solveWrench()
     //first get the forces/moments from each limb
     //assuming that each limb has been properly set with the outcoming measured
     //forces/moments which are necessary for the wrench computation
+    vector<function<void()> > tasks;
     for(unsigned int i=0; i<rbtList.size(); i++)
     {
         if(rbtList[i].getWrenchFlow()==RBT_NODE_IN)         
         {
             //compute the wrench pass in that limb
-            rbtList[i].computeLimbWrench();
+            tasks.push_back([this,i]() { rbtList[i].computeLimbWrench(); });
+        }
+    }
+    runLimbTasks(tasks);
+
+    for(unsigned int i=0; i<rbtList.size(); i++)
+    {
+        if(rbtList[i].getWrenchFlow()==RBT_NODE_IN)         
+        {
             //update the node force/moment with the wrench coming from the limb base/end
             // note that getWrench sum the result to F,Mu - because they are passed by reference
             // F = F + F[i], Mu = Mu + Mu[i]
+            // the sum is always carried out in the same order, regardless of the worker pool
             rbtList[i].getWrench(F,Mu);
             //check
             outputNode++;
@@ -628,16 +751,21 @@ bool iDynNode::solveWrench()
     }
 
     //now forward the wrench output from the node to limbs whose wrench flow is output type
+    tasks.clear();
     for(unsigned int i=0; i<rbtList.size(); i++)
     {
         if(rbtList[i].getWrenchFlow()==RBT_NODE_OUT)
         {
-            //init the wrench with the node information
-            rbtList[i].setWrench(F,Mu);
-            //solve wrench in that limb/chain
-            rbtList[i].computeLimbWrench();
+            tasks.push_back([this,i]()
+            {
+                //init the wrench with the node information
+                rbtList[i].setWrench(F,Mu);
+                //solve wrench in that limb/chain
+                rbtList[i].computeLimbWrench();
+            });
         }
     }
+    runLimbTasks(tasks);
     return true;
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -1355,6 +1483,7 @@ bool iDynSensorNode::solveWrench()
     // set to zero the node force/moment
     F.zero(); Mu.zero();
 
+    vector<function<void()> > tasks;
     //first get the forces/moments from each limb
     //assuming that each limb has been properly set with the outcoming measured
     //forces/moments which are necessary for the wrench computation
@@ -1365,11 +1494,22 @@ bool iDynSensorNode::solveWrench()
             //compute the wrench pass in that limb
             // if there's a sensor, we must use iDynSensor
             // otherwise we use the limb method as usual
-            if(rbtList[i].isSensorized()==true)
-                sensorList[i]->computeWrenchFromSensorNewtonEuler();
-            else
-                rbtList[i].computeLimbWrench();
+            tasks.push_back([this,i]()
+            {
+                if(rbtList[i].isSensorized()==true)
+                    sensorList[i]->computeWrenchFromSensorNewtonEuler();
+                else
+                    rbtList[i].computeLimbWrench();
+            });
+        }
+    }
+    runLimbTasks(tasks);
 
+    for(unsigned int i=0; i<rbtList.size(); i++)
+    {
+        if(rbtList[i].getWrenchFlow()==RBT_NODE_IN)         
+        {
+            // the sum is always carried out in the same order, regardless of the worker pool
             //update the node force/moment with the wrench coming from the limb base/end
             // note that getWrench sum the result to F,Mu - because they are passed by reference
             // F = F + F[i], Mu = Mu + Mu[i]
@@ -1397,16 +1537,21 @@ bool iDynSensorNode::solveWrench()
 
     //now forward the wrench output from the node to limbs whose wrench flow is output type
     // assuming they don't have a FT sensor
+    tasks.clear();
     for(unsigned int i=0; i<rbtList.size(); i++)
     {
         if(rbtList[i].getWrenchFlow()==RBT_NODE_OUT)
         {
-            //init the wrench with the node information
-            rbtList[i].setWrench(F,Mu);
-            //solve wrench in that limb/chain
-            rbtList[i].computeLimbWrench();
+            tasks.push_back([this,i]()
+            {
+                //init the wrench with the node information
+                rbtList[i].setWrench(F,Mu);
+                //solve wrench in that limb/chain
+                rbtList[i].computeLimbWrench();
+            });
         }
     }
+    runLimbTasks(tasks);
     return true;
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -2409,6 +2554,9 @@ iCubWholeBody::iCubWholeBody(version_tag _tag, const NewEulMode mode, unsigned i
     H.eye();
     //H  is no used currently since the transformation is an identity
     rbt = new RigidBodyTransformation(lowerTorso->up,H,"connection between lower and upper torso",false,RBT_NODE_OUT,RBT_NODE_OUT,mode,verbose);
+
+    //serial computations by default
+    pool = NULL;
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 iCubWholeBody::~iCubWholeBody()
@@ -2416,6 +2564,28 @@ iCubWholeBody::~iCubWholeBody()
     if (upperTorso) delete upperTorso; upperTorso = NULL;
     if (lowerTorso) delete lowerTorso; lowerTorso = NULL;
     if (rbt)        delete rbt;        rbt        = NULL;
+    if (pool)       delete pool;       pool       = NULL;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void iCubWholeBody::setParallelMode(const bool enable, const unsigned int nThreads)
+{
+    upperTorso->setWorkerPool(NULL);
+    lowerTorso->setWorkerPool(NULL);
+    if (pool) delete pool; pool = NULL;
+
+    if (enable)
+    {
+        // each node has three limbs at most to be solved concurrently:
+        // additional threads would only stay idle
+        unsigned int n = nThreads;
+        if (n==0)
+            n = std::min(std::max(std::thread::hardware_concurrency(),1U),3U);
+
+        //the two nodes are solved one after the other, hence they can share the pool
+        pool = new iDynWorkerPool(n);
+        upperTorso->setWorkerPool(pool);
+        lowerTorso->setWorkerPool(pool);
+    }
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void iCubWholeBody::attachLowerTorso(const Vector &FM_right_leg, const Vector &FM_left_leg)
@@ -3028,5 +3198,223 @@ bool iCubWholeBody::EXPERIMENTAL_getCOMvelocity(BodyPart which_part, Vector &com
     return true;
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//      COM JACOBIAN SWEEP
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+namespace
+{
+    // inertial and kinematic quantities of a link, expressed in the root frame
+    struct comLinkState
+    {
+        double m;       // mass
+        double c[3];    // position of the COM
+        double I[9];    // inertia about the COM (row-major)
+        double z[3];    // axis of the joint moving the link
+        double p[3];    // origin of the joint moving the link
+        bool   joint;   // false if the joint is blocked
+    };
+
+    // accumulated quantities of a set of links: mass, first moment sum(m*c) and
+    // second moment sum(I + m*(|c|^2*eye - c*c')) about the root origin
+    struct comSubtreeState
+    {
+        double m;
+        double s[3];
+        double Q[9];
+    };
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+static void zeroSubtree(comSubtreeState &st)
+{
+    st.m = 0.0;
+    for (int i=0; i<3; i++) st.s[i] = 0.0;
+    for (int i=0; i<9; i++) st.Q[i] = 0.0;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+static void addToSubtree(comSubtreeState &st, const comLinkState &l)
+{
+    double cc = l.c[0]*l.c[0] + l.c[1]*l.c[1] + l.c[2]*l.c[2];
+    st.m += l.m;
+    for (int i=0; i<3; i++)
+    {
+        st.s[i] += l.m*l.c[i];
+        for (int j=0; j<3; j++)
+            st.Q[3*i+j] += l.I[3*i+j] + l.m*((i==j?cc:0.0) - l.c[i]*l.c[j]);
+    }
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+static void addToSubtree(comSubtreeState &st, const comSubtreeState &other)
+{
+    st.m += other.m;
+    for (int i=0; i<3; i++) st.s[i] += other.s[i];
+    for (int i=0; i<9; i++) st.Q[i] += other.Q[i];
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+static void collectLimbStates(iDynLimb *limb, const Matrix &Tb, vector<comLinkState> &links, comSubtreeState &total)
+{
+    unsigned int N = limb->getN();
+    links.resize(N);
+
+    // the frame preceding each link is the one where its joint axis lies:
+    // the transformations come from the cache of the chain
+    Matrix Hprev = Tb*limb->getH0();
+    for (unsigned int i=0; i<N; i++)
+    {
+        Matrix H = limb->getH(i,true);
+        // the last transformation includes HN, which is not part of the link
+        if (i==N-1)
+            H = H*SE3inv(limb->getHN());
+        H = Tb*H;
+
+        comLinkState &l = links[i];
+        l.m = limb->getMass(i);
+        l.joint = !limb->isLinkBlocked(i);
+
+        Matrix I = limb->getInertia(i);
+        Vector rC = limb->getCOM(i).getCol(3);
+        for (int r=0; r<3; r++)
+        {
+            l.c[r] = H(r,0)*rC[0] + H(r,1)*rC[1] + H(r,2)*rC[2] + H(r,3);
+            l.z[r] = Hprev(r,2);
+            l.p[r] = Hprev(r,3);
+        }
+
+        // rotate the inertia in the root frame: R*I*R'
+        for (int r=0; r<3; r++)
+        {
+            for (int c=0; c<3; c++)
+            {
+                double sum = 0.0;
+                for (int a=0; a<3; a++)
+                    for (int b=0; b<3; b++)
+                        sum += H(r,a)*I(a,b)*H(c,b);
+                l.I[3*r+c] = sum;
+            }
+        }
+
+        addToSubtree(total,l);
+        Hprev = H;
+    }
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+static void sweepLimb(const vector<comLinkState> &links, const comSubtreeState &tail, const double *com, 
+                      const double mass, const unsigned int col0, Matrix &jac, Matrix &cmm)
+{
+    // each joint moves the links from the one it belongs to up to the end of the limb,
+    // plus whatever is attached to the end (tail): the quantities of the moved subtree 
+    // are therefore accumulated from the end backward
+    comSubtreeState st = tail;
+
+    unsigned int col = col0;
+    for (size_t i=0; i<links.size(); i++)
+        if (links[i].joint)
+            col++;
+
+    double cc = com[0]*com[0] + com[1]*com[1] + com[2]*com[2];
+    for (int i=(int)links.size()-1; i>=0; i--)
+    {
+        const comLinkState &l = links[i];
+        addToSubtree(st,l);
+        if (!l.joint)
+            continue;
+
+        col--;
+        const double *z = l.z;
+        const double *p = l.p;
+
+        // linear momentum: z x (s - m*p)
+        double d[3] = { st.s[0]-st.m*p[0], st.s[1]-st.m*p[1], st.s[2]-st.m*p[2] };
+        double h[3] = { z[1]*d[2]-z[2]*d[1], z[2]*d[0]-z[0]*d[2], z[0]*d[1]-z[1]*d[0] };
+
+        // composite inertia of the subtree about the COM of the robot
+        double sc = st.s[0]*com[0] + st.s[1]*com[1] + st.s[2]*com[2];
+        double Ic[9];
+        for (int r=0; r<3; r++)
+            for (int c=0; c<3; c++)
+                Ic[3*r+c] = st.Q[3*r+c] - ((r==c?2.0*sc:0.0) - st.s[r]*com[c] - com[r]*st.s[c])
+                                        + st.m*((r==c?cc:0.0) - com[r]*com[c]);
+
+        // angular momentum about the COM: Ic*z + (s - m*com) x (z x (com - p))
+        double e[3] = { com[0]-p[0], com[1]-p[1], com[2]-p[2] };
+        double v[3] = { z[1]*e[2]-z[2]*e[1], z[2]*e[0]-z[0]*e[2], z[0]*e[1]-z[1]*e[0] };
+        double g[3] = { st.s[0]-st.m*com[0], st.s[1]-st.m*com[1], st.s[2]-st.m*com[2] };
+        double k[3] = { g[1]*v[2]-g[2]*v[1], g[2]*v[0]-g[0]*v[2], g[0]*v[1]-g[1]*v[0] };
+
+        for (int r=0; r<3; r++)
+        {
+            jac(r,col)   = h[r]/mass;
+            cmm(r,col)   = h[r];
+            cmm(r+3,col) = Ic[3*r]*z[0] + Ic[3*r+1]*z[1] + Ic[3*r+2]*z[2] + k[r];
+        }
+    }
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool iCubWholeBody::computeCOMjacobian()
+{
+    // limbs ordered as in getAllPositions(): left leg, right leg, torso, left arm, right arm, head
+    iDynLimb *limbs[6] = { lowerTorso->left, lowerTorso->right, lowerTorso->up,
+                           upperTorso->left, upperTorso->right, upperTorso->up };
+    vector<comLinkState> links[6];
+    comSubtreeState total[6];
+
+    // transformation from the root (lower torso node) to the upper torso node
+    Matrix Tup = lowerTorso->HUp*lowerTorso->up->getH(lowerTorso->up->getN()-1,true);
+    Matrix Tb[6] = { lowerTorso->HLeft, lowerTorso->HRight, lowerTorso->HUp,
+                     Tup*upperTorso->HLeft, Tup*upperTorso->HRight, Tup*upperTorso->HUp };
+
+    // first pass: gather the links in the root frame and the COM of the robot
+    comSubtreeState robot;
+    zeroSubtree(robot);
+    unsigned int col[6];
+    unsigned int dof = 0;
+    for (int n=0; n<6; n++)
+    {
+        zeroSubtree(total[n]);
+        collectLimbStates(limbs[n],Tb[n],links[n],total[n]);
+        addToSubtree(robot,total[n]);
+        col[n] = dof;
+        dof += limbs[n]->getDOF();
+    }
+
+    if (robot.m<=0.0)
+    {
+        fprintf(stderr,"iCubWholeBody: error, could not compute the COM jacobian because the total mass is zero \n");
+        return false;
+    }
+
+    double com[3] = { robot.s[0]/robot.m, robot.s[1]/robot.m, robot.s[2]/robot.m };
+
+    COM_jacobian.resize(3,dof);
+    centroidal_momentum_matrix.resize(6,dof);
+
+    // second pass: the torso moves the whole upper body as well
+    comSubtreeState upper, none;
+    zeroSubtree(upper);
+    zeroSubtree(none);
+    for (int n=3; n<6; n++)
+        addToSubtree(upper,total[n]);
+
+    for (int n=0; n<6; n++)
+        sweepLimb(links[n],(n==2)?upper:none,com,robot.m,col[n],COM_jacobian,centroidal_momentum_matrix);
+
+    return true;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool iCubWholeBody::getCOMjacobian(Matrix &jac) const
+{
+    if (COM_jacobian.cols()==0)
+        return false;
+
+    jac = COM_jacobian;
+    return true;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool iCubWholeBody::getCentroidalMomentumMatrix(Matrix &cmm) const
+{
+    if (centroidal_momentum_matrix.cols()==0)
+        return false;
 
+    cmm = centroidal_momentum_matrix;
+    return true;
+}
 
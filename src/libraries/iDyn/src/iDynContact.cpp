@@ -17,6 +17,9 @@
 */
 
 #include <iostream>
+#include <cmath>
+#include <vector>
+#include <algorithm>
 #include <iCub/iDyn/iDynContact.h>
 #include <yarp/math/SVD.h>
 #include <stdio.h>
@@ -37,11 +40,11 @@ using namespace iCub::skinDynLib;
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 iDynContactSolver::iDynContactSolver(iDynChain *_c, const string &_info, const NewEulMode _mode, BodyPart _bodyPart, unsigned int verb)
-:iDynSensor(_c, _info, _mode, verb), bodyPart(_bodyPart){}
+:iDynSensor(_c, _info, _mode, verb), bodyPart(_bodyPart), factType(FACT_NONE){}
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 iDynContactSolver::iDynContactSolver(iDynChain *_c, unsigned int sensLink, SensorLinkNewtonEuler *sensor, 
                                     const string &_info, const NewEulMode _mode, BodyPart _bodyPart, unsigned int verb)
-:iDynSensor(_c, _info, _mode, verb), bodyPart(_bodyPart)
+:iDynSensor(_c, _info, _mode, verb), bodyPart(_bodyPart), factType(FACT_NONE)
 {
     lSens = sensLink;
     sens = sensor;
@@ -49,7 +52,7 @@ iDynContactSolver::iDynContactSolver(iDynChain *_c, unsigned int sensLink, Senso
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 iDynContactSolver::iDynContactSolver(iDynChain *_c, unsigned int sensLink, const Matrix &_H, const Matrix &_HC, double _m, 
                                      const Matrix &_I, const string &_info, const NewEulMode _mode, BodyPart _bodyPart, unsigned int verb)
-:iDynSensor(_c, sensLink, _H, _HC, _m, _I, _info, _mode, verb), bodyPart(_bodyPart){}
+:iDynSensor(_c, sensLink, _H, _HC, _m, _I, _info, _mode, verb), bodyPart(_bodyPart), factType(FACT_NONE){}
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 iDynContactSolver::~iDynContactSolver(){}
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -80,6 +83,13 @@ void iDynContactSolver::clearContactList()
     if(!contactList.empty())
         contactList.clear();
 }
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void iDynContactSolver::resetFactorization()
+{
+    factType = FACT_NONE;
+    factA.resize(0,0);
+    factPinv.resize(0,0);
+}
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 const dynContactList& iDynContactSolver::computeExternalContacts(const Vector &FMsens)
 {
@@ -140,8 +150,7 @@ const dynContactList& iDynContactSolver::computeExternalContacts()
     // the reference frame is the <firstContactLink-1> 
     Matrix A = buildA(firstContactLink, lastContactLink);
     Vector B = buildB(firstContactLink, lastContactLink);
-    Matrix pinv_A = pinv(A, TOLLERANCE);
-    Vector X = pinv_A * B;
+    Vector X = solveContactSystem(A, B);
     
     // SET THE COMPUTED VALUES IN THE CONTACT LIST
     unsigned int unknownInd = 0;
@@ -289,6 +298,186 @@ Vector iDynContactSolver::buildB(unsigned int firstContactLink, unsigned int las
 
     return cat(Bforce, Bmoment);
 }
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+namespace
+{
+    // Householder QR with column pivoting M*P=Q*R of the p-by-k matrix M (p>=k), stored by rows;
+    // on exit M holds R in its upper triangle and the Householder vectors below the diagonal,
+    // beta the coefficients of the reflectors and perm the permutation
+    void qrPivoted(double *M, int p, int k, std::vector<double> &beta, std::vector<int> &perm)
+    {
+        std::vector<double> norms(k,0.0);
+        for(int j=0; j<k; j++)
+        {
+            perm[j] = j;
+            for(int r=0; r<p; r++)
+                norms[j] += M[r*k+j]*M[r*k+j];
+        }
+
+        for(int j=0; j<k; j++)
+        {
+            // bring forward the column of largest residual norm
+            int piv = j;
+            for(int c=j+1; c<k; c++)
+                if(norms[c]>norms[piv])
+                    piv = c;
+            if(piv!=j)
+            {
+                for(int r=0; r<p; r++)
+                    std::swap(M[r*k+j],M[r*k+piv]);
+                std::swap(norms[j],norms[piv]);
+                std::swap(perm[j],perm[piv]);
+            }
+
+            // reflector zeroing the column below the diagonal
+            double alpha = 0.0;
+            for(int r=j; r<p; r++)
+                alpha += M[r*k+j]*M[r*k+j];
+            alpha = sqrt(alpha);
+            if(M[j*k+j]>0.0)
+                alpha = -alpha;
+
+            beta[j] = 0.0;
+            if(alpha!=0.0)
+            {
+                M[j*k+j] -= alpha;
+                double vv = 0.0;
+                for(int r=j; r<p; r++)
+                    vv += M[r*k+j]*M[r*k+j];
+                beta[j] = 2.0/vv;
+
+                for(int c=j+1; c<k; c++)
+                {
+                    double s = 0.0;
+                    for(int r=j; r<p; r++)
+                        s += M[r*k+j]*M[r*k+c];
+                    s *= beta[j];
+                    for(int r=j; r<p; r++)
+                        M[r*k+c] -= s*M[r*k+j];
+                }
+            }
+
+            // the diagonal keeps R, the reflector is stored below it with implicit head
+            double head = M[j*k+j];
+            for(int r=j+1; r<p; r++)
+                M[r*k+j] /= (head!=0.0 ? head : 1.0);
+            beta[j] *= head*head;
+            M[j*k+j] = alpha;
+
+            // downdate the residual norms of the remaining columns
+            for(int c=j+1; c<k; c++)
+            {
+                norms[c] -= M[j*k+c]*M[j*k+c];
+                if(norms[c]<0.0)
+                    norms[c] = 0.0;
+            }
+        }
+    }
+
+    // apply Q=H_0*...*H_{k-1} to the p-by-k block y (stored by rows with stride k), from the left
+    void qrApplyQ(const double *M, int p, int k, const std::vector<double> &beta, double *y)
+    {
+        for(int j=k-1; j>=0; j--)
+        {
+            if(beta[j]==0.0)
+                continue;
+            for(int c=0; c<k; c++)
+            {
+                double s = y[j*k+c];
+                for(int r=j+1; r<p; r++)
+                    s += M[r*k+j]*y[r*k+c];
+                s *= beta[j];
+                y[j*k+c] -= s;
+                for(int r=j+1; r<p; r++)
+                    y[r*k+c] -= s*M[r*k+j];
+            }
+        }
+    }
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Vector iDynContactSolver::solveContactSystem(const Matrix &A, const Vector &B)
+{
+    int m = A.rows();
+    int n = A.cols();
+
+    // the factorization is kept as long as the contacts geometry, hence A, does not change;
+    // in the steady case only B, i.e. the measured wrench, changes between two calls
+    bool reuse = (factType!=FACT_NONE) && (factA.rows()==A.rows()) && (factA.cols()==A.cols());
+    for(int i=0; reuse && (i<m*n); i++)
+        reuse = (factA.data()[i]==A.data()[i]);
+
+    if(!reuse)
+    {
+        factA = A;
+
+        // QR of A itself for the overdetermined case and of A' for the underdetermined one
+        // (minimum-norm solution), so that the conditioning of A is not squared
+        bool cols = (n<=m);
+        int p = cols ? m : n;
+        int k = cols ? n : m;
+        Matrix M = cols ? A : A.transposed();
+        std::vector<double> beta(k);
+        std::vector<int> perm(k);
+        qrPivoted(M.data(),p,k,beta,perm);
+
+        // R has the same singular values as A; since sigma_min(R) <= min|R(i,i)| and
+        // 1/||R^-1||_F <= sigma_min(R), the pseudo-inverse is used whenever the SVD
+        // would have truncated a singular value to TOLLERANCE
+        bool fullRank = true;
+        for(int i=0; fullRank && (i<k); i++)
+            fullRank = (fabs(M(i,i))>TOLLERANCE);
+
+        Matrix Rinv(k,k);
+        Rinv.zero();
+        if(fullRank)
+        {
+            double frob = 0.0;
+            for(int j=0; j<k; j++)
+            {
+                Rinv(j,j) = 1.0/M(j,j);
+                for(int i=j-1; i>=0; i--)
+                {
+                    double s = 0.0;
+                    for(int l=i+1; l<=j; l++)
+                        s += M(i,l)*Rinv(l,j);
+                    Rinv(i,j) = -s/M(i,i);
+                }
+                for(int i=0; i<=j; i++)
+                    frob += Rinv(i,j)*Rinv(i,j);
+            }
+            fullRank = (1.0/sqrt(frob)>TOLLERANCE);
+        }
+
+        if(fullRank)
+        {
+            // A = Q*R*P' gives pinv(A) = P*R^-1*Q', while A' = Q*R*P' gives pinv(A) = Q*R^-T*P'
+            Matrix QRinv(p,k);
+            QRinv.zero();
+            for(int i=0; i<k; i++)
+                for(int j=0; j<k; j++)
+                    QRinv(i,j) = Rinv(j,i);
+            qrApplyQ(M.data(),p,k,beta,QRinv.data());   // Q*R^-T
+
+            factPinv.resize(n,m);
+            for(int i=0; i<k; i++)
+                for(int r=0; r<p; r++)
+                {
+                    if(cols)
+                        factPinv(perm[i],r) = QRinv(r,i);
+                    else
+                        factPinv(r,perm[i]) = QRinv(r,i);
+                }
+            factType = FACT_QR;
+        }
+        else
+        {
+            factPinv = pinv(A, TOLLERANCE);
+            factType = FACT_PINV;
+        }
+    }
+
+    return factPinv*B;
+}
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 const dynContactList& iDynContactSolver::getContactList() const
 {
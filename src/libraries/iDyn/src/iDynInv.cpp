@@ -22,6 +22,7 @@
 #include <iCub/iKin/iKinFwd.h>
 #include <iCub/iDyn/iDyn.h>
 #include <iCub/iDyn/iDynInv.h>
+#include <iCub/iDyn/iDynSpatial.h>
 #include <stdio.h>
 #include <deque>
 #include <string>
@@ -33,6 +34,7 @@ using namespace yarp::math;
 using namespace iCub::ctrl;
 using namespace iCub::iKin;
 using namespace iCub::iDyn;
+using namespace iCub::iDyn::spatial;
 using namespace iCub::skinDynLib;
 
 
@@ -51,6 +53,7 @@ OneLinkNewtonEuler::OneLinkNewtonEuler(iDynLink *dlink)
     link = dlink;
     z0.resize(3); z0.zero(); z0(2)=1;   
     zm.resize(3); zm.zero();
+    buf3.resize(3);
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 OneLinkNewtonEuler::OneLinkNewtonEuler(const NewEulMode _mode, unsigned int verb, iDynLink *dlink)
@@ -61,6 +64,7 @@ OneLinkNewtonEuler::OneLinkNewtonEuler(const NewEulMode _mode, unsigned int verb
     link = dlink;
     z0.resize(3); z0.zero(); z0(2)=1;   
     zm.resize(3); zm.zero();
+    buf3.resize(3);
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void OneLinkNewtonEuler::zero()
@@ -384,6 +388,12 @@ const Vector&   OneLinkNewtonEuler::getrC(bool proj)        { return link->getrC
      //   core computation
      //~~~~~~~~~~~~~~~~~~~~~~
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+const Vector& OneLinkNewtonEuler::toYarp(const Vec3 &v)
+{
+    v.store(buf3);
+    return buf3;
+}
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void OneLinkNewtonEuler::computeAngVel(OneLinkNewtonEuler *prev)
 {
@@ -393,14 +403,14 @@ void OneLinkNewtonEuler::computeAngVel(OneLinkNewtonEuler *prev)
     case DYNAMIC:
     case DYNAMIC_W_ROTOR:
         {
-            Vector w = prev->getAngVel();
+            Vec3 w(prev->getAngVel());
             w[2] += getDq();
-            setAngVel(w*getR());
+            setAngVel(toYarp(Mat3(getR()).transposedTimes(w)));
             //setAngVel( getR().transposed() * ( prev->getAngVel() + getDq() * z0 ));
             break;
         }
     case STATIC:
-        setAngVel(zeros(3));
+        setAngVel(toYarp(Vec3()));
         break;
     }
 }
@@ -413,14 +423,14 @@ void OneLinkNewtonEuler::computeAngVelBackward(OneLinkNewtonEuler *next)
     case DYNAMIC:
     case DYNAMIC_W_ROTOR:
         {
-            Vector w = next->getR() * next->getAngVel();
+            Vec3 w = Mat3(next->getR()) * Vec3(next->getAngVel());
             w[2] -= next->getDq();
-            setAngVel(w);
+            setAngVel(toYarp(w));
             //setAngVel( next->getR() * next->getAngVel() - next->getDq() * z0 );
             break;
         }
     case STATIC:
-        setAngVel(zeros(3));
+        setAngVel(toYarp(Vec3()));
         break;
     }
 }
@@ -432,27 +442,27 @@ void OneLinkNewtonEuler::computeAngAcc(OneLinkNewtonEuler *prev)
     case DYNAMIC:
     case DYNAMIC_W_ROTOR:
         {
-            Vector dw = prev->getAngAcc();
-            const Vector& prevW = prev->getAngVel();
+            Vec3 dw(prev->getAngAcc());
+            Vec3 prevW(prev->getAngVel());
             dw[0] += getDq()*prevW[1];
             dw[1] -= getDq()*prevW[0];
             dw[2] += getD2q();
-            setAngAcc(dw * getR());
+            setAngAcc(toYarp(Mat3(getR()).transposedTimes(dw)));
             //setAngAcc( (getR()).transposed() * ( prev->getAngAcc() + getD2q()*z0 + getDq() * cross(prev->getAngVel(),z0));
             break;
         }
     case DYNAMIC_CORIOLIS_GRAVITY:
         {
-            Vector dw = prev->getAngAcc();
-            const Vector& prevW = prev->getAngVel();
+            Vec3 dw(prev->getAngAcc());
+            Vec3 prevW(prev->getAngVel());
             dw[0] += getDq()*prevW[1];
             dw[1] -= getDq()*prevW[0];
-            setAngAcc(dw * getR());
+            setAngAcc(toYarp(Mat3(getR()).transposedTimes(dw)));
             //setAngAcc( (getR()).transposed() * ( prev->getAngAcc() + getDq() * cross(prev->getAngVel(),z0) ));
             break;
         }
     case STATIC:
-        setAngAcc(zeros(3));
+        setAngAcc(toYarp(Vec3()));
         break;
     }
 }
@@ -464,77 +474,72 @@ void OneLinkNewtonEuler::computeAngAccBackward(OneLinkNewtonEuler *next)
     case DYNAMIC:
     case DYNAMIC_W_ROTOR:
         {
-            Vector nextDw = next->getR() * next->getAngAcc();
-            const Vector& w = getAngVel();
+            Vec3 nextDw = Mat3(next->getR()) * Vec3(next->getAngAcc());
+            Vec3 w(getAngVel());
             nextDw[0] -= next->getDq()*w[1];
             nextDw[1] += next->getDq()*w[0];
             nextDw[2] -= next->getD2q();
-            setAngAcc(nextDw);
+            setAngAcc(toYarp(nextDw));
             //setAngAcc( next->getR() * next->getAngAcc() - next->getD2q() * z0 - next->getDq() * cross(getAngVel(),z0) );
             break;
         }
     case DYNAMIC_CORIOLIS_GRAVITY:
         {
-            Vector nextDw = next->getR() * next->getAngAcc();
-            const Vector& w = getAngVel();
+            Vec3 nextDw = Mat3(next->getR()) * Vec3(next->getAngAcc());
+            Vec3 w(getAngVel());
             nextDw[0] -= next->getDq()*w[1];
             nextDw[1] += next->getDq()*w[0];
-            setAngAcc(nextDw);
+            setAngAcc(toYarp(nextDw));
             //setAngAcc( next->getR() * next->getAngAcc() - next->getDq() * cross(getAngVel(),z0) );
             break;
         }
     case STATIC:
-        setAngAcc(zeros(3));
+        setAngAcc(toYarp(Vec3()));
         break;
     }
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void OneLinkNewtonEuler::computeLinAcc(OneLinkNewtonEuler *prev)
 {
-    const Matrix& R = getR();
+    Mat3 R(getR());
+    Vec3 ddp = R.transposedTimes(Vec3(prev->getLinAcc()));
     switch(mode)
     {
     case DYNAMIC:
     case DYNAMIC_CORIOLIS_GRAVITY:
     case DYNAMIC_W_ROTOR:
         {
-            const Vector& r = getr(true);
-            Vector temp = prev->getLinAcc()*R;
-            temp += cross(link->dw, r);
-            temp += cross(link->w, cross(link->w, r));
-            setLinAcc(temp);
+            MotionVector acc(Vec3(link->dw), ddp);
+            setLinAcc(toYarp(acc.shiftAcc(Vec3(link->w), Vec3(getr(true)))));
             /*setLinAcc( prev->getLinAcc()*R
                 + cross(getAngAcc(), r)
                 + cross(getAngVel(), cross(getAngVel(), r)) );*/
             break;
         }
     case STATIC:
-        setLinAcc( prev->getLinAcc()*R );
+        setLinAcc(toYarp(ddp));
         break;
     }
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void OneLinkNewtonEuler::computeLinAccBackward(OneLinkNewtonEuler *next)
 {
-    const Matrix& R = next->getR();
+    Mat3 R(next->getR());
     switch(mode)
     {
     case DYNAMIC:
     case DYNAMIC_CORIOLIS_GRAVITY:
     case DYNAMIC_W_ROTOR:
         {
-            const Vector& r = next->getr(true);
-            Vector temp = next->getLinAcc();
-            temp -= cross(next->getAngAcc(), r);
-            temp -= cross(next->getAngVel(), cross(next->getAngVel(), r));
-            setLinAcc(R*temp);
+            MotionVector acc(Vec3(next->getAngAcc()), Vec3(next->getLinAcc()));
+            setLinAcc(toYarp(R * acc.shiftAcc(Vec3(next->getAngVel()), -1.0*Vec3(next->getr(true)))));
             /*setLinAcc(R * (next->getLinAcc() 
                 - cross(next->getAngAcc(), r) 
                 - cross(next->getAngVel(), cross(next->getAngVel(), r)) ));*/
             break;
         }
     case STATIC:
-        setLinAcc( R * next->getLinAcc() );
+        setLinAcc(toYarp(R * Vec3(next->getLinAcc())));
         break;
     }
 }
@@ -547,10 +552,8 @@ void OneLinkNewtonEuler::computeLinAccC()
     case DYNAMIC_CORIOLIS_GRAVITY:
     case DYNAMIC_W_ROTOR:
         {
-            Vector temp = getLinAcc();
-            temp += cross(getAngAcc(),getrC());
-            temp += cross(getAngVel(),cross(getAngVel(),getrC()));
-            setLinAccC(temp);
+            MotionVector acc = MotionVector(Vec3(getAngAcc()), Vec3(getLinAcc()));
+            setLinAccC(toYarp(acc.shiftAcc(Vec3(getAngVel()), Vec3(getrC()))));
             //setLinAccC( getLinAcc() + cross(getAngAcc(),getrC()) + cross(getAngVel(),cross(getAngVel(),getrC())));
             break;
         }
@@ -569,130 +572,122 @@ void OneLinkNewtonEuler::computeAngAccM(OneLinkNewtonEuler *prev)
         setAngAccM( prev->getAngAcc());
         break;
     case DYNAMIC_W_ROTOR:
-        setAngAccM( prev->getAngAcc() + (getKr() * getD2q()) * zm
-            + (getKr() * getDq()) * cross(prev->getAngVel(),zm) );
-        break;
+        {
+            Vec3 z(zm);
+            Vec3 dwM(prev->getAngAcc());
+            dwM += (getKr() * getD2q()) * z;
+            dwM += (getKr() * getDq()) * cross(Vec3(prev->getAngVel()),z);
+            setAngAccM(toYarp(dwM));
+            /*setAngAccM( prev->getAngAcc() + (getKr() * getD2q()) * zm
+                + (getKr() * getDq()) * cross(prev->getAngVel(),zm) );*/
+            break;
+        }
     case STATIC:
-        setAngAccM(zeros(3)); 
+        setAngAccM(toYarp(Vec3()));
         break;
     }
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ForceVector OneLinkNewtonEuler::computeWrenchBackward(OneLinkNewtonEuler *next)
+{
+    // the wrench is first computed in the frame of the following link
+    Vec3 Fn(next->getForce());
+    Vec3 rnp(next->getr(true));
+    Vec3 mddpC = next->getMass() * Vec3(next->getLinAccC());
+    ForceVector wrench;
+    wrench.f = Fn + mddpC;
+    wrench.mu = cross(rnp, Fn);
+    wrench.mu += cross(rnp + Vec3(next->getrC()), mddpC);
+    wrench.mu += Vec3(next->getMoment(false));
+
+    if(mode!=STATIC)
+    {
+        Mat3 I(next->getInertia());
+        Vec3 w(next->getAngVel());
+        wrench.mu += I * Vec3(next->getAngAcc());
+        wrench.mu += cross(w, I * w);
+    }
+
+    wrench = wrench.rotate(Mat3(next->getR()));
+
+    if(mode==DYNAMIC_W_ROTOR)
+    {
+        Vec3 z(next->getZM());
+        wrench.mu += (next->getKr() * next->getD2q() * next->getIm()) * z;
+        wrench.mu += (next->getKr() * next->getDq() * next->getIm()) * cross(Vec3(next->getAngVel()), z);
+    }
+
+    /*setForce( next->getR() * ( next->getForce() + next->getMass() * next->getLinAccC()));
+      setMoment( Rn * ( cross(rnp , next->getForce()) 
+                      + cross(rnp + next->getrC() , next->getMass() * next->getLinAccC())
+                      + next->getMoment(false)
+                      + next->getInertia() * next->getAngAcc() 
+                      + cross( next->getAngVel() , next->getInertia() * next->getAngVel()))
+              + next->getKr() * next->getD2q() * next->getIm() * next->getZM()
+              + next->getKr() * next->getDq() * next->getIm() * cross(next->getAngVel(),next->getZM()) );
+      (inertial terms in dynamic modes only, rotor terms in DYNAMIC_W_ROTOR only) */
+    return wrench;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ForceVector OneLinkNewtonEuler::computeWrenchForward(OneLinkNewtonEuler *prev)
+{
+    Mat3 R(getR());
+    Vec3 RTr(getr(true));
+    Vec3 mddpC = getMass() * Vec3(getLinAccC());
+    Vec3 Mu(prev->getMoment(false));
+
+    if(mode==DYNAMIC_W_ROTOR)
+    {
+        Vec3 z(getZM());
+        Mu -= (getKr() * getD2q() * getIm()) * z;
+        Mu -= (getKr() * getDq() * getIm()) * cross(Vec3(getAngVel()), z);
+    }
+
+    // the wrench of the previous link is brought to the frame of this link
+    ForceVector wrench = ForceVector(Vec3(prev->getForce()), Mu).rotateTransposed(R);
+    wrench.f -= mddpC;
+    wrench.mu -= cross(RTr, wrench.f);
+    wrench.mu -= cross(RTr + Vec3(getrC()), mddpC);
+
+    if(mode!=STATIC)
+    {
+        Mat3 I(getInertia());
+        Vec3 w(getAngVel());
+        wrench.mu -= I * Vec3(getAngAcc());
+        wrench.mu -= cross(w, I * w);
+    }
+
+    /*setForce( prev->getForce()*getR() - getMass() * getLinAccC() );
+      setMoment( (prev->getMoment(false)
+                - getKr() * getD2q() * getIm() * getZM()
+                - getKr() * getDq() * getIm() * cross(getAngVel(),getZM()))*R
+          - cross(RTr, getForce())
+          - cross(RTr + getrC(), getMass() * getLinAccC())
+          - getInertia() * getAngAcc()
+          - cross( getAngVel(), getInertia()*getAngVel())
+          );
+      (inertial terms in dynamic modes only, rotor terms in DYNAMIC_W_ROTOR only) */
+    return wrench;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void OneLinkNewtonEuler::computeForceBackward(OneLinkNewtonEuler *next)
 {
-    Vector temp = next->getMass() * next->getLinAccC();
-    temp += next->getForce();
-    setForce(next->getR() * temp);
+    setForce(toYarp(computeWrenchBackward(next).f));
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void OneLinkNewtonEuler::computeForceForward(OneLinkNewtonEuler *prev)
 {
-    Vector temp = prev->getForce()*getR();
-    temp -= getMass() * getLinAccC();
-    setForce(temp);
-    //setForce( prev->getForce()*getR() - getMass() * getLinAccC() );
+    setForce(toYarp(computeWrenchForward(prev).f));
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void OneLinkNewtonEuler::computeMomentBackward(OneLinkNewtonEuler *next)
 {
-    const Matrix& Rn = next->getR();
-    const Vector& rnp = next->getr(true);
-    switch(mode)
-    {
-    case DYNAMIC_CORIOLIS_GRAVITY:
-    case DYNAMIC:
-        {
-            Vector temp = cross(rnp , next->getForce());
-            temp += cross(rnp + next->getrC() , next->getMass() * next->getLinAccC());
-            temp += next->getMoment(false);
-            temp += next->getInertia() * next->getAngAcc();
-            temp += cross( next->getAngVel() , next->getInertia() * next->getAngVel());
-            setMoment(Rn*temp);
-            /*setMoment( Rn * ( cross(rnp , next->getForce()) 
-                            + cross(rnp + next->getrC() , next->getMass() * next->getLinAccC())
-                            + next->getMoment(false)
-                            + next->getInertia() * next->getAngAcc() 
-                            + cross( next->getAngVel() , next->getInertia() * next->getAngVel()))
-                    );*/
-            break;
-        }
-    case DYNAMIC_W_ROTOR:
-        setMoment( Rn * ( cross(rnp , next->getForce()) 
-                    + cross(rnp + next->getrC() , next->getMass() * next->getLinAccC())
-                    + next->getMoment(false)
-                    + next->getInertia() * next->getAngAcc() 
-                    + cross( next->getAngVel() , next->getInertia() * next->getAngVel()))
-            + next->getKr() * next->getD2q() * next->getIm() * next->getZM()
-            + next->getKr() * next->getDq() * next->getIm() * cross(next->getAngVel(),next->getZM()) );
-        break;
-    case STATIC:
-        {
-            Vector temp = cross(rnp , next->getForce());
-            temp += cross(rnp + next->getrC() , next->getMass() * next->getLinAccC());
-            temp += next->getMoment(false);
-            setMoment(Rn*temp);
-            /*setMoment( Rn * ( cross(rnp , next->getForce()) 
-                        + cross(rnp + next->getrC() , next->getMass() * next->getLinAccC())
-                        + next->getMoment(false)));*/
-            break;
-        }
-    }
+    setMoment(toYarp(computeWrenchBackward(next).mu));
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void OneLinkNewtonEuler::computeMomentForward( OneLinkNewtonEuler *prev)
 {
-    const Matrix& R = link->getR();
-    const Vector& RTr = link->getr(true);
-    switch(mode)
-    {
-    case DYNAMIC_CORIOLIS_GRAVITY:
-    case DYNAMIC:
-        {
-            Vector temp = prev->getMoment(false)*R;
-            temp -= cross(RTr, link->F);
-            temp -= cross(RTr + link->rc, link->m * link->ddpC);
-            temp -= link->I * link->dw;
-            temp -= cross( link->w, link->I * link->w);
-            setMoment(temp);
-            /*setMoment( prev->getMoment(false)*R- cross(RTr, getForce())
-                - cross(RTr + getrC(), getMass() * getLinAccC())
-                - getInertia() * getAngAcc()
-                - cross( getAngVel(), getInertia()*getAngVel())
-                );*/
-            break;
-        }
-    case DYNAMIC_W_ROTOR:
-        {
-            Vector temp = prev->getMoment(false);
-            temp -= getKr() * getD2q() * getIm() * getZM();
-            temp -= getKr() * getDq() * getIm() * cross(getAngVel(),getZM());
-            temp *= R;
-            temp -= cross(RTr, getForce());
-            temp -= cross(RTr + getrC(), getMass() * getLinAccC());
-            temp -= getInertia() * getAngAcc();
-            temp -= cross( getAngVel(), getInertia()*getAngVel());
-            setMoment(temp);
-            /*setMoment( (prev->getMoment(false)
-                      - getKr() * getD2q() * getIm() * getZM()
-                      - getKr() * getDq() * getIm() * cross(getAngVel(),getZM()))*R
-                - cross(RTr, getForce())
-                - cross(RTr + getrC(), getMass() * getLinAccC())
-                - getInertia() * getAngAcc()
-                - cross( getAngVel(), getInertia()*getAngVel())
-                );*/
-            break;
-        }
-    case STATIC:
-        {
-            Vector temp = prev->getMoment(false)*R;
-            temp -= cross(RTr, getForce());
-            temp -= cross(RTr + getrC(), getMass() * getLinAccC());
-            setMoment(temp);
-            /*setMoment( prev->getMoment(false)*R - cross(RTr, getForce())
-                - cross(RTr + getrC(), getMass() * getLinAccC()));*/
-            break;
-        }
-    }
+    setMoment(toYarp(computeWrenchForward(prev).mu));
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void OneLinkNewtonEuler::computeTorque(OneLinkNewtonEuler *prev)
@@ -736,14 +731,16 @@ void OneLinkNewtonEuler::BackwardKinematics( OneLinkNewtonEuler *prev)
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void OneLinkNewtonEuler::BackwardWrench( OneLinkNewtonEuler *next)
 {
-    this->computeForceBackward(next);
-    this->computeMomentBackward(next);
+    ForceVector wrench = computeWrenchBackward(next);
+    setForce(toYarp(wrench.f));
+    setMoment(toYarp(wrench.mu));
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void OneLinkNewtonEuler::ForwardWrench( OneLinkNewtonEuler *prev)
 {
-    this->computeForceForward(prev);
-    this->computeMomentForward(prev);
+    ForceVector wrench = computeWrenchForward(prev);
+    setForce(toYarp(wrench.f));
+    setMoment(toYarp(wrench.mu));
     this->computeTorque(prev);
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,288 @@
+/*
+ * Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-3-Clause license. See the accompanying LICENSE file for details.
+*/
+
+#include <cstring>
+#include <yarp/os/Vocab.h>
+#include <yarp/os/ConnectionReader.h>
+#include <yarp/os/ConnectionWriter.h>
+#include <iCub/iDyn/iDynWholeBodyState.h>
+
+#define WBS_VOCAB   yarp::os::createVocab('w','b','d','s')
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace iCub::iDyn;
+
+namespace
+{
+    const char *fieldNames[WBS_FIELD_NUM]=
+    {
+        "torques_head",
+        "torques_torso",
+        "torques_left_arm",
+        "torques_right_arm",
+        "torques_left_leg",
+        "torques_right_leg",
+        "wrench_torso",
+        "wrench_left_arm",
+        "wrench_right_arm",
+        "wrench_left_leg",
+        "wrench_right_leg",
+        "wrench_left_foot",
+        "wrench_right_foot",
+        "cartesian_wrench_left_arm",
+        "cartesian_wrench_right_arm",
+        "cartesian_wrench_left_leg",
+        "cartesian_wrench_right_leg",
+        "cartesian_wrench_left_foot",
+        "cartesian_wrench_right_foot",
+        "sensor_wrench_left_arm",
+        "sensor_wrench_right_arm",
+        "sensor_wrench_left_leg",
+        "sensor_wrench_right_leg",
+        "com_all",
+        "com_lower_body",
+        "com_upper_body",
+        "com_left_arm",
+        "com_right_arm",
+        "com_left_leg",
+        "com_right_leg",
+        "com_head",
+        "com_torso",
+        "com_all_foot",
+        "com_velocity",
+        "all_positions",
+        "all_velocities",
+        "com_jacobian",
+        "com_analytic_jacobian",
+        "centroidal_momentum_matrix",
+        "root_position_mat",
+        "root_position_vec"
+    };
+
+    // upper bound on the values carried by one state (4 MB of payload),
+    // far beyond any whole-body layout but safe against corrupted sizes
+    const size_t maxValues=512*1024;
+}
+
+const int wholeBodyState::VERSION=1;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+wholeBodyState::wholeBodyState()
+{
+    clear();
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void wholeBodyState::clear()
+{
+    nFields=0;
+    nValues=0;
+    for (int i=0; i<WBS_FIELD_NUM; i++)
+        lookup[i]=-1;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool wholeBodyState::append(const int field, const int rows, const int cols, const double *data)
+{
+    if ((field<0) || (field>=WBS_FIELD_NUM) || (lookup[field]>=0))
+        return false;
+
+    if ((rows<0) || (cols<0))
+        return false;
+
+    size_t len=(size_t)rows*cols;
+    if ((len>maxValues-nValues) || ((len>0) && (data==NULL)))
+        return false;
+
+    FieldInfo info;
+    info.id=field;
+    info.rows=rows;
+    info.cols=cols;
+    info.offset=(int)nValues;
+
+    // the storage only grows, hence a steady layout does not allocate
+    if (fields.size()<=nFields)
+        fields.push_back(info);
+    else
+        fields[nFields]=info;
+
+    if (values.size()<nValues+len)
+        values.resize(nValues+len);
+    if (len>0)
+        memcpy(values.data()+nValues,data,len*sizeof(double));
+
+    lookup[field]=(int)nFields;
+    nFields++;
+    nValues+=len;
+    return true;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool wholeBodyState::add(const int field, const Vector &v)
+{
+    return append(field,1,(int)v.length(),v.data());
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool wholeBodyState::add(const int field, const Matrix &m)
+{
+    // yarp matrices are stored by rows in a contiguous block
+    return append(field,(int)m.rows(),(int)m.cols(),m.data());
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool wholeBodyState::has(const int field) const
+{
+    return ((field>=0) && (field<WBS_FIELD_NUM) && (lookup[field]>=0));
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+const double *wholeBodyState::getData(const int field, int &rows, int &cols) const
+{
+    if (!has(field))
+    {
+        rows=cols=0;
+        return NULL;
+    }
+
+    const FieldInfo &info=fields[lookup[field]];
+    rows=info.rows;
+    cols=info.cols;
+    return values.data()+info.offset;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool wholeBodyState::get(const int field, Vector &v) const
+{
+    int rows,cols;
+    const double *data=getData(field,rows,cols);
+    if (data==NULL)
+        return false;
+
+    v.resize(rows*cols);
+    if (v.length()>0)
+        memcpy(v.data(),data,v.length()*sizeof(double));
+    return true;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool wholeBodyState::get(const int field, Matrix &m) const
+{
+    int rows,cols;
+    const double *data=getData(field,rows,cols);
+    if (data==NULL)
+        return false;
+
+    m.resize(rows,cols);
+    if (rows*cols>0)
+        memcpy(m.data(),data,rows*cols*sizeof(double));
+    return true;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+int wholeBodyState::getFieldId(const int i) const
+{
+    if ((i<0) || (i>=(int)nFields))
+        return -1;
+
+    return fields[i].id;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+string wholeBodyState::getFieldName(const int field)
+{
+    if ((field<0) || (field>=WBS_FIELD_NUM))
+        return string();
+
+    return fieldNames[field];
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool wholeBodyState::write(ConnectionWriter& connection) const
+{
+    // header: magic, version, stamp
+    connection.appendInt(WBS_VOCAB);
+    connection.appendInt(VERSION);
+    connection.appendInt(stamp.getCount());
+    connection.appendDouble(stamp.getTime());
+
+    // schema: one entry per field
+    connection.appendInt((int)nFields);
+    for (size_t i=0; i<nFields; i++)
+    {
+        connection.appendInt(fields[i].id);
+        connection.appendInt(fields[i].rows);
+        connection.appendInt(fields[i].cols);
+        connection.appendInt(fields[i].offset);
+    }
+
+    // payload: all the values as one raw block
+    connection.appendInt((int)nValues);
+    if (nValues>0)
+        connection.appendBlock((const char*)values.data(),nValues*sizeof(double));
+
+    return !connection.isError();
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool wholeBodyState::read(ConnectionReader& connection)
+{
+    clear();
+
+    if (connection.expectInt()!=WBS_VOCAB)
+        return false;
+    if (connection.expectInt()!=VERSION)
+        return false;
+
+    int count=connection.expectInt();
+    double time=connection.expectDouble();
+    stamp=Stamp(count,time);
+
+    int n=connection.expectInt();
+    if ((n<0) || (n>WBS_FIELD_NUM))
+        return false;
+
+    if ((int)fields.size()<n)
+        fields.resize(n);
+    for (int i=0; i<n; i++)
+    {
+        FieldInfo &info=fields[i];
+        info.id=connection.expectInt();
+        info.rows=connection.expectInt();
+        info.cols=connection.expectInt();
+        info.offset=connection.expectInt();
+        if ((info.id<0) || (info.id>=WBS_FIELD_NUM) || (lookup[info.id]>=0) ||
+            (info.rows<0) || (info.cols<0) || (info.offset<0))
+        {
+            clear();
+            return false;
+        }
+        lookup[info.id]=i;
+    }
+    nFields=n;
+
+    // never trust the size on the wire: it cannot exceed the bytes
+    // actually carried by the connection
+    int len=connection.expectInt();
+    if ((len<0) || ((size_t)len>maxValues) ||
+        ((size_t)len*sizeof(double)>connection.getSize()))
+    {
+        clear();
+        return false;
+    }
+    for (size_t i=0; i<nFields; i++)
+    {
+        if (fields[i].offset+(size_t)fields[i].rows*fields[i].cols>(size_t)len)
+        {
+            clear();
+            return false;
+        }
+    }
+
+    if ((int)values.size()<len)
+        values.resize(len);
+    if ((len>0) && !connection.expectBlock((char*)values.data(),len*sizeof(double)))
+    {
+        clear();
+        return false;
+    }
+    nValues=len;
+
+    return !connection.isError();
+}
+
@@ -55,6 +55,7 @@
 
 #include <string>
 #include <deque>
+#include <vector>
 
 #include <yarp/os/Property.h>
 #include <yarp/dev/ControlBoardInterfaces.h>
@@ -98,6 +99,7 @@ protected:
     bool         cumulative;
     bool         constrained;
     unsigned int verbose;
+    unsigned int rev;
 
     yarp::sig::Matrix H;
     yarp::sig::Matrix cumH;
@@ -118,6 +120,7 @@ protected:
     void         release()          { blocked=false;              }
     void         rmCumH()           { cumulative=false;           }
     void         addCumH(const yarp::sig::Matrix &_cumH);
+    void         computeH(double *_H, const bool c_override);
 
 public:
     /**
@@ -191,7 +194,7 @@ public:
     * Sets the Link length A. 
     * @param new Link length _A. 
     */
-    void setA(const double _A) { A=_A; }
+    void setA(const double _A) { A=_A; rev++; }
 
     /**
     * Returns the Link offset D.
@@ -227,7 +230,7 @@ public:
     * Sets the joint angle offset. 
     * @param new joint angle offset _Offset. 
     */
-    void setOffset(const double _Offset) { Offset=_Offset; }
+    void setOffset(const double _Offset) { Offset=_Offset; rev++; }
 
     /**
     * Returns the joint angle lower bound.
@@ -370,10 +373,22 @@ protected:
     yarp::sig::Matrix hess_J;
     yarp::sig::Matrix hess_Jlnk;
 
+    std::vector<double>       intH;
+    std::vector<double>       sufH;
+    std::vector<unsigned int> intRev;
+    unsigned int              intValid;
+    bool                      intHNValid;
+    unsigned long             cacheHits;
+    unsigned long             cacheMisses;
+
     virtual void clone(const iKinChain &c);
     virtual void build();
     virtual void dispose();
 
+    void computeH(const unsigned int i, const bool allLink, double *H);
+    void computeIntH(const unsigned int n);
+    const double *computeIntHN();
+
     yarp::sig::Vector RotAng(const yarp::sig::Matrix &R);
     yarp::sig::Vector dRotAng(const yarp::sig::Matrix &R, const yarp::sig::Matrix &dR);
     yarp::sig::Vector d2RotAng(const yarp::sig::Matrix &R, const yarp::sig::Matrix &dRi,
@@ -858,6 +873,29 @@ public:
     */
     yarp::sig::Matrix DJacobian(const unsigned int lnk, const yarp::sig::Vector &dq);
 
+    /**
+    * Returns the statistics of the cache of the links 
+    * transformations. 
+    * @param hits is the number of link transformations reused 
+    *             from the cache since the last reset.
+    * @param misses is the number of link transformations 
+    *               recomputed since the last reset.
+    * @note The cache stores the cumulative products of the links 
+    *       transformations from the root frame and is invalidated
+    *       from the first link whose joint angle or parameters
+    *       have changed, so that queries performed on the same
+    *       configuration (e.g. getH(i), Position(i),
+    *       GeoJacobian()) as well as queries following the change
+    *       of the most distal joints reuse the common prefix.
+    */
+    void getCacheStats(unsigned long &hits, unsigned long &misses) const;
+
+    /**
+    * Resets the statistics of the cache of the links 
+    * transformations. 
+    */
+    void resetCacheStats() { cacheHits=cacheMisses=0; }
+
     /**
     * Destructor. 
     */
@@ -1030,6 +1068,38 @@ public:
     */
     virtual bool alignJointsBounds(const std::deque<yarp::dev::IControlLimits*>&) { notImplemented(verbose); return true; }
 
+    /**
+    * Computes the end-effector poses and, optionally, the 
+    * geometric Jacobians for a batch of joints configurations. 
+    * The current configuration of the Limb is not affected. 
+    * @param q is the DOFxM matrix of the M configurations stored 
+    *          as structure of arrays, i.e. the ith row contains
+    *          the values of the ith DOF for all the
+    *          configurations (angles constraints are evaluated).
+    * @param poses is the output 7xM (axis/angle notation) or 6xM 
+    *              (Euler angles) matrix where the kth column
+    *              contains the kth end-effector pose, as returned
+    *              by EndEffPose().
+    * @param jacobians if not NULL, is the output (6*DOF)xM matrix 
+    *                  where the kth column contains the kth
+    *                  6xDOF geometric Jacobian stored by rows,
+    *                  i.e. the element (r,c) of the Jacobian lies
+    *                  in the row r*DOF+c.
+    * @param axisRep if true returns the axis/angle notation. 
+    * @param nThreads is the number of threads the batch is split 
+    *                 over (0 to use the available cores).
+    * @return true/false on success/failure. 
+    *  
+    * @note Configurations are processed in blocks, with the 
+    *       innermost loops running across configurations over
+    *       contiguous memory, so that the compiler can vectorize
+    *       them. H0 and HN are assumed to be rigid
+    *       transformations.
+    */
+    bool EndEffPoseBatch(const yarp::sig::Matrix &q, yarp::sig::Matrix &poses,
+                         yarp::sig::Matrix *jacobians=NULL, const bool axisRep=true,
+                         const unsigned int nThreads=0);
+
     /**
     * Destructor. 
     */
@@ -0,0 +1,594 @@
+/*
+ * Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD-3-Clause license. See the accompanying LICENSE file for
+ * details.
+*/
+
+/**
+ * \defgroup iKinFwdFixed iKinFwdFixed
+ *
+ * @ingroup iKinFwd
+ *
+ * Allocation-free forward kinematics working on fixed-size
+ * storage provided by the caller.
+ *
+ * Homogeneous transformations are stored as row-major arrays of
+ * 16 doubles, i.e. with the same layout of the data() buffer of
+ * a 4x4 yarp::sig::Matrix; Jacobians are stored as row-major
+ * 6xDOF arrays. None of the routines here allocates memory,
+ * hence they can be safely employed within high-rate control
+ * loops. The dynamically sized iKinChain relies on the same
+ * kernels internally.
+ */
+
+#ifndef __IKINFWDFIXED_H__
+#define __IKINFWDFIXED_H__
+
+#include <cmath>
+#include <cstring>
+
+#include <iCub/iKin/iKinFwd.h>
+
+
+namespace iCub
+{
+
+namespace iKin
+{
+
+namespace fixed
+{
+
+/**
+* \ingroup iKinFwdFixed
+*
+* Sets H to the 4x4 identity.
+* @param H the 16-elements output buffer.
+*/
+inline void eye(double *H)
+{
+    std::memset(H,0,16*sizeof(double));
+    H[0]=H[5]=H[10]=H[15]=1.0;
+}
+
+
+/**
+* \ingroup iKinFwdFixed
+*
+* Copies a 4x4 matrix.
+* @param src the source buffer.
+* @param dst the destination buffer.
+*/
+inline void copy(const double *src, double *dst)
+{
+    std::memcpy(dst,src,16*sizeof(double));
+}
+
+
+/**
+* \ingroup iKinFwdFixed
+*
+* Fills the varying part (i.e. the first two rows) of the
+* Denavit-Hartenberg transformation of a link.
+* @param A is the Link length.
+* @param c_alpha is the cosine of the Link twist.
+* @param s_alpha is the sine of the Link twist.
+* @param theta is the joint angle comprising the offset.
+* @param H the 16-elements buffer whose last two rows are
+*          assumed to be already filled in via dhInit().
+*/
+inline void dhUpdate(const double A, const double c_alpha,
+                     const double s_alpha, const double theta,
+                     double *H)
+{
+    const double c_theta=std::cos(theta);
+    const double s_theta=std::sin(theta);
+
+    H[0]=c_theta;
+    H[1]=-s_theta*c_alpha;
+    H[2]=s_theta*s_alpha;
+    H[3]=c_theta*A;
+
+    H[4]=s_theta;
+    H[5]=c_theta*c_alpha;
+    H[6]=-c_theta*s_alpha;
+    H[7]=s_theta*A;
+}
+
+
+/**
+* \ingroup iKinFwdFixed
+*
+* Fills the constant part (i.e. the last two rows) of the
+* Denavit-Hartenberg transformation of a link.
+* @param D is the Link offset.
+* @param c_alpha is the cosine of the Link twist.
+* @param s_alpha is the sine of the Link twist.
+* @param H the 16-elements output buffer.
+*/
+inline void dhInit(const double D, const double c_alpha,
+                   const double s_alpha, double *H)
+{
+    H[8]=0.0;  H[9]=s_alpha; H[10]=c_alpha; H[11]=D;
+    H[12]=0.0; H[13]=0.0;    H[14]=0.0;     H[15]=1.0;
+}
+
+
+/**
+* \ingroup iKinFwdFixed
+*
+* Computes the full Denavit-Hartenberg transformation of a link.
+* @param A is the Link length.
+* @param D is the Link offset.
+* @param c_alpha is the cosine of the Link twist.
+* @param s_alpha is the sine of the Link twist.
+* @param theta is the joint angle comprising the offset.
+* @param H the 16-elements output buffer.
+*/
+inline void dh(const double A, const double D, const double c_alpha,
+               const double s_alpha, const double theta, double *H)
+{
+    dhInit(D,c_alpha,s_alpha,H);
+    dhUpdate(A,c_alpha,s_alpha,theta,H);
+}
+
+
+/**
+* \ingroup iKinFwdFixed
+*
+* Computes the first derivative of the Denavit-Hartenberg
+* transformation of a link with respect to the joint angle.
+* @param A is the Link length.
+* @param c_alpha is the cosine of the Link twist.
+* @param s_alpha is the sine of the Link twist.
+* @param theta is the joint angle comprising the offset.
+* @param DH the 16-elements output buffer.
+*/
+inline void dhDerivative(const double A, const double c_alpha,
+                         const double s_alpha, const double theta,
+                         double *DH)
+{
+    const double c_theta=std::cos(theta);
+    const double s_theta=std::sin(theta);
+
+    DH[0]=-s_theta;
+    DH[1]=-c_theta*c_alpha;
+    DH[2]=c_theta*s_alpha;
+    DH[3]=-s_theta*A;
+
+    DH[4]=c_theta;
+    DH[5]=-s_theta*c_alpha;
+    DH[6]=s_theta*s_alpha;
+    DH[7]=c_theta*A;
+
+    std::memset(DH+8,0,8*sizeof(double));
+}
+
+
+/**
+* \ingroup iKinFwdFixed
+*
+* Computes C=A*B, where B is a homogeneous transformation (i.e.
+* its last row is [0 0 0 1]).
+* @param A the first operand.
+* @param B the second operand.
+* @param C the 16-elements output buffer (it must not alias A
+*          or B).
+*/
+inline void mulH(const double *A, const double *B, double *C)
+{
+    for (int r=0; r<16; r+=4)
+    {
+        const double a0=A[r],a1=A[r+1],a2=A[r+2];
+        C[r]  =a0*B[0]+a1*B[4]+a2*B[8];
+        C[r+1]=a0*B[1]+a1*B[5]+a2*B[9];
+        C[r+2]=a0*B[2]+a1*B[6]+a2*B[10];
+        C[r+3]=a0*B[3]+a1*B[7]+a2*B[11]+A[r+3];
+    }
+}
+
+
+/**
+* \ingroup iKinFwdFixed
+*
+* Computes C=A*B for generic 4x4 matrices.
+* @param A the first operand.
+* @param B the second operand.
+* @param C the 16-elements output buffer (it must not alias A
+*          or B).
+*/
+inline void mul(const double *A, const double *B, double *C)
+{
+    for (int r=0; r<16; r+=4)
+    {
+        const double a0=A[r],a1=A[r+1],a2=A[r+2],a3=A[r+3];
+        for (int c=0; c<4; c++)
+            C[r+c]=a0*B[c]+a1*B[4+c]+a2*B[8+c]+a3*B[12+c];
+    }
+}
+
+
+/**
+* \ingroup iKinFwdFixed
+*
+* Computes A=A*B, where B is a homogeneous transformation.
+* @param A the first operand, overwritten with the result.
+* @param B the second operand.
+*/
+inline void mulHInPlace(double *A, const double *B)
+{
+    double tmp[16];
+    mulH(A,B,tmp);
+    copy(tmp,A);
+}
+
+
+/**
+* \ingroup iKinFwdFixed
+*
+* Computes the axis/angle representation of the rotational part
+* of H with the same formulas of yarp::math::dcm2axis().
+* @param H the homogeneous transformation.
+* @param v the 4-elements output buffer.
+* @return false if the rotation is degenerate (angle equal to 0
+*         or pi), that is when the rotation axis cannot be
+*         retrieved in closed form; v is left untouched.
+*/
+inline bool dcm2axis(const double *H, double *v)
+{
+    const double x=H[9]-H[6];
+    const double y=H[2]-H[8];
+    const double z=H[4]-H[1];
+    const double r=std::sqrt(x*x+y*y+z*z);
+    if (r<1e-9)
+        return false;
+
+    v[0]=(1.0/r)*x;
+    v[1]=(1.0/r)*y;
+    v[2]=(1.0/r)*z;
+    v[3]=std::atan2(0.5*r,0.5*(H[0]+H[5]+H[10]-1.0));
+
+    return true;
+}
+
+
+/**
+* \ingroup iKinFwdFixed
+*
+* Computes the Euler angles (XYZ form) of the rotational part
+* of H, as done by iKinChain::EndEffPose(false).
+* @param H the homogeneous transformation.
+* @param r the 3-elements output buffer.
+*/
+inline void rotAng(const double *H, double *r)
+{
+    r[0]=std::atan2(-H[9],H[10]);
+    r[1]=std::asin(H[8]);
+    r[2]=std::atan2(-H[4],H[0]);
+}
+
+
+/**
+* \ingroup iKinFwdFixed
+*
+* Fills the column of the geometric Jacobian associated with a
+* revolute joint.
+* @param Z the transformation of the frame the joint axis lies
+*          on (z-axis).
+* @param PN the transformation of the end-effector frame.
+* @param J the row-major Jacobian buffer.
+* @param col the column index.
+* @param cols the number of columns of J.
+*/
+inline void geoJacobianCol(const double *Z, const double *PN,
+                           double *J, const unsigned int col,
+                           const unsigned int cols)
+{
+    const double zx=Z[2],zy=Z[6],zz=Z[10];
+    const double dx=PN[3]-Z[3];
+    const double dy=PN[7]-Z[7];
+    const double dz=PN[11]-Z[11];
+
+    J[col]       =zy*dz-zz*dy;
+    J[cols+col]  =zz*dx-zx*dz;
+    J[2*cols+col]=zx*dy-zy*dx;
+    J[3*cols+col]=zx;
+    J[4*cols+col]=zy;
+    J[5*cols+col]=zz;
+}
+
+}
+
+
+/**
+* \ingroup iKinFwdFixed
+*
+* A serial-links chain with a number of links known at compile
+* time, whose forward kinematics is carried out on fixed-size
+* storage with no memory allocation.
+*
+* The chain is a snapshot of an existing iKinChain, which is
+* acquired via fromChain(): links blocking status, constraints
+* and H0/HN transformations are preserved. Joints values are
+* handled in DOF order, as in iKinChain::setAng().
+*
+* @note Specializations for the iCub limbs are given by the
+*       iCubTorsoFixed, iCubArmFixed, iCubLegFixed and
+*       iCubEyeFixed types.
+*/
+template<unsigned int NL>
+class iKinFixedChain
+{
+protected:
+    double A[NL];
+    double c_alpha[NL];
+    double s_alpha[NL];
+    double Offset[NL];
+    double Min[NL];
+    double Max[NL];
+    double Ang[NL];
+    bool   blocked[NL];
+    bool   constrained[NL];
+
+    unsigned int DOF;
+    unsigned int hash[NL];
+
+    double H0[16];
+    double HN[16];
+    double Hlnk[NL][16];
+    double frames[NL+1][16];
+    double HEE[16];
+
+    /************************************************************************/
+    void solve()
+    {
+        for (unsigned int i=0; i<NL; i++)
+        {
+            fixed::dhUpdate(A[i],c_alpha[i],s_alpha[i],Ang[i]+Offset[i],Hlnk[i]);
+            fixed::mulH(frames[i],Hlnk[i],frames[i+1]);
+        }
+
+        fixed::mul(frames[NL],HN,HEE);
+    }
+
+public:
+    /**
+    * Default constructor: all links are set to zero length.
+    */
+    iKinFixedChain() : DOF(NL)
+    {
+        for (unsigned int i=0; i<NL; i++)
+        {
+            A[i]=Offset[i]=Ang[i]=0.0;
+            c_alpha[i]=1.0; s_alpha[i]=0.0;
+            Min[i]=-iCub::ctrl::CTRL_PI;
+            Max[i]=iCub::ctrl::CTRL_PI;
+            blocked[i]=false;
+            constrained[i]=true;
+            hash[i]=i;
+            fixed::dh(0.0,0.0,1.0,0.0,0.0,Hlnk[i]);
+        }
+
+        fixed::eye(H0);
+        fixed::eye(HN);
+        fixed::copy(H0,frames[0]);
+        solve();
+    }
+
+    /**
+    * Acquires links parameters, joints values and H0/HN from an
+    * existing chain.
+    * @param chain the chain to be copied.
+    * @return true iff the chain has exactly NL links.
+    * @note The method does allocate memory, therefore it is
+    *       meant to be called at configuration time.
+    */
+    bool fromChain(iKinChain &chain)
+    {
+        if (chain.getN()!=NL)
+            return false;
+
+        DOF=0;
+        for (unsigned int i=0; i<NL; i++)
+        {
+            iKinLink &l=chain[i];
+            A[i]=l.getA();
+            c_alpha[i]=std::cos(l.getAlpha());
+            s_alpha[i]=std::sin(l.getAlpha());
+            Offset[i]=l.getOffset();
+            Min[i]=l.getMin();
+            Max[i]=l.getMax();
+            Ang[i]=l.getAng();
+            blocked[i]=l.isBlocked();
+            constrained[i]=l.getConstraint();
+            fixed::dhInit(l.getD(),c_alpha[i],s_alpha[i],Hlnk[i]);
+
+            if (!blocked[i])
+                hash[DOF++]=i;
+        }
+
+        yarp::sig::Matrix H=chain.getH0();
+        fixed::copy(H.data(),H0);
+        H=chain.getHN();
+        fixed::copy(H.data(),HN);
+
+        fixed::copy(H0,frames[0]);
+        solve();
+
+        return true;
+    }
+
+    /**
+    * Returns the number of links.
+    * @return number of links.
+    */
+    unsigned int getN() const { return NL; }
+
+    /**
+    * Returns the number of DOF.
+    * @return number of DOF.
+    */
+    unsigned int getDOF() const { return DOF; }
+
+    /**
+    * Sets the free joint angles and updates the kinematics.
+    * @param q the DOF-elements buffer of joints values (angles
+    *          constraints are evaluated).
+    */
+    void setAng(const double *q)
+    {
+        for (unsigned int i=0; i<DOF; i++)
+        {
+            const unsigned int j=hash[i];
+            Ang[j]=constrained[j] ? (q[i]<Min[j] ? Min[j] : (q[i]>Max[j] ? Max[j] : q[i])) : q[i];
+        }
+
+        solve();
+    }
+
+    /**
+    * Retrieves the current free joint angles.
+    * @param q the DOF-elements output buffer.
+    */
+    void getAng(double *q) const
+    {
+        for (unsigned int i=0; i<DOF; i++)
+            q[i]=Ang[hash[i]];
+    }
+
+    /**
+    * Retrieves the roto-translation matrix from the root
+    * reference frame to the end-effector (HN is taken into
+    * account).
+    * @param H the 16-elements output buffer.
+    */
+    void getH(double *H) const { fixed::copy(HEE,H); }
+
+    /**
+    * Retrieves the roto-translation matrix from the root
+    * reference frame to the ith link, spanning over the full set
+    * of links as iKinChain::getH(i,true) does.
+    * @param i is the Link number.
+    * @param H the 16-elements output buffer.
+    * @return true iff i is in range.
+    */
+    bool getH(const unsigned int i, double *H) const
+    {
+        if (i>=NL)
+            return false;
+
+        fixed::copy(i==NL-1 ? HEE : frames[i+1],H);
+        return true;
+    }
+
+    /**
+    * Retrieves the end-effector position.
+    * @param p the 3-elements output buffer.
+    */
+    void EndEffPosition(double *p) const
+    {
+        p[0]=HEE[3];
+        p[1]=HEE[7];
+        p[2]=HEE[11];
+    }
+
+    /**
+    * Retrieves the end-effector pose either in axis/angle
+    * notation (7 elements) or with Euler angles (6 elements).
+    * @param v the output buffer.
+    * @param axisRep if true returns the axis/angle notation.
+    * @note In case of degenerate rotation (angle equal to 0 or
+    *       pi) the axis is retrieved out of the symmetric part of
+    *       the rotation matrix.
+    */
+    void EndEffPose(double *v, const bool axisRep=true) const
+    {
+        EndEffPosition(v);
+        if (axisRep)
+        {
+            if (!fixed::dcm2axis(HEE,v+3))
+            {
+                // R=2*u*u'-I for an angle of pi, R=I otherwise
+                const double c=0.5*(HEE[0]+HEE[5]+HEE[10]-1.0);
+                if (c>0.0)
+                {
+                    v[3]=v[4]=v[6]=0.0;
+                    v[5]=1.0;
+                }
+                else
+                {
+                    const double x=std::sqrt(std::fmax(0.0,0.5*(HEE[0]+1.0)));
+                    const double y=std::sqrt(std::fmax(0.0,0.5*(HEE[5]+1.0)));
+                    const double z=std::sqrt(std::fmax(0.0,0.5*(HEE[10]+1.0)));
+                    if ((x>=y) && (x>=z))
+                    {
+                        v[3]=x; v[4]=0.5*HEE[1]/x; v[5]=0.5*HEE[2]/x;
+                    }
+                    else if (y>=z)
+                    {
+                        v[3]=0.5*HEE[1]/y; v[4]=y; v[5]=0.5*HEE[6]/y;
+                    }
+                    else
+                    {
+                        v[3]=0.5*HEE[2]/z; v[4]=0.5*HEE[6]/z; v[5]=z;
+                    }
+                    v[6]=iCub::ctrl::CTRL_PI;
+                }
+            }
+        }
+        else
+            fixed::rotAng(HEE,v+3);
+    }
+
+    /**
+    * Retrieves the geometric Jacobian of the end-effector.
+    * @param J the row-major 6xDOF output buffer (at least 6*NL
+    *          elements long).
+    * @note The blocked links are not considered.
+    */
+    void GeoJacobian(double *J) const
+    {
+        for (unsigned int i=0; i<DOF; i++)
+            fixed::geoJacobianCol(frames[hash[i]],HEE,J,i,DOF);
+    }
+};
+
+
+/**
+* \ingroup iKinFwdFixed
+*
+* Fixed-size counterpart of iCubTorso.
+*/
+typedef iKinFixedChain<3> iCubTorsoFixed;
+
+/**
+* \ingroup iKinFwdFixed
+*
+* Fixed-size counterpart of iCubArm.
+*/
+typedef iKinFixedChain<10> iCubArmFixed;
+
+/**
+* \ingroup iKinFwdFixed
+*
+* Fixed-size counterpart of iCubLeg.
+*/
+typedef iKinFixedChain<6> iCubLegFixed;
+
+/**
+* \ingroup iKinFwdFixed
+*
+* Fixed-size counterpart of iCubEye.
+*/
+typedef iKinFixedChain<8> iCubEyeFixed;
+
+}
+
+}
+
+#endif
+
+
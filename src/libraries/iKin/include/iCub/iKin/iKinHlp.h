@@ -26,6 +26,8 @@
 
 #define IKIN_ALMOST_ZERO    1e-6
 
+#include <deque>
+
 #include <yarp/os/Bottle.h>
 #include <yarp/sig/all.h>
 
@@ -50,6 +52,8 @@ protected:
     static void addVectorOption(yarp::os::Bottle &b, const int vcb, const yarp::sig::Vector &v);
     static bool getDesiredOption(const yarp::os::Bottle &reply, yarp::sig::Vector &xdhat,
                                  yarp::sig::Vector &odhat, yarp::sig::Vector &qdhat);
+    static bool getDesiredOptions(const yarp::os::Bottle &reply, std::deque<yarp::sig::Vector> &xdhat,
+                                  std::deque<yarp::sig::Vector> &odhat, std::deque<yarp::sig::Vector> &qdhat);
 
 public:
     /**
@@ -59,6 +63,14 @@ public:
     */
     static void addTargetOption(yarp::os::Bottle &b, const yarp::sig::Vector &xd);
 
+    /**
+    * Appends to a bottle all data needed to command a batch of 
+    * targets. 
+    * @param b is the bottle where to append the data.
+    * @param xd is the list of targets.
+    */
+    static void addTargetsOption(yarp::os::Bottle &b, const std::deque<yarp::sig::Vector> &xd);
+
     /**
     * Appends to a bottle all data needed to reconfigure chain's 
     * dof. 
@@ -171,6 +183,89 @@ public:
                                          yarp::sig::Vector &fp, yarp::sig::Matrix &J);
 };
 
+/**
+* \ingroup iKinHlp
+*
+* Extension of the yarp::dev::ICartesianControl interface for 
+* solving a batch of targets within one single request. The 
+* cartesian controller devices implementing it can be viewed 
+* through the standard PolyDriver::view() mechanism.
+*/
+class ICartesianControlBatch
+{
+public:
+    /**
+    * Destructor.
+    */
+    virtual ~ICartesianControlBatch() { }
+
+    /**
+    * Asks for inverting the kinematics for a batch of full poses 
+    * without actually moving the robot. 
+    * @param xd the list of desired positions.
+    * @param od the list of desired orientations in axis-angle 
+    *           representation; it must have the same size of xd.
+    * @param xdhat the list of achievable positions.
+    * @param odhat the list of achievable orientations.
+    * @param qdhat the list of joints configurations [deg].
+    * @return true/false on success/failure.
+    */
+    virtual bool askForPoses(const std::deque<yarp::sig::Vector> &xd,
+                             const std::deque<yarp::sig::Vector> &od,
+                             std::deque<yarp::sig::Vector> &xdhat,
+                             std::deque<yarp::sig::Vector> &odhat,
+                             std::deque<yarp::sig::Vector> &qdhat)=0;
+
+    /**
+    * Asks for inverting the kinematics for a batch of full poses 
+    * starting from a given configuration.
+    * @param q0 the starting joints configuration [deg].
+    * @param xd the list of desired positions.
+    * @param od the list of desired orientations in axis-angle 
+    *           representation; it must have the same size of xd.
+    * @param xdhat the list of achievable positions.
+    * @param odhat the list of achievable orientations.
+    * @param qdhat the list of joints configurations [deg].
+    * @return true/false on success/failure.
+    */
+    virtual bool askForPoses(const yarp::sig::Vector &q0,
+                             const std::deque<yarp::sig::Vector> &xd,
+                             const std::deque<yarp::sig::Vector> &od,
+                             std::deque<yarp::sig::Vector> &xdhat,
+                             std::deque<yarp::sig::Vector> &odhat,
+                             std::deque<yarp::sig::Vector> &qdhat)=0;
+
+    /**
+    * Asks for inverting the kinematics for a batch of positions 
+    * without actually moving the robot. 
+    * @param xd the list of desired positions.
+    * @param xdhat the list of achievable positions.
+    * @param odhat the list of achievable orientations.
+    * @param qdhat the list of joints configurations [deg].
+    * @return true/false on success/failure.
+    */
+    virtual bool askForPositions(const std::deque<yarp::sig::Vector> &xd,
+                                 std::deque<yarp::sig::Vector> &xdhat,
+                                 std::deque<yarp::sig::Vector> &odhat,
+                                 std::deque<yarp::sig::Vector> &qdhat)=0;
+
+    /**
+    * Asks for inverting the kinematics for a batch of positions 
+    * starting from a given configuration.
+    * @param q0 the starting joints configuration [deg].
+    * @param xd the list of desired positions.
+    * @param xdhat the list of achievable positions.
+    * @param odhat the list of achievable orientations.
+    * @param qdhat the list of joints configurations [deg].
+    * @return true/false on success/failure.
+    */
+    virtual bool askForPositions(const yarp::sig::Vector &q0,
+                                 const std::deque<yarp::sig::Vector> &xd,
+                                 std::deque<yarp::sig::Vector> &xdhat,
+                                 std::deque<yarp::sig::Vector> &odhat,
+                                 std::deque<yarp::sig::Vector> &qdhat)=0;
+};
+
 }
 
 }
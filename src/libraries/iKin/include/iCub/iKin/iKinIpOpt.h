@@ -27,6 +27,7 @@
 #define __IKINIPOPT_H__
 
 #include <iCub/iKin/iKinInv.h>
+#include <iCub/iKin/iKinSeedCache.h>
 
 
 namespace iCub
@@ -207,6 +208,8 @@ private:
 
 protected:
     void *App;
+    void *NLP;
+    void *workers;
 
     iKinChain &chain;
     iKinChain chain2ndTask;
@@ -223,6 +226,18 @@ protected:
     double upperBoundInf;
     std::string posePriority;
 
+    int    lastIterations;
+    double lastSolveTime;
+
+    unsigned int   nMultiStart;
+    unsigned int   nMultiStartThreads;
+    unsigned int   optionsVersion;
+    iKinSeedCache *seedCache;
+    bool           querySeedCache;
+
+    yarp::sig::Vector getSeed(const yarp::sig::Vector &q0, const yarp::sig::Vector &xd);
+    void prepareWorkers(const size_t nWorkers, bool *exhalt);
+
 public:
     /**
     * Constructor. 
@@ -295,6 +310,25 @@ public:
     */
     iKinLinIneqConstr &getLIC() { return *pLIC; }
 
+    /**
+    * Attach a iKinSeedCache object to be queried for starting 
+    * points and fed with the converged solutions. 
+    * @param cache is the iKinSeedCache object to attach (NULL 
+    *              detaches the current one).
+    * @note The cached configuration closest to the target replaces 
+    *       q0 only if it attains a smaller position error; the seeds
+    *       given explicitly to solveMultiStart() and solveBatch() are
+    *       never replaced.
+    * @see iKinSeedCache
+    */
+    void attachSeedCache(iKinSeedCache *cache) { seedCache=cache; }
+
+    /**
+    * Returns a pointer to the attached seed cache.
+    * @return the seed cache (NULL if not attached).
+    */
+    iKinSeedCache *getSeedCache() { return seedCache; }
+
     /**
     * Selects the End-Effector of the 2nd task by giving the ordinal
     * number n of last joint pointing at it. 
@@ -411,6 +445,43 @@ public:
     */
     void setBoundsInf(const double lower, const double upper);
 
+    /**
+    * Enables/disables the warm start of the optimization (disabled 
+    * at start-up by default). When enabled, the primal and dual 
+    * variables found by the last successful call to solve() are 
+    * used as starting point for the next one, in place of q0.
+    * @param warmStart true if warm start shall be enabled. 
+    * @note The stored solution is discarded automatically whenever 
+    *       the problem dimensions change (e.g. blocked links or
+    *       number of active constraints).
+    */
+    void setWarmStart(const bool warmStart);
+
+    /**
+    * Returns the warm start settings.
+    * @return true if warm start is enabled.
+    */
+    bool getWarmStart() const;
+
+    /**
+    * Discards the solution stored for warm-starting, so that the 
+    * next call to solve() will start from q0. 
+    */
+    void resetWarmStart();
+
+    /**
+    * Returns the number of iterations performed by the last call to
+    * solve(). 
+    * @return number of iterations.
+    */
+    int getLastIterations() const { return lastIterations; }
+
+    /**
+    * Returns the wall-clock time spent by the last call to solve().
+    * @return time in seconds.
+    */
+    double getLastSolveTime() const { return lastSolveTime; }
+
     /**
     * Executes the IpOpt algorithm trying to converge on target. 
     * @param q0 is the vector of initial joint angles values. 
@@ -479,6 +550,108 @@ public:
     */
     virtual yarp::sig::Vector solve(const yarp::sig::Vector &q0, yarp::sig::Vector &xd);
 
+    /**
+    * Enables/disables the multi-start mode (disabled at start-up by
+    * default), where several instances of the optimization are run 
+    * from different seeds. 
+    * @param nSeeds the number of seeds; 0 disables the multi-start 
+    *               mode.
+    * @param nThreads the number of worker threads the seeds are 
+    *                 distributed over (1 by default, i.e. the seeds
+    *                 are solved serially).
+    * @note Each worker relies on its own copy of the chain and of 
+    *       the IpOpt application, which are allocated at the first
+    *       call to solveMultiStart() and shared with solveBatch().
+    * @warning More than one thread requires a thread-safe linear 
+    *          solver: MUMPS, the default one of IpOpt, is not.
+    */
+    void setMultiStart(const unsigned int nSeeds, const unsigned int nThreads=1);
+
+    /**
+    * Returns the number of seeds of the multi-start mode.
+    * @return the number of seeds (0 if the mode is disabled).
+    */
+    unsigned int getMultiStart() const;
+
+    /**
+    * Returns the number of worker threads of the multi-start mode.
+    * @return the number of threads.
+    */
+    unsigned int getMultiStartThreads() const;
+
+    /**
+    * Executes the IpOpt algorithm from each seed, distributing the 
+    * seeds over the worker threads, and returns the best solution 
+    * found. 
+    * @param seeds the list of initial joint angles values (e.g. the 
+    *              current configuration, the rest posture, previous
+    *              solutions).
+    * @param xd is the End-Effector target Pose to be attained. 
+    * @param weight2ndTask weights the second task (disabled if 
+    *                      0.0).
+    * @param xd_2nd is the second target task traslational Pose.
+    * @param w_2nd weights each components of the distance vector 
+    *              xd_2nd-x_2nd.
+    * @param weight3rdTask weights the third task (disabled if 0.0).
+    * @param qd_3rd is the third task joint angles target positions.
+    * @param w_3rd weights each components of the distance vector 
+    *              qd-q.
+    * @param costThres if positive, the first converged solution 
+    *                  whose cost is below this threshold is
+    *                  returned straightaway and the remaining
+    *                  instances are stopped (0.0 by default).
+    * @param exit_code stores the exit code of the selected solution 
+    *                  (NULL by default).
+    * @param exhalt checks for an external request to exit (NULL by 
+    *               default).
+    * @return estimated joint angles: the converged solution with the
+    *         lowest cost or, if none converged, the one with the
+    *         lowest constraint violation.
+    * @note Falls back on solve() if the multi-start mode is disabled
+    *       or less than two seeds are given.
+    */
+    virtual yarp::sig::Vector solveMultiStart(const std::deque<yarp::sig::Vector> &seeds,
+                                              yarp::sig::Vector &xd, double weight2ndTask,
+                                              yarp::sig::Vector &xd_2nd, yarp::sig::Vector &w_2nd,
+                                              double weight3rdTask, yarp::sig::Vector &qd_3rd,
+                                              yarp::sig::Vector &w_3rd, const double costThres=0.0,
+                                              int *exit_code=NULL, bool *exhalt=NULL);
+
+    /**
+    * Executes the IpOpt algorithm on a list of targets, 
+    * distributing them over a set of worker threads. 
+    * @param q0 is the vector of initial joint angles values, common
+    *           to all the targets.
+    * @param xd is the list of End-Effector target Poses.
+    * @param weight2ndTask weights the second task (disabled if 
+    *                      0.0).
+    * @param xd_2nd is the second target task traslational Pose.
+    * @param w_2nd weights each components of the distance vector 
+    *              xd_2nd-x_2nd.
+    * @param weight3rdTask weights the third task (disabled if 0.0).
+    * @param qd_3rd is the third task joint angles target positions.
+    * @param w_3rd weights each components of the distance vector 
+    *              qd-q.
+    * @param qd is the list of estimated joint angles, one per 
+    *           target.
+    * @param exit_codes stores the exit code of each target (NULL by
+    *                   default).
+    * @param nThreads the number of worker threads (1 by default, 
+    *                 i.e. the targets are solved serially by this
+    *                 solver).
+    * @param exhalt checks for an external request to exit (NULL by 
+    *               default).
+    * @note getLastIterations() returns the overall number of 
+    *       iterations and getLastSolveTime() the time spent for the
+    *       whole batch. The warm start is not applied to the targets
+    *       and the solution kept for the next solve() is dropped.
+    */
+    virtual void solveBatch(const yarp::sig::Vector &q0, const std::deque<yarp::sig::Vector> &xd,
+                            double weight2ndTask, yarp::sig::Vector &xd_2nd, yarp::sig::Vector &w_2nd,
+                            double weight3rdTask, yarp::sig::Vector &qd_3rd, yarp::sig::Vector &w_3rd,
+                            std::deque<yarp::sig::Vector> &qd, std::deque<int> *exit_codes=NULL,
+                            const unsigned int nThreads=1, bool *exhalt=NULL);
+
     /**
     * Default destructor.
     */
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD-3-Clause license. See the accompanying LICENSE file for
+ * details.
+*/
+
+/**
+ * \defgroup iKinSeedCache iKinSeedCache
+ *
+ * @ingroup iKin
+ *
+ * Spatial cache of joints configurations indexed by the
+ * end-effector pose they attain, meant to provide inverse
+ * kinematics solvers with good starting points.
+ *
+ * The workspace is partitioned in a voxel grid over the
+ * end-effector position; each voxel retains the most recent
+ * configurations that landed inside it. A query explores the
+ * voxel containing the target together with its neighbours and
+ * ranks the candidates according to a distance that accounts
+ * for both position and orientation. The cache can be saved to
+ * and loaded from disk, so that the knowledge gathered by a
+ * solver survives restarts.
+ */
+
+#ifndef __IKINSEEDCACHE_H__
+#define __IKINSEEDCACHE_H__
+
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+
+#include <yarp/sig/Vector.h>
+
+#include <iCub/iKin/iKinFwd.h>
+
+#define IKINSEEDCACHE_DEFAULT_RESOLUTION    0.02    // [m]
+#define IKINSEEDCACHE_DEFAULT_CAPACITY      4
+#define IKINSEEDCACHE_DEFAULT_ORIENWEIGHT   0.05    // [m/rad]
+
+
+namespace iCub
+{
+
+namespace iKin
+{
+
+/**
+* \ingroup iKinSeedCache
+*
+* Pose-indexed cache of joints configurations for a given limb
+* type.
+*
+* Configurations are stored in terms of all the N joints of the
+* chain, regardless of the blocked status of the links, so that
+* the cache stays valid when the DOF change.
+*/
+class iKinSeedCache
+{
+protected:
+    struct Entry
+    {
+        double            pos[3];
+        double            quat[4];
+        yarp::sig::Vector q;
+    };
+
+    std::string  type;
+    unsigned int N;
+    double       resolution;
+    unsigned int capacity;
+    double       orienWeight;
+    size_t       numEntries;
+
+    std::unordered_map<long long,std::deque<Entry> > grid;
+    mutable std::mutex mtx;
+
+    long long getKey(const int ix, const int iy, const int iz) const;
+    void      getIndices(const double *pos, int &ix, int &iy, int &iz) const;
+    void      fillEntry(const yarp::sig::Vector &pose, Entry &entry) const;
+    double    distance(const Entry &target, const Entry &entry) const;
+    void      insert(const Entry &entry);
+
+public:
+    /**
+    * Constructor.
+    * @param _type the limb type the cache refers to (e.g. the value
+    *              returned by iKinLimb::getType()).
+    * @param _N the total number of links of the chain.
+    * @param _resolution the side of the voxels in meters.
+    * @param _capacity the maximum number of configurations retained
+    *                  within each voxel; the oldest ones get
+    *                  replaced first.
+    */
+    iKinSeedCache(const std::string &_type, const unsigned int _N,
+                  const double _resolution=IKINSEEDCACHE_DEFAULT_RESOLUTION,
+                  const unsigned int _capacity=IKINSEEDCACHE_DEFAULT_CAPACITY);
+
+    /**
+    * Returns the limb type the cache refers to.
+    * @return the limb type.
+    */
+    std::string getType() const { return type; }
+
+    /**
+    * Returns the number of links the stored configurations are
+    * made of.
+    * @return the number of links.
+    */
+    unsigned int getN() const { return N; }
+
+    /**
+    * Returns the resolution of the voxel grid.
+    * @return the side of the voxels in meters.
+    */
+    double getResolution() const { return resolution; }
+
+    /**
+    * Sets the weight of the orientation error with respect to the
+    * position error when ranking the candidates.
+    * @param weight the weight in [m/rad] (0.0 disregards the
+    *               orientation).
+    */
+    void setOrientationWeight(const double weight) { orienWeight=weight; }
+
+    /**
+    * Returns the number of configurations stored.
+    * @return the number of configurations.
+    */
+    size_t size() const;
+
+    /**
+    * Empties the cache.
+    */
+    void clear();
+
+    /**
+    * Stores a configuration along with the end-effector pose it
+    * attains.
+    * @param pose the end-effector pose (either the 3-components
+    *             position or the 7-components vector
+    *             position+axis/angle).
+    * @param q the N joints angles [rad].
+    * @return true/false on success/failure.
+    */
+    bool add(const yarp::sig::Vector &pose, const yarp::sig::Vector &q);
+
+    /**
+    * Stores the current configuration of the chain.
+    * @param chain the chain, whose number of links must match the
+    *              one of the cache.
+    * @return true/false on success/failure.
+    */
+    bool add(iKinChain &chain);
+
+    /**
+    * Retrieves the stored configurations closest to a given target
+    * pose.
+    * @param xd the target pose (either the 3-components position or
+    *           the 7-components vector position+axis/angle).
+    * @param k the maximum number of configurations to retrieve.
+    * @param seeds the list of N joints configurations, sorted from
+    *              the closest one.
+    * @return the number of configurations retrieved.
+    * @note Only the voxel containing the target and its neighbours
+    *       are explored.
+    */
+    size_t query(const yarp::sig::Vector &xd, const size_t k,
+                 std::deque<yarp::sig::Vector> &seeds) const;
+
+    /**
+    * Retrieves the stored configuration closest to a given target
+    * pose.
+    * @param xd the target pose (either the 3-components position or
+    *           the 7-components vector position+axis/angle).
+    * @param q the N joints configuration.
+    * @return true if a configuration was found.
+    */
+    bool query(const yarp::sig::Vector &xd, yarp::sig::Vector &q) const;
+
+    /**
+    * Saves the cache to file.
+    * @param fileName the file name.
+    * @return true/false on success/failure.
+    */
+    bool save(const std::string &fileName) const;
+
+    /**
+    * Loads the cache from file, adding the configurations to the
+    * ones already stored.
+    * @param fileName the file name.
+    * @return true/false on success/failure.
+    * @note The file is rejected if it refers to a different limb
+    *       type or number of links.
+    */
+    bool load(const std::string &fileName);
+};
+
+}
+
+}
+
+#endif
+
+
@@ -173,8 +173,18 @@
  *    something like [ack] ([q] (...)) ([x] (...)), where the
  *    found configuration q is returned as well as the final
  *    attained pose x.
- *  
- * Commands concerning the thread status: 
+ *
+ * Commands issued through the [askb] vocab:
+ *
+ * \b xd request: example [askb] ([xd] ((x y z ...) (x y z ...)))
+ *    ([pose] [xyz]) ([q] (...)). Ask to solve for a batch of
+ *    targets, all starting from the same joint configuration q.
+ *    The targets are distributed over the threads specified by
+ *    the batchThreads option. The reply will contain [ack]
+ *    followed by one item per target, each in the form of the
+ *    reply to the [ask] request: ([ack] ([x] (...)) ([q] (...))).
+ *
+ * Commands concerning the thread status:
  *  
  * \b susp request: example [susp], suspend the thread. 
  *  
@@ -214,6 +224,14 @@
  * \b tok property: contains the token that the client may have 
  *    added to the request.
  *  
+ * When the client lives within the same process (as it happens
+ * for the cartesian controller server), the streaming ports can
+ * be bypassed by enabling the local mode through
+ * setLocalMode(): requests and results are then exchanged as
+ * plain structures (CartesianSolverRequest and
+ * CartesianSolverResult) through lock-free queues, while the
+ * rpc commands can be issued straight with processRpc().
+ *  
  * Date: first release 20/06/2009
  *
  * \author Ugo Pattacini
@@ -238,6 +256,10 @@
 
 #include <iCub/iKin/iKinHlp.h>
 #include <iCub/iKin/iKinIpOpt.h>
+#include <iCub/iKin/iKinSpscQueue.h>
+
+#define CARTSLV_LOCAL_MAX_DOF       32
+#define CARTSLV_LOCAL_QUEUE_LEN     16
 
 
 namespace iCub
@@ -248,6 +270,42 @@ namespace iKin
 
 class CartesianSolver;
 
+/**
+* \ingroup iKinSlv
+*
+* Request exchanged with the solver in local mode, equivalent to
+* the bottle streamed to the port /<solverName>/in.
+*/
+struct CartesianSolverRequest
+{
+    double xd[7];       // the target pose
+    size_t xdLen;       // 3 (position) or 7 (position+axis/angle)
+    int    pose;        // [full]/[xyz] vocab, 0 if not specified
+    int    mode;        // [cont]/[shot] vocab, 0 if not specified
+    double token;
+    bool   tokenValid;
+};
+
+
+/**
+* \ingroup iKinSlv
+*
+* Result produced by the solver in local mode, equivalent to the
+* bottle streamed out of the port /<solverName>/out.
+*/
+struct CartesianSolverResult
+{
+    double xd[7];
+    double x[7];
+    double q[CARTSLV_LOCAL_MAX_DOF];    // [deg]
+    size_t xdLen;
+    size_t xLen;
+    size_t qLen;
+    double token;
+    bool   tokenValid;
+};
+
+
 class RpcProcessor : public yarp::os::PortReader
 {
 protected:
@@ -296,6 +354,7 @@ public:
     bool handleDOF(yarp::os::Bottle *b);
     bool handlePose(const int newPose);
     bool handleMode(const int newMode);    
+    void handleRequest(const CartesianSolverRequest &req);
 };
 
 
@@ -340,6 +399,9 @@ protected:
 
     iKinIpOptMin   *slv;
     SolverCallback *clb;
+    iKinSeedCache  *seedCache;
+    std::string     seedCacheFile;
+    unsigned int    batchThreads;
 
     RpcProcessor                             *cmdProcessor;
     yarp::os::Port                           *rpcPort;
@@ -347,6 +409,10 @@ protected:
     yarp::os::BufferedPort<yarp::os::Bottle> *outPort;
     std::mutex                                mtx;
 
+    bool                                  localMode;
+    iKinSpscQueue<CartesianSolverRequest> localRequests;
+    iKinSpscQueue<CartesianSolverResult>  localResults;
+
     std::string   slvName;
     std::string   type;
     unsigned int  period;
@@ -386,6 +452,9 @@ protected:
 
     virtual PartDescriptor *getPartDesc(yarp::os::Searchable &options)=0;
     virtual yarp::sig::Vector solve(yarp::sig::Vector &xd);
+    virtual void fillSeeds(const yarp::sig::Vector &xd, std::deque<yarp::sig::Vector> &seeds);
+    virtual void solveBatch(const std::deque<yarp::sig::Vector> &xd, std::deque<yarp::sig::Vector> &q);
+    virtual void prepareAsk(const yarp::os::Bottle &command, const yarp::os::Bottle *b_q);
 
     virtual yarp::sig::Vector &encodeDOF();
     virtual bool decodeDOF(const yarp::sig::Vector &_dof);
@@ -507,6 +576,41 @@ public:
     *    all intermediate points of optimization instance; allowed
     *    values are [on] or [off].
     *  
+    * \b warmStart <vocab>: example (warmStart on), selects whether 
+    *    to warm-start each optimization instance from the
+    *    solution of the previous one; allowed values are [on] or
+    *    [off].
+    *  
+    * \b multiStart <int>: example (multiStart 4), specifies the 
+    *    number of optimization instances run from different seeds
+    *    (the current configuration, the rest posture, the cached
+    *    solutions and random configurations); the best solution is
+    *    retained. Intermediate points are not streamed in this
+    *    mode.
+    *  
+    * \b multiStartThreads <int>: example (multiStartThreads 4), 
+    *    specifies the number of threads the multiStart instances
+    *    are distributed over (1 by default, i.e. the instances are
+    *    run serially). Values greater than 1 require IpOpt to be
+    *    linked against a thread-safe linear solver (e.g. ma27/ma57
+    *    from HSL): MUMPS, the default one, is not thread-safe.
+    *  
+    * \b batchThreads <int>: example (batchThreads 4), specifies 
+    *    the number of threads serving the [askb] requests, each of
+    *    them relying on its own copy of the chain and of the
+    *    optimizer (1 by default); the same limitation of
+    *    multiStartThreads on the linear solver applies.
+    *  
+    * \b seedCache <string>: example (seedCache cache.txt), enables 
+    *    the cache of the solutions indexed by the end-effector pose,
+    *    which provides the optimizer with starting points; the cache
+    *    is loaded from the given file at start-up, if available, and
+    *    saved back to it at closure.
+    *  
+    * \b seedCacheResolution <double>: example 
+    *    (seedCacheResolution 0.02), specifies the resolution in
+    *    meters of the seed cache.
+    *  
     * \b ping_robot_tmo <double>: example (ping_robot_tmo 2.0), 
     *    specifies a timeout in seconds during which robot state
     *    ports are pinged prior to connecting; a timeout equal to
@@ -554,6 +658,48 @@ public:
     */
     virtual void resume();
 
+    /**
+    * Enable/disable the local mode, where requests and results are
+    * exchanged with a client living within the same process through
+    * lock-free queues instead of the streaming ports.
+    * @param sw true to enable the local mode.
+    *
+    * @note In local mode the results are written to the port
+    *       /<solverName>/out only if someone is connected to it.
+    */
+    virtual void setLocalMode(const bool sw) { localMode=sw; }
+
+    /**
+    * Return the local mode status.
+    * @return true if the local mode is enabled.
+    */
+    virtual bool getLocalMode() const { return localMode; }
+
+    /**
+    * Return the queue of requests to be filled in local mode; the
+    * client is the only producer, whereas the solver thread is the
+    * only consumer.
+    * @return a reference to the queue.
+    */
+    iKinSpscQueue<CartesianSolverRequest> &getLocalRequests() { return localRequests; }
+
+    /**
+    * Return the queue of results produced in local mode; the
+    * solver thread is the only producer, whereas the client is the
+    * only consumer.
+    * @return a reference to the queue.
+    */
+    iKinSpscQueue<CartesianSolverResult> &getLocalResults() { return localResults; }
+
+    /**
+    * Process an rpc command as if it were received through the port
+    * /<solverName>/rpc.
+    * @param command the command.
+    * @param reply the reply.
+    * @return true/false on success/failure.
+    */
+    virtual bool processRpc(const yarp::os::Bottle &command, yarp::os::Bottle &reply);
+
     /**
     * Default destructor.
     */
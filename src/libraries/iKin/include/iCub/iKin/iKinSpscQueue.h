@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD-3-Clause license. See the accompanying LICENSE file for
+ * details.
+*/
+
+/**
+ * \defgroup iKinSpscQueue iKinSpscQueue
+ *
+ * @ingroup iKin
+ *
+ * Lock-free single-producer/single-consumer queue of
+ * preallocated items, meant to exchange data between threads
+ * living within the same process without any serialization or
+ * dynamic allocation.
+ *
+ * The producer fills in place the slot returned by prepare() and
+ * publishes it with push(); the consumer accesses in place the
+ * oldest published item through front() and releases it with
+ * pop().
+ */
+
+#ifndef __IKINSPSCQUEUE_H__
+#define __IKINSPSCQUEUE_H__
+
+#include <cstddef>
+#include <vector>
+#include <atomic>
+
+#define IKINSPSCQUEUE_CACHE_LINE    64
+
+
+namespace iCub
+{
+
+namespace iKin
+{
+
+/**
+* \ingroup iKinSpscQueue
+*
+* Bounded lock-free queue for one producer thread and one
+* consumer thread.
+*
+* @note More producers (or consumers) are allowed as long as
+*       they are serialized by the user.
+*/
+template <typename T>
+class iKinSpscQueue
+{
+protected:
+    std::vector<T> items;
+    size_t         len;
+
+    alignas(IKINSPSCQUEUE_CACHE_LINE) std::atomic<size_t> head;
+    alignas(IKINSPSCQUEUE_CACHE_LINE) std::atomic<size_t> tail;
+
+    size_t next(const size_t i) const { return (i+1<len)?i+1:0; }
+
+    // not copyable
+    iKinSpscQueue(const iKinSpscQueue&);
+    iKinSpscQueue &operator=(const iKinSpscQueue&);
+
+public:
+    /**
+    * Constructor.
+    * @param capacity the maximum number of items the queue can
+    *                 hold; all of them are allocated here.
+    */
+    iKinSpscQueue(const size_t capacity) : items(capacity+1), len(capacity+1),
+                                           head(0), tail(0) { }
+
+    /**
+    * Returns the maximum number of items the queue can hold.
+    * @return the capacity.
+    */
+    size_t capacity() const { return len-1; }
+
+    /**
+    * Returns the number of items currently stored.
+    * @return the number of items.
+    * @note The value is exact only when queried by either the
+    *       producer or the consumer.
+    */
+    size_t size() const
+    {
+        size_t h=head.load(std::memory_order_acquire);
+        size_t t=tail.load(std::memory_order_acquire);
+        return (t>=h)?(t-h):(len-h+t);
+    }
+
+    /**
+    * Checks whether the queue is empty.
+    * @return true if empty.
+    */
+    bool empty() const
+    {
+        return (head.load(std::memory_order_acquire)==
+                tail.load(std::memory_order_acquire));
+    }
+
+    /**
+    * Called by the producer to access the slot where the next item
+    * is to be written.
+    * @return a pointer to the slot, or NULL if the queue is full.
+    * @note The item is not visible to the consumer until push()
+    *       is called.
+    */
+    T *prepare()
+    {
+        size_t t=tail.load(std::memory_order_relaxed);
+        if (next(t)==head.load(std::memory_order_acquire))
+            return NULL;
+
+        return &items[t];
+    }
+
+    /**
+    * Called by the producer to publish the slot returned by the
+    * last successful call to prepare().
+    */
+    void push()
+    {
+        size_t t=tail.load(std::memory_order_relaxed);
+        tail.store(next(t),std::memory_order_release);
+    }
+
+    /**
+    * Called by the consumer to access the oldest item.
+    * @return a pointer to the item, or NULL if the queue is empty.
+    */
+    T *front()
+    {
+        size_t h=head.load(std::memory_order_relaxed);
+        if (h==tail.load(std::memory_order_acquire))
+            return NULL;
+
+        return &items[h];
+    }
+
+    /**
+    * Called by the consumer to release the item returned by the
+    * last successful call to front().
+    */
+    void pop()
+    {
+        size_t h=head.load(std::memory_order_relaxed);
+        head.store(next(h),std::memory_order_release);
+    }
+};
+
+}
+
+}
+
+#endif
+
+
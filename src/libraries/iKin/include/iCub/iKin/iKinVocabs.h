@@ -16,6 +16,7 @@
 #define IKINSLV_VOCAB_CMD_GET           yarp::os::createVocab('g','e','t')
 #define IKINSLV_VOCAB_CMD_SET           yarp::os::createVocab('s','e','t')
 #define IKINSLV_VOCAB_CMD_ASK           yarp::os::createVocab('a','s','k')
+#define IKINSLV_VOCAB_CMD_ASK_BATCH     yarp::os::createVocab('a','s','k','b')
 #define IKINSLV_VOCAB_CMD_SUSP          yarp::os::createVocab('s','u','s','p')
 #define IKINSLV_VOCAB_CMD_RUN           yarp::os::createVocab('r','u','n')
 #define IKINSLV_VOCAB_CMD_STATUS        yarp::os::createVocab('s','t','a','t')
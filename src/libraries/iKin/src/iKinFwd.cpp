@@ -9,13 +9,16 @@
 */
 
 #include <cstdlib>
+#include <cstring>
 #include <sstream>
 #include <cmath>
 #include <algorithm>
+#include <thread>
 
 #include <yarp/os/Log.h>
 
 #include <iCub/iKin/iKinFwd.h>
+#include <iCub/iKin/iKinFwdFixed.h>
 
 using namespace std;
 using namespace yarp::os;
@@ -25,6 +28,202 @@ using namespace yarp::math;
 using namespace iCub::ctrl;
 using namespace iCub::iKin;
 
+#define IKINFWD_BATCH_BLOCK     64
+
+namespace
+{
+    struct BatchLink
+    {
+        double A,D,c_alpha,s_alpha;
+        double Offset,Min,Max,Ang;
+        bool   blocked,constrained;
+    };
+
+    /********************************************************************/
+    void batchKernel(const vector<BatchLink> &links, const double *H0,
+                     const double *HN, const unsigned int DOF, const Matrix &q,
+                     const unsigned int k0, const unsigned int k1,
+                     const bool axisRep, Matrix *poses, Matrix *jacobians)
+    {
+        const unsigned int B=IKINFWD_BATCH_BLOCK;
+        const unsigned int N=(unsigned int)links.size();
+
+        // structure of arrays holding, for each configuration of the block,
+        // the first three rows of the current frame, the temporary product,
+        // the joint cos/sin and the z-axis/origin of the frames of the DOFs
+        vector<double> buf((12+12+2+6*DOF)*B);
+        double *F=&buf[0];
+        double *T=F+12*B;
+        double *c=T+12*B;
+        double *s=c+B;
+        double *ZP=s+B;
+
+        for (unsigned int kb=k0; kb<k1; kb+=B)
+        {
+            const unsigned int nb=std::min(B,k1-kb);
+
+            for (unsigned int r=0; r<12; r++)
+                std::fill(F+r*B,F+r*B+nb,H0[r]);
+
+            unsigned int dof=0;
+            for (unsigned int j=0; j<N; j++)
+            {
+                const BatchLink &l=links[j];
+
+                if (l.blocked)
+                {
+                    std::fill(c,c+nb,cos(l.Ang+l.Offset));
+                    std::fill(s,s+nb,sin(l.Ang+l.Offset));
+                }
+                else
+                {
+                    const double *qj=q[dof]+kb;
+                    for (unsigned int k=0; k<nb; k++)
+                    {
+                        double ang=qj[k];
+                        if (l.constrained)
+                            ang=(ang<l.Min) ? l.Min : ((ang>l.Max) ? l.Max : ang);
+
+                        c[k]=cos(ang+l.Offset);
+                        s[k]=sin(ang+l.Offset);
+                    }
+
+                    double *zp=ZP+6*dof*B;
+                    std::copy(F+2*B,F+2*B+nb,zp);
+                    std::copy(F+6*B,F+6*B+nb,zp+B);
+                    std::copy(F+10*B,F+10*B+nb,zp+2*B);
+                    std::copy(F+3*B,F+3*B+nb,zp+3*B);
+                    std::copy(F+7*B,F+7*B+nb,zp+4*B);
+                    std::copy(F+11*B,F+11*B+nb,zp+5*B);
+                    dof++;
+                }
+
+                // F*=H_j, with H_j expressed in Denavit-Hartenberg notation
+                for (unsigned int r=0; r<3; r++)
+                {
+                    const double *f0=F+4*r*B;
+                    const double *f1=f0+B;
+                    const double *f2=f1+B;
+                    const double *f3=f2+B;
+                    double *t0=T+4*r*B;
+                    double *t1=t0+B;
+                    double *t2=t1+B;
+                    double *t3=t2+B;
+
+                    for (unsigned int k=0; k<nb; k++)
+                    {
+                        const double a=f0[k]*c[k]+f1[k]*s[k];
+                        const double b=f1[k]*c[k]-f0[k]*s[k];
+                        t0[k]=a;
+                        t1[k]=b*l.c_alpha+f2[k]*l.s_alpha;
+                        t2[k]=f2[k]*l.c_alpha-b*l.s_alpha;
+                        t3[k]=a*l.A+f2[k]*l.D+f3[k];
+                    }
+                }
+
+                std::swap(F,T);
+            }
+
+            // end-effector frame
+            for (unsigned int r=0; r<12; r+=4)
+            {
+                const double *f0=F+r*B;
+                const double *f1=f0+B;
+                const double *f2=f1+B;
+                const double *f3=f2+B;
+
+                for (unsigned int col=0; col<4; col++)
+                {
+                    double *t=T+(r+col)*B;
+                    for (unsigned int k=0; k<nb; k++)
+                        t[k]=f0[k]*HN[col]+f1[k]*HN[4+col]+f2[k]*HN[8+col];
+
+                    if (col==3)
+                        for (unsigned int k=0; k<nb; k++)
+                            t[k]+=f3[k];
+                }
+            }
+
+            if (poses!=NULL)
+            {
+                double H[16]={0.0,0.0,0.0,0.0, 0.0,0.0,0.0,0.0,
+                              0.0,0.0,0.0,0.0, 0.0,0.0,0.0,1.0};
+                double v[4];
+
+                for (unsigned int k=0; k<nb; k++)
+                {
+                    for (unsigned int r=0; r<12; r++)
+                        H[r]=T[r*B+k];
+
+                    const unsigned int col=kb+k;
+                    (*poses)(0,col)=H[3];
+                    (*poses)(1,col)=H[7];
+                    (*poses)(2,col)=H[11];
+
+                    if (axisRep)
+                    {
+                        if (!fixed::dcm2axis(H,v))
+                        {
+                            Vector r=dcm2axis(Matrix(4,4,H));
+                            v[0]=r[0]; v[1]=r[1]; v[2]=r[2]; v[3]=r[3];
+                        }
+
+                        (*poses)(3,col)=v[0];
+                        (*poses)(4,col)=v[1];
+                        (*poses)(5,col)=v[2];
+                        (*poses)(6,col)=v[3];
+                    }
+                    else
+                    {
+                        fixed::rotAng(H,v);
+                        (*poses)(3,col)=v[0];
+                        (*poses)(4,col)=v[1];
+                        (*poses)(5,col)=v[2];
+                    }
+                }
+            }
+
+            if (jacobians!=NULL)
+            {
+                const double *px=T+3*B;
+                const double *py=T+7*B;
+                const double *pz=T+11*B;
+
+                for (unsigned int i=0; i<DOF; i++)
+                {
+                    const double *zx=ZP+6*i*B;
+                    const double *zy=zx+B;
+                    const double *zz=zy+B;
+                    const double *ox=zz+B;
+                    const double *oy=ox+B;
+                    const double *oz=oy+B;
+
+                    double *j0=(*jacobians)[i]+kb;
+                    double *j1=(*jacobians)[DOF+i]+kb;
+                    double *j2=(*jacobians)[2*DOF+i]+kb;
+                    double *j3=(*jacobians)[3*DOF+i]+kb;
+                    double *j4=(*jacobians)[4*DOF+i]+kb;
+                    double *j5=(*jacobians)[5*DOF+i]+kb;
+
+                    for (unsigned int k=0; k<nb; k++)
+                    {
+                        const double dx=px[k]-ox[k];
+                        const double dy=py[k]-oy[k];
+                        const double dz=pz[k]-oz[k];
+
+                        j0[k]=zy[k]*dz-zz[k]*dy;
+                        j1[k]=zz[k]*dx-zx[k]*dz;
+                        j2[k]=zx[k]*dy-zy[k]*dx;
+                        j3[k]=zx[k];
+                        j4[k]=zy[k];
+                        j5[k]=zz[k];
+                    }
+                }
+            }
+        }
+    }
+}
+
 
 /************************************************************************/
 void iCub::iKin::notImplemented(const unsigned int verbose)
@@ -54,6 +253,7 @@ iKinLink::iKinLink(double _A, double _D, double _Alpha, double _Offset,
     cumulative =false;
     constrained=true;
     verbose    =0;
+    rev        =0;
 
     H.resize(4,4);
     H.zero();
@@ -87,6 +287,7 @@ void iKinLink::clone(const iKinLink &l)
     cumulative =l.cumulative;
     constrained=l.constrained;
     verbose    =l.verbose;
+    rev++;
 
     H   =l.H;
     cumH=l.cumH;
@@ -95,7 +296,7 @@ void iKinLink::clone(const iKinLink &l)
 
 
 /************************************************************************/
-iKinLink::iKinLink(const iKinLink &l)
+iKinLink::iKinLink(const iKinLink &l) : rev(0)
 {
     clone(l);
 }
@@ -116,7 +317,10 @@ void iKinLink::setMin(const double _Min)
     Min=_Min;
 
     if (Ang<Min)
+    {
         Ang=Min;
+        rev++;
+    }
 }
 
 
@@ -126,7 +330,10 @@ void iKinLink::setMax(const double _Max)
     Max=_Max;
 
     if (Ang>Max)
+    {
         Ang=Max;
+        rev++;
+    }
 }
 
 
@@ -134,6 +341,7 @@ void iKinLink::setMax(const double _Max)
 void iKinLink::setD(const double _D)
 {
     H(2,3)=D=_D;
+    rev++;
 }
 
 
@@ -144,6 +352,7 @@ void iKinLink::setAlpha(const double _Alpha)
 
     H(2,2)=c_alpha=cos(Alpha);
     H(2,1)=s_alpha=sin(Alpha);
+    rev++;
 }
 
 
@@ -152,10 +361,15 @@ double iKinLink::setAng(double _Ang)
 {
     if (!blocked)
     {
+        double prevAng=Ang;
+
         if (constrained)
             Ang=(_Ang<Min) ? Min : ((_Ang>Max) ? Max : _Ang);
         else
             Ang=_Ang;
+
+        if (Ang!=prevAng)
+            rev++;
     }
     else if (verbose)
         yWarning("Attempt to set joint angle to %g while blocked",_Ang);
@@ -165,26 +379,24 @@ double iKinLink::setAng(double _Ang)
 
 
 /************************************************************************/
-Matrix iKinLink::getH(bool c_override)
+void iKinLink::computeH(double *_H, const bool c_override)
 {
-    double theta=Ang+Offset;
-    double c_theta=cos(theta);
-    double s_theta=sin(theta);
-
-    H(0,0)=c_theta;
-    H(0,1)=-s_theta*c_alpha;
-    H(0,2)=s_theta*s_alpha;
-    H(0,3)=c_theta*A;
-
-    H(1,0)=s_theta;
-    H(1,1)=c_theta*c_alpha;
-    H(1,2)=-c_theta*s_alpha;
-    H(1,3)=s_theta*A;
+    fixed::dhUpdate(A,c_alpha,s_alpha,Ang+Offset,H.data());
 
     if (cumulative && !c_override)
-        return cumH*H;
+        fixed::mulH(cumH.data(),H.data(),_H);
     else
-        return H;
+        fixed::copy(H.data(),_H);
+}
+
+
+/************************************************************************/
+Matrix iKinLink::getH(bool c_override)
+{
+    Matrix res(4,4);
+    computeH(res.data(),c_override);
+
+    return res;
 }
 
 
@@ -256,6 +468,11 @@ iKinChain::iKinChain()
 {
     N=DOF=verbose=0;
     H0=HN=eye(4,4);
+
+    intH.assign(16*(N+3),0.0);
+    intValid=0;
+    intHNValid=false;
+    cacheHits=cacheMisses=0;
 }
 
 
@@ -271,6 +488,14 @@ void iKinChain::clone(const iKinChain &c)
     hess_J   =c.hess_J;
     hess_Jlnk=c.hess_Jlnk;
 
+    intH       =c.intH;
+    sufH       =c.sufH;
+    intRev     =c.intRev;
+    intValid   =c.intValid;
+    intHNValid =c.intHNValid;
+    cacheHits  =c.cacheHits;
+    cacheMisses=c.cacheMisses;
+
     allList.assign(c.allList.begin(),c.allList.end());
     quickList.assign(c.quickList.begin(),c.quickList.end());
     hash.assign(c.hash.begin(),c.hash.end());
@@ -358,6 +583,10 @@ void iKinChain::clear()
 
     N=DOF=0;
     H0=HN=eye(4,4);
+
+    intH.assign(16*(N+3),0.0);
+    intValid=0;
+    intHNValid=false;
 }
 
 
@@ -554,6 +783,14 @@ void iKinChain::build()
 
     if (DOF>0)
         curr_q.resize(DOF,0);
+
+    // the layout of intH is the following:
+    // [H0] [H0*H_0] ... [H0*H_0*...*H_N-1] [end-effector] [HN]
+    intH.resize(16*(N+3));
+    sufH.resize(16*(N+1));
+    intRev.assign(N,0);
+    intValid=0;
+    intHNValid=false;
 }
 
 
@@ -563,6 +800,8 @@ bool iKinChain::setH0(const Matrix &_H0)
     if ((_H0.rows()==4) && (_H0.cols()==4))
     {
         H0=_H0;
+        intValid=0;
+        intHNValid=false;
         return true;
     }
     else
@@ -581,6 +820,7 @@ bool iKinChain::setHN(const Matrix &_HN)
     if ((_HN.rows()==4) && (_HN.cols()==4))
     {
         HN=_HN;
+        intHNValid=false;
         return true;
     }
     else
@@ -728,46 +968,112 @@ Vector iKinChain::d2RotAng(const Matrix &R, const Matrix &dRi,
 
 
 /************************************************************************/
-Matrix iKinChain::getH(const unsigned int i, const bool allLink)
+void iKinChain::computeIntH(const unsigned int n)
 {
-    Matrix H=H0;
-    unsigned int _i,n;
-    deque<iKinLink*> *l;
-    bool cumulHN=false;
-    bool c_override;
+    // H0 can be also modified directly by derived classes
+    if (memcmp(&intH[0],H0.data(),16*sizeof(double))!=0)
+    {
+        fixed::copy(H0.data(),&intH[0]);
+        intValid=0;
+    }
 
-    if (allLink)
+    // look for the first link whose transformation
+    // has changed since the last update of the cache
+    unsigned int first=std::min(intValid,n);
+    for (unsigned int j=0; j<first; j++)
     {
-        n=N;
-        l=&allList;
-        c_override=true;
+        if (allList[j]->rev!=intRev[j])
+        {
+            first=j;
+            break;
+        }
+    }
+
+    cacheHits+=first;
+    cacheMisses+=n-first;
+
+    if (first<n)
+    {
+        double Hj[16];
+        for (unsigned int j=first; j<n; j++)
+        {
+            allList[j]->computeH(Hj,true);
+            intRev[j]=allList[j]->rev;
+            fixed::mulH(&intH[16*j],Hj,&intH[16*(j+1)]);
+        }
 
-        _i=i;
-        if (_i>=N-1)
-            cumulHN=true;
+        intValid=n;
+        intHNValid=false;
     }
-    else
+}
+
+
+/************************************************************************/
+const double *iKinChain::computeIntHN()
+{
+    computeIntH(N);
+
+    double *HEE=&intH[16*(N+1)];
+    double *_HN=&intH[16*(N+2)];
+
+    // HN can be also modified directly by derived classes
+    if (!intHNValid || (memcmp(_HN,HN.data(),16*sizeof(double))!=0))
+    {
+        fixed::copy(HN.data(),_HN);
+        fixed::mul(&intH[16*N],_HN,HEE);
+        intHNValid=true;
+    }
+
+    return HEE;
+}
+
+
+/************************************************************************/
+void iKinChain::computeH(const unsigned int i, const bool allLink, double *H)
+{
+    if (allLink)
     {
-        n=DOF;
-        l=&quickList;
-        c_override=false;
+        yAssert(i<N);
 
-        if (i==DOF)
-            _i=(unsigned int)quickList.size();
+        if (i>=N-1)
+            fixed::copy(computeIntHN(),H);
         else
-            _i=i;
+        {
+            computeIntH(i+1);
+            fixed::copy(&intH[16*(i+1)],H);
+        }
 
-        if (hash[_i]>=N-1)
-            cumulHN=true;
+        return;
     }
 
-    yAssert(i<n);
+    // only the unblocked links are spanned from here on
+    unsigned int _i=(i==DOF)?(unsigned int)quickList.size():i;
+    bool cumulHN=(hash[_i]>=N-1);
+
+    yAssert(i<DOF);
 
+    double Hj[16],tmp[16];
+
+    fixed::copy(H0.data(),H);
     for (unsigned int j=0; j<=_i; j++)
-        H*=((*l)[j]->getH(c_override));
+    {
+        quickList[j]->computeH(Hj,false);
+        fixed::mulHInPlace(H,Hj);
+    }
 
     if (cumulHN)
-        H*=HN;
+    {
+        fixed::mul(H,HN.data(),tmp);
+        fixed::copy(tmp,H);
+    }
+}
+
+
+/************************************************************************/
+Matrix iKinChain::getH(const unsigned int i, const bool allLink)
+{
+    Matrix H(4,4);
+    computeH(i,allLink,H.data());
 
     return H;
 }
@@ -776,15 +1082,10 @@ Matrix iKinChain::getH(const unsigned int i, const bool allLink)
 /************************************************************************/
 Matrix iKinChain::getH()
 {
-    // may be different from DOF since one blocked link may lie
-    // at the end of the chain.
-    unsigned int n=(unsigned int)quickList.size();
-    Matrix H=H0;
+    Matrix H(4,4);
+    fixed::copy(computeIntHN(),H.data());
 
-    for (unsigned int i=0; i<n; i++)
-        H*=quickList[i]->getH();
-
-    return H*HN;
+    return H;
 }
 
 
@@ -841,7 +1142,16 @@ Vector iKinChain::Pose(const unsigned int i, const bool axisRep)
 Vector iKinChain::Position(const unsigned int i)
 {
     yAssert(i<N);
-    return getH(i,true).subcol(0,3,3);
+
+    double H[16];
+    computeH(i,true,H);
+
+    Vector p(3);
+    p[0]=H[3];
+    p[1]=H[7];
+    p[2]=H[11];
+
+    return p;
 }
 
 
@@ -849,31 +1159,26 @@ Vector iKinChain::Position(const unsigned int i)
 Vector iKinChain::EndEffPose(const bool axisRep)
 {
     Matrix H=getH();
-    Vector v;
+    Vector v(axisRep ? 7 : 6);
+
+    v[0]=H(0,3);
+    v[1]=H(1,3);
+    v[2]=H(2,3);
 
     if (axisRep)
     {
-        v.resize(7);
-        Vector r=dcm2axis(H);
-        v[0]=H(0,3);
-        v[1]=H(1,3);
-        v[2]=H(2,3);
-        v[3]=r[0];
-        v[4]=r[1];
-        v[5]=r[2];
-        v[6]=r[3];
+        // resort to yarp only in case of degenerate rotations
+        if (!fixed::dcm2axis(H.data(),v.data()+3))
+        {
+            Vector r=dcm2axis(H);
+            v[3]=r[0];
+            v[4]=r[1];
+            v[5]=r[2];
+            v[6]=r[3];
+        }
     }
     else
-    {
-        v.resize(6);
-        Vector r=RotAng(H);
-        v[0]=H(0,3);
-        v[1]=H(1,3);
-        v[2]=H(2,3);
-        v[3]=r[0];
-        v[4]=r[1];
-        v[5]=r[2];
-    }
+        fixed::rotAng(H.data(),v.data()+3);
 
     return v;
 }
@@ -959,38 +1264,32 @@ Matrix iKinChain::AnaJacobian(unsigned int col)
 
     col=col>3 ? 3 : col;
 
-    // may be different from DOF since one blocked link may lie
-    // at the end of the chain.
-    unsigned int n=(unsigned int)quickList.size();
     Matrix J(6,DOF);
-    Matrix H,dH,_H;
-    Vector dr;
+    const double *H=computeIntHN();
+    double dHj[16],tmp[16],dH[16];
+
+    // products of the links transformations from the jth link
+    // down to the end-effector: the member H of each link
+    // is up-to-date since computeIntHN() has been just called
+    fixed::copy(&intH[16*(N+2)],&sufH[16*N]);
+    for (int j=N-1; j>=0; j--)
+        fixed::mul(allList[j]->H.data(),&sufH[16*(j+1)],&sufH[16*j]);
 
     for (unsigned int i=0; i<DOF; i++)
     {
-        H=dH=H0;
-
-        for (unsigned int j=0; j<n; j++)
-        {
-            _H=quickList[j]->getH();
-            H*=_H;
-
-            if (hash_dof[i]==j)
-                dH*=quickList[j]->getDnH();
-            else
-                dH*=_H;
-        }
+        unsigned int j=hash[i];
+        iKinLink *l=allList[j];
 
-        H*=HN;
-        dH*=HN;
-        dr=dRotAng(H,dH);
+        fixed::dhDerivative(l->A,l->c_alpha,l->s_alpha,l->Ang+l->Offset,dHj);
+        fixed::mul(&intH[16*j],dHj,tmp);
+        fixed::mul(tmp,&sufH[16*(j+1)],dH);
 
-        J(0,i)=dH(0,col);
-        J(1,i)=dH(1,col);
-        J(2,i)=dH(2,col);
-        J(3,i)=dr[0];
-        J(4,i)=dr[1];
-        J(5,i)=dr[2];
+        J(0,i)=dH[col];
+        J(1,i)=dH[4+col];
+        J(2,i)=dH[8+col];
+        J(3,i)=(H[9]*dH[10]-H[10]*dH[9])/(H[9]*H[9]+H[10]*H[10]);
+        J(4,i)=dH[8]/sqrt(fabs(1.0-H[8]*H[8]));
+        J(5,i)=(H[4]*dH[0]-H[0]*dH[4])/(H[4]*H[4]+H[0]*H[0]);
     }
 
     return J;
@@ -1013,32 +1312,19 @@ Matrix iKinChain::GeoJacobian(const unsigned int i)
     yAssert(i<N);
 
     Matrix J(6,i+1);
-    Matrix PN,Z;
-    Vector w;
-
-    deque<Matrix> intH;
-    intH.push_back(H0);
-
-    for (unsigned int j=0; j<=i; j++)
-        intH.push_back(intH[j]*allList[j]->getH(true));
+    const double *PN;
 
-    PN=intH[i+1];
     if (i>=N-1)
-        PN=PN*HN;
-
-    for (unsigned int j=0; j<=i; j++)
+        PN=computeIntHN();
+    else
     {
-        Z=intH[j];
-        w=cross(Z,2,PN-Z,3);
-
-        J(0,j)=w[0];
-        J(1,j)=w[1];
-        J(2,j)=w[2];
-        J(3,j)=Z(0,2);
-        J(4,j)=Z(1,2);
-        J(5,j)=Z(2,2);
+        computeIntH(i+1);
+        PN=&intH[16*(i+1)];
     }
 
+    for (unsigned int j=0; j<=i; j++)
+        fixed::geoJacobianCol(&intH[16*j],PN,J.data(),j,i+1);
+
     return J;
 }
 
@@ -1049,31 +1335,10 @@ Matrix iKinChain::GeoJacobian()
     yAssert(DOF>0);
 
     Matrix J(6,DOF);
-    Matrix PN,Z;
-    Vector w;
-
-    deque<Matrix> intH;
-    intH.push_back(H0);
-
-    for (unsigned int i=0; i<N; i++)
-        intH.push_back(intH[i]*allList[i]->getH(true));
-
-    PN=intH[N]*HN;
+    const double *PN=computeIntHN();
 
     for (unsigned int i=0; i<DOF; i++)
-    {
-        unsigned int j=hash[i];
-
-        Z=intH[j];
-        w=cross(Z,2,PN-Z,3);
-
-        J(0,i)=w[0];
-        J(1,i)=w[1];
-        J(2,i)=w[2];
-        J(3,i)=Z(0,2);
-        J(4,i)=Z(1,2);
-        J(5,i)=Z(2,2);
-    }
+        fixed::geoJacobianCol(&intH[16*hash[i]],PN,J.data(),i,DOF);
 
     return J;
 }
@@ -1295,6 +1560,14 @@ Matrix iKinChain::DJacobian(const unsigned int lnk, const Vector &dq)
 }
 
 
+/************************************************************************/
+void iKinChain::getCacheStats(unsigned long &hits, unsigned long &misses) const
+{
+    hits=cacheHits;
+    misses=cacheMisses;
+}
+
+
 /************************************************************************/
 iKinChain::~iKinChain()
 {
@@ -1503,6 +1776,62 @@ iKinLimb &iKinLimb::operator=(const iKinLimb &limb)
 }
 
 
+/************************************************************************/
+bool iKinLimb::EndEffPoseBatch(const Matrix &q, Matrix &poses, Matrix *jacobians,
+                               const bool axisRep, const unsigned int nThreads)
+{
+    if ((DOF==0) || (q.rows()!=(int)DOF))
+    {
+        if (verbose)
+            yError("EndEffPoseBatch() failed due to wrong configurations size: %d!=%d",
+                   q.rows(),DOF);
+
+        return false;
+    }
+
+    vector<BatchLink> links(N);
+    for (unsigned int j=0; j<N; j++)
+    {
+        iKinLink &l=*allList[j];
+        links[j].A=l.getA();
+        links[j].D=l.getD();
+        links[j].c_alpha=cos(l.getAlpha());
+        links[j].s_alpha=sin(l.getAlpha());
+        links[j].Offset=l.getOffset();
+        links[j].Min=l.getMin();
+        links[j].Max=l.getMax();
+        links[j].Ang=l.getAng();
+        links[j].blocked=l.isBlocked();
+        links[j].constrained=l.getConstraint();
+    }
+
+    unsigned int M=(unsigned int)q.cols();
+    poses.resize(axisRep ? 7 : 6,M);
+    if (jacobians!=NULL)
+        jacobians->resize(6*DOF,M);
+
+    // split the batch in chunks made up of whole blocks
+    unsigned int nBlocks=(M+IKINFWD_BATCH_BLOCK-1)/IKINFWD_BATCH_BLOCK;
+    unsigned int n=(nThreads>0) ? nThreads : std::thread::hardware_concurrency();
+    n=std::max(1U,std::min(n,nBlocks));
+    unsigned int chunk=IKINFWD_BATCH_BLOCK*((nBlocks+n-1)/n);
+
+    vector<std::thread> workers;
+    for (unsigned int k0=chunk; k0<M; k0+=chunk)
+        workers.push_back(std::thread(batchKernel,std::cref(links),H0.data(),HN.data(),
+                                      DOF,std::cref(q),k0,std::min(k0+chunk,M),
+                                      axisRep,&poses,jacobians));
+
+    batchKernel(links,H0.data(),HN.data(),DOF,q,0,std::min(chunk,M),
+                axisRep,&poses,jacobians);
+
+    for (size_t i=0; i<workers.size(); i++)
+        workers[i].join();
+
+    return true;
+}
+
+
 /************************************************************************/
 iKinLimb::~iKinLimb()
 {
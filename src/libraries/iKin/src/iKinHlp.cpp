@@ -15,6 +15,7 @@
 #include <iCub/iKin/iKinInv.h>
 #include <iCub/iKin/iKinHlp.h>
 
+using namespace std;
 using namespace yarp::os;
 using namespace yarp::sig;
 using namespace yarp::math;
@@ -82,6 +83,42 @@ bool CartesianHelper::getDesiredOption(const Bottle &reply, Vector &xdhat,
 }
 
 
+/************************************************************************/
+bool CartesianHelper::getDesiredOptions(const Bottle &reply, deque<Vector> &xdhat,
+                                        deque<Vector> &odhat, deque<Vector> &qdhat)
+{
+    xdhat.clear();
+    odhat.clear();
+    qdhat.clear();
+
+    if (reply.size()==0)
+        return false;
+
+    if (reply.get(0).asVocab()==IKINSLV_VOCAB_REP_ACK)
+    {
+        // each item complies with the reply to a single request
+        for (size_t i=1; i<reply.size(); i++)
+        {
+            Bottle *item=reply.get(i).asList();
+            if (item==NULL)
+                return false;
+
+            Vector x,o,q;
+            if (!getDesiredOption(*item,x,o,q))
+                return false;
+
+            xdhat.push_back(x);
+            odhat.push_back(o);
+            qdhat.push_back(q);
+        }
+
+        return true;
+    }
+    else
+        return false;
+}
+
+
 /************************************************************************/
 void CartesianHelper::addTargetOption(Bottle &b, const Vector &xd)
 {
@@ -89,6 +126,22 @@ void CartesianHelper::addTargetOption(Bottle &b, const Vector &xd)
 }
 
 
+/************************************************************************/
+void CartesianHelper::addTargetsOption(Bottle &b, const deque<Vector> &xd)
+{
+    Bottle &part=b.addList();
+    part.addVocab(IKINSLV_VOCAB_OPT_XD);
+    Bottle &targets=part.addList();
+
+    for (size_t k=0; k<xd.size(); k++)
+    {
+        Bottle &vect=targets.addList();
+        for (size_t i=0; i<xd[k].length(); i++)
+            vect.addDouble(xd[k][i]);
+    }
+}
+
+
 /************************************************************************/
 void CartesianHelper::addDOFOption(Bottle &b, const Vector &dof)
 {
@@ -10,14 +10,25 @@
 
 #include <cstdlib>
 #include <limits>
+#include <algorithm>
 #include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
 
 #include <IpTNLP.hpp>
 #include <IpIpoptApplication.hpp>
 
+#include <yarp/os/SystemClock.h>
+
 #include <iCub/iKin/iKinIpOpt.h>
 
 #define CAST_IPOPTAPP(x)                    (static_cast<IpoptApplication*>(x))
+#define CAST_IPOPTNLP(x)                    (static_cast<SmartPtr<iKin_NLP>*>(x))
+#define CAST_WORKERS(x)                     (static_cast<iKinWorkerPool*>(x))
+#define IKINIPOPT_WARMSTART_PUSH            1e-6
 #define IKINIPOPT_SHOULDER_MAXABDUCTION     (100.0*CTRL_DEG2RAD)
 
 using namespace std;
@@ -240,22 +251,24 @@ protected:
     iKinChain &chain;
     iKinChain &chain2ndTask;
 
-    iKinLinIneqConstr &LIC;
+    iKinLinIneqConstr *LIC;
 
     unsigned int dim;
     unsigned int dim_2nd;
     unsigned int ctrlPose;
 
-    yarp::sig::Vector &xd;
-    yarp::sig::Vector &xd_2nd;
-    yarp::sig::Vector &w_2nd;
-    yarp::sig::Vector &qd_3rd;
-    yarp::sig::Vector &w_3rd;
+    yarp::sig::Vector  xd;
+    yarp::sig::Vector  xd_2nd;
+    yarp::sig::Vector  w_2nd;
+    yarp::sig::Vector  qd_3rd;
+    yarp::sig::Vector  w_3rd;
     yarp::sig::Vector  qd;
     yarp::sig::Vector  q0;
     yarp::sig::Vector  q;
     bool              *exhalt;
 
+    const std::atomic<bool> *cancel;
+
     yarp::sig::Vector  e_zero;
     yarp::sig::Vector  e_xyz;
     yarp::sig::Vector  e_ang;
@@ -286,6 +299,20 @@ protected:
     double weight3rdTask;
     bool   firstGo;
 
+    // primal-dual solution kept for warm-starting the next instance
+    bool   warmStart;
+    bool   warmReady;
+    Index  warm_n;
+    Index  warm_m;
+    std::vector<Number> warm_x;
+    std::vector<Number> warm_z_L;
+    std::vector<Number> warm_z_U;
+    std::vector<Number> warm_lambda;
+
+    Index  iterations;
+    double last_obj;
+    double last_constr;
+
     /************************************************************************/
     virtual void computeQuantities(const Number *x)
     {
@@ -344,25 +371,74 @@ protected:
                 for (unsigned int i=0; i<dim; i++)
                     e_3rd[i]=w_3rd[i]*(qd_3rd[i]-q[i]);
 
-            if (LIC.isActive())
-                linC=LIC.getC()*q;
+            if (LIC->isActive())
+                linC=LIC->getC()*q;
+        }
+    }
+
+    /************************************************************************/
+    Index get_num_lic() const
+    {
+        if (LIC->isActive())
+        {
+            int lenLower=(int)LIC->getlB().length();
+            int lenUpper=(int)LIC->getuB().length();
+
+            if (lenLower && (lenLower==lenUpper) && (LIC->getC().cols()==dim))
+                return lenLower;
         }
+
+        return 0;
     }
 
 
 public:
     /************************************************************************/
-    iKin_NLP(iKinChain &c, unsigned int _ctrlPose, const yarp::sig::Vector &_q0,
-             yarp::sig::Vector &_xd, double _weight2ndTask, iKinChain &_chain2ndTask,
-             yarp::sig::Vector &_xd_2nd, yarp::sig::Vector &_w_2nd, double _weight3rdTask,
-             yarp::sig::Vector &_qd_3rd, yarp::sig::Vector &_w_3rd, iKinLinIneqConstr &_LIC,
-             bool *_exhalt=NULL) :
-             chain(c), q0(_q0), xd(_xd),
-             chain2ndTask(_chain2ndTask),   xd_2nd(_xd_2nd), w_2nd(_w_2nd),
-             weight3rdTask(_weight3rdTask), qd_3rd(_qd_3rd), w_3rd(_w_3rd),
-             LIC(_LIC), 
-             exhalt(_exhalt)
+    iKin_NLP(iKinChain &c, iKinChain &_chain2ndTask) :
+             chain(c), chain2ndTask(_chain2ndTask)
+    {
+        LIC=NULL;
+        exhalt=NULL;
+        cancel=NULL;
+        dim=dim_2nd=0;
+        ctrlPose=IKINCTRL_POSE_FULL;
+
+        weight2ndTask=weight3rdTask=0.0;
+
+        __obj_scaling=1.0;
+        __x_scaling  =1.0;
+        __g_scaling  =1.0;
+
+        lowerBoundInf=-std::numeric_limits<double>::max();
+        upperBoundInf=std::numeric_limits<double>::max();
+
+        callback=NULL;
+
+        warmStart=false;
+        warmReady=false;
+        warm_n=warm_m=0;
+        iterations=0;
+        last_obj=last_constr=0.0;
+    }
+
+    /************************************************************************/
+    void set_problem(unsigned int _ctrlPose, const yarp::sig::Vector &_q0,
+                     const yarp::sig::Vector &_xd, double _weight2ndTask,
+                     const yarp::sig::Vector &_xd_2nd, const yarp::sig::Vector &_w_2nd,
+                     double _weight3rdTask, const yarp::sig::Vector &_qd_3rd,
+                     const yarp::sig::Vector &_w_3rd, iKinLinIneqConstr &_LIC,
+                     bool *_exhalt=NULL)
     {
+        q0=_q0;
+        xd=_xd;
+        xd_2nd=_xd_2nd;
+        w_2nd=_w_2nd;
+        qd_3rd=_qd_3rd;
+        w_3rd=_w_3rd;
+        weight3rdTask=_weight3rdTask;
+        LIC=&_LIC;
+        exhalt=_exhalt;
+
         dim=chain.getDOF();
         dim_2nd=chain2ndTask.getDOF();
 
@@ -413,23 +489,50 @@ public:
         J_cst=&J_xyz;
 
         firstGo=true;
+        iterations=0;
+    }
 
-        __obj_scaling=1.0;
-        __x_scaling  =1.0;
-        __g_scaling  =1.0;
+    /************************************************************************/
+    void set_warm_start(const bool _warmStart)
+    {
+        warmStart=_warmStart;
+        if (!warmStart)
+            warmReady=false;
+    }
 
-        lowerBoundInf=-std::numeric_limits<double>::max();
-        upperBoundInf=std::numeric_limits<double>::max();
+    /************************************************************************/
+    bool get_warm_start() const { return warmStart; }
 
-        callback=NULL;
+    /************************************************************************/
+    void reset_warm_start() { warmReady=false; }
+
+    /************************************************************************/
+    bool is_warm_start_available() const
+    {
+        // the previous solution is reusable only if the
+        // problem dimensions have not changed meanwhile
+        return (warmStart && warmReady && (warm_n==(Index)dim) &&
+                (warm_m==1+get_num_lic()));
     }
 
+    /************************************************************************/
+    int get_iterations() const { return (int)iterations; }
+
+    /************************************************************************/
+    double get_obj_value() const { return last_obj; }
+
+    /************************************************************************/
+    double get_constr_value() const { return last_constr; }
+
     /************************************************************************/
     yarp::sig::Vector get_qd() { return qd; }
 
     /************************************************************************/
     void set_callback(iKinIterateCallback *_callback) { callback=_callback; }
 
+    /************************************************************************/
+    void set_cancel(const std::atomic<bool> *_cancel) { cancel=_cancel; }
+
     /************************************************************************/
     void set_scaling(double _obj_scaling, double _x_scaling, double _g_scaling)
     {
@@ -494,18 +597,16 @@ public:
         m=1;
         nnz_jac_g=dim;
 
-        if (LIC.isActive())
+        if (LIC->isActive())
         {
-            int lenLower=(int)LIC.getlB().length();
-            int lenUpper=(int)LIC.getuB().length();
-
-            if (lenLower && (lenLower==lenUpper) && (LIC.getC().cols()==dim))
+            Index lenLIC=get_num_lic();
+            if (lenLIC>0)
             {
-                m+=lenLower;
-                nnz_jac_g+=lenLower*dim;
+                m+=lenLIC;
+                nnz_jac_g+=lenLIC*dim;
             }
             else
-                LIC.setActive(false);
+                LIC->setActive(false);
         }
         
         nnz_h_lag=(dim*(dim+1))>>1;
@@ -535,8 +636,8 @@ public:
             }
             else
             {
-                g_l[i]=LIC.getlB()[i-offs];
-                g_u[i]=LIC.getuB()[i-offs];
+                g_l[i]=LIC->getlB()[i-offs];
+                g_u[i]=LIC->getuB()[i-offs];
             }
         }
 
@@ -548,6 +649,33 @@ public:
                             Number* z_L, Number* z_U, Index m, bool init_lambda,
                             Number* lambda)
     {
+        if (is_warm_start_available() && (n==warm_n) && (m==warm_m))
+        {
+            if (init_x)
+                for (Index i=0; i<n; i++)
+                    x[i]=warm_x[i];
+
+            if (init_z)
+            {
+                for (Index i=0; i<n; i++)
+                {
+                    z_L[i]=warm_z_L[i];
+                    z_U[i]=warm_z_U[i];
+                }
+            }
+
+            if (init_lambda)
+                for (Index i=0; i<m; i++)
+                    lambda[i]=warm_lambda[i];
+
+            return true;
+        }
+
+        // IpOpt asks for the multipliers only when the warm start
+        // has been requested, which is not the case here
+        if (init_z || init_lambda)
+            return false;
+
         for (Index i=0; i<n; i++)
             x[i]=q0[i];
 
@@ -649,7 +777,7 @@ public:
                             offs=1;
                         }
                         else
-                            values[idx]=LIC.getC()(row-offs,col);
+                            values[idx]=LIC->getC()(row-offs,col);
                     
                         idx++;
                     }
@@ -748,9 +876,15 @@ public:
                                Index ls_trials, const IpoptData* ip_data,
                                IpoptCalculatedQuantities* ip_cq)
     {
+        iterations=iter;
+
         if (callback!=NULL)
             callback->exec(xd,q);
 
+        // request shared among the workers
+        if ((cancel!=NULL) && cancel->load())
+            return false;
+
         if (exhalt!=NULL)
             return !(*exhalt);
         else
@@ -785,6 +919,22 @@ public:
             qd[i]=x[i];
 
         qd=chain.setAng(qd);
+
+        last_obj=obj_value;
+        last_constr=(m>0)?g[0]:0.0;
+
+        // store the primal-dual solution only if it
+        // is worth being used as starting point
+        warmReady=warmStart && ((status==SUCCESS) || (status==STOP_AT_ACCEPTABLE_POINT));
+        if (warmReady)
+        {
+            warm_n=n;
+            warm_m=m;
+            warm_x.assign(x,x+n);
+            warm_z_L.assign(z_L,z_L+n);
+            warm_z_U.assign(z_U,z_U+n);
+            warm_lambda.assign(lambda,lambda+m);
+        }
     }
 
     /************************************************************************/
@@ -792,6 +942,100 @@ public:
 };
 
 
+/************************************************************************/
+class iKinChainReplica : public iKinLimb
+{
+public:
+    /************************************************************************/
+    iKinChainReplica(iKinChain &c) : iKinLimb()
+    {
+        sync(c);
+    }
+
+    /************************************************************************/
+    void sync(iKinChain &c)
+    {
+        // the replica owns its links so that it can be
+        // moved independently of the original chain
+        if (linkList.size()!=c.getN())
+        {
+            dispose();
+            for (unsigned int i=0; i<c.getN(); i++)
+                pushLink(new iKinLink(c[i]));
+        }
+        else
+        {
+            for (unsigned int i=0; i<c.getN(); i++)
+                *linkList[i]=c[i];
+
+            build();
+        }
+
+        setH0(c.getH0());
+        setHN(c.getHN());
+    }
+};
+
+
+/************************************************************************/
+class iKinMultiStartCallback : public iKinIterateCallback
+{
+protected:
+    bool *exhalt;
+    std::atomic<bool> *cancel;
+
+public:
+    /************************************************************************/
+    iKinMultiStartCallback() : exhalt(NULL), cancel(NULL) { }
+
+    /************************************************************************/
+    void set(bool *_exhalt, std::atomic<bool> *_cancel)
+    {
+        exhalt=_exhalt;
+        cancel=_cancel;
+    }
+
+    /************************************************************************/
+    virtual ~iKinMultiStartCallback() { }
+
+    /************************************************************************/
+    void exec(const yarp::sig::Vector &xd, const yarp::sig::Vector &q)
+    {
+        // forward the external request to exit to all the workers
+        if ((exhalt!=NULL) && *exhalt)
+            cancel->store(true);
+    }
+};
+
+
+/************************************************************************/
+struct iKinWorkerPool
+{
+    std::deque<iKinChainReplica*>       replicas;
+    std::deque<iKinIpOptMin*>           solvers;
+    std::deque<iKinLinIneqConstr>       LICs;
+    std::deque<iKinMultiStartCallback*> callbacks;
+    std::deque<unsigned int>            optionsVersions;
+
+    // raised to stop all the workers
+    std::atomic<bool> cancel;
+
+    /************************************************************************/
+    iKinWorkerPool() : cancel(false) { }
+
+    /************************************************************************/
+    ~iKinWorkerPool()
+    {
+        for (size_t i=0; i<solvers.size(); i++)
+        {
+            delete solvers[i];
+            delete replicas[i];
+            delete callbacks[i];
+        }
+    }
+};
+
+
 /************************************************************************/
 iKinIpOptMin::iKinIpOptMin(iKinChain &c, const unsigned int _ctrlPose, const double tol,
                            const double constr_tol, const int max_iter,
@@ -815,6 +1059,11 @@ iKinIpOptMin::iKinIpOptMin(iKinChain &c, const unsigned int _ctrlPose, const dou
     CAST_IPOPTAPP(App)->Options()->SetStringValue("mu_strategy","adaptive");
     CAST_IPOPTAPP(App)->Options()->SetIntegerValue("print_level",verbose);
 
+    // warm start is enabled on demand right before each solve
+    CAST_IPOPTAPP(App)->Options()->SetStringValue("warm_start_init_point","no");
+    CAST_IPOPTAPP(App)->Options()->SetNumericValue("warm_start_bound_push",IKINIPOPT_WARMSTART_PUSH);
+    CAST_IPOPTAPP(App)->Options()->SetNumericValue("warm_start_mult_bound_push",IKINIPOPT_WARMSTART_PUSH);
+
     getBoundsInf(lowerBoundInf,upperBoundInf);
 
     if (max_iter>0)
@@ -826,6 +1075,19 @@ iKinIpOptMin::iKinIpOptMin(iKinChain &c, const unsigned int _ctrlPose, const dou
         CAST_IPOPTAPP(App)->Options()->SetStringValue("hessian_approximation","limited-memory");
 
     CAST_IPOPTAPP(App)->Initialize();
+
+    // the NLP is kept alive across the calls to solve()
+    NLP=new SmartPtr<iKin_NLP>(new iKin_NLP(chain,chain2ndTask));
+
+    lastIterations=0;
+    lastSolveTime=0.0;
+
+    workers=NULL;
+    nMultiStart=0;
+    nMultiStartThreads=1;
+    optionsVersion=1;
+    seedCache=NULL;
+    querySeedCache=true;
 }
 
 
@@ -885,6 +1147,7 @@ void iKinIpOptMin::setMaxIter(const int max_iter)
         CAST_IPOPTAPP(App)->Options()->SetIntegerValue("max_iter",std::numeric_limits<int>::max());
 
     CAST_IPOPTAPP(App)->Initialize();
+    optionsVersion++;
 }
 
 
@@ -902,6 +1165,7 @@ void iKinIpOptMin::setMaxCpuTime(const double max_cpu_time)
 {
     CAST_IPOPTAPP(App)->Options()->SetNumericValue("max_cpu_time",max_cpu_time);
     CAST_IPOPTAPP(App)->Initialize();
+    optionsVersion++;
 }
 
 
@@ -919,6 +1183,7 @@ void iKinIpOptMin::setTol(const double tol)
 {
     CAST_IPOPTAPP(App)->Options()->SetNumericValue("tol",tol);
     CAST_IPOPTAPP(App)->Initialize();
+    optionsVersion++;
 }
 
 
@@ -936,6 +1201,7 @@ void iKinIpOptMin::setConstrTol(const double constr_tol)
 {
     CAST_IPOPTAPP(App)->Options()->SetNumericValue("constr_viol_tol",constr_tol);
     CAST_IPOPTAPP(App)->Initialize();
+    optionsVersion++;
 }
 
 
@@ -954,6 +1220,7 @@ void iKinIpOptMin::setVerbosity(const unsigned int verbose)
     CAST_IPOPTAPP(App)->Options()->SetIntegerValue("print_level",verbose);
 
     CAST_IPOPTAPP(App)->Initialize();
+    optionsVersion++;
 }
 
 
@@ -966,6 +1233,7 @@ void iKinIpOptMin::setHessianOpt(const bool useHessian)
         CAST_IPOPTAPP(App)->Options()->SetStringValue("hessian_approximation","limited-memory");
 
     CAST_IPOPTAPP(App)->Initialize();
+    optionsVersion++;
 }
 
 
@@ -985,6 +1253,7 @@ void iKinIpOptMin::setUserScaling(const bool useUserScaling, const double _obj_s
         CAST_IPOPTAPP(App)->Options()->SetStringValue("nlp_scaling_method","gradient-based");
 
     CAST_IPOPTAPP(App)->Initialize();
+    optionsVersion++;
 }
 
 
@@ -1004,6 +1273,7 @@ void iKinIpOptMin::setDerivativeTest(const bool enableTest, const bool enable2nd
         CAST_IPOPTAPP(App)->Options()->SetStringValue("derivative_test","none");
 
     CAST_IPOPTAPP(App)->Initialize();
+    optionsVersion++;
 }
 
 
@@ -1023,6 +1293,36 @@ void iKinIpOptMin::setBoundsInf(const double lower, const double upper)
 
     lowerBoundInf=lower;
     upperBoundInf=upper;
+    optionsVersion++;
+}
+
+
+/************************************************************************/
+yarp::sig::Vector iKinIpOptMin::getSeed(const yarp::sig::Vector &q0,
+                                        const yarp::sig::Vector &xd)
+{
+    yarp::sig::Vector q;
+    if (!querySeedCache || (seedCache==NULL) || (seedCache->getN()!=chain.getN()) ||
+        (q0.length()!=chain.getDOF()) || (xd.length()<3) ||
+        !seedCache->query(xd,q))
+        return q0;
+
+    // retain only the DOF currently controlled
+    yarp::sig::Vector seed(chain.getDOF());
+    for (unsigned int i=0, j=0; i<chain.getN(); i++)
+        if (!chain[i].isBlocked())
+            seed[j++]=q[i];
+
+    // the cached configuration is preferred
+    // only if it gets closer to the target;
+    // the chain is then brought back where it was
+    yarp::sig::Vector q_cur=chain.getAng();
+    yarp::sig::Vector xd_xyz=xd.subVector(0,2);
+    double e_seed=norm(xd_xyz-chain.EndEffPosition(seed));
+    double e_q0=norm(xd_xyz-chain.EndEffPosition(q0));
+    chain.setAng(q_cur);
+
+    return (e_seed<e_q0)?seed:q0;
 }
 
 
@@ -1033,17 +1333,28 @@ yarp::sig::Vector iKinIpOptMin::solve(const yarp::sig::Vector &q0, yarp::sig::Ve
                                       yarp::sig::Vector &qd_3rd, yarp::sig::Vector &w_3rd,
                                       int *exit_code, bool *exhalt, iKinIterateCallback *iterate)
 {
-    SmartPtr<iKin_NLP> nlp=new iKin_NLP(chain,ctrlPose,q0,xd,
-                                        weight2ndTask,chain2ndTask,xd_2nd,w_2nd,
-                                        weight3rdTask,qd_3rd,w_3rd,
-                                        *pLIC,exhalt);
+    double t0=yarp::os::SystemClock::nowSystem();
+
+    SmartPtr<iKin_NLP> &nlp=*CAST_IPOPTNLP(NLP);
+    nlp->set_problem(ctrlPose,getSeed(q0,xd),xd,weight2ndTask,xd_2nd,w_2nd,
+                     weight3rdTask,qd_3rd,w_3rd,*pLIC,exhalt);
     
     nlp->set_scaling(obj_scaling,x_scaling,g_scaling);
     nlp->set_bound_inf(lowerBoundInf,upperBoundInf);
     nlp->set_posePriority(posePriority);
     nlp->set_callback(iterate);
 
+    CAST_IPOPTAPP(App)->Options()->SetStringValue("warm_start_init_point",
+                                                  nlp->is_warm_start_available()?"yes":"no");
+
     ApplicationReturnStatus status=CAST_IPOPTAPP(App)->OptimizeTNLP(GetRawPtr(nlp));
+    lastSolveTime=yarp::os::SystemClock::nowSystem()-t0;
+    lastIterations=nlp->get_iterations();
+
+    // feed the cache with converged solutions only
+    if ((seedCache!=NULL) &&
+        ((status==Solve_Succeeded) || (status==Solved_To_Acceptable_Level)))
+        seedCache->add(chain);
 
     if (exit_code!=NULL)
         *exit_code=status;
@@ -1070,9 +1381,353 @@ yarp::sig::Vector iKinIpOptMin::solve(const yarp::sig::Vector &q0, yarp::sig::Ve
 }
 
 
+/************************************************************************/
+void iKinIpOptMin::setWarmStart(const bool warmStart)
+{
+    (*CAST_IPOPTNLP(NLP))->set_warm_start(warmStart);
+}
+
+
+/************************************************************************/
+bool iKinIpOptMin::getWarmStart() const
+{
+    return (*CAST_IPOPTNLP(NLP))->get_warm_start();
+}
+
+
+/************************************************************************/
+void iKinIpOptMin::resetWarmStart()
+{
+    (*CAST_IPOPTNLP(NLP))->reset_warm_start();
+}
+
+
+/************************************************************************/
+void iKinIpOptMin::prepareWorkers(const size_t nWorkers, bool *exhalt)
+{
+    if (workers==NULL)
+        workers=new iKinWorkerPool;
+
+    iKinWorkerPool *pool=CAST_WORKERS(workers);
+
+    // allocate the workers lazily
+    while (pool->solvers.size()<nWorkers)
+    {
+        iKinChainReplica *replica=new iKinChainReplica(chain);
+        iKinIpOptMin *solver=new iKinIpOptMin(*replica->asChain(),ctrlPose,
+                                              getTol(),getConstrTol());
+        pool->replicas.push_back(replica);
+        pool->solvers.push_back(solver);
+        pool->LICs.push_back(iKinLinIneqConstr());
+        pool->callbacks.push_back(new iKinMultiStartCallback);
+        pool->optionsVersions.push_back(0);
+    }
+
+    pool->cancel=false;
+
+    // align the workers to the current state of the solver
+    for (size_t k=0; k<nWorkers; k++)
+    {
+        iKinIpOptMin *solver=pool->solvers[k];
+
+        pool->replicas[k]->sync(chain);
+        if (chain2ndTask.getN()>0)
+            solver->specify2ndTaskEndEff(chain2ndTask.getN());
+        else
+            solver->get2ndTaskChain().clear();
+
+        // initializing IpOpt is expensive (e.g. the options file is
+        // parsed again), hence it is done only when the options change
+        if (pool->optionsVersions[k]!=optionsVersion)
+        {
+            *CAST_IPOPTAPP(solver->App)->Options()=*CAST_IPOPTAPP(App)->Options();
+            CAST_IPOPTAPP(solver->App)->Options()->SetStringValue("warm_start_init_point","no");
+            CAST_IPOPTAPP(solver->App)->Initialize();
+            pool->optionsVersions[k]=optionsVersion;
+        }
+
+        solver->ctrlPose=ctrlPose;
+        solver->posePriority=posePriority;
+        solver->obj_scaling=obj_scaling;
+        solver->x_scaling=x_scaling;
+        solver->g_scaling=g_scaling;
+        solver->lowerBoundInf=lowerBoundInf;
+        solver->upperBoundInf=upperBoundInf;
+
+        pool->LICs[k]=*pLIC;
+        solver->attachLIC(pool->LICs[k]);
+
+        // the seeds of the workers are given explicitly,
+        // hence the cache can only be fed
+        solver->querySeedCache=false;
+
+        pool->callbacks[k]->set(exhalt,&pool->cancel);
+    }
+}
+
+
+/************************************************************************/
+void iKinIpOptMin::setMultiStart(const unsigned int nSeeds, const unsigned int nThreads)
+{
+    nMultiStart=nSeeds;
+    nMultiStartThreads=std::max(nThreads,1U);
+}
+
+
+/************************************************************************/
+unsigned int iKinIpOptMin::getMultiStart() const
+{
+    return nMultiStart;
+}
+
+
+/************************************************************************/
+unsigned int iKinIpOptMin::getMultiStartThreads() const
+{
+    return nMultiStartThreads;
+}
+
+
+/************************************************************************/
+yarp::sig::Vector iKinIpOptMin::solveMultiStart(const std::deque<yarp::sig::Vector> &seeds,
+                                                yarp::sig::Vector &xd, double weight2ndTask,
+                                                yarp::sig::Vector &xd_2nd, yarp::sig::Vector &w_2nd,
+                                                double weight3rdTask, yarp::sig::Vector &qd_3rd,
+                                                yarp::sig::Vector &w_3rd, const double costThres,
+                                                int *exit_code, bool *exhalt)
+{
+    // fall back on the plain solver when there is nothing to parallelize
+    if ((nMultiStart==0) || (seeds.size()<2))
+    {
+        // an explicit seed is not replaced by the cached ones
+        bool query=querySeedCache;
+        querySeedCache=(seeds.size()==0);
+        yarp::sig::Vector q=solve(seeds.size()>0?seeds[0]:chain.getAng(),xd,weight2ndTask,xd_2nd,w_2nd,
+                                  weight3rdTask,qd_3rd,w_3rd,exit_code,exhalt);
+        querySeedCache=query;
+        return q;
+    }
+
+    double t0=yarp::os::SystemClock::nowSystem();
+
+    size_t nWorkers=std::min((size_t)nMultiStartThreads,seeds.size());
+    prepareWorkers(nWorkers,exhalt);
+    iKinWorkerPool *pool=CAST_WORKERS(workers);
+    std::atomic<bool> &cancel=pool->cancel;
+
+    // each worker picks up the next available seed until none is left
+    // or a solution good enough has been found
+    std::mutex mtx;
+    size_t nextSeed=0;
+    bool   found=false;
+    bool   bestFeasible=false;
+    double bestObj=std::numeric_limits<double>::max();
+    double bestConstr=std::numeric_limits<double>::max();
+    int    bestExitCode=User_Requested_Stop;
+    int    bestIterations=0;
+    yarp::sig::Vector bestQ=chain.getAng();
+
+    auto work=[&](const size_t k)
+    {
+        iKinIpOptMin *solver=pool->solvers[k];
+        iKin_NLP *nlp=GetRawPtr(*CAST_IPOPTNLP(solver->NLP));
+        nlp->set_cancel(&cancel);
+
+        // every worker needs its own copy of the task vectors
+        yarp::sig::Vector _xd=xd;
+        yarp::sig::Vector _xd_2nd=xd_2nd;
+        yarp::sig::Vector _w_2nd=w_2nd;
+        yarp::sig::Vector _qd_3rd=qd_3rd;
+        yarp::sig::Vector _w_3rd=w_3rd;
+
+        while (true)
+        {
+            size_t i;
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                if (cancel || (nextSeed>=seeds.size()))
+                    break;
+                i=nextSeed++;
+            }
+
+            int exit_code_k;
+            yarp::sig::Vector q=solver->solve(seeds[i],_xd,weight2ndTask,_xd_2nd,_w_2nd,
+                                              weight3rdTask,_qd_3rd,_w_3rd,&exit_code_k,
+                                              NULL,pool->callbacks[k]);
+
+            bool feasible=(exit_code_k==Solve_Succeeded) || (exit_code_k==Solved_To_Acceptable_Level);
+            double obj=nlp->get_obj_value();
+            double constr=nlp->get_constr_value();
+
+            std::lock_guard<std::mutex> lck(mtx);
+            if (found || (exit_code_k==User_Requested_Stop))
+                continue;
+
+            // feasible solutions are ranked by cost, while
+            // the others by the violation of the constraint
+            bool better=feasible ? (!bestFeasible || (obj<bestObj)) :
+                                   (!bestFeasible && (constr<bestConstr));
+            if (better)
+            {
+                bestFeasible=feasible;
+                bestObj=obj;
+                bestConstr=constr;
+                bestExitCode=exit_code_k;
+                bestIterations=solver->getLastIterations();
+                bestQ=q;
+            }
+
+            if (feasible && (costThres>0.0) && (obj<=costThres))
+            {
+                found=true;
+                cancel=true;
+            }
+        }
+
+        nlp->set_cancel(NULL);
+    };
+
+    // a single worker goes through the seeds serially within the caller
+    if (nWorkers<=1)
+        work(0);
+    else
+    {
+        std::deque<std::thread> threads;
+        for (size_t k=0; k<nWorkers; k++)
+            threads.push_back(std::thread(work,k));
+
+        for (size_t k=0; k<threads.size(); k++)
+            threads[k].join();
+    }
+
+    bestQ=chain.setAng(bestQ);
+
+    if ((seedCache!=NULL) && bestFeasible)
+        seedCache->add(chain);
+
+    lastIterations=bestIterations;
+    lastSolveTime=yarp::os::SystemClock::nowSystem()-t0;
+
+    if (exit_code!=NULL)
+        *exit_code=bestExitCode;
+
+    return bestQ;
+}
+
+
+/************************************************************************/
+void iKinIpOptMin::solveBatch(const yarp::sig::Vector &q0, const std::deque<yarp::sig::Vector> &xd,
+                              double weight2ndTask, yarp::sig::Vector &xd_2nd, yarp::sig::Vector &w_2nd,
+                              double weight3rdTask, yarp::sig::Vector &qd_3rd, yarp::sig::Vector &w_3rd,
+                              std::deque<yarp::sig::Vector> &qd, std::deque<int> *exit_codes,
+                              const unsigned int nThreads, bool *exhalt)
+{
+    double t0=yarp::os::SystemClock::nowSystem();
+
+    qd.assign(xd.size(),q0);
+    if (exit_codes!=NULL)
+        exit_codes->assign(xd.size(),User_Requested_Stop);
+
+    int iterations=0;
+    size_t nWorkers=std::min((size_t)nThreads,xd.size());
+
+    if (nWorkers<=1)
+    {
+        // q0 is given explicitly, hence the cache can only be fed
+        bool query=querySeedCache;
+        querySeedCache=false;
+
+        // every target starts from q0, regardless of the order:
+        // warm-starting from the previous target is not allowed
+        bool warmStart=getWarmStart();
+        setWarmStart(false);
+
+        for (size_t i=0; i<xd.size(); i++)
+        {
+            if ((exhalt!=NULL) && *exhalt)
+                break;
+
+            int exit_code;
+            yarp::sig::Vector _xd=xd[i];
+            qd[i]=solve(q0,_xd,weight2ndTask,xd_2nd,w_2nd,
+                        weight3rdTask,qd_3rd,w_3rd,&exit_code,exhalt);
+
+            iterations+=lastIterations;
+            if (exit_codes!=NULL)
+                (*exit_codes)[i]=exit_code;
+        }
+
+        querySeedCache=query;
+        setWarmStart(warmStart);
+    }
+    else
+    {
+        prepareWorkers(nWorkers,exhalt);
+        iKinWorkerPool *pool=CAST_WORKERS(workers);
+        std::atomic<bool> &cancel=pool->cancel;
+
+        // each worker picks up the next available target until none is left
+        std::mutex mtx;
+        size_t nextTarget=0;
+
+        std::deque<std::thread> threads;
+        for (size_t k=0; k<nWorkers; k++)
+        {
+            threads.push_back(std::thread([&,k]()
+            {
+                iKinIpOptMin *solver=pool->solvers[k];
+                iKin_NLP *nlp=GetRawPtr(*CAST_IPOPTNLP(solver->NLP));
+                nlp->set_cancel(&cancel);
+                solver->attachSeedCache(seedCache);
+
+                // every worker needs its own copy of the task vectors
+                yarp::sig::Vector _xd_2nd=xd_2nd;
+                yarp::sig::Vector _w_2nd=w_2nd;
+                yarp::sig::Vector _qd_3rd=qd_3rd;
+                yarp::sig::Vector _w_3rd=w_3rd;
+
+                while (true)
+                {
+                    size_t i;
+                    {
+                        std::lock_guard<std::mutex> lck(mtx);
+                        if (cancel || (nextTarget>=xd.size()))
+                            break;
+                        i=nextTarget++;
+                    }
+
+                    int exit_code;
+                    yarp::sig::Vector _xd=xd[i];
+                    yarp::sig::Vector q=solver->solve(q0,_xd,weight2ndTask,_xd_2nd,_w_2nd,
+                                                      weight3rdTask,_qd_3rd,_w_3rd,&exit_code,
+                                                      NULL,pool->callbacks[k]);
+
+                    std::lock_guard<std::mutex> lck(mtx);
+                    qd[i]=q;
+                    iterations+=solver->getLastIterations();
+                    if (exit_codes!=NULL)
+                        (*exit_codes)[i]=exit_code;
+                }
+
+                solver->attachSeedCache(NULL);
+                nlp->set_cancel(NULL);
+            }));
+        }
+
+        for (size_t k=0; k<threads.size(); k++)
+            threads[k].join();
+    }
+
+    lastIterations=iterations;
+    lastSolveTime=yarp::os::SystemClock::nowSystem()-t0;
+}
+
+
 /************************************************************************/
 iKinIpOptMin::~iKinIpOptMin()
 {
+    delete CAST_IPOPTNLP(NLP);
+    delete CAST_WORKERS(workers);
     delete CAST_IPOPTAPP(App);
 }
 
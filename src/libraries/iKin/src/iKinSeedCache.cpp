@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD-3-Clause license. See the accompanying LICENSE file for
+ * details.
+*/
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <fstream>
+#include <iomanip>
+
+#include <iCub/iKin/iKinSeedCache.h>
+
+#define IKINSEEDCACHE_KEY_BITS      21
+#define IKINSEEDCACHE_KEY_OFFSET    (1<<(IKINSEEDCACHE_KEY_BITS-1))
+#define IKINSEEDCACHE_KEY_MASK      ((1LL<<IKINSEEDCACHE_KEY_BITS)-1)
+#define IKINSEEDCACHE_FILE_HEADER   "iKinSeedCache"
+
+using namespace std;
+using namespace yarp::sig;
+using namespace iCub::iKin;
+
+
+/************************************************************************/
+iKinSeedCache::iKinSeedCache(const string &_type, const unsigned int _N,
+                             const double _resolution, const unsigned int _capacity) :
+                             type(_type), N(_N)
+{
+    resolution=(_resolution>0.0)?_resolution:IKINSEEDCACHE_DEFAULT_RESOLUTION;
+    capacity=(_capacity>0)?_capacity:1;
+    orienWeight=IKINSEEDCACHE_DEFAULT_ORIENWEIGHT;
+    numEntries=0;
+}
+
+
+/************************************************************************/
+long long iKinSeedCache::getKey(const int ix, const int iy, const int iz) const
+{
+    return ((((long long)ix+IKINSEEDCACHE_KEY_OFFSET)&IKINSEEDCACHE_KEY_MASK)<<(2*IKINSEEDCACHE_KEY_BITS)) |
+           ((((long long)iy+IKINSEEDCACHE_KEY_OFFSET)&IKINSEEDCACHE_KEY_MASK)<<IKINSEEDCACHE_KEY_BITS)     |
+           ( ((long long)iz+IKINSEEDCACHE_KEY_OFFSET)&IKINSEEDCACHE_KEY_MASK);
+}
+
+
+/************************************************************************/
+void iKinSeedCache::getIndices(const double *pos, int &ix, int &iy, int &iz) const
+{
+    ix=(int)floor(pos[0]/resolution);
+    iy=(int)floor(pos[1]/resolution);
+    iz=(int)floor(pos[2]/resolution);
+}
+
+
+/************************************************************************/
+void iKinSeedCache::fillEntry(const Vector &pose, Entry &entry) const
+{
+    entry.pos[0]=pose[0];
+    entry.pos[1]=pose[1];
+    entry.pos[2]=pose[2];
+
+    // store the orientation as unit quaternion to speed up
+    // the computation of the distance; a null quaternion
+    // means that the orientation is not specified
+    entry.quat[0]=entry.quat[1]=entry.quat[2]=entry.quat[3]=0.0;
+    if (pose.length()>=7)
+    {
+        double r=sqrt(pose[3]*pose[3]+pose[4]*pose[4]+pose[5]*pose[5]);
+        double s=sin(0.5*pose[6]);
+        entry.quat[0]=cos(0.5*pose[6]);
+        if (r>0.0)
+        {
+            entry.quat[1]=s*pose[3]/r;
+            entry.quat[2]=s*pose[4]/r;
+            entry.quat[3]=s*pose[5]/r;
+        }
+        else
+            entry.quat[0]=1.0;
+    }
+}
+
+
+/************************************************************************/
+double iKinSeedCache::distance(const Entry &target, const Entry &entry) const
+{
+    double dx=target.pos[0]-entry.pos[0];
+    double dy=target.pos[1]-entry.pos[1];
+    double dz=target.pos[2]-entry.pos[2];
+    double d=sqrt(dx*dx+dy*dy+dz*dz);
+
+    if ((orienWeight>0.0) && (target.quat[0]!=0.0 || target.quat[1]!=0.0 ||
+                              target.quat[2]!=0.0 || target.quat[3]!=0.0))
+    {
+        double c=fabs(target.quat[0]*entry.quat[0]+target.quat[1]*entry.quat[1]+
+                      target.quat[2]*entry.quat[2]+target.quat[3]*entry.quat[3]);
+        d+=orienWeight*2.0*acos(std::min(c,1.0));
+    }
+
+    return d;
+}
+
+
+/************************************************************************/
+void iKinSeedCache::insert(const Entry &entry)
+{
+    int ix,iy,iz;
+    getIndices(entry.pos,ix,iy,iz);
+
+    deque<Entry> &voxel=grid[getKey(ix,iy,iz)];
+    voxel.push_back(entry);
+    numEntries++;
+
+    if (voxel.size()>capacity)
+    {
+        voxel.pop_front();
+        numEntries--;
+    }
+}
+
+
+/************************************************************************/
+size_t iKinSeedCache::size() const
+{
+    lock_guard<mutex> lck(mtx);
+    return numEntries;
+}
+
+
+/************************************************************************/
+void iKinSeedCache::clear()
+{
+    lock_guard<mutex> lck(mtx);
+    grid.clear();
+    numEntries=0;
+}
+
+
+/************************************************************************/
+bool iKinSeedCache::add(const Vector &pose, const Vector &q)
+{
+    if ((pose.length()<3) || (q.length()!=N))
+        return false;
+
+    Entry entry;
+    fillEntry(pose,entry);
+    entry.q=q;
+
+    lock_guard<mutex> lck(mtx);
+    insert(entry);
+
+    return true;
+}
+
+
+/************************************************************************/
+bool iKinSeedCache::add(iKinChain &chain)
+{
+    if (chain.getN()!=N)
+        return false;
+
+    Vector q(N);
+    for (unsigned int i=0; i<N; i++)
+        q[i]=chain[i].getAng();
+
+    return add(chain.EndEffPose(),q);
+}
+
+
+/************************************************************************/
+size_t iKinSeedCache::query(const Vector &xd, const size_t k, deque<Vector> &seeds) const
+{
+    seeds.clear();
+    if ((xd.length()<3) || (k==0))
+        return 0;
+
+    Entry target;
+    fillEntry(xd,target);
+
+    int ix,iy,iz;
+    getIndices(target.pos,ix,iy,iz);
+
+    deque<pair<double,const Entry*> > candidates;
+
+    lock_guard<mutex> lck(mtx);
+    for (int i=ix-1; i<=ix+1; i++)
+    {
+        for (int j=iy-1; j<=iy+1; j++)
+        {
+            for (int l=iz-1; l<=iz+1; l++)
+            {
+                auto voxel=grid.find(getKey(i,j,l));
+                if (voxel!=grid.end())
+                    for (size_t n=0; n<voxel->second.size(); n++)
+                        candidates.push_back(make_pair(distance(target,voxel->second[n]),
+                                                       &voxel->second[n]));
+            }
+        }
+    }
+
+    size_t len=std::min(k,candidates.size());
+    partial_sort(candidates.begin(),candidates.begin()+len,candidates.end(),
+                 [](const pair<double,const Entry*> &a, const pair<double,const Entry*> &b)
+                 { return (a.first<b.first); });
+
+    for (size_t i=0; i<len; i++)
+        seeds.push_back(candidates[i].second->q);
+
+    return len;
+}
+
+
+/************************************************************************/
+bool iKinSeedCache::query(const Vector &xd, Vector &q) const
+{
+    deque<Vector> seeds;
+    if (query(xd,1,seeds)>0)
+    {
+        q=seeds.front();
+        return true;
+    }
+    else
+        return false;
+}
+
+
+/************************************************************************/
+bool iKinSeedCache::save(const string &fileName) const
+{
+    ofstream fout(fileName.c_str());
+    if (!fout.is_open())
+        return false;
+
+    lock_guard<mutex> lck(mtx);
+
+    fout<<IKINSEEDCACHE_FILE_HEADER<<endl;
+    fout<<"type "<<(type.empty()?"none":type)<<endl;
+    fout<<"N "<<N<<endl;
+    fout<<"entries "<<numEntries<<endl;
+
+    // position, quaternion and joints angles per row
+    fout<<setprecision(numeric_limits<double>::digits10+2);
+    for (auto voxel=grid.begin(); voxel!=grid.end(); voxel++)
+    {
+        for (size_t n=0; n<voxel->second.size(); n++)
+        {
+            const Entry &entry=voxel->second[n];
+            for (int i=0; i<3; i++)
+                fout<<entry.pos[i]<<" ";
+            for (int i=0; i<4; i++)
+                fout<<entry.quat[i]<<" ";
+            for (size_t i=0; i<entry.q.length(); i++)
+                fout<<entry.q[i]<<((i<entry.q.length()-1)?" ":"");
+            fout<<endl;
+        }
+    }
+
+    return !fout.fail();
+}
+
+
+/************************************************************************/
+bool iKinSeedCache::load(const string &fileName)
+{
+    ifstream fin(fileName.c_str());
+    if (!fin.is_open())
+        return false;
+
+    string header,tag,_type;
+    unsigned int _N;
+    size_t entries;
+
+    fin>>header;
+    if (header!=IKINSEEDCACHE_FILE_HEADER)
+        return false;
+
+    fin>>tag>>_type;
+    if ((tag!="type") || (_type!=(type.empty()?"none":type)))
+        return false;
+
+    fin>>tag>>_N;
+    if ((tag!="N") || (_N!=N))
+        return false;
+
+    fin>>tag>>entries;
+    if (tag!="entries")
+        return false;
+
+    deque<Entry> loaded;
+    for (size_t n=0; n<entries; n++)
+    {
+        Entry entry;
+        entry.q.resize(N);
+        for (int i=0; i<3; i++)
+            fin>>entry.pos[i];
+        for (int i=0; i<4; i++)
+            fin>>entry.quat[i];
+        for (unsigned int i=0; i<N; i++)
+            fin>>entry.q[i];
+
+        if (fin.fail())
+            return false;
+
+        loaded.push_back(entry);
+    }
+
+    lock_guard<mutex> lck(mtx);
+    for (size_t n=0; n<loaded.size(); n++)
+        insert(loaded[n]);
+
+    return true;
+}
+
@@ -15,6 +15,7 @@
 #include <yarp/os/LogStream.h>
 #include <yarp/os/Network.h>
 #include <yarp/os/Time.h>
+#include <yarp/math/Rand.h>
 
 #include <iCub/iKin/iKinVocabs.h>
 #include <iCub/iKin/iKinSlv.h>
@@ -256,6 +257,36 @@ void InputPort::onRead(Bottle &b)
 }
 
 
+/************************************************************************/
+void InputPort::handleRequest(const CartesianSolverRequest &req)
+{
+    // same handling as in onRead()
+    if (req.tokenValid)
+    {
+        token=req.token;
+        pToken=&token;
+    }
+    else
+        pToken=NULL;
+
+    if (req.mode!=0)
+        if (!handleMode(req.mode))
+            yWarning("%s: got incomplete %s command",slv->slvName.c_str(),
+                     Vocab::decode(IKINSLV_VOCAB_OPT_MODE).c_str());
+
+    if (req.pose!=0)
+        if (!handlePose(req.pose))
+            yWarning("%s: got incomplete %s command",slv->slvName.c_str(),
+                     Vocab::decode(IKINSLV_VOCAB_OPT_POSE).c_str());
+
+    lock_guard<mutex> lck(mtx);
+    size_t len=std::min(req.xdLen,maxLen);
+    for (size_t i=0; i<len; i++)
+        xd[i]=req.xd[i];
+    isNew=true;
+}
+
+
 /************************************************************************/
 void SolverCallback::exec(const Vector &xd, const Vector &q)
 {
@@ -265,7 +296,9 @@ void SolverCallback::exec(const Vector &xd, const Vector &q)
 
 /************************************************************************/
 CartesianSolver::CartesianSolver(const string &_slvName) :
-                                PeriodicThread((double)CARTSLV_DEFAULT_PER/1000.0)
+                                PeriodicThread((double)CARTSLV_DEFAULT_PER/1000.0),
+                                localRequests(CARTSLV_LOCAL_QUEUE_LEN),
+                                localResults(CARTSLV_LOCAL_QUEUE_LEN)
 {          
     // initialization
     slvName=_slvName;
@@ -282,8 +315,11 @@ CartesianSolver::CartesianSolver(const string &_slvName) :
     prt=NULL;
     slv=NULL;
     clb=NULL;
+    seedCache=NULL;
+    batchThreads=1;
     inPort=NULL;
     outPort=NULL;
+    localMode=false;
 
     // open rpc port
     rpcPort=new Port;
@@ -960,32 +996,8 @@ void CartesianSolver::respond(const Bottle &command, Bottle &reply)
                 for (size_t i=0; i<xd.length(); i++)
                     xd[i]=b_xd->get(i).asDouble();
             
-                // accounts for the starting DOF
-                // if different from the actual one
-                if (b_q!=NULL)
-                {
-                    size_t len=std::min((size_t)b_q->size(),(size_t)prt->chn->getDOF());
-                    for (size_t i=0; i<len; i++)
-                        (*prt->chn)(i).setAng(CTRL_DEG2RAD*b_q->get(i).asDouble());
-                }
-                else
-                    getFeedback();  // otherwise get the current configuration
-            
-                // account for the pose 
-                if (command.check(Vocab::decode(IKINSLV_VOCAB_OPT_POSE)))
-                {
-                    int pose=command.find(Vocab::decode(IKINSLV_VOCAB_OPT_POSE)).asVocab();
-            
-                    if (pose==IKINSLV_VOCAB_VAL_POSE_FULL)
-                        slv->set_ctrlPose(IKINCTRL_POSE_FULL);
-                    else if (pose==IKINSLV_VOCAB_VAL_POSE_XYZ)
-                        slv->set_ctrlPose(IKINCTRL_POSE_XYZ);
-                }
-            
-                // set things for the 3rd task
-                for (unsigned int i=0; i<prt->chn->getDOF(); i++)
-                    if (idx_3rdTask[i]!=0.0)
-                        qd_3rdTask[i]=(*prt->chn)(i).getAng();
+                // account for the starting DOF and the pose
+                prepareAsk(command,b_q);
             
                 // call the solver to converge
                 double t0=Time::now();
@@ -1016,6 +1028,85 @@ void CartesianSolver::respond(const Bottle &command, Bottle &reply)
                 break;
             }
 
+            //-----------------
+            case IKINSLV_VOCAB_CMD_ASK_BATCH:
+            {
+                Bottle *b_xd=getTargetOption(command);
+                Bottle *b_q=getJointsOption(command);
+            
+                // some integrity checks
+                if (b_xd==NULL)
+                {
+                    reply.addVocab(IKINSLV_VOCAB_REP_NACK);
+                    break;
+                }
+
+                // get the targets
+                deque<Vector> xd;
+                for (size_t k=0; k<b_xd->size(); k++)
+                {
+                    Bottle *b_xd_k=b_xd->get(k).asList();
+                    if (b_xd_k==NULL)
+                        break;
+                    else if (b_xd_k->size()<3)  // at least the positional part must be given
+                        break;
+
+                    Vector xd_k(b_xd_k->size());
+                    for (size_t i=0; i<xd_k.length(); i++)
+                        xd_k[i]=b_xd_k->get(i).asDouble();
+
+                    xd.push_back(xd_k);
+                }
+
+                if ((xd.size()==0) || (xd.size()!=b_xd->size()))
+                {
+                    reply.addVocab(IKINSLV_VOCAB_REP_NACK);
+                    break;
+                }
+            
+                lock();
+            
+                // account for the starting DOF and the pose
+                prepareAsk(command,b_q);
+            
+                // call the solver to converge
+                double t0=Time::now();
+                deque<Vector> q;
+                solveBatch(xd,q);
+                double t1=Time::now();
+            
+                // dump on screen
+                if (verbosity)
+                {
+                    printf("   Request type       = ask batch\n");
+                    printf("    number of targets = %d\n",(int)xd.size());
+                    printf("    computed in   [s] = %g\n",t1-t0);
+                    printf("         iterations   = %d\n",slv->getLastIterations());
+                }
+
+                // fill the reply accordingly: each item
+                // complies with the reply to a single ask
+                reply.addVocab(IKINSLV_VOCAB_REP_ACK);
+                for (size_t k=0; k<q.size(); k++)
+                {
+                    Vector x=prt->chn->EndEffPose(q[k]);
+
+                    // prepare the complete joints configuration
+                    Vector _q(prt->chn->getN());
+                    for (unsigned int i=0; i<prt->chn->getN(); i++)
+                        _q[i]=CTRL_RAD2DEG*prt->chn->getAng(i);
+
+                    Bottle &item=reply.addList();
+                    item.addVocab(IKINSLV_VOCAB_REP_ACK);
+                    addVectorOption(item,IKINSLV_VOCAB_OPT_X,x);
+                    addVectorOption(item,IKINSLV_VOCAB_OPT_Q,_q);
+                }
+
+                unlock();
+            
+                break;
+            }
+
             //-----------------
             case IKINSLV_VOCAB_CMD_SUSP:
             {
@@ -1074,6 +1165,7 @@ void CartesianSolver::respond(const Bottle &command, Bottle &reply)
                 reply.addVocab(IKINSLV_VOCAB_CMD_GET);
                 reply.addVocab(IKINSLV_VOCAB_CMD_SET);
                 reply.addVocab(IKINSLV_VOCAB_CMD_ASK);
+                reply.addVocab(IKINSLV_VOCAB_CMD_ASK_BATCH);
                 reply.addVocab(IKINSLV_VOCAB_CMD_SUSP);
                 reply.addVocab(IKINSLV_VOCAB_CMD_RUN);
                 reply.addVocab(IKINSLV_VOCAB_CMD_STATUS);
@@ -1126,6 +1218,28 @@ void CartesianSolver::respond(const Bottle &command, Bottle &reply)
 void CartesianSolver::send(const Vector &xd, const Vector &x, const Vector &q,
                            double *tok)
 {       
+    if (localMode)
+    {
+        if (CartesianSolverResult *res=localResults.prepare())
+        {
+            res->xdLen=std::min(xd.length(),(size_t)7);
+            res->xLen=std::min(x.length(),(size_t)7);
+            res->qLen=std::min(q.length(),(size_t)CARTSLV_LOCAL_MAX_DOF);
+            std::copy(xd.data(),xd.data()+res->xdLen,res->xd);
+            std::copy(x.data(),x.data()+res->xLen,res->x);
+            std::copy(q.data(),q.data()+res->qLen,res->q);
+            res->tokenValid=(tok!=NULL);
+            res->token=res->tokenValid?*tok:0.0;
+            localResults.push();
+        }
+        else
+            yWarning("%s: local results queue is full, result dropped",slvName.c_str());
+
+        // stream out only for monitoring purposes
+        if (outPort->getOutputCount()==0)
+            return;
+    }
+
     Bottle &b=outPort->prepare();
     b.clear();
 
@@ -1153,6 +1267,7 @@ void CartesianSolver::printInfo(const string &typ, const Vector &xd,
     printf("  Target txPose   [m] = %s\n",x_.toString().c_str());
     printf("Target txJoints [deg] = %s\n",q.toString().c_str());
     printf("    computed in   [s] = %g\n",t);
+    printf("         iterations   = %d\n",slv->getLastIterations());
 }
 
 
@@ -1406,6 +1521,43 @@ bool CartesianSolver::open(Searchable &options)
     // enable scaling
     slv->setUserScaling(true,100.0,100.0,100.0);
 
+    // enable warm start if required
+    if (options.check("warmStart"))
+        if (options.find("warmStart").asVocab()==IKINSLV_VOCAB_VAL_ON)
+            slv->setWarmStart(true);
+
+    // number of threads serving the batch requests
+    batchThreads=std::max(options.check("batchThreads",Value(1)).asInt(),1);
+
+    // instantiate the seed cache if required
+    if (options.check("seedCache"))
+    {
+        seedCacheFile=options.find("seedCache").asString();
+        double res=options.check("seedCacheResolution",
+                                 Value(IKINSEEDCACHE_DEFAULT_RESOLUTION)).asDouble();
+        seedCache=new iKinSeedCache(prt->lmb->getType(),prt->chn->getN(),res);
+
+        if (seedCache->load(seedCacheFile))
+            yInfo("%s: loaded %d seeds from %s",slvName.c_str(),
+                  (int)seedCache->size(),seedCacheFile.c_str());
+
+        slv->attachSeedCache(seedCache);
+    }
+
+    // enable multi-start if required
+    if (options.check("multiStart"))
+    {
+        int nSeeds=options.find("multiStart").asInt();
+        if (nSeeds>1)
+        {
+            // serial by default, since MUMPS is not thread-safe
+            int nThreads=std::max(options.check("multiStartThreads",Value(1)).asInt(),1);
+
+            Rand::init();
+            slv->setMultiStart(nSeeds,nThreads);
+        }
+    }
+
     // enforce linear inequalities constraints, if any
     if (prt->cns!=NULL)
     {
@@ -1511,16 +1663,108 @@ void CartesianSolver::prepareJointsRestTask()
 }
 
 
+/************************************************************************/
+void CartesianSolver::fillSeeds(const Vector &xd, deque<Vector> &seeds)
+{
+    unsigned int nSeeds=slv->getMultiStart();
+
+    // the current configuration and the rest posture come first,
+    // then the cached configurations closest to the target and
+    // finally random configurations within the joints bounds
+    seeds.clear();
+    seeds.push_back(prt->chn->getAng());
+    seeds.push_back(qd_3rdTask);
+
+    if ((seedCache!=NULL) && (nSeeds>seeds.size()))
+    {
+        deque<Vector> cached;
+        seedCache->query(xd,nSeeds-seeds.size(),cached);
+
+        for (size_t k=0; k<cached.size(); k++)
+        {
+            Vector q(prt->chn->getDOF());
+            for (unsigned int i=0, j=0; i<prt->chn->getN(); i++)
+                if (!(*prt->chn)[i].isBlocked())
+                    q[j++]=cached[k][i];
+
+            seeds.push_back(q);
+        }
+    }
+
+    while (seeds.size()<nSeeds)
+    {
+        Vector q(prt->chn->getDOF());
+        for (unsigned int i=0; i<prt->chn->getDOF(); i++)
+            q[i]=Rand::scalar((*prt->chn)(i).getMin(),(*prt->chn)(i).getMax());
+
+        seeds.push_back(q);
+    }
+}
+
+
 /************************************************************************/
 Vector CartesianSolver::solve(Vector &xd)
 {
+    double weight2ndTask=slv->get2ndTaskChain().getN()>0?CARTSLV_WEIGHT_2ND_TASK:0.0;
+
+    if (slv->getMultiStart()>0)
+    {
+        deque<Vector> q0;
+        fillSeeds(xd,q0);
+
+        return slv->solveMultiStart(q0,xd,weight2ndTask,xd_2ndTask,w_2ndTask,
+                                    CARTSLV_WEIGHT_3RD_TASK,qd_3rdTask,w_3rdTask);
+    }
+
     return slv->solve(prt->chn->getAng(),xd,
-                      slv->get2ndTaskChain().getN()>0?CARTSLV_WEIGHT_2ND_TASK:0.0,xd_2ndTask,w_2ndTask,
+                      weight2ndTask,xd_2ndTask,w_2ndTask,
                       CARTSLV_WEIGHT_3RD_TASK,qd_3rdTask,w_3rdTask,
                       NULL,NULL,clb);
 }
 
 
+/************************************************************************/
+void CartesianSolver::solveBatch(const deque<Vector> &xd, deque<Vector> &q)
+{
+    slv->solveBatch(prt->chn->getAng(),xd,
+                    slv->get2ndTaskChain().getN()>0?CARTSLV_WEIGHT_2ND_TASK:0.0,xd_2ndTask,w_2ndTask,
+                    CARTSLV_WEIGHT_3RD_TASK,qd_3rdTask,w_3rdTask,
+                    q,NULL,batchThreads);
+}
+
+
+/************************************************************************/
+void CartesianSolver::prepareAsk(const Bottle &command, const Bottle *b_q)
+{
+    // accounts for the starting DOF
+    // if different from the actual one
+    if (b_q!=NULL)
+    {
+        size_t len=std::min((size_t)b_q->size(),(size_t)prt->chn->getDOF());
+        for (size_t i=0; i<len; i++)
+            (*prt->chn)(i).setAng(CTRL_DEG2RAD*b_q->get(i).asDouble());
+    }
+    else
+        getFeedback();  // otherwise get the current configuration
+
+    // account for the pose 
+    if (command.check(Vocab::decode(IKINSLV_VOCAB_OPT_POSE)))
+    {
+        int pose=command.find(Vocab::decode(IKINSLV_VOCAB_OPT_POSE)).asVocab();
+
+        if (pose==IKINSLV_VOCAB_VAL_POSE_FULL)
+            slv->set_ctrlPose(IKINCTRL_POSE_FULL);
+        else if (pose==IKINSLV_VOCAB_VAL_POSE_XYZ)
+            slv->set_ctrlPose(IKINCTRL_POSE_XYZ);
+    }
+
+    // set things for the 3rd task
+    for (unsigned int i=0; i<prt->chn->getDOF(); i++)
+        if (idx_3rdTask[i]!=0.0)
+            qd_3rdTask[i]=(*prt->chn)(i).getAng();
+}
+
+
 /************************************************************************/
 void CartesianSolver::interrupt()
 {
@@ -1555,10 +1799,19 @@ void CartesianSolver::close()
         outPort=NULL;
     }
 
+    if (seedCache!=NULL)
+    {
+        if (!seedCacheFile.empty() && !seedCache->save(seedCacheFile))
+            yWarning("%s: unable to save the seed cache to %s",
+                     slvName.c_str(),seedCacheFile.c_str());
+    }
+
     delete slv;
     delete clb;
+    delete seedCache;
     slv=NULL;
     clb=NULL;
+    seedCache=NULL;
 
     for (size_t i=0; i<drv.size(); i++)
     {
@@ -1643,6 +1896,14 @@ void CartesianSolver::resume()
 /************************************************************************/
 void CartesianSolver::run()
 {
+    // handle the requests received in local mode
+    // outside the lock, as done by the input port
+    while (CartesianSolverRequest *req=localRequests.front())
+    {
+        inPort->handleRequest(*req);
+        localRequests.pop();
+    }
+
     lock();
 
     // init conditions
@@ -1745,6 +2006,18 @@ void CartesianSolver::threadRelease()
 }
 
 
+/************************************************************************/
+bool CartesianSolver::processRpc(const Bottle &command, Bottle &reply)
+{
+    reply.clear();
+    if (isClosed())
+        return false;
+
+    respond(command,reply);
+    return true;
+}
+
+
 /************************************************************************/
 CartesianSolver::~CartesianSolver()
 {
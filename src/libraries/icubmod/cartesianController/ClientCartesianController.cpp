@@ -675,6 +675,73 @@ bool ClientCartesianController::askForPosition(const Vector &q0, const Vector &x
 }
 
 
+/************************************************************************/
+bool ClientCartesianController::askForBatch(const Vector *q0, const deque<Vector> &xd,
+                                            const deque<Vector> *od, deque<Vector> &xdhat,
+                                            deque<Vector> &odhat, deque<Vector> &qdhat)
+{
+    if (!connected || xd.empty())
+        return false;
+
+    if ((od!=NULL) && (od->size()!=xd.size()))
+        return false;
+
+    Bottle command, reply;
+    deque<Vector> tg;
+    for (size_t k=0; k<xd.size(); k++)
+        tg.push_back((od!=NULL)?cat(xd[k],(*od)[k]):xd[k]);
+
+    command.addVocab(IKINCARTCTRL_VOCAB_CMD_ASK_BATCH);
+    addTargetsOption(command,tg);
+    if (q0!=NULL)
+        addVectorOption(command,IKINCARTCTRL_VOCAB_OPT_Q,*q0);
+    addPoseOption(command,(od!=NULL)?IKINCTRL_POSE_FULL:IKINCTRL_POSE_XYZ);
+
+    if (!portRpc.write(command,reply))
+    {
+        yError("unable to get reply from server!");
+        return false;
+    }
+
+    return getDesiredOptions(reply,xdhat,odhat,qdhat);
+}
+
+
+/************************************************************************/
+bool ClientCartesianController::askForPoses(const deque<Vector> &xd, const deque<Vector> &od,
+                                            deque<Vector> &xdhat, deque<Vector> &odhat,
+                                            deque<Vector> &qdhat)
+{
+    return askForBatch(NULL,xd,&od,xdhat,odhat,qdhat);
+}
+
+
+/************************************************************************/
+bool ClientCartesianController::askForPoses(const Vector &q0, const deque<Vector> &xd,
+                                            const deque<Vector> &od, deque<Vector> &xdhat,
+                                            deque<Vector> &odhat, deque<Vector> &qdhat)
+{
+    return askForBatch(&q0,xd,&od,xdhat,odhat,qdhat);
+}
+
+
+/************************************************************************/
+bool ClientCartesianController::askForPositions(const deque<Vector> &xd, deque<Vector> &xdhat,
+                                                deque<Vector> &odhat, deque<Vector> &qdhat)
+{
+    return askForBatch(NULL,xd,NULL,xdhat,odhat,qdhat);
+}
+
+
+/************************************************************************/
+bool ClientCartesianController::askForPositions(const Vector &q0, const deque<Vector> &xd,
+                                                deque<Vector> &xdhat, deque<Vector> &odhat,
+                                                deque<Vector> &qdhat)
+{
+    return askForBatch(&q0,xd,NULL,xdhat,odhat,qdhat);
+}
+
+
 /************************************************************************/
 bool ClientCartesianController::getDOF(Vector &curDof)
 {
@@ -21,6 +21,7 @@
 
 #include <string>
 #include <set>
+#include <deque>
 #include <map>
 
 #include <yarp/os/all.h>
@@ -62,6 +63,7 @@ public:
 */
 class ClientCartesianController : public    yarp::dev::DeviceDriver,
                                   public    yarp::dev::ICartesianControl,
+                                  public    iCub::iKin::ICartesianControlBatch,
                                   protected iCub::iKin::CartesianHelper
 {
 protected:
@@ -87,6 +89,9 @@ protected:
     bool deleteContexts();
     void eventHandling(yarp::os::Bottle &event);
     bool getInfoHelper(yarp::os::Bottle &info);
+    bool askForBatch(const yarp::sig::Vector *q0, const std::deque<yarp::sig::Vector> &xd,
+                     const std::deque<yarp::sig::Vector> *od, std::deque<yarp::sig::Vector> &xdhat,
+                     std::deque<yarp::sig::Vector> &odhat, std::deque<yarp::sig::Vector> &qdhat);
 
 public:
     ClientCartesianController();
@@ -116,6 +121,17 @@ public:
                         yarp::sig::Vector &qdhat);
     bool askForPosition(const yarp::sig::Vector &q0, const yarp::sig::Vector &xd, yarp::sig::Vector &xdhat,
                         yarp::sig::Vector &odhat, yarp::sig::Vector &qdhat);
+    bool askForPoses(const std::deque<yarp::sig::Vector> &xd, const std::deque<yarp::sig::Vector> &od,
+                     std::deque<yarp::sig::Vector> &xdhat, std::deque<yarp::sig::Vector> &odhat,
+                     std::deque<yarp::sig::Vector> &qdhat);
+    bool askForPoses(const yarp::sig::Vector &q0, const std::deque<yarp::sig::Vector> &xd,
+                     const std::deque<yarp::sig::Vector> &od, std::deque<yarp::sig::Vector> &xdhat,
+                     std::deque<yarp::sig::Vector> &odhat, std::deque<yarp::sig::Vector> &qdhat);
+    bool askForPositions(const std::deque<yarp::sig::Vector> &xd, std::deque<yarp::sig::Vector> &xdhat,
+                         std::deque<yarp::sig::Vector> &odhat, std::deque<yarp::sig::Vector> &qdhat);
+    bool askForPositions(const yarp::sig::Vector &q0, const std::deque<yarp::sig::Vector> &xd,
+                         std::deque<yarp::sig::Vector> &xdhat, std::deque<yarp::sig::Vector> &odhat,
+                         std::deque<yarp::sig::Vector> &qdhat);
     bool getDOF(yarp::sig::Vector &curDof);
     bool setDOF(const yarp::sig::Vector &newDof, yarp::sig::Vector &curDof);
     bool getRestPos(yarp::sig::Vector &curRestPos);
@@ -24,6 +24,7 @@
 #define IKINCARTCTRL_VOCAB_CMD_GET              yarp::os::createVocab('g','e','t')
 #define IKINCARTCTRL_VOCAB_CMD_SET              yarp::os::createVocab('s','e','t')
 #define IKINCARTCTRL_VOCAB_CMD_ASK              yarp::os::createVocab('a','s','k')
+#define IKINCARTCTRL_VOCAB_CMD_ASK_BATCH        yarp::os::createVocab('a','s','k','b')
 #define IKINCARTCTRL_VOCAB_CMD_STORE            yarp::os::createVocab('s','t','o','r')
 #define IKINCARTCTRL_VOCAB_CMD_RESTORE          yarp::os::createVocab('r','e','s','t')
 #define IKINCARTCTRL_VOCAB_CMD_DELETE           yarp::os::createVocab('d','e','l')
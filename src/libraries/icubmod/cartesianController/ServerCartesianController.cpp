@@ -30,6 +30,10 @@
 
 #include <iCub/iKin/iKinVocabs.h>
 
+#ifdef CARTCTRL_LOCAL_SOLVER
+#include <iCub/iKin/iKinSlv.h>
+#endif
+
 #define CARTCTRL_SERVER_VER                 1.1
 #define CARTCTRL_DEFAULT_PER                0.01    // [s]
 #define CARTCTRL_DEFAULT_TASKVEL_PERFACTOR  4
@@ -195,6 +199,7 @@ void ServerCartesianController::init()
 
     portCmd     =NULL;
     rpcProcessor=NULL;
+    localSlv    =NULL;
 
     attached     =false;
     connected    =false;
@@ -234,9 +239,14 @@ void ServerCartesianController::openPorts()
     string prefixName="/";
     prefixName=prefixName+ctrlName;
 
-    portSlvIn.open(prefixName+"/"+slvName+"/in");
-    portSlvOut.open(prefixName+"/"+slvName+"/out");
-    portSlvRpc.open(prefixName+"/"+slvName+"/rpc");
+    // the solver hosted in-process is reached directly
+    if (localSlv==NULL)
+    {
+        portSlvIn.open(prefixName+"/"+slvName+"/in");
+        portSlvOut.open(prefixName+"/"+slvName+"/out");
+        portSlvRpc.open(prefixName+"/"+slvName+"/rpc");
+    }
+
     portCmd->open(prefixName+"/command:i");
     portState.open(prefixName+"/state:o");
     portEvent.open(prefixName+"/events:o");
@@ -347,11 +357,12 @@ bool ServerCartesianController::respond(const Bottle &command, Bottle &reply)
 
             //-----------------
             case IKINCARTCTRL_VOCAB_CMD_ASK:
+            case IKINCARTCTRL_VOCAB_CMD_ASK_BATCH:
             {
                 // just behave as a relay
                 Bottle slvCommand=command;
 
-                if (!portSlvRpc.write(slvCommand,reply))
+                if (!writeSolverRpc(slvCommand,reply))
                 {
                     yError("%s: unable to get reply from solver!",ctrlName.c_str());
                     reply.addVocab(IKINCARTCTRL_VOCAB_REP_NACK);
@@ -1191,38 +1202,24 @@ void ServerCartesianController::createController()
 /************************************************************************/
 bool ServerCartesianController::getNewTarget()
 {
-    if (Bottle *b1=portSlvIn.read(false))
-    {
-        bool tokened=getTokenOption(*b1,&rxToken);
-
-        // token shall be not greater than the trasmitted one
-        if (tokened && (rxToken>txToken))
-        {
-            yWarning("%s: skipped message from solver due to invalid token (rx=%g)>(thr=%g)",
-                     ctrlName.c_str(),rxToken,txToken);
+    bool tokened=false;
+    bool xOptIn=false;
+    bool qOptIn=false;
+    Vector _xdes, _qdes;
 
+    if (localSlv!=NULL)
+    {
+        if (!getLocalSolverResult(tokened,_xdes,_qdes))
             return false;
-        }
 
-        // if we stopped the controller then we skip
-        // any message with token smaller than the threshold
-        if (skipSlvRes)
-        {
-            if (tokened && !trackingMode && (rxToken<=txTokenLatchedStopControl))
-            {
-                yWarning("%s: skipped message from solver since controller has been stopped (rx=%g)<=(thr=%g)",
-                         ctrlName.c_str(),rxToken,txTokenLatchedStopControl);
-
-                return false;
-            }
-            else
-                skipSlvRes=false;
-        }
-
-        bool isNew=false;
-        Vector _xdes, _qdes;
+        xOptIn=(_xdes.length()>0);
+        qOptIn=(_qdes.length()>0);
+    }
+    else if (Bottle *b1=portSlvIn.read(false))
+    {
+        tokened=getTokenOption(*b1,&rxToken);
 
-        if (b1->check(Vocab::decode(IKINSLV_VOCAB_OPT_X)))
+        if ((xOptIn=b1->check(Vocab::decode(IKINSLV_VOCAB_OPT_X))))
         {
             Bottle *b2=getEndEffectorPoseOption(*b1);
             int l1=(int)b2->size();
@@ -1232,12 +1229,9 @@ bool ServerCartesianController::getNewTarget()
 
             for (int i=0; i<len; i++)
                 _xdes[i]=b2->get(i).asDouble();
-
-            if (!(_xdes==xdes))
-                isNew=true;
         }
 
-        if (b1->check(Vocab::decode(IKINSLV_VOCAB_OPT_Q)))
+        if ((qOptIn=b1->check(Vocab::decode(IKINSLV_VOCAB_OPT_Q))))
         {
             Bottle *b2=getJointsOption(*b1);
             int l1=(int)b2->size();
@@ -1247,36 +1241,71 @@ bool ServerCartesianController::getNewTarget()
 
             for (int i=0; i<len; i++)
                 _qdes[i]=CTRL_DEG2RAD*b2->get(i).asDouble();
+        }
+    }
+    else
+        return false;
 
-            if (_qdes.length()!=ctrl->get_dim())
-            {    
-                yWarning("%s: skipped message from solver since does not match the controller dimension (qdes=%d)!=(ctrl=%d)",
-                         ctrlName.c_str(),(int)_qdes.length(),ctrl->get_dim());
+    // token shall be not greater than the trasmitted one
+    if (tokened && (rxToken>txToken))
+    {
+        yWarning("%s: skipped message from solver due to invalid token (rx=%g)>(thr=%g)",
+                 ctrlName.c_str(),rxToken,txToken);
 
-                return false;
-            }
-            else if (!(_qdes==qdes))
-                isNew=true;
-        }
+        return false;
+    }
 
-        // update target
-        if (isNew)
+    // if we stopped the controller then we skip
+    // any message with token smaller than the threshold
+    if (skipSlvRes)
+    {
+        if (tokened && !trackingMode && (rxToken<=txTokenLatchedStopControl))
         {
-            xdes=_xdes;
-            qdes=_qdes;
+            yWarning("%s: skipped message from solver since controller has been stopped (rx=%g)<=(thr=%g)",
+                     ctrlName.c_str(),rxToken,txTokenLatchedStopControl);
+
+            return false;
         }
+        else
+            skipSlvRes=false;
+    }
 
-        // wake up rpc
-        if (tokened && syncEventEnabled && (rxToken>=txTokenLatchedGoToRpc))
-        {
-            syncEventEnabled=false;
-            cv_syncEvent.notify_all();
+    bool isNew=false;
+
+    if (xOptIn)
+    {
+        if (!(_xdes==xdes))
+            isNew=true;
+    }
+
+    if (qOptIn)
+    {
+        if (_qdes.length()!=ctrl->get_dim())
+        {    
+            yWarning("%s: skipped message from solver since does not match the controller dimension (qdes=%d)!=(ctrl=%d)",
+                     ctrlName.c_str(),(int)_qdes.length(),ctrl->get_dim());
+
+            return false;
         }
+        else if (!(_qdes==qdes))
+            isNew=true;
+    }
 
-        return isNew;
+    // update target
+    if (isNew)
+    {
+        xdes=_xdes;
+        qdes=_qdes;
     }
-    else
-        return false;
+
+    // wake up rpc
+    if (tokened && syncEventEnabled && (rxToken>=txTokenLatchedGoToRpc))
+    {
+        syncEventEnabled=false;
+        cv_syncEvent.notify_all();
+    }
+
+    return isNew;
 }
 
 
@@ -1960,6 +1989,18 @@ bool ServerCartesianController::open(Searchable &config)
     else
         plantModelProperties.clear();
 
+    // acquire options for the solver to be hosted in-process
+    Bottle &optLocalSolver=config.findGroup("LOCAL_SOLVER");
+    if (!optLocalSolver.isNull())
+    {
+        yInfo("LOCAL_SOLVER group detected");
+        if (!createLocalSolver(optLocalSolver))
+        {
+            close();
+            return false;
+        }
+    }
+
     // instantiate kinematic object
     if (kinPart=="arm")
         limbState=new iCubArm(kinType);
@@ -2013,6 +2054,7 @@ bool ServerCartesianController::close()
         return true;
 
     detachAll();
+    closeLocalSolver();
 
     delete limbState;
     delete limbPlan;
@@ -2185,6 +2227,12 @@ bool ServerCartesianController::attachAll(const PolyDriverList &p)
     // init task-space reference velocity
     xdot_set.resize(7,0.0);
 
+    if (!openLocalSolver())
+    {
+        yError("unable to open the local solver");
+        return false;
+    }
+
     // this line shall be put before any
     // call to attached-dependent methods
     attached=true;
@@ -2247,6 +2295,9 @@ bool ServerCartesianController::detachAll()
 /************************************************************************/
 bool ServerCartesianController::pingSolver()
 {    
+    if (localSlv!=NULL)
+        return pingLocalSolver();
+
     string portSlvName="/";
     portSlvName=portSlvName+slvName+"/in";    
 
@@ -2270,9 +2321,12 @@ bool ServerCartesianController::connectToSolver()
 
         bool ok=true;
 
-        ok&=Network::connect(portSlvName+"/out",portSlvIn.getName(),"udp");
-        ok&=Network::connect(portSlvOut.getName(),portSlvName+"/in","udp");
-        ok&=Network::connect(portSlvRpc.getName(),portSlvName+"/rpc");
+        if (localSlv==NULL)
+        {
+            ok&=Network::connect(portSlvName+"/out",portSlvIn.getName(),"udp");
+            ok&=Network::connect(portSlvOut.getName(),portSlvName+"/in","udp");
+            ok&=Network::connect(portSlvRpc.getName(),portSlvName+"/rpc");
+        }
 
         if (ok)
             yInfo("%s: Connections established with %s",ctrlName.c_str(),slvName.c_str());
@@ -2292,7 +2346,7 @@ bool ServerCartesianController::connectToSolver()
         command.addVocab(IKINSLV_VOCAB_OPT_DOF);
 
         // send command to solver and wait for reply
-        if (!portSlvRpc.write(command,reply))
+        if (!writeSolverRpc(command,reply))
         {
             yError("%s: unable to get reply from solver!",ctrlName.c_str());         
             return false;
@@ -2323,6 +2377,175 @@ bool ServerCartesianController::connectToSolver()
 }
 
 
+#ifdef CARTCTRL_LOCAL_SOLVER
+/************************************************************************/
+bool ServerCartesianController::createLocalSolver(const Bottle &options)
+{
+    if (kinPart=="arm")
+        localSlv=new iCubArmCartesianSolver(slvName);
+    else if (kinPart=="leg")
+        localSlv=new iCubLegCartesianSolver(slvName);
+    else
+    {
+        yError("%s: the local solver is not available for the %s kinematic part",
+               ctrlName.c_str(),kinPart.c_str());
+        return false;
+    }
+
+    localSlvOptions.fromString(options.toString());
+    if (!localSlvOptions.check("type"))
+        localSlvOptions.put("type",kinType);
+
+    yInfo("%s: cartesian solver %s will run in-process",ctrlName.c_str(),slvName.c_str());
+    return true;
+}
+
+
+/************************************************************************/
+bool ServerCartesianController::openLocalSolver()
+{
+    if ((localSlv==NULL) || localSlv->isRunning())
+        return true;
+
+    localSlv->setLocalMode(true);
+    return localSlv->open(localSlvOptions);
+}
+
+
+/************************************************************************/
+void ServerCartesianController::closeLocalSolver()
+{
+    delete localSlv;
+    localSlv=NULL;
+}
+
+
+/************************************************************************/
+bool ServerCartesianController::pingLocalSolver()
+{
+    bool ok=localSlv->isRunning();
+    yInfo("%s: Checking if cartesian solver %s is alive... %s",
+          ctrlName.c_str(),slvName.c_str(),ok?"ready":"not yet");
+
+    return ok;
+}
+
+
+/************************************************************************/
+bool ServerCartesianController::sendLocalSolverRequest(const Vector &xd)
+{
+    CartesianSolverRequest *req=localSlv->getLocalRequests().prepare();
+    if (req==NULL)
+    {
+        yWarning("%s: local solver busy, request dropped",ctrlName.c_str());
+        return false;
+    }
+
+    req->xdLen=std::min(xd.length(),(size_t)7);
+    for (size_t i=0; i<req->xdLen; i++)
+        req->xd[i]=xd[i];
+
+    req->pose=(ctrlPose==IKINCTRL_POSE_FULL)?IKINSLV_VOCAB_VAL_POSE_FULL:
+                                             IKINSLV_VOCAB_VAL_POSE_XYZ;
+    // see goTo() for the continuous mode
+    req->mode=IKINSLV_VOCAB_VAL_MODE_TRACK;
+    req->token=txToken;
+    req->tokenValid=true;
+
+    localSlv->getLocalRequests().push();
+    return true;
+}
+
+
+/************************************************************************/
+bool ServerCartesianController::getLocalSolverResult(bool &tokened, Vector &_xdes,
+                                                     Vector &_qdes)
+{
+    // keep only the most recent result
+    iKinSpscQueue<CartesianSolverResult> &results=localSlv->getLocalResults();
+    while (results.size()>1)
+        results.pop();
+
+    CartesianSolverResult *res=results.front();
+    if (res==NULL)
+        return false;
+
+    if ((tokened=res->tokenValid))
+        rxToken=res->token;
+
+    _xdes.resize(res->xLen);
+    for (size_t i=0; i<res->xLen; i++)
+        _xdes[i]=res->x[i];
+
+    _qdes.resize(std::min(res->qLen,(size_t)chainState->getDOF()));
+    for (size_t i=0; i<_qdes.length(); i++)
+        _qdes[i]=CTRL_DEG2RAD*res->q[i];
+
+    results.pop();
+    return true;
+}
+
+
+/************************************************************************/
+bool ServerCartesianController::writeSolverRpc(Bottle &command, Bottle &reply)
+{
+    if (localSlv!=NULL)
+        return localSlv->processRpc(command,reply);
+    else
+        return portSlvRpc.write(command,reply);
+}
+#else
+/************************************************************************/
+bool ServerCartesianController::createLocalSolver(const Bottle &options)
+{
+    yError("%s: the local solver requires iKin to be compiled with IPOPT",ctrlName.c_str());
+    return false;
+}
+
+
+/************************************************************************/
+bool ServerCartesianController::openLocalSolver()
+{
+    return true;
+}
+
+
+/************************************************************************/
+void ServerCartesianController::closeLocalSolver()
+{
+}
+
+
+/************************************************************************/
+bool ServerCartesianController::pingLocalSolver()
+{
+    return false;
+}
+
+
+/************************************************************************/
+bool ServerCartesianController::sendLocalSolverRequest(const Vector &xd)
+{
+    return false;
+}
+
+
+/************************************************************************/
+bool ServerCartesianController::getLocalSolverResult(bool &tokened, Vector &_xdes,
+                                                     Vector &_qdes)
+{
+    return false;
+}
+
+
+/************************************************************************/
+bool ServerCartesianController::writeSolverRpc(Bottle &command, Bottle &reply)
+{
+    return portSlvRpc.write(command,reply);
+}
+#endif
+
+
 /************************************************************************/
 bool ServerCartesianController::goTo(unsigned int _ctrlPose, const Vector &xd,
                                      const double t, const bool latchToken)
@@ -2337,6 +2560,15 @@ bool ServerCartesianController::goTo(unsigned int _ctrlPose, const Vector &xd,
         if (t>0.0)
             setTrajTimeHelper(t);
 
+        txToken=Time::now();
+        skipSlvRes=false;
+        if (latchToken)
+            txTokenLatchedGoToRpc=txToken;
+
+        // the solver hosted in-process is fed directly
+        if (localSlv!=NULL)
+            return sendLocalSolverRequest(xd);
+
         Bottle &b=portSlvOut.prepare();
         b.clear();
     
@@ -2352,11 +2584,7 @@ bool ServerCartesianController::goTo(unsigned int _ctrlPose, const Vector &xd,
         // accordingly at the end of trajectory
         addModeOption(b,true);
         // token part
-        addTokenOption(b,txToken=Time::now());
-
-        skipSlvRes=false;
-        if (latchToken)
-            txTokenLatchedGoToRpc=txToken;
+        addTokenOption(b,txToken);
 
         portSlvOut.writeStrict();
         return true;
@@ -2378,7 +2606,7 @@ bool ServerCartesianController::setTrackingModeHelper(const bool f)
 
         // send command to solver and wait for reply
         bool ret=false;
-        if (!portSlvRpc.write(command,reply))
+        if (!writeSolverRpc(command,reply))
             yError("%s: unable to get reply from solver!",ctrlName.c_str());         
         else if (reply.get(0).asVocab()==IKINSLV_VOCAB_REP_ACK)
         {
@@ -2454,7 +2682,7 @@ bool ServerCartesianController::setPosePriority(const string &p)
         command.addVocab(p=="position"?IKINSLV_VOCAB_VAL_PRIO_XYZ:IKINSLV_VOCAB_VAL_PRIO_ANG);
 
         // send command to solver and wait for reply
-        if (portSlvRpc.write(command,reply))
+        if (writeSolverRpc(command,reply))
             ret=(reply.get(0).asVocab()==IKINSLV_VOCAB_REP_ACK);
         else
             yError("%s: unable to get reply from solver!",ctrlName.c_str());
@@ -2475,7 +2703,7 @@ bool ServerCartesianController::getPosePriority(string &p)
         command.addVocab(IKINSLV_VOCAB_OPT_PRIO);
 
         // send command to solver and wait for reply
-        if (portSlvRpc.write(command,reply))
+        if (writeSolverRpc(command,reply))
         {
             if (ret=(reply.get(0).asVocab()==IKINSLV_VOCAB_REP_ACK))
                 p=(reply.get(1).asVocab()==IKINSLV_VOCAB_VAL_PRIO_XYZ)?
@@ -2661,7 +2889,7 @@ bool ServerCartesianController::askForPose(const Vector &xd, const Vector &od,
 
     // send command and wait for reply
     bool ret=false;
-    if (portSlvRpc.write(command,reply))
+    if (writeSolverRpc(command,reply))
         ret=getDesiredOption(reply,xdhat,odhat,qdhat);
     else
         yError("%s: unable to get reply from solver!",ctrlName.c_str());         
@@ -2695,7 +2923,7 @@ bool ServerCartesianController::askForPose(const Vector &q0, const Vector &xd,
 
     // send command and wait for reply
     bool ret=false;
-    if (portSlvRpc.write(command,reply))
+    if (writeSolverRpc(command,reply))
         ret=getDesiredOption(reply,xdhat,odhat,qdhat);
     else
         yError("%s: unable to get reply from solver!",ctrlName.c_str());         
@@ -2720,7 +2948,7 @@ bool ServerCartesianController::askForPosition(const Vector &xd, Vector &xdhat,
 
     // send command and wait for reply
     bool ret=false;
-    if (portSlvRpc.write(command,reply))
+    if (writeSolverRpc(command,reply))
         ret=getDesiredOption(reply,xdhat,odhat,qdhat);
     else
         yError("%s: unable to get reply from solver!",ctrlName.c_str());         
@@ -2747,7 +2975,7 @@ bool ServerCartesianController::askForPosition(const Vector &q0, const Vector &x
 
     // send command and wait for reply
     bool ret=false;
-    if (portSlvRpc.write(command,reply))
+    if (writeSolverRpc(command,reply))
         ret=getDesiredOption(reply,xdhat,odhat,qdhat);
     else
         yError("%s: unable to get reply from solver!",ctrlName.c_str());         
@@ -2756,6 +2984,76 @@ bool ServerCartesianController::askForPosition(const Vector &q0, const Vector &x
 }
 
 
+/************************************************************************/
+bool ServerCartesianController::askForBatch(const Vector *q0, const deque<Vector> &xd,
+                                            const deque<Vector> *od, deque<Vector> &xdhat,
+                                            deque<Vector> &odhat, deque<Vector> &qdhat)
+{
+    if (!connected || xd.empty())
+        return false;
+
+    if ((od!=NULL) && (od->size()!=xd.size()))
+        return false;
+
+    lock_guard<mutex> lck(mtx);
+
+    Bottle command, reply;
+    deque<Vector> tg;
+    for (size_t k=0; k<xd.size(); k++)
+        tg.push_back((od!=NULL)?cat(xd[k],(*od)[k]):xd[k]);
+
+    command.addVocab(IKINSLV_VOCAB_CMD_ASK_BATCH);
+    addTargetsOption(command,tg);
+    if (q0!=NULL)
+        addVectorOption(command,IKINSLV_VOCAB_OPT_Q,*q0);
+    addPoseOption(command,(od!=NULL)?IKINCTRL_POSE_FULL:IKINCTRL_POSE_XYZ);
+
+    // send command and wait for reply
+    bool ret=false;
+    if (writeSolverRpc(command,reply))
+        ret=getDesiredOptions(reply,xdhat,odhat,qdhat);
+    else
+        yError("%s: unable to get reply from solver!",ctrlName.c_str());
+
+    return ret;
+}
+
+
+/************************************************************************/
+bool ServerCartesianController::askForPoses(const deque<Vector> &xd, const deque<Vector> &od,
+                                            deque<Vector> &xdhat, deque<Vector> &odhat,
+                                            deque<Vector> &qdhat)
+{
+    return askForBatch(NULL,xd,&od,xdhat,odhat,qdhat);
+}
+
+
+/************************************************************************/
+bool ServerCartesianController::askForPoses(const Vector &q0, const deque<Vector> &xd,
+                                            const deque<Vector> &od, deque<Vector> &xdhat,
+                                            deque<Vector> &odhat, deque<Vector> &qdhat)
+{
+    return askForBatch(&q0,xd,&od,xdhat,odhat,qdhat);
+}
+
+
+/************************************************************************/
+bool ServerCartesianController::askForPositions(const deque<Vector> &xd, deque<Vector> &xdhat,
+                                                deque<Vector> &odhat, deque<Vector> &qdhat)
+{
+    return askForBatch(NULL,xd,NULL,xdhat,odhat,qdhat);
+}
+
+
+/************************************************************************/
+bool ServerCartesianController::askForPositions(const Vector &q0, const deque<Vector> &xd,
+                                                deque<Vector> &xdhat, deque<Vector> &odhat,
+                                                deque<Vector> &qdhat)
+{
+    return askForBatch(&q0,xd,NULL,xdhat,odhat,qdhat);
+}
+
+
 /************************************************************************/
 bool ServerCartesianController::getDOF(Vector &curDof)
 {
@@ -2790,7 +3088,7 @@ bool ServerCartesianController::setDOF(const Vector &newDof, Vector &curDof)
     
         // send command to solver and wait for reply
         bool ret=false;
-        if (portSlvRpc.write(command,reply))
+        if (writeSolverRpc(command,reply))
         {
             // update chain's links
             // skip the first ack/nack vocab
@@ -2838,7 +3136,7 @@ bool ServerCartesianController::getRestPos(Vector &curRestPos)
     
         // send command to solver and wait for reply
         bool ret=false;
-        if (portSlvRpc.write(command,reply))
+        if (writeSolverRpc(command,reply))
         {
             Bottle *rxRestPart=reply.get(1).asList();
             curRestPos.resize(rxRestPart->size());
@@ -2872,7 +3170,7 @@ bool ServerCartesianController::setRestPos(const Vector &newRestPos,
     
         // send command to solver and wait for reply
         bool ret=false;
-        if (portSlvRpc.write(command,reply))
+        if (writeSolverRpc(command,reply))
         {
             Bottle *rxRestPart=reply.get(1).asList();
             curRestPos.resize(rxRestPart->size());
@@ -2904,7 +3202,7 @@ bool ServerCartesianController::getRestWeights(Vector &curRestWeights)
     
         // send command to solver and wait for reply
         bool ret=false;
-        if (portSlvRpc.write(command,reply))
+        if (writeSolverRpc(command,reply))
         {
             Bottle *rxRestPart=reply.get(1).asList();
             curRestWeights.resize(rxRestPart->size());
@@ -2938,7 +3236,7 @@ bool ServerCartesianController::setRestWeights(const Vector &newRestWeights,
     
         // send command to solver and wait for reply
         bool ret=false;
-        if (portSlvRpc.write(command,reply))
+        if (writeSolverRpc(command,reply))
         {
             Bottle *rxRestPart=reply.get(1).asList();
             curRestWeights.resize(rxRestPart->size());
@@ -2973,7 +3271,7 @@ bool ServerCartesianController::getLimits(const int axis, double *min,
             command.addInt(axis);
 
             // send command to solver and wait for reply
-            if (!portSlvRpc.write(command,reply))
+            if (!writeSolverRpc(command,reply))
                 yError("%s: unable to get reply from solver!",ctrlName.c_str());         
             else if (reply.get(0).asVocab()==IKINSLV_VOCAB_REP_ACK)
             {
@@ -3005,7 +3303,7 @@ bool ServerCartesianController::setLimits(const int axis, const double min,
         command.addDouble(max);
 
         // send command to solver and wait for reply        
-        if (portSlvRpc.write(command,reply))
+        if (writeSolverRpc(command,reply))
             ret=(reply.get(0).asVocab()==IKINSLV_VOCAB_REP_ACK);
         else
             yError("%s: unable to get reply from solver!",ctrlName.c_str());
@@ -3219,7 +3517,7 @@ bool ServerCartesianController::attachTipFrame(const Vector &x, const Vector &o)
 
         // send command to solver and wait for reply
         bool ret=false;
-        if (portSlvRpc.write(command,reply))
+        if (writeSolverRpc(command,reply))
         {
             if (ret=(reply.get(0).asVocab()==IKINSLV_VOCAB_REP_ACK))
             {
@@ -3715,7 +4013,7 @@ bool ServerCartesianController::getTask2ndOptions(Value &v)
         command.addVocab(IKINSLV_VOCAB_OPT_TASK2);
 
         // send command to solver and wait for reply
-        if (portSlvRpc.write(command,reply))
+        if (writeSolverRpc(command,reply))
         {
             if (ret=(reply.get(0).asVocab()==IKINSLV_VOCAB_REP_ACK))
                 v=reply.get(1);
@@ -3742,7 +4040,7 @@ bool ServerCartesianController::setTask2ndOptions(const Value &v)
         command.add(v);
 
         // send command to solver and wait for reply
-        if (portSlvRpc.write(command,reply))
+        if (writeSolverRpc(command,reply))
             ret=(reply.get(0).asVocab()==IKINSLV_VOCAB_REP_ACK);
         else
             yError("%s: unable to get reply from solver!",ctrlName.c_str());
@@ -3763,7 +4061,7 @@ bool ServerCartesianController::getSolverConvergenceOptions(Bottle &options)
         command.addVocab(IKINSLV_VOCAB_OPT_CONVERGENCE);
 
         // send command to solver and wait for reply
-        if (portSlvRpc.write(command,reply))
+        if (writeSolverRpc(command,reply))
         {
             if (ret=(reply.get(0).asVocab()==IKINSLV_VOCAB_REP_ACK))
                 options=*reply.get(1).asList();
@@ -3790,7 +4088,7 @@ bool ServerCartesianController::setSolverConvergenceOptions(const Bottle &option
         command.addList()=options;
 
         // send command to solver and wait for reply
-        if (portSlvRpc.write(command,reply))
+        if (writeSolverRpc(command,reply))
             ret=(reply.get(0).asVocab()==IKINSLV_VOCAB_REP_ACK);
         else
             yError("%s: unable to get reply from solver!",ctrlName.c_str());        
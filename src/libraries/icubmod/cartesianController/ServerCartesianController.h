@@ -39,6 +39,14 @@
 #include "SmithPredictor.h"
 
 
+namespace iCub
+{
+    namespace iKin
+    {
+        class CartesianSolver;
+    }
+}
+
 class ServerCartesianController;
 
 
@@ -100,10 +108,19 @@ public:
 * |:-----------------:|
 * | `servercartesiancontroller` |
 *
+* The solver is usually a separate process reached through
+* ports. Alternatively, it can be hosted within the device by
+* providing the group [LOCAL_SOLVER], which contains the solver
+* options (see iCub::iKin::CartesianSolver::open()): targets and
+* solutions are then exchanged through lock-free queues without
+* any serialization. The local solver is available for the arm
+* and leg kinematic parts only.
+*
 */
 class ServerCartesianController : public    yarp::dev::DeviceDriver,
                                   public    yarp::dev::IMultipleWrapper,
                                   public    yarp::dev::ICartesianControl,
+                                  public    iCub::iKin::ICartesianControlBatch,
                                   public    yarp::os::PeriodicThread,
                                   protected iCub::iKin::CartesianHelper
 {
@@ -188,6 +205,9 @@ protected:
     yarp::os::BufferedPort<yarp::os::Bottle>   portSlvOut;
     yarp::os::RpcClient                        portSlvRpc;
 
+    iCub::iKin::CartesianSolver *localSlv;
+    yarp::os::Property           localSlvOptions;
+
     yarp::os::BufferedPort<yarp::sig::Vector>  portState;
     yarp::os::BufferedPort<yarp::os::Bottle>   portEvent;
     yarp::os::BufferedPort<yarp::os::Bottle>   portDebugInfo;
@@ -265,6 +285,9 @@ protected:
     bool setTask2ndOptions(const yarp::os::Value &v);
     bool getSolverConvergenceOptions(yarp::os::Bottle &options);
     bool setSolverConvergenceOptions(const yarp::os::Bottle &options);
+    bool askForBatch(const yarp::sig::Vector *q0, const std::deque<yarp::sig::Vector> &xd,
+                     const std::deque<yarp::sig::Vector> *od, std::deque<yarp::sig::Vector> &xdhat,
+                     std::deque<yarp::sig::Vector> &odhat, std::deque<yarp::sig::Vector> &qdhat);
 
 public:
     ServerCartesianController();
@@ -275,6 +298,13 @@ public:
 
     bool pingSolver();
     bool connectToSolver();
+    bool createLocalSolver(const yarp::os::Bottle &options);
+    bool openLocalSolver();
+    void closeLocalSolver();
+    bool pingLocalSolver();
+    bool sendLocalSolverRequest(const yarp::sig::Vector &xd);
+    bool getLocalSolverResult(bool &tokened, yarp::sig::Vector &_xdes, yarp::sig::Vector &_qdes);
+    bool writeSolverRpc(yarp::os::Bottle &command, yarp::os::Bottle &reply);
 
     bool attachAll(const yarp::dev::PolyDriverList &p);
     bool detachAll();
@@ -300,6 +330,17 @@ public:
                         yarp::sig::Vector &qdhat);
     bool askForPosition(const yarp::sig::Vector &q0, const yarp::sig::Vector &xd, yarp::sig::Vector &xdhat,
                         yarp::sig::Vector &odhat, yarp::sig::Vector &qdhat);
+    bool askForPoses(const std::deque<yarp::sig::Vector> &xd, const std::deque<yarp::sig::Vector> &od,
+                     std::deque<yarp::sig::Vector> &xdhat, std::deque<yarp::sig::Vector> &odhat,
+                     std::deque<yarp::sig::Vector> &qdhat);
+    bool askForPoses(const yarp::sig::Vector &q0, const std::deque<yarp::sig::Vector> &xd,
+                     const std::deque<yarp::sig::Vector> &od, std::deque<yarp::sig::Vector> &xdhat,
+                     std::deque<yarp::sig::Vector> &odhat, std::deque<yarp::sig::Vector> &qdhat);
+    bool askForPositions(const std::deque<yarp::sig::Vector> &xd, std::deque<yarp::sig::Vector> &xdhat,
+                         std::deque<yarp::sig::Vector> &odhat, std::deque<yarp::sig::Vector> &qdhat);
+    bool askForPositions(const yarp::sig::Vector &q0, const std::deque<yarp::sig::Vector> &xd,
+                         std::deque<yarp::sig::Vector> &xdhat, std::deque<yarp::sig::Vector> &odhat,
+                         std::deque<yarp::sig::Vector> &qdhat);
     bool getDOF(yarp::sig::Vector &curDof);
     bool setDOF(const yarp::sig::Vector &newDof, yarp::sig::Vector &curDof);
     bool getRestPos(yarp::sig::Vector &curRestPos);
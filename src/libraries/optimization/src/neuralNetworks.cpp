@@ -58,6 +58,7 @@ protected:
     const deque<Vector> &in;
     const deque<Vector> &out;
     deque<Vector> &pred;
+    Matrix inBatch;
     double error;
 
     /****************************************************************/
@@ -125,6 +126,12 @@ public:
                      IW(_net.get_IW()), LW(_net.get_LW()),
                      b1(_net.get_b1()), b2(_net.get_b2())
     {
+        // the inputs are stored once for all by rows, so that the
+        // network can process them in one go
+        inBatch.resize(in.size(),in.front().length());
+        for (size_t i=0; i<in.size(); i++)
+            inBatch.setRow(i,in[i]);
+
         pred.clear();
         error=0.0;        
     }
@@ -223,11 +230,17 @@ public:
     {
         fillNet(x);
 
+        Matrix batch=net.predict(inBatch);
         obj_value=0.0;
         for (size_t i=0; i<in.size(); i++)
         {
-            Vector pred=net.predict(in[i]);
-            obj_value+=norm2(out[i]-pred);
+            const Vector &o=out[i];
+            const double *p=batch[i];
+            for (size_t j=0; j<o.length(); j++)
+            {
+                double e=o[j]-p[j];
+                obj_value+=e*e;
+            }
         }
 
         obj_value/=in.size();
@@ -275,9 +288,10 @@ public:
     {
         error=0.0;
         pred.clear();
+        Matrix batch=net.predict(inBatch);
         for (size_t i=0; i<in.size(); i++)
         {
-            Vector pred=net.predict(in[i]);            
+            Vector pred=batch.getRow(i);
             error+=norm2(out[i]-pred);
             this->pred.push_back(pred);
         }
@@ -25,6 +25,7 @@
 #ifndef __DINCONT_H__
 #define __DINCONT_H__
 
+#include <atomic>
 #include <yarp/os/Portable.h>
 #include <yarp/sig/Vector.h>
 #include <yarp/sig/Matrix.h>
@@ -52,7 +53,8 @@ class dynContact : public yarp::os::Portable
 {
 protected:
     // static variable containing the id of the last contact created
-    static unsigned long ID;
+    // (atomic, since contacts may be created by limbs solved concurrently)
+    static std::atomic<unsigned long> ID;
     // unique id of the contact
     unsigned long contactId;
 
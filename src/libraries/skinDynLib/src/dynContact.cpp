@@ -28,7 +28,7 @@ using namespace iCub::skinDynLib;
 //~~~~~~~~~~~~~~~~~~~~~~
 //   DYN CONTACT
 //~~~~~~~~~~~~~~~~~~~~~~
-unsigned long dynContact::ID = 1;
+std::atomic<unsigned long> dynContact::ID(1);
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 dynContact::dynContact(){
     init(BODY_PART_UNKNOWN, 0, zeros(3));
@@ -176,8 +176,8 @@ using namespace iCub::ctrl;
 class dataCollector : public BufferedPort<Bottle>
 {
 private:
-    AWLinEstimator       *linEst;
-    AWQuadEstimator      *quadEst;
+    AWLinFastEstimator   *linEst;
+    AWQuadFastEstimator  *quadEst;
     BufferedPort<Vector> &port_vel;
     BufferedPort<Vector> &port_acc;
 
@@ -224,8 +224,8 @@ public:
                   unsigned int NAcc, double DAcc, BufferedPort<Vector> &_port_acc) :
                   port_vel(_port_vel), port_acc(_port_acc)
     {
-        linEst =new AWLinEstimator(NVel,DVel);
-        quadEst=new AWQuadEstimator(NAcc,DAcc);
+        linEst =new AWLinFastEstimator(NVel,DVel);
+        quadEst=new AWQuadFastEstimator(NAcc,DAcc);
     }
 
     ~dataCollector()
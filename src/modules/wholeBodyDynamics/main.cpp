@@ -69,6 +69,38 @@ http://wiki.icub.org/wiki/Force_Control
 --no_legs   
 - this option disables the dynamics computation for the legs joints
 
+--parallel_threads \e n
+- The limbs of the upper and lower body are solved concurrently
+  by a pool of \e n threads. Results are identical to the serial
+  computation, which is the default.
+
+--pipelined
+- Acquisition, computation and publication run as a pipeline:
+  a dedicated thread reads the robot and produces timestamped
+  snapshots, the main thread solves the dynamics on the latest
+  available snapshot and another thread writes the output ports.
+  A slow sensor read or a slow subscriber no longer delays the
+  estimate. The sample-to-torque latency can be queried with the
+  \e latency rpc command.
+
+--state_port
+- Opens the port \e <name>/state:o, where all the quantities
+  computed in one cycle (joint torques, external wrenches, COMs,
+  root position and, if enabled, COM velocity and jacobian) are
+  streamed as a single binary packet with a single stamp. The
+  packet is an iCub::iDyn::wholeBodyState, which also decodes it
+  on the client side; the individual ports are still available.
+
+--stats_port
+- Opens the port \e <name>/stats:o, where the timing statistics of
+  each stage of the computation are published once per second.
+  The same statistics are returned by the \e stats rpc command: for
+  each stage (acquisition, encoders_up, encoders_low, solve_up,
+  solve_low, skin, compute, publication and the sample-to-torque
+  latency) a list with the name, the median, the 99th percentile
+  and the maximum duration in ms over the last 5-10 s, and the
+  number of samples.
+
 \section portsa_sec Ports Accessed
 The port the service is listening to.
 
@@ -215,11 +247,16 @@ private:
     bool     dummy_ft;
     bool     dump_vel_enabled;
     bool     auto_drift_comp;
+    int      parallel_threads;      // >0: number of threads solving the limbs concurrently
+    bool     pipelined;             // true: acquisition, computation and publication run in separate threads
+    bool     stats_port_enabled;    // true: the timing statistics are published once per second
+    bool     state_port_enabled;    // true: all the outputs are also streamed in one packet per cycle
     bool     default_ee_cont;       // true: when skin detects no contact, the ext contact is supposed at the end effector
                                     // false: ext contact is supposed at the last location where skin detected a contact
 
     dataFilter *inertialFilter{};
     BufferedPort<Vector> port_filtered_output;
+    BufferedPort<Bottle> port_stats;
     Port rpcPort;
 
     inverseDynamics *inv_dyn;
@@ -255,6 +292,10 @@ public:
         dummy_ft = false;
         dump_vel_enabled = false;
         auto_drift_comp = false;
+        parallel_threads = 0;
+        pipelined = false;
+        stats_port_enabled = false;
+        state_port_enabled = false;
         default_ee_cont = false;
     }
 
@@ -338,6 +379,25 @@ public:
                 reply.addString("calib arms");
                 reply.addString("calib legs");
                 reply.addString("calib feet");
+                reply.addString("latency");
+                reply.addString("stats");
+                return true;
+            }
+            else if (command.get(0).asString()=="stats")
+            {
+                if (inv_dyn)
+                    inv_dyn->getStageStats(reply);
+                return true;
+            }
+            else if (command.get(0).asString()=="latency")
+            {
+                double last=0.0, mean=0.0, max=0.0;
+                if (inv_dyn)
+                    inv_dyn->getLatency(last,mean,max,false);
+                reply.addString("latency");
+                reply.addDouble(last);
+                reply.addDouble(mean);
+                reply.addDouble(max);
                 return true;
             }
             else if (command.get(0).asString()=="calib")
@@ -537,6 +597,32 @@ public:
             yInfo("Enabling automatic drift compensation (experimental)\n");
         }
 
+        //---------------------PARALLEL-------------------------//
+        if (rf.check("parallel_threads"))
+        {
+            parallel_threads = rf.find("parallel_threads").asInt();
+            if (parallel_threads>0)
+                yInfo("Solving the limbs concurrently with %d threads\n",parallel_threads);
+        }
+
+        if (rf.check("pipelined"))
+        {
+            pipelined = true;
+            yInfo("Acquisition, computation and publication run as a pipeline\n");
+        }
+
+        if (rf.check("state_port"))
+        {
+            state_port_enabled = true;
+            yInfo("Streaming the whole-body state on a single port\n");
+        }
+
+        if (rf.check("stats_port"))
+        {
+            stats_port_enabled = true;
+            yInfo("Publishing the timing statistics\n");
+        }
+
         if (rf.check("default_ee_cont"))
         {
             default_ee_cont = true;
@@ -660,12 +746,17 @@ public:
 
         //---------------OPEN INERTIAL PORTS--------------------//
         port_filtered_output.open("/"+local_name+"/filtered/inertial:o");
+        if (stats_port_enabled)
+            port_stats.open("/"+local_name+"/stats:o");
         inertialFilter = new dataFilter(port_filtered_output, m_iGyro, m_iAcc);
 
         //--------------------------THREAD--------------------------
         inv_dyn = new inverseDynamics(rate, dd_left_arm, dd_right_arm, dd_head, dd_left_leg, dd_right_leg, dd_torso, robot_name, local_name, icub_type, autoconnect);
         inv_dyn->com_enabled=com_enabled;
         inv_dyn->auto_drift_comp=auto_drift_comp;
+        inv_dyn->parallel_threads=parallel_threads;
+        inv_dyn->pipelined=pipelined;
+        inv_dyn->state_port_enabled=state_port_enabled;
         inv_dyn->com_vel_enabled=com_vel_enabled;
         inv_dyn->dummy_ft=dummy_ft;
         inv_dyn->w0_dw0_enabled=w0_dw0_enabled;
@@ -717,6 +808,13 @@ public:
         yInfo("Closing the rpc port \n");     
         rpcPort.close();
 
+        if (stats_port_enabled)
+        {
+            yInfo("Closing the stats port \n");
+            port_stats.interrupt();
+            port_stats.close();
+        }
+
         if (dd_left_arm)
         {
             yInfo("Closing dd_left_arm \n");     
@@ -783,11 +881,26 @@ public:
         if (Time::now() - curr_time > 60)
         {
             yInfo ("wholeBodyDynamics is alive! running for %ld mins.\n",++alive_counter);
+            if (inv_dyn)
+            {
+                double last, mean, max;
+                inv_dyn->getLatency(last,mean,max);
+                yInfo ("sample-to-torque latency: mean %.2f ms, max %.2f ms\n",1000.0*mean,1000.0*max);
+            }
             curr_time = Time::now();
         }
 
         if (inv_dyn==nullptr)
             return false;
+
+        if (stats_port_enabled && port_stats.getOutputCount()>0)
+        {
+            Bottle &stats = port_stats.prepare();
+            stats.clear();
+            inv_dyn->getStageStats(stats);
+            port_stats.write();
+        }
+
         thread_status_enum thread_status = inv_dyn->getThreadStatus();
         if (thread_status==STATUS_OK)
             return true;
@@ -834,6 +947,10 @@ int main(int argc, char * argv[])
         cout << "\t--dumpvel         dumps joint velocities and accelerations (debug use only)"                                  << endl;
         cout << "\t--experimental_com_vel  enables com velocity computation (experimental)"                                      << endl;
         cout << "\t--auto_drift_comp  enables automatic drift compensation  (experimental, under debug)"                         << endl;
+        cout << "\t--parallel_threads n  solves the limbs concurrently using n threads (default: 0, i.e. serial computation)"  << endl;
+        cout << "\t--pipelined      runs acquisition, computation and publication in separate threads"                        << endl;
+        cout << "\t--state_port     streams all the outputs of each cycle in one packet on <name>/state:o"                     << endl;
+        cout << "\t--stats_port     publishes the timing statistics of each stage on <name>/stats:o"                          << endl;
         return 0;
     }
 
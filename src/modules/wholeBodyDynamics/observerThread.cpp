@@ -17,6 +17,7 @@
 */
 
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <string>
@@ -260,8 +261,17 @@ inverseDynamics::inverseDynamics(int _rate, PolyDriver *_ddAL, PolyDriver *_ddAR
     w0_dw0_enabled   = false;
     dumpvel_enabled = false;
     auto_drift_comp = false;
+    parallel_threads = 0;
+    pipelined = false;
+    state_port_enabled = false;
     add_legs_once = false;
 
+    acq_thread = nullptr;
+    pub_thread = nullptr;
+    acq_delay_check = 0;
+    latency_last = latency_sum = latency_max = 0.0;
+    latency_count = 0;
+
     icub      = new iCubWholeBody(icub_type, DYNAMIC, VERBOSE);
     icub_sens = new iCubWholeBody(icub_type, DYNAMIC, VERBOSE);
     first = true;
@@ -343,10 +353,13 @@ inverseDynamics::inverseDynamics(int _rate, PolyDriver *_ddAL, PolyDriver *_ddAR
     port_external_ft_leg_right = new BufferedPort<Vector>;
     port_COM_vel = new BufferedPort<Vector>;
     port_COM_Jacobian = new BufferedPort<Matrix>;
+    port_COM_analytic_Jacobian = new BufferedPort<Matrix>;
+    port_centroidal_momentum_matrix = new BufferedPort<Matrix>;
     port_all_velocities = new BufferedPort<Vector>;
     port_all_positions = new BufferedPort<Vector>;
     port_root_position_mat = new BufferedPort<Matrix>;
     port_root_position_vec = new BufferedPort<Vector>;
+    port_state = nullptr;
 
     port_inertial_thread->open(string("/"+local_name+"/inertial:i").c_str());
     port_ft_arm_left->open(string("/"+local_name+"/left_arm/FT:i").c_str());
@@ -402,6 +415,8 @@ inverseDynamics::inverseDynamics(int _rate, PolyDriver *_ddAL, PolyDriver *_ddAR
     port_external_ft_leg_right->open(string("/"+local_name+"/right_leg/ext_ft_sens:o").c_str());
     port_COM_vel->open(string("/"+local_name+"/com_vel:o").c_str());
     port_COM_Jacobian->open(string("/"+local_name+"/com_jacobian:o").c_str());
+    port_COM_analytic_Jacobian->open(string("/"+local_name+"/com_jacobian_analytic:o").c_str());
+    port_centroidal_momentum_matrix->open(string("/"+local_name+"/centroidal_momentum_matrix:o").c_str());
     port_all_velocities->open(string("/"+local_name+"/all_velocities:o").c_str());
     port_all_positions->open(string("/"+local_name+"/all_positions:o").c_str());
     port_root_position_mat->open(string("/"+local_name+"/root_position_mat:o").c_str());
@@ -441,11 +456,11 @@ inverseDynamics::inverseDynamics(int _rate, PolyDriver *_ddAL, PolyDriver *_ddAR
     if (ddLR) {ddLR->view(iencs_leg_right); ddLR->view(iint_leg_right); ddLR->view(icmd_leg_right);}
     if (ddT)  {ddT->view(iencs_torso);      ddT ->view(iint_torso);      ddT ->view(icmd_torso);}
 
-    linEstUp =new AWLinEstimator(16,1.0);
-    quadEstUp=new AWQuadEstimator(25,1.0);
-    linEstLow =new AWLinEstimator(16,1.0);
-    quadEstLow=new AWQuadEstimator(25,1.0);
-    InertialEst = new AWLinEstimator(16,1.0);
+    linEstUp =new AWLinFastEstimator(16,1.0);
+    quadEstUp=new AWQuadFastEstimator(25,1.0);
+    linEstLow =new AWLinFastEstimator(16,1.0);
+    quadEstLow=new AWQuadFastEstimator(25,1.0);
+    InertialEst = new AWLinFastEstimator(16,1.0);
 
     //-----------parts INIT VARIABLES----------------//
     init_upper();
@@ -471,11 +486,25 @@ inverseDynamics::inverseDynamics(int _rate, PolyDriver *_ddAL, PolyDriver *_ddAR
     F_ext_cartesian_left_foot.resize(6,0.0);
     F_ext_cartesian_right_foot.resize(6,0.0);
     com_jac.resize(6,32);
+    com_jac_an.resize(3,32);
+    com_cmm.resize(6,32);
 
 }
 
 bool inverseDynamics::threadInit()
 {
+    if (state_port_enabled)
+    {
+        port_state = new BufferedPort<wholeBodyState>;
+        port_state->open(string("/"+local_name+"/state:o").c_str());
+    }
+
+    if (parallel_threads>0)
+    {
+        icub->setParallelMode(true,parallel_threads);
+        icub_sens->setParallelMode(true,parallel_threads);
+    }
+
     yInfo("threadInit: waiting for port connections... \n\n");
     if (!dummy_ft)
     {
@@ -498,10 +527,43 @@ bool inverseDynamics::threadInit()
     // the queue previous_status now contains status_queue_size elements, and we can calibrate
     calibrateOffset();
 
+    if (pipelined)
+    {
+        acq_status = current_status;
+        status_buffer.fill(current_status);
+
+        acq_thread = new acquisitionThread(getPeriod(),this);
+        pub_thread = new publicationThread(this);
+        if (!acq_thread->start() || !pub_thread->start())
+        {
+            yError("Unable to start the pipeline stages, stopping... \n");
+            thread_status = STATUS_DISCONNECTED;
+            return false;
+        }
+        yInfo("threadInit: pipeline started\n");
+    }
+
     thread_status = STATUS_OK;
     return true;
 }
 
+void acquisitionThread::run()
+{
+    owner->acquire();
+}
+
+void publicationThread::run()
+{
+    while (!isStopping())
+    {
+        new_output.wait();
+        if (isStopping())
+            break;
+
+        owner->publish();
+    }
+}
+
 bool iCubStatus::checkIcubNotMoving()
 {
     bool ret = true;
@@ -543,22 +605,47 @@ void inverseDynamics::run()
     timestamp.update();
 
     thread_status = STATUS_OK;
-    static int delay_check=0;
-    if(!readAndUpdate(false))
+    if (pipelined)
     {
-        delay_check++;
-        yWarning ("network delays detected (%d/10)\n", delay_check);
-        if (delay_check>=10)
+        if (acq_delay_check>=10)
         {
             yError ("inverseDynamics thread lost connection with iCubInterface.\n");
             thread_status = STATUS_DISCONNECTED;
         }
+
+        // nothing to do until the acquisition stage produces a new snapshot
+        if (!status_buffer.update())
+            return;
+
+        current_status = status_buffer.readSlot();
+        updateStatus();
     }
     else
     {
-        delay_check = 0;
+        static int delay_check=0;
+        bool ok;
+        {
+            stageTimer timer(stage_stats[STAGE_ACQUISITION]);
+            ok = readAndUpdate(false);
+        }
+        if(!ok)
+        {
+            delay_check++;
+            yWarning ("network delays detected (%d/10)\n", delay_check);
+            if (delay_check>=10)
+            {
+                yError ("inverseDynamics thread lost connection with iCubInterface.\n");
+                thread_status = STATUS_DISCONNECTED;
+            }
+        }
+        else
+        {
+            delay_check = 0;
+        }
     }
 
+    stageTimer compute_timer(stage_stats[STAGE_COMPUTE]);
+
     //remove the offset from the FT sensors measurements
     F_LArm  = -1.0 * (current_status.ft_arm_left-Offset_LArm);
     F_RArm  = -1.0 * (current_status.ft_arm_right-Offset_RArm);
@@ -605,9 +692,16 @@ void inverseDynamics::run()
     static double startTime = 0;
     startTime = Time::now();
 #endif
-    icub->upperTorso->solveKinematics();
-    addSkinContacts();
-    icub->upperTorso->solveWrench();
+    {
+        // the time spent on the skin contacts is also accounted for in the upper torso solve
+        stageTimer timer(stage_stats[STAGE_SOLVE_UP]);
+        icub->upperTorso->solveKinematics();
+        {
+            stageTimer skin_timer(stage_stats[STAGE_SKIN]);
+            addSkinContacts();
+        }
+        icub->upperTorso->solveWrench();
+    }
 #ifdef DEBUG_PERFORMANCE
     meanTime += Time::now()-startTime;
     yDebug("Mean uppertorso NE time: %.4f\n", meanTime/getIterations());
@@ -621,9 +715,12 @@ void inverseDynamics::run()
     yDebug ("UPTORSO: %s \n", icub->upperTorso->getTorsoLinAcc().toString().c_str());
 #endif
 
-    icub->attachLowerTorso(F_RLeg,F_LLeg);
-    icub->lowerTorso->solveKinematics();
-    icub->lowerTorso->solveWrench();
+    {
+        stageTimer timer(stage_stats[STAGE_SOLVE_LOW]);
+        icub->attachLowerTorso(F_RLeg,F_LLeg);
+        icub->lowerTorso->solveKinematics();
+        icub->lowerTorso->solveWrench();
+    }
 
 //#define DEBUG_KINEMATICS
 #ifdef DEBUG_KINEMATICS
@@ -684,16 +781,6 @@ void inverseDynamics::run()
     yDebug ("TORQUES:     %s ***  \n\n", TOTorques.toString().c_str());
 #endif
 
-    writeTorque(RATorques, 1, port_RATorques); //arm
-    writeTorque(LATorques, 1, port_LATorques); //arm
-    writeTorque(TOTorques, 4, port_TOTorques); //torso
-    writeTorque(HDTorques, 0, port_HDTorques); //head
-
-    if (ddLR) writeTorque(RLTorques, 2, port_RLTorques); //leg
-    if (ddLL) writeTorque(LLTorques, 2, port_LLTorques); //leg
-    writeTorque(RATorques, 3, port_RWTorques); //wrist
-    writeTorque(LATorques, 3, port_LWTorques); //wrist
-
     Vector com_all(7), com_ll(7), com_rl(7), com_la(7),com_ra(7), com_hd(7), com_to(7), com_lb(7), com_ub(7);
     double mass_all  , mass_ll  , mass_rl  , mass_la  ,mass_ra  , mass_hd,   mass_to, mass_lb, mass_ub;
     Vector com_v; com_v.resize(3); com_v.zero();
@@ -726,10 +813,16 @@ void inverseDynamics::run()
 
         if (com_vel_enabled)
         {
+            // com_jacobian:o and com_vel:o keep the 6x32 jacobian and the
+            // 6-vector velocity of the EXPERIMENTAL methods
             icub->EXPERIMENTAL_computeCOMjacobian();
             icub->EXPERIMENTAL_getCOMjacobian(BODY_PART_ALL,com_jac);
             icub->EXPERIMENTAL_getCOMvelocity(BODY_PART_ALL,com_v,all_dq);
             icub->getAllPositions(all_q);
+
+            icub->computeCOMjacobian();
+            icub->getCOMjacobian(com_jac_an);
+            icub->getCentroidalMomentumMatrix(com_cmm);
         }
 
         icub->getCOM(BODY_PART_ALL,     com_all, mass_all);
@@ -957,58 +1050,295 @@ void inverseDynamics::run()
     // *** DUMP VEL DATA ***
     //sendVelAccData();
 
+    // the handoff and, in serial mode, the publication are not part of the computation
+    compute_timer.stop();
+
+    // hand the results over to the publication stage
+    wholeBodyOutput &out = pipelined ? output_buffer.writeSlot() : output;
+    out.stamp = pipelined ? Stamp(timestamp.getCount(),current_status.timestamp) : timestamp;
+    out.sample_time = current_status.timestamp;
+    out.RATorques = RATorques;
+    out.LATorques = LATorques;
+    out.RLTorques = RLTorques;
+    out.LLTorques = LLTorques;
+    out.TOTorques = TOTorques;
+    out.HDTorques = HDTorques;
+    out.com_all = com_all;
+    out.com_lb  = com_lb;
+    out.com_ub  = com_ub;
+    out.com_ll  = com_ll;
+    out.com_rl  = com_rl;
+    out.com_la  = com_la;
+    out.com_ra  = com_ra;
+    out.com_hd  = com_hd;
+    out.com_to  = com_to;
+    out.com_all_foot = com_all_foot;
+    if (com_vel_enabled)
+    {
+        out.com_v   = com_v;
+        out.all_dq  = all_dq;
+        out.all_q   = all_q;
+        out.com_jac = com_jac;
+        out.com_jac_an = com_jac_an;
+        out.com_cmm = com_cmm;
+    }
+    out.F_up = F_up;
+    out.F_ext_right_arm = F_ext_right_arm;
+    out.F_ext_left_arm  = F_ext_left_arm;
+    out.F_ext_cartesian_right_arm = F_ext_cartesian_right_arm;
+    out.F_ext_cartesian_left_arm  = F_ext_cartesian_left_arm;
+    out.F_ext_right_leg  = F_ext_right_leg;
+    out.F_ext_left_leg   = F_ext_left_leg;
+    out.F_ext_right_foot = F_ext_right_foot;
+    out.F_ext_left_foot  = F_ext_left_foot;
+#ifdef TEST_LEG_SENSOR
+    out.F_sns_right_leg = F_sns_right_leg;
+    out.F_sns_left_leg  = F_sns_left_leg;
+    out.F_mdl_right_leg = F_mdl_right_leg;
+    out.F_mdl_left_leg  = F_mdl_left_leg;
+#endif
+    out.F_ext_cartesian_right_leg  = F_ext_cartesian_right_leg;
+    out.F_ext_cartesian_left_leg   = F_ext_cartesian_left_leg;
+    out.F_ext_cartesian_right_foot = F_ext_cartesian_right_foot;
+    out.F_ext_cartesian_left_foot  = F_ext_cartesian_left_foot;
+    out.F_ext_sens_right_arm = F_ext_sens_right_arm;
+    out.F_ext_sens_left_arm  = F_ext_sens_left_arm;
+    out.F_ext_sens_right_leg = F_ext_sens_right_leg;
+    out.F_ext_sens_left_leg  = F_ext_sens_left_leg;
+    out.foot_root_mat = foot_root_mat;
+    out.foot_root_vec = foot_root_vec;
+    out.skinContacts  = skinContacts;
+
+    if (pipelined)
+    {
+        output_buffer.publish();
+        pub_thread->notify();
+    }
+    else
+    {
+        publishOutput(out);
+    }
+}
+
+void inverseDynamics::acquire()
+{
+    bool ok;
+    {
+        stageTimer timer(stage_stats[STAGE_ACQUISITION]);
+        ok = acquireStatus(acq_status);
+    }
+    if (!ok)
+    {
+        int delay_check = ++acq_delay_check;
+        yWarning ("network delays detected (%d/10)\n", delay_check);
+    }
+    else
+    {
+        acq_delay_check = 0;
+    }
+
+    status_buffer.writeSlot() = acq_status;
+    status_buffer.publish();
+}
+
+void inverseDynamics::publish()
+{
+    if (output_buffer.update())
+        publishOutput(output_buffer.readSlot());
+}
+
+void inverseDynamics::publishOutput(wholeBodyOutput &out)
+{
+    stageTimer timer(stage_stats[STAGE_PUBLICATION]);
+
+    writeTorque(out.RATorques, 1, port_RATorques); //arm
+    writeTorque(out.LATorques, 1, port_LATorques); //arm
+    writeTorque(out.TOTorques, 4, port_TOTorques); //torso
+    writeTorque(out.HDTorques, 0, port_HDTorques); //head
+
+    if (ddLR) writeTorque(out.RLTorques, 2, port_RLTorques); //leg
+    if (ddLL) writeTorque(out.LLTorques, 2, port_LLTorques); //leg
+    writeTorque(out.RATorques, 3, port_RWTorques); //wrist
+    writeTorque(out.LATorques, 3, port_LWTorques); //wrist
+
+    // sample-to-torque latency
+    double latency = Time::now()-out.sample_time;
+    {
+        std::lock_guard<std::mutex> lck(latency_mutex);
+        latency_last = latency;
+        latency_sum += latency;
+        latency_max = std::max(latency_max,latency);
+        latency_count++;
+    }
+    stage_stats[STAGE_LATENCY].record(latency);
+
     if (com_vel_enabled)
     {
         // com_jac = M_PI/180.0 * (com_jac);
         // all_dq  = 180.0/M_PI * all_dq;
         // all_q  = 180.0/M_PI * all_q;
-        broadcastData<Vector> (com_v, port_COM_vel);
-        broadcastData<Vector> (all_dq, port_all_velocities);
-        broadcastData<Vector> (all_q,  port_all_positions);
-        broadcastData<Matrix> (com_jac, port_COM_Jacobian);
-    }
-    broadcastData<Vector> (com_all, port_com_all);
-    broadcastData<Vector> (com_lb,  port_com_lb);
-    broadcastData<Vector> (com_ub,  port_com_ub);
-    broadcastData<Vector> (com_ll,  port_com_ll);
-    broadcastData<Vector> (com_rl,  port_com_rl);
-    broadcastData<Vector> (com_la,  port_com_la);
-    broadcastData<Vector> (com_ra,  port_com_ra);
-    broadcastData<Vector> (com_hd,  port_com_hd);
-    broadcastData<Vector> (com_to,  port_com_to);
-    broadcastData<Vector> (com_all_foot, port_com_all_foot);
-
-    broadcastData<Vector> (F_up,                                    port_external_wrench_TO);
-    broadcastData<Vector> (F_ext_right_arm,                         port_external_wrench_RA);
-    broadcastData<Vector> (F_ext_left_arm,                          port_external_wrench_LA);
-    broadcastData<Vector> (F_ext_cartesian_right_arm,               port_external_cartesian_wrench_RA);
-    broadcastData<Vector> (F_ext_cartesian_left_arm,                port_external_cartesian_wrench_LA);
-    broadcastData<Vector> (F_ext_right_leg,                         port_external_wrench_RL);
-    broadcastData<Vector> (F_ext_left_leg,                          port_external_wrench_LL);
-    broadcastData<Vector> (F_ext_right_foot,                        port_external_wrench_RF);
-    broadcastData<Vector> (F_ext_left_foot,                         port_external_wrench_LF);
+        broadcastData<Vector> (out.com_v,   port_COM_vel,                    out.stamp);
+        broadcastData<Vector> (out.all_dq,  port_all_velocities,             out.stamp);
+        broadcastData<Vector> (out.all_q,   port_all_positions,              out.stamp);
+        broadcastData<Matrix> (out.com_jac, port_COM_Jacobian,               out.stamp);
+        broadcastData<Matrix> (out.com_jac_an, port_COM_analytic_Jacobian,   out.stamp);
+        broadcastData<Matrix> (out.com_cmm, port_centroidal_momentum_matrix, out.stamp);
+    }
+    broadcastData<Vector> (out.com_all, port_com_all, out.stamp);
+    broadcastData<Vector> (out.com_lb,  port_com_lb,  out.stamp);
+    broadcastData<Vector> (out.com_ub,  port_com_ub,  out.stamp);
+    broadcastData<Vector> (out.com_ll,  port_com_ll,  out.stamp);
+    broadcastData<Vector> (out.com_rl,  port_com_rl,  out.stamp);
+    broadcastData<Vector> (out.com_la,  port_com_la,  out.stamp);
+    broadcastData<Vector> (out.com_ra,  port_com_ra,  out.stamp);
+    broadcastData<Vector> (out.com_hd,  port_com_hd,  out.stamp);
+    broadcastData<Vector> (out.com_to,  port_com_to,  out.stamp);
+    broadcastData<Vector> (out.com_all_foot, port_com_all_foot, out.stamp);
+
+    broadcastData<Vector> (out.F_up,                                port_external_wrench_TO,           out.stamp);
+    broadcastData<Vector> (out.F_ext_right_arm,                     port_external_wrench_RA,           out.stamp);
+    broadcastData<Vector> (out.F_ext_left_arm,                      port_external_wrench_LA,           out.stamp);
+    broadcastData<Vector> (out.F_ext_cartesian_right_arm,           port_external_cartesian_wrench_RA, out.stamp);
+    broadcastData<Vector> (out.F_ext_cartesian_left_arm,            port_external_cartesian_wrench_LA, out.stamp);
+    broadcastData<Vector> (out.F_ext_right_leg,                     port_external_wrench_RL,           out.stamp);
+    broadcastData<Vector> (out.F_ext_left_leg,                      port_external_wrench_LL,           out.stamp);
+    broadcastData<Vector> (out.F_ext_right_foot,                    port_external_wrench_RF,           out.stamp);
+    broadcastData<Vector> (out.F_ext_left_foot,                     port_external_wrench_LF,           out.stamp);
 #ifdef TEST_LEG_SENSOR
-    broadcastData<Vector> (F_sns_right_leg,                         port_sensor_wrench_RL);
-    broadcastData<Vector> (F_sns_left_leg,                          port_sensor_wrench_LL);
-    broadcastData<Vector> (F_mdl_right_leg,                         port_model_wrench_RL);
-    broadcastData<Vector> (F_mdl_left_leg,                          port_model_wrench_LL);
+    broadcastData<Vector> (out.F_sns_right_leg,                     port_sensor_wrench_RL,             out.stamp);
+    broadcastData<Vector> (out.F_sns_left_leg,                      port_sensor_wrench_LL,             out.stamp);
+    broadcastData<Vector> (out.F_mdl_right_leg,                     port_model_wrench_RL,              out.stamp);
+    broadcastData<Vector> (out.F_mdl_left_leg,                      port_model_wrench_LL,              out.stamp);
 #endif
-    broadcastData<Vector> (F_ext_cartesian_right_leg,               port_external_cartesian_wrench_RL);
-    broadcastData<Vector> (F_ext_cartesian_left_leg,                port_external_cartesian_wrench_LL);
-    broadcastData<Vector> (F_ext_cartesian_right_foot,              port_external_cartesian_wrench_RF);
-    broadcastData<Vector> (F_ext_cartesian_left_foot,               port_external_cartesian_wrench_LF);
-    broadcastData<skinContactList>( skinContacts,                   port_contacts);
-    broadcastData<Vector> (F_ext_sens_right_arm,                    port_external_ft_arm_right);
-    broadcastData<Vector> (F_ext_sens_left_arm,                     port_external_ft_arm_left);
-    broadcastData<Vector> (F_ext_sens_right_leg,                    port_external_ft_leg_right);
-    broadcastData<Vector> (F_ext_sens_left_leg,                     port_external_ft_leg_left);
-
-    broadcastData<Matrix> (foot_root_mat,                           port_root_position_mat);
-    broadcastData<Vector> (foot_root_vec,                           port_root_position_vec);
+    broadcastData<Vector> (out.F_ext_cartesian_right_leg,           port_external_cartesian_wrench_RL, out.stamp);
+    broadcastData<Vector> (out.F_ext_cartesian_left_leg,            port_external_cartesian_wrench_LL, out.stamp);
+    broadcastData<Vector> (out.F_ext_cartesian_right_foot,          port_external_cartesian_wrench_RF, out.stamp);
+    broadcastData<Vector> (out.F_ext_cartesian_left_foot,           port_external_cartesian_wrench_LF, out.stamp);
+    broadcastData<skinContactList>( out.skinContacts,               port_contacts,                     out.stamp);
+    broadcastData<Vector> (out.F_ext_sens_right_arm,                port_external_ft_arm_right,        out.stamp);
+    broadcastData<Vector> (out.F_ext_sens_left_arm,                 port_external_ft_arm_left,         out.stamp);
+    broadcastData<Vector> (out.F_ext_sens_right_leg,                port_external_ft_leg_right,        out.stamp);
+    broadcastData<Vector> (out.F_ext_sens_left_leg,                 port_external_ft_leg_left,         out.stamp);
+
+    broadcastData<Matrix> (out.foot_root_mat,                       port_root_position_mat,            out.stamp);
+    broadcastData<Vector> (out.foot_root_vec,                       port_root_position_vec,            out.stamp);
+
+    publishState(out);
+}
+
+void inverseDynamics::publishState(wholeBodyOutput &out)
+{
+    if (!port_state || port_state->getOutputCount()==0)
+        return;
+
+    // all the quantities above in a single packet, sharing the same stamp
+    wholeBodyState &state = port_state->prepare();
+    state.clear();
+    state.setStamp(out.stamp);
+
+    state.add(WBS_TORQUES_HEAD,      out.HDTorques);
+    state.add(WBS_TORQUES_TORSO,     out.TOTorques);
+    state.add(WBS_TORQUES_LEFT_ARM,  out.LATorques);
+    state.add(WBS_TORQUES_RIGHT_ARM, out.RATorques);
+    if (ddLL) state.add(WBS_TORQUES_LEFT_LEG,  out.LLTorques);
+    if (ddLR) state.add(WBS_TORQUES_RIGHT_LEG, out.RLTorques);
+
+    state.add(WBS_WRENCH_TORSO,      out.F_up);
+    state.add(WBS_WRENCH_LEFT_ARM,   out.F_ext_left_arm);
+    state.add(WBS_WRENCH_RIGHT_ARM,  out.F_ext_right_arm);
+    state.add(WBS_WRENCH_LEFT_LEG,   out.F_ext_left_leg);
+    state.add(WBS_WRENCH_RIGHT_LEG,  out.F_ext_right_leg);
+    state.add(WBS_WRENCH_LEFT_FOOT,  out.F_ext_left_foot);
+    state.add(WBS_WRENCH_RIGHT_FOOT, out.F_ext_right_foot);
+    state.add(WBS_CARTESIAN_WRENCH_LEFT_ARM,   out.F_ext_cartesian_left_arm);
+    state.add(WBS_CARTESIAN_WRENCH_RIGHT_ARM,  out.F_ext_cartesian_right_arm);
+    state.add(WBS_CARTESIAN_WRENCH_LEFT_LEG,   out.F_ext_cartesian_left_leg);
+    state.add(WBS_CARTESIAN_WRENCH_RIGHT_LEG,  out.F_ext_cartesian_right_leg);
+    state.add(WBS_CARTESIAN_WRENCH_LEFT_FOOT,  out.F_ext_cartesian_left_foot);
+    state.add(WBS_CARTESIAN_WRENCH_RIGHT_FOOT, out.F_ext_cartesian_right_foot);
+    state.add(WBS_SENSOR_WRENCH_LEFT_ARM,  out.F_ext_sens_left_arm);
+    state.add(WBS_SENSOR_WRENCH_RIGHT_ARM, out.F_ext_sens_right_arm);
+    state.add(WBS_SENSOR_WRENCH_LEFT_LEG,  out.F_ext_sens_left_leg);
+    state.add(WBS_SENSOR_WRENCH_RIGHT_LEG, out.F_ext_sens_right_leg);
+
+    state.add(WBS_COM_ALL,        out.com_all);
+    state.add(WBS_COM_LOWER_BODY, out.com_lb);
+    state.add(WBS_COM_UPPER_BODY, out.com_ub);
+    state.add(WBS_COM_LEFT_ARM,   out.com_la);
+    state.add(WBS_COM_RIGHT_ARM,  out.com_ra);
+    state.add(WBS_COM_LEFT_LEG,   out.com_ll);
+    state.add(WBS_COM_RIGHT_LEG,  out.com_rl);
+    state.add(WBS_COM_HEAD,       out.com_hd);
+    state.add(WBS_COM_TORSO,      out.com_to);
+    state.add(WBS_COM_ALL_FOOT,   out.com_all_foot);
+    if (com_vel_enabled)
+    {
+        state.add(WBS_COM_VELOCITY,               out.com_v);
+        state.add(WBS_ALL_POSITIONS,              out.all_q);
+        state.add(WBS_ALL_VELOCITIES,             out.all_dq);
+        state.add(WBS_COM_JACOBIAN,               out.com_jac);
+        state.add(WBS_COM_ANALYTIC_JACOBIAN,      out.com_jac_an);
+        state.add(WBS_CENTROIDAL_MOMENTUM_MATRIX, out.com_cmm);
+    }
+
+    state.add(WBS_ROOT_POSITION_MAT, out.foot_root_mat);
+    state.add(WBS_ROOT_POSITION_VEC, out.foot_root_vec);
+
+    port_state->setEnvelope(out.stamp);
+    port_state->write();
+}
+
+void inverseDynamics::getStageStats(Bottle &stats)
+{
+    static const char *names[STAGE_NUM] = {"acquisition", "encoders_up", "encoders_low", "solve_up", "solve_low",
+                                           "skin", "compute", "publication", "latency"};
+
+    // one list per stage: name, p50, p99 and max in ms, number of samples
+    for (int i=0; i<STAGE_NUM; i++)
+    {
+        double p50, p99, max;
+        unsigned int count;
+        stage_stats[i].getStats(p50,p99,max,count);
+
+        Bottle &b = stats.addList();
+        b.addString(names[i]);
+        b.addDouble(1000.0*p50);
+        b.addDouble(1000.0*p99);
+        b.addDouble(1000.0*max);
+        b.addInt((int)count);
+    }
+}
+
+void inverseDynamics::getLatency(double &last, double &mean, double &max, bool reset)
+{
+    std::lock_guard<std::mutex> lck(latency_mutex);
+    last = latency_last;
+    mean = (latency_count>0) ? latency_sum/latency_count : 0.0;
+    max  = latency_max;
+    if (reset)
+    {
+        latency_sum = latency_max = 0.0;
+        latency_count = 0;
+    }
 }
 
 void inverseDynamics::threadRelease()
 {
+    if (acq_thread)
+    {
+        yInfo( "Stopping the acquisition stage\n");
+        acq_thread->stop();
+        delete acq_thread;
+        acq_thread = nullptr;
+    }
+    if (pub_thread)
+    {
+        yInfo( "Stopping the publication stage\n");
+        pub_thread->stop();
+        delete pub_thread;
+        pub_thread = nullptr;
+    }
+
     yInfo( "Closing the linear estimator\n");
     if(linEstUp)
     {
@@ -1132,6 +1462,10 @@ void inverseDynamics::threadRelease()
     closePort(port_COM_vel);
     yInfo("Closing COM Jacobian port\n");
     closePort(port_COM_Jacobian);
+    yInfo("Closing COM analytic Jacobian port\n");
+    closePort(port_COM_analytic_Jacobian);
+    yInfo("Closing centroidal momentum matrix port\n");
+    closePort(port_centroidal_momentum_matrix);
     yInfo("Closing All Velocities port\n");
     closePort(port_all_velocities);
     yInfo("Closing All Positions port\n");
@@ -1139,6 +1473,12 @@ void inverseDynamics::threadRelease()
     yInfo("Closing Foot/Root port\n");
     closePort(port_root_position_mat);
     closePort(port_root_position_vec);
+    if (port_state)
+    {
+        yInfo("Closing whole-body state port\n");
+        closePort(port_state);
+        port_state = nullptr;
+    }
 
     if (icub)      {delete icub; icub=0;}
     if (icub_sens) {delete icub_sens; icub=0;}
@@ -1156,11 +1496,11 @@ void inverseDynamics::closePort(Contactable *_port)
     }
 }
 
-template <class T> void inverseDynamics::broadcastData(T& _values, BufferedPort<T> *_port)
+template <class T> void inverseDynamics::broadcastData(T& _values, BufferedPort<T> *_port, const Stamp &_stamp)
 {
     if (_port && _port->getOutputCount()>0)
     {
-        _port->setEnvelope(this->timestamp);
+        _port->setEnvelope(_stamp);
         _port->prepare()  = _values ;
         _port->write();
     }
@@ -1250,6 +1590,13 @@ void inverseDynamics::calibrateOffset(calib_enum calib_code)
 }
 
 bool inverseDynamics::readAndUpdate(bool waitMeasure, bool _init)
+{
+    bool b = acquireStatus(current_status,waitMeasure);
+    updateStatus(_init);
+    return b;
+}
+
+bool inverseDynamics::acquireStatus(iCubStatus &status, bool waitMeasure)
 {
     bool b = true;
     
@@ -1263,12 +1610,12 @@ bool inverseDynamics::readAndUpdate(bool waitMeasure, bool _init)
             tmp = port_ft_arm_left->read(waitMeasure);
             if (tmp != nullptr)
             {
-                current_status.ft_arm_left  = *tmp;
+                status.ft_arm_left  = *tmp;
             }
         }
         else
         {
-            current_status.ft_arm_left.zero();
+            status.ft_arm_left.zero();
         }
         if (waitMeasure) yDebug("done. \n");
     }
@@ -1282,17 +1629,19 @@ bool inverseDynamics::readAndUpdate(bool waitMeasure, bool _init)
             tmp = port_ft_arm_right->read(waitMeasure);
             if (tmp != nullptr)
             {
-                current_status.ft_arm_right = *tmp;
+                status.ft_arm_right = *tmp;
             }
         }
         else
         {
-            current_status.ft_arm_right.zero();
+            status.ft_arm_right.zero();
         }
         if (waitMeasure) yInfo("done. \n");
     }
-    b &= getUpperEncodersSpeedAndAcceleration();
-    setUpperMeasure(_init);
+    {
+        stageTimer timer(stage_stats[STAGE_ENCODERS_UP]);
+        b &= getUpperEncodersSpeedAndAcceleration(status);
+    }
 
     // legs
     if (ddLL)
@@ -1304,12 +1653,12 @@ bool inverseDynamics::readAndUpdate(bool waitMeasure, bool _init)
             tmp = port_ft_leg_left->read(waitMeasure);
             if (tmp != nullptr)
             {
-                current_status.ft_leg_left  = *tmp;
+                status.ft_leg_left  = *tmp;
             }
         }
         else
         {
-            current_status.ft_leg_left.zero();
+            status.ft_leg_left.zero();
         }
         if (waitMeasure) yInfo("done. \n");
     }
@@ -1322,12 +1671,12 @@ bool inverseDynamics::readAndUpdate(bool waitMeasure, bool _init)
             tmp = port_ft_leg_right->read(waitMeasure);
             if (tmp != nullptr)
             {
-                current_status.ft_leg_right = *tmp;
+                status.ft_leg_right = *tmp;
             }
         }
         else
         {
-            current_status.ft_leg_right.zero();
+            status.ft_leg_right.zero();
         }
         if (waitMeasure) yInfo("done. \n");
     }
@@ -1342,12 +1691,12 @@ bool inverseDynamics::readAndUpdate(bool waitMeasure, bool _init)
             tmp = port_ft_foot_left->read(false); //not all the robot versions have the FT sensors installed in the feet
             if (tmp != nullptr)
             {
-                current_status.ft_foot_left  = *tmp;
+                status.ft_foot_left  = *tmp;
             }
         }
         else
         {
-            current_status.ft_foot_left.zero();
+            status.ft_foot_left.zero();
         }
         if (waitMeasure) yInfo("done. \n");
     }
@@ -1360,18 +1709,20 @@ bool inverseDynamics::readAndUpdate(bool waitMeasure, bool _init)
             tmp = port_ft_foot_right->read(false); //not all the robot versions have the FT sensors installed in the feet
             if (tmp != nullptr)
             {
-                current_status.ft_foot_right = *tmp;
+                status.ft_foot_right = *tmp;
             }
         }
         else
         {
-            current_status.ft_foot_right.zero();
+            status.ft_foot_right.zero();
         }
         if (waitMeasure) yInfo("done. \n");
     }
 
-    b &= getLowerEncodersSpeedAndAcceleration();
-    setLowerMeasure(_init);
+    {
+        stageTimer timer(stage_stats[STAGE_ENCODERS_LOW]);
+        b &= getLowerEncodersSpeedAndAcceleration(status);
+    }
 
     //inertial sensor
     if (waitMeasure) yInfo("Trying to connect to inertial sensor...");
@@ -1390,29 +1741,35 @@ bool inverseDynamics::readAndUpdate(bool waitMeasure, bool _init)
          (*inertial)[4] = 0;
          (*inertial)[5] = 0;
 #endif
-        current_status.inertial_d2p0[0] = (*inertial)[0];
-        current_status.inertial_d2p0[1] = (*inertial)[1];
-        current_status.inertial_d2p0[2] = (*inertial)[2];
-        current_status.inertial_w0 [0] =  (*inertial)[3]*CTRL_DEG2RAD;
-        current_status.inertial_w0 [1] =  (*inertial)[4]*CTRL_DEG2RAD;
-        current_status.inertial_w0 [2] =  (*inertial)[5]*CTRL_DEG2RAD;
-        current_status.inertial_dw0 = this->eval_domega(current_status.inertial_w0);
-        //yDebug ("%3.3f, %3.3f, %3.3f \n",current_status.inertial_d2p0[0],current_status.inertial_d2p0[1],current_status.inertial_d2p0[2]);
+        status.inertial_d2p0[0] = (*inertial)[0];
+        status.inertial_d2p0[1] = (*inertial)[1];
+        status.inertial_d2p0[2] = (*inertial)[2];
+        status.inertial_w0 [0] =  (*inertial)[3]*CTRL_DEG2RAD;
+        status.inertial_w0 [1] =  (*inertial)[4]*CTRL_DEG2RAD;
+        status.inertial_w0 [2] =  (*inertial)[5]*CTRL_DEG2RAD;
+        status.inertial_dw0 = this->eval_domega(status.inertial_w0);
+        //yDebug ("%3.3f, %3.3f, %3.3f \n",status.inertial_d2p0[0],status.inertial_d2p0[1],status.inertial_d2p0[2]);
 #ifdef DEBUG_PRINT_INERTIAL
         yDebug ("meas_w  (rad/s):  %3.3f, %3.3f, %3.3f \n", w0[0],   w0[1],   w0[2]);
         yDebug ("meas_dwo(rad/s):  %3.3f, %3.3f, %3.3f \n", dw0[0],  dw0[1],  dw0[2]);
 #endif
     }
 
+    status.timestamp=Time::now();
+    return b;
+}
+
+void inverseDynamics::updateStatus(bool _init)
+{
+    setUpperMeasure(_init);
+    setLowerMeasure(_init);
+
     //update the status memory
-    current_status.timestamp=Time::now();
     previous_status.push_front(current_status);
     if (previous_status.size()>status_queue_size) previous_status.pop_back();
-
-    return b;
 }
 
-bool inverseDynamics::getLowerEncodersSpeedAndAcceleration()
+bool inverseDynamics::getLowerEncodersSpeedAndAcceleration(iCubStatus &status)
 {
     bool b = true;
     if (iencs_leg_left)
@@ -1432,24 +1789,24 @@ bool inverseDynamics::getLowerEncodersSpeedAndAcceleration()
 
     for (size_t i=0;i<3;i++)
     {
-        current_status.all_q_low(i) = encoders_torso(2-i);
+        status.all_q_low(i) = encoders_torso(2-i);
     }
     for (size_t i=0;i<6;i++)
     {
-        current_status.all_q_low(3+i) = encoders_leg_left(i);
+        status.all_q_low(3+i) = encoders_leg_left(i);
     }
     for (size_t i=0;i<6;i++)
     {
-        current_status.all_q_low(3+6+i) = encoders_leg_right(i);
+        status.all_q_low(3+6+i) = encoders_leg_right(i);
     }
-    current_status.all_dq_low = evalVelLow(current_status.all_q_low);
-    current_status.all_d2q_low = evalAccLow(current_status.all_q_low);
+    status.all_dq_low = evalVelLow(status.all_q_low);
+    status.all_d2q_low = evalAccLow(status.all_q_low);
 
     return b;
 }
 
 
-bool inverseDynamics::getUpperEncodersSpeedAndAcceleration()
+bool inverseDynamics::getUpperEncodersSpeedAndAcceleration(iCubStatus &status)
 {
     bool b = true;
     if (iencs_arm_left) b &= iencs_arm_left->getEncoders(encoders_arm_left.data());
@@ -1461,18 +1818,18 @@ bool inverseDynamics::getUpperEncodersSpeedAndAcceleration()
 
     for (size_t i=0;i<3;i++)
     {
-        current_status.all_q_up(i) = encoders_head(i);
+        status.all_q_up(i) = encoders_head(i);
     }
     for (size_t i=0;i<7;i++)
     {
-        current_status.all_q_up(3+i) = encoders_arm_left(i);
+        status.all_q_up(3+i) = encoders_arm_left(i);
     }
     for (size_t i=0;i<7;i++)
     {
-        current_status.all_q_up(3+7+i) = encoders_arm_right(i);
+        status.all_q_up(3+7+i) = encoders_arm_right(i);
     }
-    current_status.all_dq_up = evalVelUp(current_status.all_q_up);
-    current_status.all_d2q_up = evalAccUp(current_status.all_q_up);
+    status.all_dq_up = evalVelUp(status.all_q_up);
+    status.all_d2q_up = evalAccUp(status.all_q_up);
 
     return b;
 }
@@ -26,12 +26,18 @@
 #include <iCub/ctrl/adaptWinPolyEstimator.h>
 #include <iCub/iDyn/iDyn.h>
 #include <iCub/iDyn/iDynBody.h>
+#include <iCub/iDyn/iDynWholeBodyState.h>
 #include <iCub/skinDynLib/skinContactList.h>
 
 #include <iostream>
 #include <iomanip>
 #include <cstring>
 #include <list>
+#include <mutex>
+#include <atomic>
+
+#include "tripleBuffer.h"
+#include "stageProfiler.h"
 
 using namespace yarp::os;
 using namespace yarp::sig;
@@ -47,6 +53,8 @@ constexpr float_t SKIN_EVENTS_TIMEOUT = 0.2;     // max time (in sec) a contact
 
 enum thread_status_enum {STATUS_OK=0, STATUS_DISCONNECTED}; 
 enum calib_enum {CALIB_ALL=0, CALIB_ARMS, CALIB_LEGS, CALIB_FEET};
+enum stage_enum {STAGE_ACQUISITION=0, STAGE_ENCODERS_UP, STAGE_ENCODERS_LOW, STAGE_SOLVE_UP, STAGE_SOLVE_LOW,
+                 STAGE_SKIN, STAGE_COMPUTE, STAGE_PUBLICATION, STAGE_LATENCY, STAGE_NUM};
 
 // struct version
 // {
@@ -125,6 +133,63 @@ class iCubStatus
 
 };
 
+// everything the compute stage hands over to the publication stage in one cycle
+class wholeBodyOutput
+{
+    public:
+    Stamp  stamp;
+    double sample_time;     // time the iCubStatus snapshot was acquired
+
+    Vector RATorques, LATorques, RLTorques, LLTorques, TOTorques, HDTorques;
+    Vector com_all, com_lb, com_ub, com_ll, com_rl, com_la, com_ra, com_hd, com_to, com_all_foot;
+    Vector com_v, all_dq, all_q;
+    Matrix com_jac, com_jac_an, com_cmm;
+    Vector F_up;
+    Vector F_ext_right_arm, F_ext_left_arm;
+    Vector F_ext_cartesian_right_arm, F_ext_cartesian_left_arm;
+    Vector F_ext_right_leg, F_ext_left_leg;
+    Vector F_ext_right_foot, F_ext_left_foot;
+    Vector F_sns_right_leg, F_sns_left_leg;
+    Vector F_mdl_right_leg, F_mdl_left_leg;
+    Vector F_ext_cartesian_right_leg, F_ext_cartesian_left_leg;
+    Vector F_ext_cartesian_right_foot, F_ext_cartesian_left_foot;
+    Vector F_ext_sens_right_arm, F_ext_sens_left_arm;
+    Vector F_ext_sens_right_leg, F_ext_sens_left_leg;
+    Matrix foot_root_mat;
+    Vector foot_root_vec;
+    iCub::skinDynLib::skinContactList skinContacts;
+
+    wholeBodyOutput ()
+    {
+        sample_time=0;
+    }
+};
+
+class inverseDynamics;
+
+// acquisition stage of the pipeline: reads the robot and produces iCubStatus snapshots
+class acquisitionThread: public PeriodicThread
+{
+    inverseDynamics *owner;
+
+public:
+    acquisitionThread(double _period, inverseDynamics *_owner) : PeriodicThread(_period), owner(_owner) { }
+    void run() override;
+};
+
+// publication stage of the pipeline: writes the output ports whenever the compute stage hands over new results
+class publicationThread: public Thread
+{
+    inverseDynamics *owner;
+    Semaphore        new_output;
+
+public:
+    publicationThread(inverseDynamics *_owner) : owner(_owner), new_output(0) { }
+    void notify() { new_output.post(); }
+    void run() override;
+    void onStop() override { new_output.post(); }
+};
+
 // class inverseDynamics: class for reading from Vrow and providing FT on an output port
 class inverseDynamics: public PeriodicThread
 {
@@ -135,6 +200,9 @@ public:
     bool       w0_dw0_enabled;
     bool       dumpvel_enabled;
     bool       auto_drift_comp;
+    int        parallel_threads;
+    bool       pipelined;
+    bool       state_port_enabled;
     bool       default_ee_cont;
     bool       add_legs_once;
 
@@ -226,10 +294,13 @@ private:
     BufferedPort<Vector> *port_dumpvel;
     BufferedPort<Vector> *port_COM_vel;
     BufferedPort<Matrix> *port_COM_Jacobian;
+    BufferedPort<Matrix> *port_COM_analytic_Jacobian;
+    BufferedPort<Matrix> *port_centroidal_momentum_matrix;
     BufferedPort<Vector> *port_all_velocities;
     BufferedPort<Vector> *port_all_positions;
     BufferedPort<Matrix> *port_root_position_mat;
     BufferedPort<Vector> *port_root_position_vec;
+    BufferedPort<wholeBodyState> *port_state;
 
     // ports outputing the external dynamics seen at the F/T sensor
     BufferedPort<Vector> *port_external_ft_arm_left;
@@ -241,11 +312,11 @@ private:
     bool first;
     thread_status_enum thread_status;
 
-    AWLinEstimator  *InertialEst;
-    AWLinEstimator  *linEstUp;
-    AWQuadEstimator *quadEstUp;
-    AWLinEstimator  *linEstLow;
-    AWQuadEstimator *quadEstLow;
+    AWLinFastEstimator  *InertialEst;
+    AWLinFastEstimator  *linEstUp;
+    AWQuadFastEstimator *quadEstUp;
+    AWLinFastEstimator  *linEstLow;
+    AWQuadFastEstimator *quadEstLow;
 
     int ctrlJnt;
     int allJnt;
@@ -257,6 +328,25 @@ private:
     list<iCubStatus> previous_status;
     list<iCubStatus> not_moving_status;
 
+    // pipeline: acquisition -> compute (this thread) -> publication
+    acquisitionThread         *acq_thread;
+    publicationThread         *pub_thread;
+    iCubStatus                 acq_status;      // working copy of the acquisition stage
+    tripleBuffer<iCubStatus>   status_buffer;
+    tripleBuffer<wholeBodyOutput> output_buffer;
+    wholeBodyOutput            output;          // used when the pipeline is disabled
+    std::atomic<int>           acq_delay_check;
+
+    // sample-to-torque latency, gathered by the publication stage
+    std::mutex latency_mutex;
+    double     latency_last;
+    double     latency_sum;
+    double     latency_max;
+    int        latency_count;
+
+    // per-stage timing
+    stageStats stage_stats[STAGE_NUM];
+
     Vector encoders_arm_left;
     Vector encoders_arm_right;
     Vector encoders_head;
@@ -292,8 +382,11 @@ private:
     int comp;
     Matrix FM_sens_up,FM_sens_low;
 
-    //COM Jacobian Matrix
+    //COM Jacobian Matrix: the 6x32 one of the EXPERIMENTAL methods on com_jacobian:o,
+    //the analytic 3x32 one and the 6x32 centroidal momentum matrix on the new ports
     Matrix com_jac;
+    Matrix com_jac_an;
+    Matrix com_cmm;
 
     Vector evalVelUp(const Vector &x);
     Vector evalVelLow(const Vector &x);
@@ -307,6 +400,7 @@ private:
     void setLowerMeasure(bool _init=false);
 
     void addSkinContacts();
+    void updateStatus(bool _init=false);
 
 public:
     inverseDynamics(int _rate, PolyDriver *_ddAL, PolyDriver *_ddAR, PolyDriver *_ddH, PolyDriver *_ddLL, PolyDriver *_ddLR, PolyDriver *_ddT, string _robot_name, string _local_name, version_tag icub_type, bool _autoconnect=false );
@@ -321,11 +415,18 @@ public:
     void threadRelease() override;
     void closePort(Contactable *_port);
     void writeTorque(Vector _values, int _address, BufferedPort<Bottle> *_port);
-    template <class T> void broadcastData(T& _values, BufferedPort<T> *_port);
+    template <class T> void broadcastData(T& _values, BufferedPort<T> *_port, const Stamp &_stamp);
     void calibrateOffset(calib_enum calib_code=CALIB_ALL);
     bool readAndUpdate(bool waitMeasure=false, bool _init=false);
-    bool getLowerEncodersSpeedAndAcceleration();
-    bool getUpperEncodersSpeedAndAcceleration();
+    bool acquireStatus(iCubStatus &status, bool waitMeasure=false);
+    bool getLowerEncodersSpeedAndAcceleration(iCubStatus &status);
+    bool getUpperEncodersSpeedAndAcceleration(iCubStatus &status);
+    void acquire();
+    void publish();
+    void publishOutput(wholeBodyOutput &out);
+    void publishState(wholeBodyOutput &out);
+    void getLatency(double &last, double &mean, double &max, bool reset=true);
+    void getStageStats(Bottle &stats);
     void setZeroJntAngVelAcc();
     void sendMonitorData();
     void sendVelAccData();
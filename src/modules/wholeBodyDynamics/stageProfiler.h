@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-3-Clause license. See the accompanying LICENSE file for details.
+*/
+
+#ifndef STAGE_PROFILER
+#define STAGE_PROFILER
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+// Rolling histogram of the durations of one stage of the computation.
+// Durations are binned on a logarithmic scale (BINS_PER_OCTAVE bins
+// per octave, from 1 us to about 2 s), so recording costs a log2 and
+// a couple of relaxed atomic increments. The history is split into
+// two halves of HALF_WINDOW seconds: the oldest one is dropped when
+// the newest one is full, hence the statistics always cover between
+// HALF_WINDOW and 2*HALF_WINDOW seconds.
+// Each instance must be fed by one thread only; the statistics can be
+// read by any thread at any time and are exact up to the samples
+// being recorded meanwhile.
+class stageStats
+{
+public:
+    typedef std::chrono::steady_clock clock;
+
+    static constexpr int    BINS_PER_OCTAVE = 4;
+    static constexpr int    BINS = 21*BINS_PER_OCTAVE;
+    static constexpr double HALF_WINDOW = 5.0;
+
+private:
+    struct window
+    {
+        std::atomic<uint32_t> bins[BINS];
+        std::atomic<uint32_t> count;
+        std::atomic<uint64_t> max_ns;
+
+        void clear()
+        {
+            for (auto &b : bins)
+                b.store(0,std::memory_order_relaxed);
+            count.store(0,std::memory_order_relaxed);
+            max_ns.store(0,std::memory_order_relaxed);
+        }
+    };
+
+    window            windows[2];
+    std::atomic<int>  current;
+    clock::time_point window_start;
+
+    stageStats(const stageStats&) = delete;
+    stageStats &operator=(const stageStats&) = delete;
+
+    static double binUpperEdge(const int i)
+    {
+        return 1e-6*std::exp2((double)(i+1)/BINS_PER_OCTAVE);
+    }
+
+public:
+    stageStats() : current(0), window_start(clock::now())
+    {
+        windows[0].clear();
+        windows[1].clear();
+    }
+
+    void record(const double dt, const clock::time_point now)
+    {
+        int cur = current.load(std::memory_order_relaxed);
+        if (std::chrono::duration<double>(now-window_start).count()>HALF_WINDOW)
+        {
+            cur = 1-cur;
+            windows[cur].clear();
+            current.store(cur,std::memory_order_relaxed);
+            window_start = now;
+        }
+
+        double us = 1e6*dt;
+        int i = (us>1.0) ? (int)(BINS_PER_OCTAVE*std::log2(us)) : 0;
+        if (i>=BINS) i = BINS-1;
+
+        window &w = windows[cur];
+        w.bins[i].fetch_add(1,std::memory_order_relaxed);
+        w.count.fetch_add(1,std::memory_order_relaxed);
+        uint64_t ns = (uint64_t)(1e9*dt);
+        if (ns>w.max_ns.load(std::memory_order_relaxed))
+            w.max_ns.store(ns,std::memory_order_relaxed);
+    }
+
+    void record(const double dt)
+    {
+        record(dt,clock::now());
+    }
+
+    // percentiles are returned as the upper edge of the bin they fall in, all values are in seconds
+    void getStats(double &p50, double &p99, double &max, unsigned int &count) const
+    {
+        uint32_t bins[BINS];
+        count = 0;
+        for (int i=0; i<BINS; i++)
+        {
+            bins[i] = windows[0].bins[i].load(std::memory_order_relaxed)+
+                      windows[1].bins[i].load(std::memory_order_relaxed);
+            count += bins[i];
+        }
+        max = 1e-9*std::max(windows[0].max_ns.load(std::memory_order_relaxed),
+                            windows[1].max_ns.load(std::memory_order_relaxed));
+
+        p50 = p99 = 0.0;
+        if (count==0)
+            return;
+
+        uint32_t n50 = (uint32_t)std::ceil(0.50*count);
+        uint32_t n99 = (uint32_t)std::ceil(0.99*count);
+        uint32_t sum = 0;
+        for (int i=0; i<BINS; i++)
+        {
+            uint32_t prev = sum;
+            sum += bins[i];
+            if ((prev<n50) && (sum>=n50))
+                p50 = std::min(binUpperEdge(i),max);
+            if ((prev<n99) && (sum>=n99))
+            {
+                p99 = std::min(binUpperEdge(i),max);
+                break;
+            }
+        }
+    }
+};
+
+// records the time elapsed between its construction and either
+// stop() or its destruction, whichever comes first
+class stageTimer
+{
+    stageStats                    &stats;
+    stageStats::clock::time_point  t0;
+    bool                           running;
+
+public:
+    explicit stageTimer(stageStats &_stats) : stats(_stats), t0(stageStats::clock::now()), running(true) { }
+
+    void stop()
+    {
+        if (running)
+        {
+            stageStats::clock::time_point t1 = stageStats::clock::now();
+            stats.record(std::chrono::duration<double>(t1-t0).count(),t1);
+            running = false;
+        }
+    }
+
+    ~stageTimer()
+    {
+        stop();
+    }
+};
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-3-Clause license. See the accompanying LICENSE file for details.
+*/
+
+#ifndef TRIPLE_BUFFER
+#define TRIPLE_BUFFER
+
+#include <atomic>
+
+// Lock-free triple buffer exchanging the latest item between one
+// producer thread and one consumer thread: the producer fills
+// writeSlot() and calls publish(), the consumer calls update() and,
+// if it returns true, reads readSlot(). Neither side ever waits for
+// the other, and the consumer always gets the most recent item;
+// items the consumer was too slow to pick up are overwritten.
+template <class T>
+class tripleBuffer
+{
+    static constexpr int FRESH = 4;
+
+    T                slots[3];
+    int              write_idx;
+    int              read_idx;
+    std::atomic<int> middle;    // index of the spare slot, plus FRESH if it holds an unread item
+
+    tripleBuffer(const tripleBuffer&) = delete;
+    tripleBuffer &operator=(const tripleBuffer&) = delete;
+
+public:
+    tripleBuffer() : write_idx(0), read_idx(1), middle(2) { }
+
+    // initialize all the slots, before any thread accesses the buffer
+    void fill(const T &item)
+    {
+        for (auto &s : slots)
+            s = item;
+    }
+
+    // producer side
+    T &writeSlot()
+    {
+        return slots[write_idx];
+    }
+
+    void publish()
+    {
+        write_idx = middle.exchange(write_idx|FRESH,std::memory_order_acq_rel) & ~FRESH;
+    }
+
+    // consumer side
+    bool update()
+    {
+        if ((middle.load(std::memory_order_relaxed) & FRESH)==0)
+            return false;
+
+        read_idx = middle.exchange(read_idx,std::memory_order_acq_rel) & ~FRESH;
+        return true;
+    }
+
+    T &readSlot()
+    {
+        return slots[read_idx];
+    }
+};
+
+#endif
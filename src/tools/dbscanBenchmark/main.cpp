@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-3-Clause license. See the accompanying LICENSE file for details.
+*/
+
+/**
+ * @ingroup icub_tools
+ *
+ * \defgroup icub_dbscanBenchmark dbscanBenchmark
+ *
+ * Benchmark of the DBSCAN clustering of ctrlLib over synthetic
+ * point clouds of increasing size.
+ *
+ * \section intro_sec Description
+ *
+ * Each cloud is made of 3D gaussian blobs, resembling the objects
+ * segmented out of a depth map, plus uniformly scattered outliers.
+ * For each size the tool times iCub::ctrl::DBSCAN::cluster() with
+ * one thread and with the requested number of threads, checking
+ * that the two runs return the same clusters. Up to a given size,
+ * it also runs a brute-force implementation of the
+ * original sequential algorithm, whose clusters must coincide
+ * with the ones of the library.
+ *
+ * \section lib_sec Libraries
+ * - YARP libraries.
+ * - ctrlLib library.
+ *
+ * \section parameters_sec Parameters
+ * --sizes "(\e n1 \e n2 ...)"
+ * - The numbers of points of the clouds [default: (1000 5000
+ *   20000 50000)].
+ *
+ * --epsilon \e eps
+ * - The DBSCAN proximity sensitivity [default: 0.02].
+ *
+ * --minpts \e n
+ * - The DBSCAN minimum number of neighbours [default: 5].
+ *
+ * --threads \e n
+ * - The number of threads [default: the number of cores].
+ *
+ * --check_max \e n
+ * - The brute-force check is carried out on the clouds with up
+ *   to \e n points [default: 20000].
+ *
+ * \section tested_os_sec Tested OS
+ * Linux and Windows.
+ */
+
+#include <cstdlib>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <algorithm>
+
+#include <yarp/os/LogStream.h>
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/Value.h>
+#include <yarp/os/Time.h>
+#include <yarp/sig/Vector.h>
+#include <iCub/ctrl/clustering.h>
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace iCub::ctrl;
+
+
+/**********************************************************************/
+vector<Vector> generateCloud(const size_t n)
+{
+    mt19937 gen(0);
+    uniform_real_distribution<double> uniform(-1.0,1.0);
+    normal_distribution<double> normal(0.0,0.05);
+
+    const size_t blobs=20;
+    vector<Vector> centers(blobs,Vector(3));
+    for (auto &c:centers)
+        for (size_t k=0; k<c.length(); k++)
+            c[k]=uniform(gen);
+
+    // one point out of ten is an outlier
+    vector<Vector> cloud(n,Vector(3));
+    for (size_t i=0; i<n; i++)
+    {
+        for (size_t k=0; k<3; k++)
+            cloud[i][k]=(i%10==0)?uniform(gen):centers[i%blobs][k]+normal(gen);
+    }
+    return cloud;
+}
+
+
+/**********************************************************************/
+map<size_t,set<size_t>> bruteForce(const vector<Vector> &data, const double epsilon,
+                                   const size_t minpts)
+{
+    const int unclassified=-1;
+    const int noise=-2;
+    vector<int> ids(data.size(),unclassified);
+
+    auto neighbours=[&](const size_t index) {
+        vector<size_t> en;
+        for (size_t i=0; i<data.size(); i++)
+        {
+            double d=0.0;
+            for (size_t j=0; j<data[index].length(); j++)
+                d+=pow(data[index][j]-data[i][j],2.0);
+            if ((i!=index) && (sqrt(d)<=epsilon))
+                en.push_back(i);
+        }
+        return en;
+    };
+
+    int id=0;
+    for (size_t i=0; i<data.size(); i++)
+    {
+        if (ids[i]!=unclassified)
+            continue;
+
+        vector<size_t> seeds=neighbours(i);
+        if (seeds.size()<minpts)
+        {
+            ids[i]=noise;
+            continue;
+        }
+
+        ids[i]=id;
+        for (auto s:seeds)
+            ids[s]=id;
+        for (size_t k=0; k<seeds.size(); k++)
+        {
+            vector<size_t> spread=neighbours(seeds[k]);
+            if (spread.size()>=minpts)
+            {
+                for (auto s:spread)
+                {
+                    if (ids[s]==unclassified)
+                        seeds.push_back(s);
+                    if ((ids[s]==unclassified) || (ids[s]==noise))
+                        ids[s]=id;
+                }
+            }
+        }
+        id++;
+    }
+
+    map<size_t,set<size_t>> clusters;
+    for (size_t i=0; i<data.size(); i++)
+        if (ids[i]!=noise)
+            clusters[ids[i]].insert(i);
+    return clusters;
+}
+
+
+/**********************************************************************/
+int main(int argc, char *argv[])
+{
+    ResourceFinder rf;
+    rf.configure(argc,argv);
+
+    if (rf.check("help"))
+    {
+        yInfo()<<"Options:";
+        yInfo()<<"\t--sizes      \"(n1 n2 ...)\"    numbers of points of the clouds";
+        yInfo()<<"\t--epsilon    <eps>            proximity sensitivity";
+        yInfo()<<"\t--minpts     <n>              minimum number of neighbours";
+        yInfo()<<"\t--threads    <n>              number of threads";
+        yInfo()<<"\t--check_max  <n>              max size checked against the brute-force algorithm";
+        return EXIT_SUCCESS;
+    }
+
+    vector<size_t> sizes={1000,5000,20000,50000};
+    if (Bottle *b=rf.find("sizes").asList())
+    {
+        sizes.clear();
+        for (int i=0; i<b->size(); i++)
+            sizes.push_back((size_t)b->get(i).asInt());
+    }
+
+    double epsilon=rf.check("epsilon",Value(0.02)).asDouble();
+    int minpts=rf.check("minpts",Value(5)).asInt();
+    int threads=rf.check("threads",Value((int)std::thread::hardware_concurrency())).asInt();
+    threads=std::max(1,threads);
+    size_t check_max=(size_t)rf.check("check_max",Value(20000)).asInt();
+
+    bool ok=true;
+    DBSCAN dbscan;
+    for (auto n:sizes)
+    {
+        vector<Vector> cloud=generateCloud(n);
+
+        Property options;
+        options.put("epsilon",epsilon);
+        options.put("minpts",minpts);
+
+        options.put("threads",1);
+        double t0=Time::now();
+        map<size_t,set<size_t>> clusters=dbscan.cluster(cloud,options);
+        double t1=Time::now();
+
+        options.put("threads",threads);
+        map<size_t,set<size_t>> clusters_mt=dbscan.cluster(cloud,options);
+        double t2=Time::now();
+
+        // the multi-threaded run shall return the very same clusters
+        bool same_mt=(clusters_mt==clusters);
+        ok&=same_mt;
+
+        string check="skipped";
+        double t3=t2,t4=t2;
+        if (n<=check_max)
+        {
+            t3=Time::now();
+            bool same=(bruteForce(cloud,epsilon,(size_t)minpts)==clusters);
+            t4=Time::now();
+            check=same?"identical":"DIFFERENT";
+            ok&=same;
+        }
+
+        yInfo()<<"points:"<<n<<"clusters:"<<clusters.size()
+               <<"| 1 thread:"<<1e3*(t1-t0)<<"ms |"<<threads<<"threads:"<<1e3*(t2-t1)<<"ms"
+               <<(same_mt?"identical":"DIFFERENT")
+               <<"| brute force:"<<((n<=check_max)?1e3*(t4-t3):0.0)<<"ms"<<check;
+    }
+
+    return (ok?EXIT_SUCCESS:EXIT_FAILURE);
+}
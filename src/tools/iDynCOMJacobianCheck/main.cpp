@@ -0,0 +1,337 @@
+/*
+ * Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-3-Clause license. See the accompanying LICENSE file for details.
+*/
+
+/**
+ * @ingroup icub_tools
+ *
+ * \defgroup icub_iDynCOMJacobianCheck iDynCOMJacobianCheck
+ *
+ * Check of the jacobian of the whole-body center of mass and of
+ * the centroidal momentum matrix of iDyn against finite
+ * differences.
+ *
+ * \section intro_sec Description
+ *
+ * For the iCub whole body, both with the version 1 and the
+ * version 2 of head and legs, the tool draws random joint
+ * configurations within the joints bounds and calls
+ * iCub::iDyn::iCubWholeBody::computeCOMjacobian(). The COM
+ * jacobian is compared column by column with the central
+ * differences of the COM provided by
+ * iCub::iDyn::iCubWholeBody::getCOM(). The centroidal momentum
+ * matrix, multiplied by random joint velocities, is compared
+ * with the total momentum of the links, whose velocities are
+ * obtained by central differences of their poses along the
+ * joint velocities: the linear momentum and the angular momentum
+ * about the COM, in the root reference frame. The COM given by
+ * the poses of the links is checked against getCOM() as well.
+ *
+ * The largest discrepancies, relative to the largest entry of
+ * the jacobian and of the momentum respectively, are reported.
+ * The tool fails if any discrepancy exceeds the tolerance, hence
+ * it is also run by ctest when testing is enabled.
+ *
+ * \section lib_sec Libraries
+ * - YARP libraries.
+ * - iDyn library.
+ *
+ * \section parameters_sec Parameters
+ * --samples \e n
+ * - The number of random configurations per robot [default:
+ *   100].
+ *
+ * --tolerance \e tol
+ * - The largest relative discrepancy allowed [default: 1e-6].
+ *
+ * --seed \e s
+ * - The seed of the random generator [default: 0].
+ *
+ * \section tested_os_sec Tested OS
+ * Linux and Windows.
+ */
+
+#include <cstdlib>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <yarp/os/LogStream.h>
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Value.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/math/Math.h>
+#include <iCub/iDyn/iDyn.h>
+#include <iCub/iDyn/iDynBody.h>
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::skinDynLib;
+using namespace iCub::iDyn;
+
+// central differences step [rad]
+#define FD_STEP     1e-6
+
+
+/**********************************************************************/
+struct LinkState
+{
+    double m;
+    Vector c;
+    Matrix R;
+    Matrix I;
+};
+
+
+/**********************************************************************/
+class Body
+{
+    iCubWholeBody body;
+    iDynLimb *limbs[6];
+
+public:
+    /******************************************************************/
+    Body(const version_tag &tag) : body(tag,DYNAMIC,NO_VERBOSE)
+    {
+        // limbs ordered as in getAllPositions()
+        limbs[0]=body.lowerTorso->left;
+        limbs[1]=body.lowerTorso->right;
+        limbs[2]=body.lowerTorso->up;
+        limbs[3]=body.upperTorso->left;
+        limbs[4]=body.upperTorso->right;
+        limbs[5]=body.upperTorso->up;
+    }
+
+    /******************************************************************/
+    unsigned int getDOF()
+    {
+        unsigned int dof=0;
+        for (int n=0; n<6; n++)
+            dof+=limbs[n]->getDOF();
+        return dof;
+    }
+
+    /******************************************************************/
+    Vector getRandomPositions(mt19937 &gen)
+    {
+        // keep away from the bounds not to clamp the differences
+        Vector q(getDOF());
+        for (int n=0,k=0; n<6; n++)
+        {
+            iDynChain &chain=*limbs[n]->asChain();
+            for (unsigned int i=0; i<chain.getDOF(); i++)
+            {
+                uniform_real_distribution<double> uniform(chain(i).getMin()+1e-3,
+                                                          chain(i).getMax()-1e-3);
+                q[k++]=uniform(gen);
+            }
+        }
+        return q;
+    }
+
+    /******************************************************************/
+    void setPositions(const Vector &q)
+    {
+        for (int n=0,k=0; n<6; n++)
+        {
+            unsigned int dof=limbs[n]->getDOF();
+            limbs[n]->setAng(q.subVector(k,k+dof-1));
+            k+=dof;
+        }
+    }
+
+    /******************************************************************/
+    bool computeCOMjacobian(Matrix &jac, Matrix &cmm)
+    {
+        return (body.computeCOMjacobian() && body.getCOMjacobian(jac) &&
+                body.getCentroidalMomentumMatrix(cmm));
+    }
+
+    /******************************************************************/
+    Vector getCOM()
+    {
+        Vector com;
+        double mass;
+        body.computeCOM();
+        body.getCOM(BODY_PART_ALL,com,mass);
+        return com;
+    }
+
+    /******************************************************************/
+    vector<LinkState> getLinks()
+    {
+        // the upper body hangs from the end of the torso
+        Matrix Tup=body.lowerTorso->getHUp()*
+                   body.lowerTorso->up->getH(body.lowerTorso->up->getN()-1,true);
+        Matrix Tb[6]={ body.lowerTorso->getHLeft(), body.lowerTorso->getHRight(),
+                       body.lowerTorso->getHUp(), Tup*body.upperTorso->getHLeft(),
+                       Tup*body.upperTorso->getHRight(), Tup*body.upperTorso->getHUp() };
+
+        vector<LinkState> links;
+        for (int n=0; n<6; n++)
+        {
+            unsigned int N=limbs[n]->getN();
+            for (unsigned int i=0; i<N; i++)
+            {
+                // the last transformation includes HN, which is not part of the link
+                Matrix H=limbs[n]->getH(i,true);
+                if (i==N-1)
+                    H=H*SE3inv(limbs[n]->getHN());
+                H=Tb[n]*H;
+
+                LinkState l;
+                l.m=limbs[n]->getMass(i);
+                l.c=(H*limbs[n]->getCOM(i).getCol(3)).subVector(0,2);
+                l.R=H.submatrix(0,2,0,2);
+                l.I=limbs[n]->getInertia(i);
+                links.push_back(l);
+            }
+        }
+        return links;
+    }
+};
+
+
+/**********************************************************************/
+double maxAbs(const Vector &v)
+{
+    double ret=0.0;
+    for (size_t i=0; i<v.length(); i++)
+        ret=std::max(ret,fabs(v[i]));
+    return ret;
+}
+
+
+/**********************************************************************/
+bool check(const string &name, const version_tag &tag, const int samples,
+           const double tolerance, mt19937 &gen)
+{
+    Body body(tag);
+    unsigned int dof=body.getDOF();
+    uniform_real_distribution<double> uniform(-1.0,1.0);
+
+    double err_com=0.0,err_jac=0.0,err_cmm=0.0;
+    for (int k=0; k<samples; k++)
+    {
+        Vector q=body.getRandomPositions(gen);
+        body.setPositions(q);
+
+        Matrix jac,cmm;
+        if (!body.computeCOMjacobian(jac,cmm) || (jac.cols()!=dof) || (cmm.cols()!=dof))
+        {
+            yError()<<name<<"computeCOMjacobian() failed";
+            return false;
+        }
+
+        // COM of the links against the one of the robot
+        Vector com=body.getCOM();
+        vector<LinkState> links=body.getLinks();
+        Vector s(3,0.0);
+        double mass=0.0;
+        for (size_t i=0; i<links.size(); i++)
+        {
+            s+=links[i].m*links[i].c;
+            mass+=links[i].m;
+        }
+        err_com=std::max(err_com,maxAbs(s/mass-com)/maxAbs(com));
+
+        // COM jacobian, column by column
+        double scale=0.0,diff=0.0;
+        for (unsigned int j=0; j<dof; j++)
+        {
+            Vector qp=q,qm=q;
+            qp[j]+=FD_STEP;
+            qm[j]-=FD_STEP;
+            body.setPositions(qp);
+            Vector comp=body.getCOM();
+            body.setPositions(qm);
+            Vector comm=body.getCOM();
+
+            Vector col=(comp-comm)/(2.0*FD_STEP);
+            for (int r=0; r<3; r++)
+            {
+                scale=std::max(scale,fabs(jac(r,j)));
+                diff=std::max(diff,fabs(col[r]-jac(r,j)));
+            }
+        }
+        err_jac=std::max(err_jac,diff/scale);
+
+        // momentum of the links moving along dq, with velocities
+        // obtained by central differences of their poses
+        Vector dq(dof);
+        for (unsigned int j=0; j<dof; j++)
+            dq[j]=uniform(gen);
+
+        body.setPositions(q+FD_STEP*dq);
+        vector<LinkState> linksp=body.getLinks();
+        body.setPositions(q-FD_STEP*dq);
+        vector<LinkState> linksm=body.getLinks();
+        body.setPositions(q);
+
+        Vector h(6,0.0);
+        for (size_t i=0; i<links.size(); i++)
+        {
+            const LinkState &l=links[i];
+            Vector v=(linksp[i].c-linksm[i].c)/(2.0*FD_STEP);
+            Matrix W=((linksp[i].R-linksm[i].R)/(2.0*FD_STEP))*l.R.transposed();
+            Vector w(3);
+            w[0]=W(2,1);
+            w[1]=W(0,2);
+            w[2]=W(1,0);
+
+            Vector hl=l.m*v;
+            Vector ha=l.R*l.I*l.R.transposed()*w+l.m*cross(l.c-com,v);
+            h.setSubvector(0,h.subVector(0,2)+hl);
+            h.setSubvector(3,h.subVector(3,5)+ha);
+        }
+
+        err_cmm=std::max(err_cmm,maxAbs(cmm*dq-h)/maxAbs(h));
+    }
+
+    bool ok=(err_com<=tolerance) && (err_jac<=tolerance) && (err_cmm<=tolerance);
+    yInfo()<<name<<"DOF:"<<dof<<"| max relative error COM:"<<err_com<<"COM jacobian:"<<err_jac
+           <<"centroidal momentum matrix:"<<err_cmm<<(ok?"":"| FAILED");
+    return ok;
+}
+
+
+/**********************************************************************/
+int main(int argc, char *argv[])
+{
+    ResourceFinder rf;
+    rf.configure(argc,argv);
+
+    if (rf.check("help"))
+    {
+        yInfo()<<"Options:";
+        yInfo()<<"\t--samples    <n>      number of random configurations per robot";
+        yInfo()<<"\t--tolerance  <tol>    largest relative discrepancy allowed";
+        yInfo()<<"\t--seed       <s>      seed of the random generator";
+        return EXIT_SUCCESS;
+    }
+
+    int samples=std::max(1,rf.check("samples",Value(100)).asInt());
+    double tolerance=rf.check("tolerance",Value(1e-6)).asDouble();
+    mt19937 gen((unsigned int)rf.check("seed",Value(0)).asInt());
+
+    bool ok=true;
+
+    version_tag v1;
+    ok&=check("iCubWholeBody v1",v1,samples,tolerance,gen);
+
+    version_tag v2;
+    v2.head_version=2;
+    v2.legs_version=2;
+    ok&=check("iCubWholeBody v2",v2,samples,tolerance,gen);
+
+    return (ok?EXIT_SUCCESS:EXIT_FAILURE);
+}
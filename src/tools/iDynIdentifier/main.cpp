@@ -0,0 +1,397 @@
+/*
+ * Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-3-Clause license. See the accompanying LICENSE file for details.
+*/
+
+/**
+ * @ingroup icub_tools
+ *
+ * \defgroup icub_iDynIdentifier iDynIdentifier
+ *
+ * Offline identification of the dynamic parameters of an iCub
+ * limb from logged joint positions and joint torques.
+ *
+ * \section intro_sec Description
+ *
+ * The joint torques of a chain are linear in the dynamic
+ * parameters of its links (mass, first moment of mass and
+ * inertia about the link origin), i.e. tau = Y(q,dq,ddq)*pi,
+ * where Y is the regressor provided by
+ * iCub::iDyn::iDynChain::computeRegressor().
+ *
+ * The tool streams the logged samples, computes the velocities
+ * and accelerations by central differences, stacks the
+ * regressors and accumulates the normal equations Y'*Y and
+ * Y'*tau in parallel over chunks of the dataset. Since only a
+ * subspace of the parameters (the base parameters) can be
+ * identified from the joint torques, the estimate is computed
+ * as the minimum-norm correction to the CAD parameters of the
+ * iDyn model that fits the data, discarding the directions
+ * whose singular values fall below a given tolerance.
+ *
+ * The joint torques can be the ones estimated by
+ * \ref wholeBodyDynamics out of the F/T sensors measurements
+ * and dumped with yarpdatadumper.
+ *
+ * \section lib_sec Libraries
+ * - YARP libraries.
+ * - iDyn library.
+ *
+ * \section parameters_sec Parameters
+ * --part \e name
+ * - The limb to be identified: one among left_arm, right_arm,
+ *   left_leg, right_leg [default: left_arm]. The arms do not
+ *   include the torso joints.
+ *
+ * --positions \e file
+ * - The file containing the joint positions in degrees, one
+ *   sample per line in the format of yarpdatadumper, i.e.
+ *   "counter timestamp q0 q1 ..."; only the first DOF values are
+ *   used.
+ *
+ * --torques \e file
+ * - The file containing the joint torques in Nm, in the same
+ *   format; each position sample is associated with the latest
+ *   torque sample whose timestamp does not exceed its own.
+ *
+ * --gravity "(\e gx \e gy \e gz)"
+ * - The vector equal and opposite to the gravity, expressed in
+ *   the root frame of the chain [default: (0.0 0.0 9.81)].
+ *
+ * --decimation \e d
+ * - Use one sample every \e d [default: 1].
+ *
+ * --threads \e n
+ * - The number of threads accumulating the normal equations
+ *   [default: the number of cores].
+ *
+ * --tolerance \e tol
+ * - The singular values below tol times the largest one are
+ *   discarded [default: 1e-6].
+ *
+ * --output \e file
+ * - The file where the identified parameters are saved, one
+ *   link per line in the order m m*rCx m*rCy m*rCz Ixx Ixy Ixz
+ *   Iyy Iyz Izz [default: identified_params.txt].
+ *
+ * \section tested_os_sec Tested OS
+ * Linux and Windows.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+#include <thread>
+#include <algorithm>
+#include <functional>
+
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/math/Math.h>
+#include <yarp/math/SVD.h>
+
+#include <iCub/ctrl/math.h>
+#include <iCub/iDyn/iDyn.h>
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::ctrl;
+using namespace iCub::iDyn;
+
+
+/************************************************************************/
+struct Sample
+{
+    double t;
+    Vector values;
+};
+
+
+/************************************************************************/
+iDynLimb *createLimb(const string &part)
+{
+    if (part=="left_arm")
+        return new iCubArmNoTorsoDyn("left");
+    else if (part=="right_arm")
+        return new iCubArmNoTorsoDyn("right");
+    else if (part=="left_leg")
+        return new iCubLegDyn("left");
+    else if (part=="right_leg")
+        return new iCubLegDyn("right");
+    else
+        return NULL;
+}
+
+
+/************************************************************************/
+bool readLog(const string &fileName, const size_t len, vector<Sample> &samples)
+{
+    ifstream fin(fileName.c_str());
+    if (!fin.is_open())
+    {
+        yError()<<"unable to open"<<fileName;
+        return false;
+    }
+
+    string line;
+    while (getline(fin,line))
+    {
+        istringstream str(line);
+        double counter;
+        Sample sample;
+        sample.values.resize(len);
+        str>>counter>>sample.t;
+        for (size_t i=0; i<len; i++)
+            str>>sample.values[i];
+
+        if (str.fail())
+            continue;
+
+        samples.push_back(sample);
+    }
+
+    yInfo()<<"read"<<samples.size()<<"samples from"<<fileName;
+    return !samples.empty();
+}
+
+
+/************************************************************************/
+class Accumulator
+{
+public:
+    Matrix A;
+    Vector b;
+    double tau2;
+    size_t rows;
+
+    /********************************************************************/
+    Accumulator() : tau2(0.0), rows(0) { }
+
+    /********************************************************************/
+    void run(const string &part, const vector<Sample> &q, const vector<Sample> &tau,
+             const vector<size_t> &indexes, const size_t begin, const size_t end,
+             const Vector &gravity)
+    {
+        iDynLimb *limb=createLimb(part);
+        iDynChain *chain=limb->asChain();
+        unsigned int dof=chain->getDOF();
+        unsigned int cols=10*chain->getN();
+        Vector zero3(3,0.0);
+
+        A.resize(cols,cols); A.zero();
+        b.resize(cols); b.zero();
+        tau2=0.0;
+        rows=0;
+
+        for (size_t k=begin; k<end; k++)
+        {
+            // central differences on possibly irregular timestamps
+            size_t i=indexes[k];
+            const Sample &prev=q[i-1];
+            const Sample &cur=q[i];
+            const Sample &next=q[i+1];
+            double dt1=cur.t-prev.t;
+            double dt2=next.t-cur.t;
+            if ((dt1<=0.0) || (dt2<=0.0))
+                continue;
+
+            Vector v1=(CTRL_DEG2RAD/dt1)*(cur.values-prev.values);
+            Vector v2=(CTRL_DEG2RAD/dt2)*(next.values-cur.values);
+
+            chain->setAng(CTRL_DEG2RAD*cur.values);
+            chain->setDAng((dt2*v1+dt1*v2)/(dt1+dt2));
+            chain->setD2Ang((2.0/(dt1+dt2))*(v2-v1));
+
+            Matrix Y=chain->computeRegressor(zero3,zero3,gravity);
+            const Vector &t=tau[i].values;
+            for (unsigned int r=0; r<dof; r++)
+            {
+                const double *y=Y[r];
+                for (unsigned int c=0; c<cols; c++)
+                {
+                    if (y[c]!=0.0)
+                    {
+                        double *a=A[c];
+                        for (unsigned int j=c; j<cols; j++)
+                            a[j]+=y[c]*y[j];
+                        b[c]+=y[c]*t[r];
+                    }
+                }
+                tau2+=t[r]*t[r];
+            }
+            rows+=dof;
+        }
+
+        // only the upper triangle has been filled in
+        for (unsigned int c=0; c<cols; c++)
+            for (unsigned int j=0; j<c; j++)
+                A(c,j)=A(j,c);
+
+        delete limb;
+    }
+};
+
+
+/************************************************************************/
+int main(int argc, char *argv[])
+{
+    ResourceFinder rf;
+    rf.configure(argc,argv);
+
+    if (rf.check("help"))
+    {
+        yInfo()<<"Options:";
+        yInfo()<<"\t--part       <name>           left_arm, right_arm, left_leg, right_leg";
+        yInfo()<<"\t--positions  <file>           joint positions log [deg]";
+        yInfo()<<"\t--torques    <file>           joint torques log [Nm]";
+        yInfo()<<"\t--gravity    \"(gx gy gz)\"     minus gravity in the root frame";
+        yInfo()<<"\t--decimation <d>              use one sample every d";
+        yInfo()<<"\t--threads    <n>              number of threads";
+        yInfo()<<"\t--tolerance  <tol>            relative tolerance on the singular values";
+        yInfo()<<"\t--output     <file>           file of the identified parameters";
+        return EXIT_SUCCESS;
+    }
+
+    string part=rf.check("part",Value("left_arm")).asString();
+    string posFile=rf.check("positions",Value("")).asString();
+    string torFile=rf.check("torques",Value("")).asString();
+    string outFile=rf.check("output",Value("identified_params.txt")).asString();
+    int decimation=std::max(1,rf.check("decimation",Value(1)).asInt());
+    double tol=rf.check("tolerance",Value(1e-6)).asDouble();
+    int threads=rf.check("threads",Value((int)std::thread::hardware_concurrency())).asInt();
+    threads=std::max(1,threads);
+
+    Vector gravity(3,0.0); gravity[2]=9.81;
+    if (Bottle *b=rf.find("gravity").asList())
+        if (b->size()>=3)
+            for (int i=0; i<3; i++)
+                gravity[i]=b->get(i).asDouble();
+
+    iDynLimb *limb=createLimb(part);
+    if (limb==NULL)
+    {
+        yError()<<"unknown part"<<part;
+        return EXIT_FAILURE;
+    }
+
+    iDynChain *chain=limb->asChain();
+    unsigned int dof=chain->getDOF();
+    Vector pi0=chain->getDynamicParameters();
+    delete limb;
+
+    vector<Sample> q,tau;
+    if (!readLog(posFile,dof,q) || !readLog(torFile,dof,tau))
+        return EXIT_FAILURE;
+
+    // align the torques to the positions by sample-and-hold
+    vector<Sample> tauAligned(q.size());
+    vector<size_t> indexes;
+    size_t j=0;
+    for (size_t i=0; i<q.size(); i++)
+    {
+        while ((j+1<tau.size()) && (tau[j+1].t<=q[i].t))
+            j++;
+        tauAligned[i]=tau[j];
+        if ((i>0) && (i+1<q.size()) && (tau[j].t<=q[i].t) && (i%decimation==0))
+            indexes.push_back(i);
+    }
+
+    if (indexes.empty())
+    {
+        yError()<<"no valid samples to process";
+        return EXIT_FAILURE;
+    }
+
+    // accumulate the normal equations over chunks of the dataset;
+    // the partial sums are then added up in a fixed order so that
+    // the result does not depend on the scheduling
+    threads=std::min(threads,(int)indexes.size());
+    vector<Accumulator> acc(threads);
+    vector<thread> workers;
+    size_t chunk=(indexes.size()+threads-1)/threads;
+    for (int t=0; t<threads; t++)
+    {
+        size_t begin=std::min(t*chunk,indexes.size());
+        size_t end=std::min(begin+chunk,indexes.size());
+        workers.push_back(thread(&Accumulator::run,&acc[t],cref(part),cref(q),
+                                 cref(tauAligned),cref(indexes),begin,end,cref(gravity)));
+    }
+    for (auto &w:workers)
+        w.join();
+
+    Matrix A=acc[0].A;
+    Vector b=acc[0].b;
+    double tau2=acc[0].tau2;
+    size_t rows=acc[0].rows;
+    for (int t=1; t<threads; t++)
+    {
+        A+=acc[t].A;
+        b+=acc[t].b;
+        tau2+=acc[t].tau2;
+        rows+=acc[t].rows;
+    }
+
+    if (rows==0)
+    {
+        yError()<<"no valid samples to process";
+        return EXIT_FAILURE;
+    }
+
+    // minimum-norm correction to the prior within the identifiable
+    // subspace: pi = pi0 + pinv(A)*(b - A*pi0)
+    Matrix U,V;
+    Vector S(A.cols());
+    U.resize(A.rows(),A.cols());
+    V.resize(A.cols(),A.cols());
+    SVD(A,U,S,V);
+
+    Vector res=b-A*pi0;
+    Vector delta(pi0.length(),0.0);
+    size_t rank=0;
+    for (size_t i=0; i<S.length(); i++)
+    {
+        if (S[i]>tol*S[0])
+        {
+            double c=dot(U.getCol(i),res)/S[i];
+            delta+=c*V.getCol(i);
+            rank++;
+        }
+    }
+    Vector pi=pi0+delta;
+
+    // residuals from the normal equations: |tau-Y*pi|^2 = tau'*tau - 2*b'*pi + pi'*A*pi
+    double rms0=sqrt(std::max(0.0,tau2-2.0*dot(b,pi0)+dot(pi0,A*pi0))/rows);
+    double rms=sqrt(std::max(0.0,tau2-2.0*dot(b,pi)+dot(pi,A*pi))/rows);
+    yInfo()<<"processed"<<rows/dof<<"samples with"<<threads<<"threads";
+    yInfo()<<"rank of the regressor"<<rank<<"out of"<<pi.length()<<"parameters";
+    yInfo()<<"torques rms error: CAD ="<<rms0<<"[Nm]; identified ="<<rms<<"[Nm]";
+
+    ofstream fout(outFile.c_str());
+    if (!fout.is_open())
+    {
+        yError()<<"unable to open"<<outFile;
+        return EXIT_FAILURE;
+    }
+
+    fout<<setprecision(numeric_limits<double>::digits10+2);
+    for (size_t i=0; i<pi.length(); i++)
+        fout<<pi[i]<<((i%10==9)?"\n":" ");
+    yInfo()<<"parameters saved to"<<outFile;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-3-Clause license. See the accompanying LICENSE file for details.
+*/
+
+/**
+ * @ingroup icub_tools
+ *
+ * \defgroup icub_iDynMassMatrixCheck iDynMassMatrixCheck
+ *
+ * Check of the mass matrix computed by the Composite Rigid Body
+ * Algorithm against the one computed by means of the
+ * Newton-Euler recursion, of the forward dynamics computed
+ * by the Articulated Body Algorithm and of the dynamic
+ * regressor, on all the iCub limbs of iDyn.
+ *
+ * \section intro_sec Description
+ *
+ * For each iCub*Dyn limb, the tool draws random joint
+ * configurations within the joints bounds and compares
+ * iCub::iDyn::iDynChain::computeMassMatrixCRBA() with
+ * iCub::iDyn::iDynChain::computeMassMatrix(). Then, for random
+ * joint velocities and accelerations, base motion and wrench at
+ * the end-effector, the joint torques given by the Newton-Euler
+ * are fed to iCub::iDyn::iDynChain::computeForwardDynamics(),
+ * which has to return the original accelerations, and, with no
+ * wrench at the end-effector, the product of
+ * iCub::iDyn::iDynChain::computeRegressor() with
+ * iCub::iDyn::iDynChain::getDynamicParameters(), which has to
+ * return the torques themselves. The arms are
+ * checked both with the torso joints blocked, as they are
+ * by default, and released. The largest discrepancies of each
+ * limb, relative to the largest entry of the mass matrix, of
+ * the inertial torques M*ddq and of the torques respectively,
+ * are reported along with the average time taken by the
+ * methods. The tool fails if any
+ * discrepancy exceeds the tolerance, hence it is also run by
+ * ctest when testing is enabled.
+ *
+ * \section lib_sec Libraries
+ * - YARP libraries.
+ * - iDyn library.
+ *
+ * \section parameters_sec Parameters
+ * --samples \e n
+ * - The number of random configurations per limb [default:
+ *   1000].
+ *
+ * --tolerance \e tol
+ * - The largest relative discrepancy allowed [default: 1e-9].
+ *
+ * --seed \e s
+ * - The seed of the random generator [default: 0].
+ *
+ * \section tested_os_sec Tested OS
+ * Linux and Windows.
+ */
+
+#include <cstdlib>
+#include <cmath>
+#include <random>
+#include <string>
+#include <algorithm>
+
+#include <yarp/os/LogStream.h>
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Value.h>
+#include <yarp/os/Time.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/math/Math.h>
+#include <iCub/iDyn/iDyn.h>
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::iKin;
+using namespace iCub::iDyn;
+
+
+/**********************************************************************/
+Vector randomVector(const unsigned int n, const double min, const double max,
+                    mt19937 &gen)
+{
+    uniform_real_distribution<double> uniform(min,max);
+    Vector v(n);
+    for (unsigned int i=0; i<n; i++)
+        v[i]=uniform(gen);
+    return v;
+}
+
+
+/**********************************************************************/
+double maxAbs(const Vector &v)
+{
+    double ret=0.0;
+    for (size_t i=0; i<v.length(); i++)
+        ret=std::max(ret,fabs(v[i]));
+    return ret;
+}
+
+
+/**********************************************************************/
+bool check(const string &name, iDynLimb &limb, const int samples,
+           const double tolerance, mt19937 &gen)
+{
+    iDynChain &chain=*limb.asChain();
+    unsigned int N=chain.getN();
+    unsigned int dof=chain.getDOF();
+
+    // the Articulated Body Algorithm neglects the inertia of the motors and
+    // takes the base motion as the Newton-Euler does when the kinematics
+    // is propagated forward from the base (the neck defaults to backward)
+    chain.setIterMode(KINFWD_WREBWD);
+    chain.prepareNewtonEuler(DYNAMIC);
+
+    Vector g(3,0.0);
+    g[2]=9.81;
+
+    Vector zero3(3,0.0);
+    Vector pi=chain.getDynamicParameters();
+
+    double err_crba=0.0,err_aba=0.0,err_reg=0.0;
+    double t_ne=0.0,t_crba=0.0,t_aba=0.0,t_reg=0.0;
+    Vector q(dof);
+    for (int k=0; k<samples; k++)
+    {
+        for (unsigned int i=0; i<dof; i++)
+        {
+            uniform_real_distribution<double> uniform(chain(i).getMin(),chain(i).getMax());
+            q[i]=uniform(gen);
+        }
+
+        double t0=Time::now();
+        Matrix M=chain.computeMassMatrix(q);
+        double t1=Time::now();
+        Matrix M_crba=chain.computeMassMatrixCRBA(q);
+        double t2=Time::now();
+        t_ne+=t1-t0;
+        t_crba+=t2-t1;
+
+        double scale=0.0,diff=0.0;
+        for (unsigned int r=0; r<dof; r++)
+        {
+            for (unsigned int c=0; c<dof; c++)
+            {
+                scale=std::max(scale,fabs(M(r,c)));
+                diff=std::max(diff,fabs(M(r,c)-M_crba(r,c)));
+            }
+        }
+
+        if (scale>0.0)
+            err_crba=std::max(err_crba,diff/scale);
+
+        // moving base and wrench at the end-effector
+        Vector dq=randomVector(dof,-1.0,1.0,gen);
+        Vector ddq=randomVector(dof,-1.0,1.0,gen);
+        Vector w0=randomVector(3,-1.0,1.0,gen);
+        Vector dw0=randomVector(3,-1.0,1.0,gen);
+        Vector ddp0=g+randomVector(3,-1.0,1.0,gen);
+        Vector Fend=randomVector(3,-5.0,5.0,gen);
+        Vector Muend=randomVector(3,-0.5,0.5,gen);
+
+        chain.setAng(q);
+        chain.setDAng(dq);
+        chain.setD2Ang(ddq);
+        chain.computeNewtonEuler(w0,dw0,ddp0,Fend,Muend);
+
+        // torques of the active joints only
+        Vector tau_all=chain.getTorques();
+        Vector tau(dof);
+        for (unsigned int i=0,d=0; i<N; i++)
+            if (!chain.isLinkBlocked(i))
+                tau[d++]=tau_all[i];
+
+        t0=Time::now();
+        Vector ddq_aba=chain.computeForwardDynamics(q,dq,tau,w0,dw0,ddp0,Fend,Muend);
+        t_aba+=Time::now()-t0;
+
+        // the accelerations are compared through the mass matrix, since the
+        // one of the neck is nearly singular and amplifies any rounding
+        scale=maxAbs(M*ddq);
+        if (scale>0.0)
+            err_aba=std::max(err_aba,maxAbs(M*(ddq_aba-ddq))/scale);
+
+        // the regressor accounts for no wrench at the end-effector
+        chain.setD2Ang(ddq);
+        chain.computeNewtonEuler(w0,dw0,ddp0,zero3,zero3);
+        tau_all=chain.getTorques();
+        for (unsigned int i=0,d=0; i<N; i++)
+            if (!chain.isLinkBlocked(i))
+                tau[d++]=tau_all[i];
+
+        t0=Time::now();
+        Matrix Y=chain.computeRegressor(w0,dw0,ddp0);
+        t_reg+=Time::now()-t0;
+
+        scale=maxAbs(tau);
+        if (scale>0.0)
+            err_reg=std::max(err_reg,maxAbs(Y*pi-tau)/scale);
+    }
+
+    bool ok=(err_crba<=tolerance) && (err_aba<=tolerance) && (err_reg<=tolerance);
+    yInfo()<<name<<"DOF:"<<dof<<"| max relative error CRBA:"<<err_crba<<"ABA:"<<err_aba
+           <<"regressor:"<<err_reg<<"| Newton-Euler:"<<1e6*t_ne/samples<<"us | CRBA:"
+           <<1e6*t_crba/samples<<"us | ABA:"<<1e6*t_aba/samples<<"us | regressor:"
+           <<1e6*t_reg/samples<<"us"<<(ok?"":"| FAILED");
+    return ok;
+}
+
+
+/**********************************************************************/
+int main(int argc, char *argv[])
+{
+    ResourceFinder rf;
+    rf.configure(argc,argv);
+
+    if (rf.check("help"))
+    {
+        yInfo()<<"Options:";
+        yInfo()<<"\t--samples    <n>      number of random configurations per limb";
+        yInfo()<<"\t--tolerance  <tol>    largest relative discrepancy allowed";
+        yInfo()<<"\t--seed       <s>      seed of the random generator";
+        return EXIT_SUCCESS;
+    }
+
+    int samples=std::max(1,rf.check("samples",Value(1000)).asInt());
+    double tolerance=rf.check("tolerance",Value(1e-9)).asDouble();
+    mt19937 gen((unsigned int)rf.check("seed",Value(0)).asInt());
+
+    bool ok=true;
+    for (const string type : {"left","right"})
+    {
+        iCubArmDyn arm(type);
+        ok&=check("iCubArmDyn "+type,arm,samples,tolerance,gen);
+
+        for (unsigned int i=0; i<3; i++)
+            arm.releaseLink(i);
+        ok&=check("iCubArmDyn "+type+" with torso",arm,samples,tolerance,gen);
+
+        iCubArmNoTorsoDyn armNoTorso(type);
+        ok&=check("iCubArmNoTorsoDyn "+type,armNoTorso,samples,tolerance,gen);
+
+        iCubLegDyn leg(type);
+        ok&=check("iCubLegDyn "+type,leg,samples,tolerance,gen);
+
+        iCubLegDynV2 legV2(type);
+        ok&=check("iCubLegDynV2 "+type,legV2,samples,tolerance,gen);
+    }
+
+    iCubTorsoDyn torso("lower");
+    ok&=check("iCubTorsoDyn",torso,samples,tolerance,gen);
+
+    iCubNeckInertialDyn neck;
+    ok&=check("iCubNeckInertialDyn",neck,samples,tolerance,gen);
+
+    iCubNeckInertialDynV2 neckV2;
+    ok&=check("iCubNeckInertialDynV2",neckV2,samples,tolerance,gen);
+
+    return (ok?EXIT_SUCCESS:EXIT_FAILURE);
+}